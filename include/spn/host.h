@@ -20,6 +20,9 @@ spn_ctx_t* spn_ctx_new(spn_wake_fn_t wake, void* wake_data);
 spn_err_t spn_ctx_open(spn_ctx_t* ctx, spn_open_request_t request);
 spn_err_t spn_ctx_open_session(spn_ctx_t* ctx, const spn_session_config_t* config, spn_session_t** session);
 void spn_ctx_close(spn_ctx_t* ctx, bool ok);
+spn_err_t spn_ctx_watch(spn_ctx_t* ctx);
+sp_sys_fd_t spn_ctx_watch_fd(spn_ctx_t* ctx);
+bool spn_ctx_watch_changed(spn_ctx_t* ctx);
 bool spn_ctx_progress(spn_ctx_t* ctx, spn_progress_t* progress);
 spn_event_t* spn_ctx_drain(spn_ctx_t* ctx);
 sp_str_t spn_ctx_project_dir(spn_ctx_t* ctx);
@@ -87,6 +87,7 @@ typedef struct spn_session_config_t {
   spn_target_selection_t selection;
   spn_profile_override_t profile;
   bool force;
+  bool thin_archives;
 } spn_session_config_t;
 
 typedef enum {
@@ -121,6 +122,7 @@ typedef struct {
 
 typedef struct {
   bool force;
+  bool lazy;
   sp_str_t only;
 } spn_sync_request_t;
 
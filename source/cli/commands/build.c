@@ -1,7 +1,10 @@
 #include "host/host.h"
+#include "tui/tui.h"
 
 static struct {
   bool force;
+  bool thin_archives;
+  bool watch;
   struct {
     bool test;
     bool bin;
@@ -21,10 +24,47 @@ static void set_rule(spn_target_rule_t* rule, bool selected, spn_str_arr_t names
   rule->names = names;
 }
 
+static bool interrupted() {
+  return sp_atomic_s32_load(&host.interrupted, SP_ATOMIC_SEQ_CST);
+}
+
+// Every pass opens a fresh session on the same context, so toolchains,
+// indexes, the runtime and the build's file cache stay warm between passes.
+// The lazy index refresh runs per pass too: it's a no-op while the indexes
+// are fresh, and picks up the ones a reloaded spn.toml adds. A failed pass is
+// reported and the watch carries on; ^C ends it
+static sp_cli_result_t watch(sp_cli_t* cli, spn_session_config_t config) {
+  if (spn_ctx_watch(host.ctx)) {
+    return SP_CLI_ERR;
+  }
+
+  while (!interrupted()) {
+    if (spn_cli_refresh_indexes(true) == SP_CLI_OK && spn_cli_session(cli, config) == SP_CLI_OK) {
+      spn_cli_op(spn_build(host.session));
+    }
+
+    while (true) {
+      sp_sys_event_clear(host.doorbell);
+      spn_tui_flush(&tui);
+      if (interrupted()) {
+        return SP_CLI_OK;
+      }
+      if (spn_ctx_watch_changed(host.ctx)) {
+        break;
+      }
+
+      sp_sys_fd_t fds [2] = { host.doorbell.fd, spn_ctx_watch_fd(host.ctx) };
+      u64 signaled = 0;
+      sp_sys_wait(fds, 2, 0, &signaled);
+    }
+  }
+  return SP_CLI_OK;
+}
+
 static sp_cli_result_t build(sp_cli_t* cli) {
   try(spn_cli_open(false));
 
-  spn_session_config_t config = { .force = args.force };
+  spn_session_config_t config = { .force = args.force, .thin_archives = args.thin_archives };
   spn_str_arr_t names = spn_cli_rest_names(cli);
 
   bool specific = args.only.bin || args.only.lib || args.only.test || args.only.script || args.only.example;
@@ -37,7 +77,10 @@ static sp_cli_result_t build(sp_cli_t* cli) {
     set_rule(&config.selection.example, all_kinds || args.only.example, names);
   }
 
-  try(spn_cli_refresh_indexes());
+  if (args.watch) {
+    return watch(cli, config);
+  }
+  try(spn_cli_refresh_indexes(true));
   try(spn_cli_session(cli, config));
   return spn_cli_op(spn_build(host.session));
 }
@@ -53,6 +96,19 @@ sp_cli_cmd_t spn_cmd_build = {
       .kind = SP_CLI_OPT_BOOLEAN,
       .ptr = &args.force,
     },
+    {
+      .name = "thin-archives",
+      .summary = "Archive dependency libraries as thin archives that reference their objects",
+      .kind = SP_CLI_OPT_BOOLEAN,
+      .ptr = &args.thin_archives,
+    },
+    {
+      .brief = 'w',
+      .name = "watch",
+      .summary = "Stay running and rebuild whenever a file in the project changes",
+      .kind = SP_CLI_OPT_BOOLEAN,
+      .ptr = &args.watch,
+    },
     {
       .brief = 'p',
       .name = "profile",
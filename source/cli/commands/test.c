@@ -13,7 +13,7 @@ static sp_cli_result_t test(sp_cli_t* cli) {
       },
     },
   };
-  try(spn_cli_refresh_indexes());
+  try(spn_cli_refresh_indexes(true));
   try(spn_cli_session(cli, config));
   try(spn_cli_op(spn_build(host.session)));
   return spn_cli_op(spn_run_tests(host.session));
@@ -58,7 +58,7 @@ sp_cli_result_t spn_cli_parse_profile(sp_cli_t* cli, spn_profile_override_t* pro
 spn_str_arr_t spn_cli_rest_names(sp_cli_t* cli);
 sp_cli_result_t spn_cli_open(bool project_optional);
 sp_cli_result_t spn_cli_session(sp_cli_t* cli, spn_session_config_t config);
-sp_cli_result_t spn_cli_refresh_indexes();
+sp_cli_result_t spn_cli_refresh_indexes(bool lazy);
 sp_cli_result_t spn_cli_op(spn_op_t* op);
 spn_err_t spn_cli_wait(spn_op_t* op);
 
@@ -838,6 +838,14 @@ static sp_str_t render_event_detail(spn_ctx_t* ctx, sp_mem_t mem, spn_event_t* e
           );
           break;
         }
+        case SPN_ERR_WATCH_FAILED: {
+          sp_fmt_io(
+            &w.base,
+            "failed to watch {.cyan} for changes",
+            sp_fmt_str(get_contextual_path(ctx, mem, event->err.fs.path))
+          );
+          break;
+        }
         case SPN_ERR_PATH_COMPONENT: {
           sp_fmt_io(
             &w.base,
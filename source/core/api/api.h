@@ -4,6 +4,7 @@
 #include "sp.h"
 #include "spn/core.h"
 
+#include "api/journal.h"
 #include "core/types.h"
 #include "paths/types.h"
 
@@ -15,6 +16,8 @@ spn_path_t      spn_api_dir_path(spn_pkg_unit_t* unit, spn_dir_t dir);
 sp_str_t        spn_api_dir(spn_pkg_unit_t* unit, spn_dir_t dir);
 s32             spn_api_copy(sp_str_t from, sp_str_t to);
 s32             spn_api_copy_rooted(spn_pkg_unit_t* unit, spn_dir_t from_dir, sp_str_t from_path, spn_dir_t to_dir, sp_str_t to_path);
+void            spn_api_record(spn_pkg_unit_t* unit, spn_api_call_t call);
+spn_err_t       spn_api_replay(spn_pkg_unit_t* unit, const spn_api_journal_t* journal);
 
 #define SPN_API_LOG(unit, fn_name, args_fmt, ...) \
   spn_event_buffer_push(spn.events, (spn_event_t) { \
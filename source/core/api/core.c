@@ -4,6 +4,7 @@
 #include "spn.h"
 
 #include "api/api.h"
+#include "api/journal.h"
 #include "api/types.h"
 #include "core/core.h"
 #include "core/types.h"
@@ -85,6 +86,21 @@ static spn_path_t api_path(spn_pkg_unit_t* unit, const c8* fn, const c8* path) {
   return spn_path_canonicalize(spn.mem, &spn.roots, made);
 }
 
+#define view(_str) sp_str_view(_str)
+
+// A call through a dep's handle lands on the dep's unit, but it's the running
+// script's package that did it, so it goes in that package's journal
+void spn_api_record(spn_pkg_unit_t* unit, spn_api_call_t call) {
+  spn_pkg_unit_t* caller = spn_wasm_active_unit();
+  if (caller && caller != unit) {
+    call.dep = unit->info->name;
+    unit = caller;
+  }
+  if (unit->journal) {
+    spn_api_journal_push(unit->journal, call);
+  }
+}
+
 static spn_target_t* wrap(spn_pkg_unit_t* unit, spn_target_info_t* info) {
   spn_target_t* target = sp_alloc_type(spn.mem, spn_target_t);
   target->unit = unit;
@@ -100,6 +116,7 @@ spn_target_t* spn_get_target(spn_t* spn, const c8* name) {
 
 spn_target_t* spn_add_exe(spn_config_t* config, const c8* name) {
   spn_pkg_unit_t* unit = spn_api_unit(config);
+  spn_api_record(unit, (spn_api_call_t) { .kind = SPN_API_CALL_ADD_EXE, .strs = { view(name) } });
   return wrap(unit, spn_pkg_add_exe(unit->info, name));
 }
 
@@ -107,16 +124,19 @@ spn_target_t* spn_add_lib(spn_config_t* config, const c8* name, spn_linkage_t ki
   spn_linkage_set_t linkages = sp_zero;
   spn_linkage_set_add(&linkages, kind);
   spn_pkg_unit_t* unit = spn_api_unit(config);
+  spn_api_record(unit, (spn_api_call_t) { .kind = SPN_API_CALL_ADD_LIB, .args = { kind }, .strs = { view(name) } });
   return wrap(unit, spn_pkg_add_lib_ex(unit->info, spn_intern_cstr(name), linkages));
 }
 
 spn_target_t* spn_add_test(spn_config_t* config, const c8* name) {
   spn_pkg_unit_t* unit = spn_api_unit(config);
+  spn_api_record(unit, (spn_api_call_t) { .kind = SPN_API_CALL_ADD_TEST, .strs = { view(name) } });
   return wrap(unit, spn_pkg_add_test(unit->info, name));
 }
 
 void spn_add_include(spn_config_t* config, const c8* path) {
   spn_pkg_unit_t* unit = spn_api_unit(config);
+  spn_api_record(unit, (spn_api_call_t) { .kind = SPN_API_CALL_ADD_INCLUDE, .strs = { view(path) } });
   spn_path_t made = api_path(unit, "spn_add_include", path);
   if (spn_path_empty(made)) {
     return;
@@ -125,11 +145,15 @@ void spn_add_include(spn_config_t* config, const c8* path) {
 }
 
 void spn_add_define(spn_config_t* config, const c8* define) {
-  spn_pkg_add_define(spn_api_unit(config)->info, define);
+  spn_pkg_unit_t* unit = spn_api_unit(config);
+  spn_api_record(unit, (spn_api_call_t) { .kind = SPN_API_CALL_ADD_DEFINE, .strs = { view(define) } });
+  spn_pkg_add_define(unit->info, define);
 }
 
 void spn_add_system_dep(spn_config_t* config, const c8* dep) {
-  spn_pkg_add_system_dep(spn_api_unit(config)->info, dep);
+  spn_pkg_unit_t* unit = spn_api_unit(config);
+  spn_api_record(unit, (spn_api_call_t) { .kind = SPN_API_CALL_ADD_SYSTEM_DEP, .strs = { view(dep) } });
+  spn_pkg_add_system_dep(unit->info, dep);
 }
 
 const spn_t* spn_get_dep(const spn_t* s, const c8* name) {
@@ -166,6 +190,7 @@ const c8* spn_get_subdir(const spn_t* s, spn_dir_t base, const c8* path) {
 
 void spn_log(spn_t* s, const c8* message) {
   spn_pkg_unit_t* unit = spn_api_unit(s);
+  spn_api_record(unit, (spn_api_call_t) { .kind = SPN_API_CALL_LOG, .strs = { view(message) } });
   spn_event_buffer_push(spn.events, (spn_event_t) {
     .kind = SPN_EVENT_USER_LOG,
     .pkg = unit->info->name,
@@ -179,6 +204,7 @@ void spn_write_file(spn_t* s, const c8* path, const c8* content) {
     return;
   }
   SPN_API_LOG(unit, "spn_write_file", "{}", SP_FMT_CSTR(path));
+  spn_api_record(unit, (spn_api_call_t) { .kind = SPN_API_CALL_WRITE_FILE, .strs = { view(path), view(content) } });
 
   sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
   spn_path_t joined = spn_path_join(scratch.mem, unit->paths.work, sp_str_view(path));
@@ -262,6 +288,7 @@ s32 spn_copy(spn_t* s, spn_dir_t from_dir, const c8* from_path, spn_dir_t to_dir
   if (spn_api_path_rejected(unit, "spn_copy", sp_str_view(from_path)) || spn_api_path_rejected(unit, "spn_copy", sp_str_view(to_path))) {
     return SPN_ERROR;
   }
+  spn_api_record(unit, (spn_api_call_t) { .kind = SPN_API_CALL_COPY, .args = { from_dir, to_dir }, .strs = { view(from_path), view(to_path) } });
   return spn_api_copy_rooted(unit, from_dir, sp_cstr_as_str(from_path), to_dir, sp_cstr_as_str(to_path));
 }
 
@@ -291,6 +318,7 @@ spn_sanitizer_set_t spn_profile_get_sanitizers(spn_profile_t* profile) {
 }
 
 void spn_target_add_source(spn_target_t* target, const c8* source) {
+  spn_api_record(target->unit, (spn_api_call_t) { .kind = SPN_API_CALL_TARGET_ADD_SOURCE, .strs = { target->info->name, view(source) } });
   spn_path_t made = api_path(target->unit, "spn_target_add_source", source);
   if (spn_path_empty(made)) {
     return;
@@ -299,6 +327,7 @@ void spn_target_add_source(spn_target_t* target, const c8* source) {
 }
 
 void spn_target_add_include(spn_target_t* target, const c8* include) {
+  spn_api_record(target->unit, (spn_api_call_t) { .kind = SPN_API_CALL_TARGET_ADD_INCLUDE, .strs = { target->info->name, view(include) } });
   spn_path_t made = api_path(target->unit, "spn_target_add_include", include);
   if (spn_path_empty(made)) {
     return;
@@ -307,31 +336,138 @@ void spn_target_add_include(spn_target_t* target, const c8* include) {
 }
 
 void spn_target_add_define(spn_target_t* target, const c8* define) {
+  spn_api_record(target->unit, (spn_api_call_t) { .kind = SPN_API_CALL_TARGET_ADD_DEFINE, .strs = { target->info->name, view(define) } });
   sp_da_push(target->info->define, spn_intern_cstr(define));
 }
 
 void spn_target_add_flag(spn_target_t* target, const c8* flag) {
+  spn_api_record(target->unit, (spn_api_call_t) { .kind = SPN_API_CALL_TARGET_ADD_FLAG, .strs = { target->info->name, view(flag) } });
   sp_da_push(target->info->flags, spn_intern_cstr(flag));
 }
 
 // Channel a little bit of Arthur himself to get these wrappers to fit on one line on my editor
-#define view(_str) sp_str_view(_str)
 #define DATA_T SP_EMBED_DEFAULT_DATA_T_S
 #define SIZE_T SP_EMBED_DEFAULT_SIZE_T_S
 void spn_target_embed_file(spn_target_t* t, const c8* file) {
+  spn_api_record(t->unit, (spn_api_call_t) { .kind = SPN_API_CALL_TARGET_EMBED_FILE, .strs = { t->info->name, view(file) } });
   spn_path_t made = api_path(t->unit, "spn_target_embed_file", file);
   if (spn_path_empty(made)) return;
   spn_target_embed_file_ex_s(t->info, made, SP_EMBED_DEFAULT_SYMBOL_S, DATA_T, SIZE_T);
 }
 
 void spn_target_embed_file_ex(spn_target_t* t, const c8* f, const c8* s, const c8* d_t, const c8* s_t) {
+  spn_api_record(t->unit, (spn_api_call_t) { .kind = SPN_API_CALL_TARGET_EMBED_FILE_EX, .strs = { t->info->name, view(f), view(s), view(d_t), view(s_t) } });
   spn_path_t made = api_path(t->unit, "spn_target_embed_file_ex", f);
   if (spn_path_empty(made)) return;
   spn_target_embed_file_ex_s(t->info, made, view(s), view(d_t), view(s_t));
 }
 
 void spn_target_embed_dir_ex(spn_target_t* t, const c8* d, const c8* dest, const c8* d_t, const c8* s_t) {
+  spn_api_record(t->unit, (spn_api_call_t) { .kind = SPN_API_CALL_TARGET_EMBED_DIR_EX, .strs = { t->info->name, view(d), view(dest), view(d_t), view(s_t) } });
   spn_path_t made = api_path(t->unit, "spn_target_embed_dir_ex", d);
   if (spn_path_empty(made) || spn_api_path_rejected(t->unit, "spn_target_embed_dir_ex", view(dest))) return;
   spn_target_embed_dir_ex_s(t->info, made, view(dest), view(d_t), view(s_t));
 }
+
+static spn_node_t* replay_node(sp_mem_t mem, spn_pkg_unit_t* unit, u32 index) {
+  if (index >= sp_da_size(unit->user_nodes)) {
+    return SP_NULLPTR;
+  }
+  spn_node_t* node = sp_alloc_type(mem, spn_node_t);
+  node->ref = (spn_node_ref_t) { .pkg = unit, .index = index };
+  return node;
+}
+
+static spn_err_t replay_call(sp_mem_t mem, spn_pkg_unit_t* unit, const spn_api_call_t* call, const c8** strs) {
+  spn_t* ctx = sp_ptr_cast(spn_t*, unit);
+  spn_config_t* config = sp_ptr_cast(spn_config_t*, unit);
+
+  switch (call->kind) {
+    case SPN_API_CALL_ADD_EXE:        spn_add_exe(config, strs[0]); return SPN_OK;
+    case SPN_API_CALL_ADD_LIB:        spn_add_lib(config, strs[0], (spn_linkage_t)call->args[0]); return SPN_OK;
+    case SPN_API_CALL_ADD_TEST:       spn_add_test(config, strs[0]); return SPN_OK;
+    case SPN_API_CALL_ADD_INCLUDE:    spn_add_include(config, strs[0]); return SPN_OK;
+    case SPN_API_CALL_ADD_DEFINE:     spn_add_define(config, strs[0]); return SPN_OK;
+    case SPN_API_CALL_ADD_SYSTEM_DEP: spn_add_system_dep(config, strs[0]); return SPN_OK;
+    case SPN_API_CALL_ADD_NODE:       spn_add_node(config, strs[0]); return SPN_OK;
+    case SPN_API_CALL_WRITE_FILE:     spn_write_file(ctx, strs[0], strs[1]); return SPN_OK;
+    case SPN_API_CALL_LOG:            spn_log(ctx, strs[0]); return SPN_OK;
+    case SPN_API_CALL_COPY: {
+      return spn_copy(ctx, (spn_dir_t)call->args[0], strs[0], (spn_dir_t)call->args[1], strs[1]) ? SPN_ERROR : SPN_OK;
+    }
+    case SPN_API_CALL_NODE_ADD_INPUT:
+    case SPN_API_CALL_NODE_ADD_OUTPUT:
+    case SPN_API_CALL_NODE_SET_FN: {
+      spn_node_t* node = replay_node(mem, unit, call->args[0]);
+      if (!node) return SPN_ERROR;
+      if (call->kind == SPN_API_CALL_NODE_ADD_INPUT) spn_node_add_input(node, strs[0]);
+      if (call->kind == SPN_API_CALL_NODE_ADD_OUTPUT) spn_node_add_output(node, strs[0]);
+      if (call->kind == SPN_API_CALL_NODE_SET_FN) spn_node_set_fn(node, strs[0]);
+      return SPN_OK;
+    }
+    case SPN_API_CALL_NODE_LINK: {
+      spn_node_t* from = replay_node(mem, unit, call->args[0]);
+      spn_node_t* to = replay_node(mem, unit, call->args[1]);
+      if (!from || !to) return SPN_ERROR;
+      spn_node_link(from, to);
+      return SPN_OK;
+    }
+    case SPN_API_CALL_TARGET_ADD_SOURCE:
+    case SPN_API_CALL_TARGET_ADD_INCLUDE:
+    case SPN_API_CALL_TARGET_ADD_DEFINE:
+    case SPN_API_CALL_TARGET_ADD_FLAG:
+    case SPN_API_CALL_TARGET_EMBED_FILE:
+    case SPN_API_CALL_TARGET_EMBED_FILE_EX:
+    case SPN_API_CALL_TARGET_EMBED_DIR_EX: {
+      spn_target_t* target = spn_get_target(ctx, strs[0]);
+      if (!target) return SPN_ERROR;
+      switch (call->kind) {
+        case SPN_API_CALL_TARGET_ADD_SOURCE:    spn_target_add_source(target, strs[1]); break;
+        case SPN_API_CALL_TARGET_ADD_INCLUDE:   spn_target_add_include(target, strs[1]); break;
+        case SPN_API_CALL_TARGET_ADD_DEFINE:    spn_target_add_define(target, strs[1]); break;
+        case SPN_API_CALL_TARGET_ADD_FLAG:      spn_target_add_flag(target, strs[1]); break;
+        case SPN_API_CALL_TARGET_EMBED_FILE:    spn_target_embed_file(target, strs[1]); break;
+        case SPN_API_CALL_TARGET_EMBED_FILE_EX: spn_target_embed_file_ex(target, strs[1], strs[2], strs[3], strs[4]); break;
+        case SPN_API_CALL_TARGET_EMBED_DIR_EX:  spn_target_embed_dir_ex(target, strs[1], strs[2], strs[3], strs[4]); break;
+        default: break;
+      }
+      return SPN_OK;
+    }
+    case SPN_API_CALL_COUNT: {
+      break;
+    }
+  }
+
+  SP_UNREACHABLE_RETURN(SPN_ERROR);
+}
+
+// Calls go back through the public API so a replayed configure validates and
+// mutates the unit exactly like the live one did
+spn_err_t spn_api_replay(spn_pkg_unit_t* unit, const spn_api_journal_t* journal) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  spn_err_t err = SPN_OK;
+  sp_da_for(journal->calls, it) {
+    const spn_api_call_t* call = &journal->calls[it];
+    const c8* strs [SPN_API_CALL_MAX_STRS] = sp_zero;
+    sp_for(st, SPN_API_CALL_MAX_STRS) {
+      strs[st] = sp_str_to_cstr(scratch.mem, call->strs[st]);
+    }
+
+    spn_pkg_unit_t* target = unit;
+    if (!sp_str_empty(call->dep)) {
+      const spn_t* dep = spn_get_dep(sp_ptr_cast(spn_t*, unit), sp_str_to_cstr(scratch.mem, call->dep));
+      if (!dep) {
+        err = SPN_ERROR;
+        break;
+      }
+      target = spn_api_unit(dep);
+    }
+
+    err = replay_call(spn.mem, target, call, strs);
+    if (err) {
+      break;
+    }
+  }
+  sp_mem_end_scratch(scratch);
+  return err;
+}
@@ -0,0 +1,140 @@
+#include "sp.h"
+#include "sp/io.h"
+#include "sp/atomic_file.h"
+
+#include "api/journal.h"
+
+#define SPN_API_JOURNAL_VERSION '2'
+
+static bool row_lit(sp_str_t* cursor, c8 c) {
+  if (!cursor->len || cursor->data[0] != c) {
+    return false;
+  }
+  cursor->data++;
+  cursor->len--;
+  return true;
+}
+
+static bool row_u64(sp_str_t* cursor, u64* out) {
+  u64 value = 0;
+  u32 digits = 0;
+  while (cursor->len && cursor->data[0] >= '0' && cursor->data[0] <= '9') {
+    value = value * 10 + (u64)(cursor->data[0] - '0');
+    cursor->data++;
+    cursor->len--;
+    digits++;
+  }
+  if (!digits) {
+    return false;
+  }
+  *out = value;
+  return true;
+}
+
+static bool row_u32(sp_str_t* cursor, u32* out) {
+  u64 value = 0;
+  if (!row_u64(cursor, &value) || value > 0xffffffff) {
+    return false;
+  }
+  *out = (u32)value;
+  return true;
+}
+
+static bool row_str(sp_str_t* cursor, sp_str_t* out) {
+  u64 len = 0;
+  if (!row_u64(cursor, &len) || !row_lit(cursor, ':') || cursor->len < len) {
+    return false;
+  }
+  *out = sp_str(cursor->data, (u32)len);
+  cursor->data += len;
+  cursor->len -= (u32)len;
+  return true;
+}
+
+// kind len:dep arg arg count len:str...
+static bool parse_call(sp_str_t* cursor, spn_api_call_t* call) {
+  u32 kind = 0;
+  u32 count = 0;
+  if (!row_u32(cursor, &kind) || kind >= SPN_API_CALL_COUNT) return false;
+  call->kind = (spn_api_call_kind_t)kind;
+  if (!row_lit(cursor, ' ') || !row_str(cursor, &call->dep)) return false;
+  sp_for(it, SPN_API_CALL_MAX_ARGS) {
+    if (!row_lit(cursor, ' ') || !row_u32(cursor, &call->args[it])) return false;
+  }
+  if (!row_lit(cursor, ' ') || !row_u32(cursor, &count) || count > SPN_API_CALL_MAX_STRS) return false;
+  sp_for(it, count) {
+    if (!row_lit(cursor, ' ') || !row_str(cursor, &call->strs[it])) return false;
+  }
+  return row_lit(cursor, '\n');
+}
+
+static spn_err_t write_call(sp_io_writer_t* io, const spn_api_call_t* call) {
+  u32 count = SPN_API_CALL_MAX_STRS;
+  while (count && !call->strs[count - 1].data) {
+    count--;
+  }
+  if (sp_fmt_io(io, "{} {}:{} {} {} {}", sp_fmt_uint(call->kind), sp_fmt_uint(call->dep.len), sp_fmt_str(call->dep), sp_fmt_uint(call->args[0]), sp_fmt_uint(call->args[1]), sp_fmt_uint(count))) {
+    return SPN_ERROR;
+  }
+  sp_for(it, count) {
+    sp_str_t str = call->strs[it];
+    if (sp_fmt_io(io, " {}:{}", sp_fmt_uint(str.len), sp_fmt_str(str))) {
+      return SPN_ERROR;
+    }
+  }
+  return sp_io_write(io, "\n", 1, SP_NULLPTR) ? SPN_ERROR : SPN_OK;
+}
+
+void spn_api_journal_init(spn_api_journal_t* journal, sp_mem_t mem) {
+  journal->mem = mem;
+  sp_da_init(mem, journal->calls);
+}
+
+void spn_api_journal_push(spn_api_journal_t* journal, spn_api_call_t call) {
+  call.dep = sp_str_copy(journal->mem, call.dep);
+  sp_for(it, SPN_API_CALL_MAX_STRS) {
+    if (call.strs[it].data) {
+      call.strs[it] = sp_str_copy(journal->mem, call.strs[it]);
+    }
+  }
+  sp_da_push(journal->calls, call);
+}
+
+spn_err_t spn_api_journal_write(spn_api_journal_t* journal, sp_str_t path) {
+  sp_mem_arena_marker_t s = sp_mem_begin_scratch();
+  sp_io_dyn_mem_writer_t sink = sp_zero;
+  sp_io_dyn_mem_writer_init(s.mem, &sink);
+
+  c8 header [2] = { SPN_API_JOURNAL_VERSION, '\n' };
+  spn_err_t err = sp_io_write(&sink.base, header, sizeof(header), SP_NULLPTR) ? SPN_ERROR : SPN_OK;
+  sp_da_for(journal->calls, it) {
+    if (err) {
+      break;
+    }
+    err = write_call(&sink.base, &journal->calls[it]);
+  }
+  if (!err && sp_fs_write_atomic(path, sp_io_dyn_mem_writer_as_str(&sink))) {
+    err = SPN_ERROR;
+  }
+
+  sp_mem_end_scratch(s);
+  return err;
+}
+
+spn_err_t spn_api_journal_read(spn_api_journal_t* journal, sp_str_t path) {
+  sp_str_t cursor = sp_zero;
+  if (sp_io_read_file(journal->mem, path, &cursor)) {
+    return SPN_ERROR;
+  }
+  if (!row_lit(&cursor, SPN_API_JOURNAL_VERSION) || !row_lit(&cursor, '\n')) {
+    return SPN_ERROR;
+  }
+  while (cursor.len) {
+    spn_api_call_t call = sp_zero;
+    if (!parse_call(&cursor, &call)) {
+      return SPN_ERROR;
+    }
+    sp_da_push(journal->calls, call);
+  }
+  return SPN_OK;
+}
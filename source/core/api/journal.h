@@ -0,0 +1,60 @@
+#ifndef SPN_API_JOURNAL_H
+#define SPN_API_JOURNAL_H
+
+#include "sp.h"
+#include "spn/core.h"
+
+#include "core/types.h"
+
+typedef enum {
+  SPN_API_CALL_ADD_EXE,
+  SPN_API_CALL_ADD_LIB,
+  SPN_API_CALL_ADD_TEST,
+  SPN_API_CALL_ADD_INCLUDE,
+  SPN_API_CALL_ADD_DEFINE,
+  SPN_API_CALL_ADD_SYSTEM_DEP,
+  SPN_API_CALL_ADD_NODE,
+  SPN_API_CALL_NODE_ADD_INPUT,
+  SPN_API_CALL_NODE_ADD_OUTPUT,
+  SPN_API_CALL_NODE_LINK,
+  SPN_API_CALL_NODE_SET_FN,
+  SPN_API_CALL_TARGET_ADD_SOURCE,
+  SPN_API_CALL_TARGET_ADD_INCLUDE,
+  SPN_API_CALL_TARGET_ADD_DEFINE,
+  SPN_API_CALL_TARGET_ADD_FLAG,
+  SPN_API_CALL_TARGET_EMBED_FILE,
+  SPN_API_CALL_TARGET_EMBED_FILE_EX,
+  SPN_API_CALL_TARGET_EMBED_DIR_EX,
+  SPN_API_CALL_WRITE_FILE,
+  SPN_API_CALL_COPY,
+  SPN_API_CALL_LOG,
+  SPN_API_CALL_COUNT,
+} spn_api_call_kind_t;
+
+#define SPN_API_CALL_MAX_ARGS 2
+#define SPN_API_CALL_MAX_STRS 5
+
+// One mutating build script API call. Nodes are referenced by index into the
+// package's user nodes and targets by name, so a call means the same thing
+// when it's replayed against a fresh unit. A call made through a dep's handle
+// names the dep, and is replayed through the same handle
+typedef struct {
+  spn_api_call_kind_t kind;
+  sp_str_t dep;
+  u32 args [SPN_API_CALL_MAX_ARGS];
+  sp_str_t strs [SPN_API_CALL_MAX_STRS];
+} spn_api_call_t;
+
+// Everything a configure script did to its package, in order. A configure
+// restored from the action cache replays this instead of running the script
+typedef struct spn_api_journal_t {
+  sp_mem_t mem;
+  sp_da(spn_api_call_t) calls;
+} spn_api_journal_t;
+
+void      spn_api_journal_init(spn_api_journal_t* journal, sp_mem_t mem);
+void      spn_api_journal_push(spn_api_journal_t* journal, spn_api_call_t call);
+spn_err_t spn_api_journal_write(spn_api_journal_t* journal, sp_str_t path);
+spn_err_t spn_api_journal_read(spn_api_journal_t* journal, sp_str_t path);
+
+#endif
@@ -3,6 +3,7 @@
 #include "spn.h"
 
 #include "api/api.h"
+#include "api/journal.h"
 #include "api/types.h"
 #include "ctx/types.h"
 #include "event/types.h"
@@ -17,6 +18,7 @@
 spn_node_t* spn_add_node(spn_config_t* config, const c8* tag) {
   spn_pkg_unit_t* unit = spn_api_unit(config);
   SPN_API_LOG(unit, "spn_add_node", "{}", SP_FMT_CSTR(tag));
+  spn_api_record(unit, (spn_api_call_t) { .kind = SPN_API_CALL_ADD_NODE, .strs = { sp_str_view(tag) } });
 
   sp_mem_t mem = spn.mem;
   u32 index = sp_da_size(unit->user_nodes);
@@ -43,6 +45,7 @@ spn_node_t* spn_add_node(spn_config_t* config, const c8* tag) {
 void spn_node_add_input(spn_node_t* node, const c8* input) {
   spn_user_node_t* info = spn_node_deref(node->ref);
   SPN_API_LOG(node->ref.pkg, "spn_node_add_input", "{}, {}", SP_FMT_STR(info->tag), SP_FMT_CSTR(input));
+  spn_api_record(node->ref.pkg, (spn_api_call_t) { .kind = SPN_API_CALL_NODE_ADD_INPUT, .args = { node->ref.index }, .strs = { sp_str_view(input) } });
   spn_path_t made = spn_api_tree_path(node->ref.pkg, "spn_node_add_input", input);
   if (spn_path_empty(made)) {
     return;
@@ -53,6 +56,7 @@ void spn_node_add_input(spn_node_t* node, const c8* input) {
 void spn_node_add_output(spn_node_t* node, const c8* output) {
   spn_user_node_t* info = spn_node_deref(node->ref);
   SPN_API_LOG(node->ref.pkg, "spn_node_add_output", "{}, {}", SP_FMT_STR(info->tag), SP_FMT_CSTR(output));
+  spn_api_record(node->ref.pkg, (spn_api_call_t) { .kind = SPN_API_CALL_NODE_ADD_OUTPUT, .args = { node->ref.index }, .strs = { sp_str_view(output) } });
   spn_path_t made = spn_api_tree_path(node->ref.pkg, "spn_node_add_output", output);
   if (spn_path_empty(made)) {
     return;
@@ -63,11 +67,13 @@ void spn_node_add_output(spn_node_t* node, const c8* output) {
 void spn_node_link(spn_node_t* from, spn_node_t* to) {
   spn_user_node_t* info = spn_node_deref(to->ref);
   SPN_API_LOG(to->ref.pkg, "spn_node_link", "{} -> {}", SP_FMT_STR(spn_node_deref(from->ref)->tag), SP_FMT_STR(info->tag));
+  spn_api_record(to->ref.pkg, (spn_api_call_t) { .kind = SPN_API_CALL_NODE_LINK, .args = { from->ref.index, to->ref.index } });
   sp_da_push(info->deps, from->ref);
 }
 
 void spn_node_set_fn(spn_node_t* node, const c8* fn) {
   spn_user_node_t* info = spn_node_deref(node->ref);
   SPN_API_LOG(node->ref.pkg, "spn_node_set_fn", "{}, {}", SP_FMT_STR(info->tag), SP_FMT_CSTR(fn));
+  spn_api_record(node->ref.pkg, (spn_api_call_t) { .kind = SPN_API_CALL_NODE_SET_FN, .args = { node->ref.index }, .strs = { sp_str_view(fn) } });
   info->fn = spn_intern_cstr(fn);
 }
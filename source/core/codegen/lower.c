@@ -165,6 +165,10 @@ static spn_target_info_t lower_metaprogram(spn_toml_loader_t* ctx, const spn_cg_
     .kind = kind,
     .define = cg->define,
     .flags = cg->flags,
+    .wasm = {
+      .stack = sp_opt_is_null(cg->stack_size) ? 0 : sp_opt_get(cg->stack_size),
+      .heap = sp_opt_is_null(cg->heap_size) ? 0 : sp_opt_get(cg->heap_size),
+    },
     .gated = {
       .source = lower_gated_sources(ctx, cg->source, false),
       .include = lower_gated_sources(ctx, cg->include, true),
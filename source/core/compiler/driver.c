@@ -245,6 +245,12 @@ spn_err_t spn_cc_validate_archive(const spn_cc_toolchain_t* toolchain, const spn
   return SPN_OK;
 }
 
+// Thin archives only exist in the GNU format; ld64 can't read them, and
+// lib.exe has no equivalent
+bool spn_cc_supports_thin_archive(const spn_cc_toolchain_t* toolchain, const spn_profile_info_t* profile) {
+  return toolchain->archiver_driver == SPN_AR_DRIVER_GNU && profile->os != SPN_OS_MACOS;
+}
+
 spn_err_t spn_cc_render_archive(sp_mem_t mem, const spn_cc_toolchain_t* toolchain, const spn_profile_info_t* profile, const spn_cc_archive_files_t* files, spn_invocation_t* invocation) {
   sp_assert(!spn_path_empty(files->output));
   spn_try(spn_cc_validate_archive(toolchain, profile));
@@ -170,7 +170,33 @@ void spn_gnu_render_compile(sp_mem_t mem, const spn_cc_toolchain_t* toolchain, c
   spn_cc_push_c(mem, invocation, "-Werror=return-type");
 }
 
+// Rewrite every root to a fixed label in debug info and __FILE__, so the
+// object is byte-identical no matter where the project, store, or toolchain
+// live on disk. Both GCC and Clang let the last matching map win, so emit
+// shortest roots first to let nested roots take precedence.
+static void push_prefix_maps(sp_mem_t mem, const spn_path_roots_t* roots, spn_invocation_t* invocation) {
+  u32 order [SPN_PATH_ROOT_COUNT] = sp_zero;
+  u32 count = 0;
+  for (u32 it = SPN_PATH_ROOT_NONE + 1; it < SPN_PATH_ROOT_COUNT; it++) {
+    if (sp_str_empty(roots->dirs[it])) continue;
+    u32 at = count++;
+    while (at && roots->dirs[order[at - 1]].len > roots->dirs[it].len) {
+      order[at] = order[at - 1];
+      at--;
+    }
+    order[at] = it;
+  }
+
+  sp_for(it, count) {
+    spn_path_root_t root = (spn_path_root_t)order[it];
+    spn_cc_push_fmt(mem, invocation, "-ffile-prefix-map={}=/spn/{}", sp_fmt_str(roots->dirs[root]), sp_fmt_str(spn_path_root_label(root)));
+  }
+}
+
 void spn_gnu_render_compile_files(sp_mem_t mem, const spn_cc_toolchain_t* toolchain, const spn_profile_info_t* profile, const spn_cc_compile_files_t* files, spn_invocation_t* invocation) {
+  if (files->relocate) {
+    push_prefix_maps(mem, files->relocate, invocation);
+  }
   spn_cc_push_path(mem, invocation, files->source);
   if (!spn_path_empty(files->depfile)) {
     spn_cc_push_c(mem, invocation, "-MD");
@@ -311,6 +337,9 @@ void spn_gnu_render_link(sp_mem_t mem, const spn_cc_toolchain_t* toolchain, cons
 void spn_gnu_render_archive(sp_mem_t mem, const spn_cc_toolchain_t* toolchain, const spn_cc_archive_files_t* files, spn_invocation_t* invocation) {
   invocation->program = toolchain->archiver.program;
   spn_cc_push_strs(mem, invocation, toolchain->archiver.args);
+  if (files->thin) {
+    spn_cc_push_c(mem, invocation, "--thin");
+  }
   spn_cc_push_c(mem, invocation, "rcs");
   spn_cc_push_path(mem, invocation, files->output);
   spn_cc_push_paths(mem, invocation, files->objects);
@@ -0,0 +1,263 @@
+#include "compiler/symtab.h"
+
+#include "sp/macro.h"
+
+typedef struct {
+  const u8* data;
+  u64 size;
+  bool big;
+} symtab_view_t;
+
+static bool symtab_has(const symtab_view_t* v, u64 offset, u64 len) {
+  return offset <= v->size && len <= v->size - offset;
+}
+
+static u16 symtab_u16(const symtab_view_t* v, u64 offset) {
+  const u8* p = v->data + offset;
+  return v->big ? (u16)((p[0] << 8) | p[1]) : (u16)((p[1] << 8) | p[0]);
+}
+
+static u32 symtab_u32(const symtab_view_t* v, u64 offset) {
+  const u8* p = v->data + offset;
+  return v->big ?
+    ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | (u32)p[3] :
+    ((u32)p[3] << 24) | ((u32)p[2] << 16) | ((u32)p[1] << 8) | (u32)p[0];
+}
+
+static u64 symtab_u64(const symtab_view_t* v, u64 offset) {
+  u64 lo = symtab_u32(v, offset + (v->big ? 4 : 0));
+  u64 hi = symtab_u32(v, offset + (v->big ? 0 : 4));
+  return (hi << 32) | lo;
+}
+
+// A NUL-terminated name inside [base, base + size)
+static bool symtab_name(const symtab_view_t* v, u64 base, u64 size, u64 offset, sp_str_t* name) {
+  if (offset >= size || !symtab_has(v, base, size)) {
+    return false;
+  }
+  const c8* start = (const c8*)v->data + base + offset;
+  u64 len = 0;
+  while (offset + len < size && start[len]) {
+    len++;
+  }
+  if (offset + len == size || !len) {
+    return false;
+  }
+  *name = sp_str(start, (u32)len);
+  return true;
+}
+
+spn_symtab_format_t spn_symtab_detect(const u8* data, u64 size) {
+  if (size >= 16 && data[0] == 0x7f && data[1] == 'E' && data[2] == 'L' && data[3] == 'F') {
+    return SPN_SYMTAB_FORMAT_ELF;
+  }
+  if (size >= 32 && data[0] == 0xcf && data[1] == 0xfa && data[2] == 0xed && data[3] == 0xfe) {
+    return SPN_SYMTAB_FORMAT_MACHO;
+  }
+  if (size >= 20) {
+    u16 machine = (u16)(data[0] | (data[1] << 8));
+    switch (machine) {
+      case 0x014c: // i386
+      case 0x8664: // amd64
+      case 0x01c4: // armnt
+      case 0xaa64: { // arm64
+        return SPN_SYMTAB_FORMAT_COFF;
+      }
+      default: {
+        break;
+      }
+    }
+  }
+  return SPN_SYMTAB_FORMAT_NONE;
+}
+
+// ELF
+#define SPN_ELF_SHT_SYMTAB 2
+#define SPN_ELF_STB_LOCAL 0
+#define SPN_ELF_STT_SECTION 3
+#define SPN_ELF_STT_FILE 4
+#define SPN_ELF_SHN_UNDEF 0
+
+static bool symtab_read_elf(const u8* data, u64 size, sp_da(sp_str_t)* symbols) {
+  bool wide = data[4] == 2;
+  if ((data[4] != 1 && data[4] != 2) || (data[5] != 1 && data[5] != 2)) {
+    return false;
+  }
+  symtab_view_t v = { .data = data, .size = size, .big = data[5] == 2 };
+  if (!symtab_has(&v, 0, wide ? 64 : 52)) {
+    return false;
+  }
+
+  u64 shoff = wide ? symtab_u64(&v, 0x28) : symtab_u32(&v, 0x20);
+  u64 shentsize = symtab_u16(&v, wide ? 0x3a : 0x2e);
+  u64 shnum = symtab_u16(&v, wide ? 0x3c : 0x30);
+  if (!shoff || shentsize < (wide ? 64u : 40u) || !symtab_has(&v, shoff, shentsize)) {
+    return false;
+  }
+  // Extended numbering keeps the real count in section 0's sh_size
+  if (!shnum) {
+    shnum = wide ? symtab_u64(&v, shoff + 32) : symtab_u32(&v, shoff + 20);
+  }
+  if (shnum > size / shentsize || !symtab_has(&v, shoff, shnum * shentsize)) {
+    return false;
+  }
+
+  sp_for(section, shnum) {
+    u64 sh = shoff + section * shentsize;
+    if (symtab_u32(&v, sh + 4) != SPN_ELF_SHT_SYMTAB) {
+      continue;
+    }
+    u64 offset = wide ? symtab_u64(&v, sh + 24) : symtab_u32(&v, sh + 16);
+    u64 bytes = wide ? symtab_u64(&v, sh + 32) : symtab_u32(&v, sh + 20);
+    u64 link = symtab_u32(&v, sh + (wide ? 40 : 24));
+    u64 entsize = wide ? symtab_u64(&v, sh + 56) : symtab_u32(&v, sh + 36);
+    if (entsize < (wide ? 24u : 16u) || link >= shnum || !symtab_has(&v, offset, bytes)) {
+      return false;
+    }
+
+    u64 strsh = shoff + link * shentsize;
+    u64 stroff = wide ? symtab_u64(&v, strsh + 24) : symtab_u32(&v, strsh + 16);
+    u64 strsize = wide ? symtab_u64(&v, strsh + 32) : symtab_u32(&v, strsh + 20);
+
+    sp_for(it, bytes / entsize) {
+      u64 sym = offset + it * entsize;
+      u32 name = symtab_u32(&v, sym);
+      u8 info = data[sym + (wide ? 4 : 12)];
+      u16 shndx = symtab_u16(&v, sym + (wide ? 6 : 14));
+      u8 bind = info >> 4;
+      u8 type = info & 0xf;
+      if (bind == SPN_ELF_STB_LOCAL || shndx == SPN_ELF_SHN_UNDEF) {
+        continue;
+      }
+      if (type == SPN_ELF_STT_SECTION || type == SPN_ELF_STT_FILE) {
+        continue;
+      }
+      sp_str_t symbol = sp_zero;
+      if (!symtab_name(&v, stroff, strsize, name, &symbol)) {
+        return false;
+      }
+      sp_da_push(*symbols, symbol);
+    }
+    return true;
+  }
+
+  // No symbol table at all; nothing to export
+  return true;
+}
+
+// COFF
+#define SPN_COFF_SYMBOL_SIZE 18
+#define SPN_COFF_CLASS_EXTERNAL 2
+#define SPN_COFF_CLASS_WEAK_EXTERNAL 105
+
+static bool symtab_read_coff(const u8* data, u64 size, sp_da(sp_str_t)* symbols) {
+  symtab_view_t v = { .data = data, .size = size };
+  u64 symoff = symtab_u32(&v, 8);
+  u64 nsyms = symtab_u32(&v, 12);
+  if (!nsyms) {
+    return true;
+  }
+  if (nsyms > size / SPN_COFF_SYMBOL_SIZE || !symtab_has(&v, symoff, nsyms * SPN_COFF_SYMBOL_SIZE)) {
+    return false;
+  }
+  u64 stroff = symoff + nsyms * SPN_COFF_SYMBOL_SIZE;
+  u64 strsize = symtab_has(&v, stroff, 4) ? symtab_u32(&v, stroff) : 0;
+
+  for (u64 it = 0; it < nsyms; it++) {
+    u64 sym = symoff + it * SPN_COFF_SYMBOL_SIZE;
+    u32 value = symtab_u32(&v, sym + 8);
+    s16 section = (s16)symtab_u16(&v, sym + 12);
+    u8 storage = data[sym + 16];
+    u8 aux = data[sym + 17];
+
+    bool external = storage == SPN_COFF_CLASS_EXTERNAL && (section > 0 || (section == 0 && value));
+    bool weak = storage == SPN_COFF_CLASS_WEAK_EXTERNAL;
+    if (external || weak) {
+      sp_str_t symbol = sp_zero;
+      if (symtab_u32(&v, sym)) {
+        const c8* name = (const c8*)data + sym;
+        u32 len = 0;
+        while (len < 8 && name[len]) {
+          len++;
+        }
+        symbol = sp_str(name, len);
+      }
+      else if (!symtab_name(&v, stroff, strsize, symtab_u32(&v, sym + 4), &symbol)) {
+        return false;
+      }
+      sp_da_push(*symbols, symbol);
+    }
+    it += aux;
+  }
+  return true;
+}
+
+// Mach-O
+#define SPN_MACHO_LC_SYMTAB 0x2
+#define SPN_MACHO_N_STAB 0xe0
+#define SPN_MACHO_N_PEXT 0x10
+#define SPN_MACHO_N_TYPE 0x0e
+#define SPN_MACHO_N_EXT 0x01
+#define SPN_MACHO_N_UNDF 0x0
+
+static bool symtab_read_macho(const u8* data, u64 size, sp_da(sp_str_t)* symbols) {
+  symtab_view_t v = { .data = data, .size = size };
+  u64 ncmds = symtab_u32(&v, 16);
+  u64 cmd = 32;
+
+  sp_for(it, ncmds) {
+    if (!symtab_has(&v, cmd, 8)) {
+      return false;
+    }
+    u32 kind = symtab_u32(&v, cmd);
+    u32 cmdsize = symtab_u32(&v, cmd + 4);
+    if (cmdsize < 8) {
+      return false;
+    }
+    if (kind == SPN_MACHO_LC_SYMTAB) {
+      if (!symtab_has(&v, cmd, 24)) {
+        return false;
+      }
+      u64 symoff = symtab_u32(&v, cmd + 8);
+      u64 nsyms = symtab_u32(&v, cmd + 12);
+      u64 stroff = symtab_u32(&v, cmd + 16);
+      u64 strsize = symtab_u32(&v, cmd + 20);
+      if (!symtab_has(&v, symoff, nsyms * 16)) {
+        return false;
+      }
+      sp_for(st, nsyms) {
+        u64 sym = symoff + st * 16;
+        u8 type = data[sym + 4];
+        u64 value = symtab_u64(&v, sym + 8);
+        if ((type & SPN_MACHO_N_STAB) || !(type & SPN_MACHO_N_EXT)) {
+          continue;
+        }
+        // Private externs can't be exported; ld64 rejects them in a symbol list
+        if (type & SPN_MACHO_N_PEXT) {
+          continue;
+        }
+        if ((type & SPN_MACHO_N_TYPE) == SPN_MACHO_N_UNDF && !value) {
+          continue;
+        }
+        sp_str_t symbol = sp_zero;
+        if (!symtab_name(&v, stroff, strsize, symtab_u32(&v, sym), &symbol)) {
+          return false;
+        }
+        sp_da_push(*symbols, symbol);
+      }
+      return true;
+    }
+    cmd += cmdsize;
+  }
+  return true;
+}
+
+bool spn_symtab_read(const u8* data, u64 size, sp_da(sp_str_t)* symbols) {
+  switch (spn_symtab_detect(data, size)) {
+    case SPN_SYMTAB_FORMAT_ELF: return symtab_read_elf(data, size, symbols);
+    case SPN_SYMTAB_FORMAT_COFF: return symtab_read_coff(data, size, symbols);
+    case SPN_SYMTAB_FORMAT_MACHO: return symtab_read_macho(data, size, symbols);
+    case SPN_SYMTAB_FORMAT_NONE: return false;
+  }
+  sp_unreachable_return(false);
+}
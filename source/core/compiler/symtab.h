@@ -0,0 +1,21 @@
+#ifndef SPN_COMPILER_SYMTAB_H
+#define SPN_COMPILER_SYMTAB_H
+
+#include "sp.h"
+#include "spn/core.h"
+
+typedef enum {
+  SPN_SYMTAB_FORMAT_NONE,
+  SPN_SYMTAB_FORMAT_ELF,
+  SPN_SYMTAB_FORMAT_COFF,
+  SPN_SYMTAB_FORMAT_MACHO,
+} spn_symtab_format_t;
+
+// Reads the symbols an archiver would put in its table of contents (defined,
+// externally visible) straight out of a relocatable object. Symbols point
+// into data. Returns false for anything it doesn't understand (bitcode, wasm,
+// /GL objects, malformed input) so the caller can fall back to the archiver
+spn_symtab_format_t spn_symtab_detect(const u8* data, u64 size);
+bool                spn_symtab_read(const u8* data, u64 size, sp_da(sp_str_t)* symbols);
+
+#endif
@@ -52,6 +52,7 @@ typedef struct {
   spn_path_t source;
   spn_path_t output;
   spn_path_t depfile;
+  const spn_path_roots_t* relocate;
 } spn_cc_compile_files_t;
 
 typedef struct {
@@ -82,6 +83,7 @@ typedef struct {
 typedef struct {
   spn_path_t output;
   sp_da(spn_path_t) objects;
+  bool thin;
 } spn_cc_archive_files_t;
 
 typedef enum {
@@ -4,6 +4,7 @@
 #include "dag/types.h"
 #include "error/error.h"
 #include "intern/intern.h"
+#include "project/types.h"
 
 spn_ctx_t spn;
 
@@ -36,6 +37,12 @@ spn_err_t spn_ctx_require_project(spn_ctx_t* ctx) {
   return SPN_OK;
 }
 
+// Every package reached by resolution is reached through a dep of the root, so
+// a project without any can't ask an index for anything
+bool spn_ctx_uses_indexes(spn_ctx_t* ctx) {
+  return !ctx->project || !sp_da_empty(ctx->project->package.deps);
+}
+
 spn_index_info_t* spn_find_index(spn_ctx_t* ctx, sp_str_t name) {
   if (sp_str_empty(name)) {
     name = sp_str_lit("core");
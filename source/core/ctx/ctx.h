@@ -8,6 +8,12 @@
 
 sp_intern_t* spn_ctx_get_intern();
 spn_err_t spn_ctx_require_project(spn_ctx_t* ctx);
+bool spn_ctx_uses_indexes(spn_ctx_t* ctx);
+
+// Subsystems that only some commands touch are brought up on first use rather
+// than at open; each is a no-op once it has succeeded
+spn_err_t spn_ctx_require_indexes(spn_ctx_t* ctx);
+spn_err_t spn_ctx_require_runtime(spn_ctx_t* ctx);
 spn_index_info_t* spn_find_index(spn_ctx_t* ctx, sp_str_t name);
 
 #endif
@@ -23,6 +23,7 @@
 #include "toolchain/catalog.h"
 #include "toolchain/provision.h"
 #include "version.h"
+#include "watch/watch.h"
 
 static sp_str_t join_path(spn_ctx_t* ctx, sp_str_t base, const c8* dir) {
   return sp_fs_join_path(ctx->heap, base, sp_cstr_as_str(dir));
@@ -96,20 +97,10 @@ static spn_err_t extract_runtime(spn_ctx_t* ctx) {
   sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
   spn_err_t result = SPN_OK;
 
-  // @spader Use SHA256 for this
   // The stamp must change whenever the embedded runtime does, not just on
-  // release; otherwise dev builds compile scripts against a stale extraction
-  sp_hash_t runtime_hash = 0;
-  sp_carr_for(spn_embed_manifest, it) {
-    spn_embed_entry_t entry = spn_embed_manifest[it];
-    sp_hash_t hashes [] = {
-      runtime_hash,
-      sp_hash_cstr(entry.path),
-      sp_hash_bytes(entry.data, entry.size, 0),
-    };
-    runtime_hash = sp_hash_combine(hashes, sp_carr_len(hashes));
-  }
-  sp_str_t stamp = sp_fmt(scratch.mem, "{}:{}", sp_fmt_cstr(SPN_VERSION), sp_fmt_uint(runtime_hash)).value;
+  // release; otherwise dev builds compile scripts against a stale extraction.
+  // The embed tool digests the runtime when spn is built, so this is free.
+  sp_str_t stamp = sp_fmt(scratch.mem, "{}:{}", sp_fmt_cstr(SPN_VERSION), sp_fmt_cstr(spn_embed_digest)).value;
 
   if (!sp_str_equal(read_stamp(scratch.mem, ctx), stamp)) {
     sp_fs_lock_t lock = sp_zero;
@@ -129,8 +120,80 @@ static spn_err_t extract_runtime(spn_ctx_t* ctx) {
   return result;
 }
 
+static spn_err_t load_config(spn_ctx_t* ctx) {
+  ctx->config.indexes = sp_da_new(ctx->heap, spn_index_info_t);
+  if (!sp_fs_exists(ctx->paths.config.toml)) {
+    return SPN_OK;
+  }
+
+  spn_cg_config_t config = sp_zero;
+  spn_toml_loader_t loader = sp_zero;
+  spn_toml_loader_init(&loader, ctx->mem, ctx->intern);
+  spn_err_t loaded = spn_codegen_load_config(&loader, ctx->paths.config.toml, &config);
+  sp_da(spn_index_info_t) indexes = sp_da_new(ctx->heap, spn_index_info_t);
+  if (!loaded) {
+    sp_da_for(config.index, it) {
+      sp_da_push(indexes, spn_index_lower(&loader, it, SPN_INDEX_KIND_USER, &config.index[it]));
+    }
+  }
+  if (loaded || !sp_da_empty(loader.issues)) {
+    return spn_err_emit(ctx, (spn_err_union_t) {
+      .kind = SPN_ERR_MANIFEST_ISSUES,
+      .manifest = { .path = ctx->paths.config.toml, .issues = spn_codegen_issues_to_err(ctx->mem, loader.issues) },
+    });
+  }
+  ctx->config.indexes = indexes;
+  return SPN_OK;
+}
+
+spn_err_t spn_ctx_require_indexes(spn_ctx_t* ctx) {
+  if (ctx->ready.indexes) {
+    return SPN_OK;
+  }
+
+  // The per-machine config only holds indexes, so it's read with them
+  spn_try(load_config(ctx));
+
+  if (sp_fs_create_dir(ctx->paths.index)) {
+    return spn_err_emit(ctx, (spn_err_union_t) {
+      .kind = SPN_ERR_FS_CREATE_DIR,
+      .fs = { .path = ctx->paths.index }
+    });
+  }
+
+  spn_index_assemble(ctx->heap, ctx->project ? &ctx->project->package.indexes : SP_NULLPTR, ctx->config.indexes, &ctx->indexes);
+
+  sp_da_for(ctx->indexes, it) {
+    spn_index_info_t* index = &ctx->indexes[it];
+    index->location = spn_index_location(index, ctx->heap, ctx->paths.index);
+    if (!index->refresh) {
+      index->refresh = ctx->config.index_refresh ? ctx->config.index_refresh : SPN_INDEX_DEFAULT_REFRESH;
+    }
+  }
+
+  ctx->ready.indexes = true;
+  return SPN_OK;
+}
+
+spn_err_t spn_ctx_require_runtime(spn_ctx_t* ctx) {
+  if (ctx->ready.runtime) {
+    return SPN_OK;
+  }
+
+  if (sp_fs_create_dir(ctx->paths.storage)) {
+    return spn_err_emit(ctx, (spn_err_union_t) {
+      .kind = SPN_ERR_FS_CREATE_DIR,
+      .fs = { .path = ctx->paths.storage }
+    });
+  }
+  spn_try(extract_runtime(ctx));
+
+  ctx->ready.runtime = true;
+  return SPN_OK;
+}
+
 static spn_err_t open_ctx(spn_ctx_t* ctx, spn_open_request_t request) {
-  sp_assert(!ctx->config.indexes);
+  sp_assert(sp_str_empty(ctx->paths.project));
 
   if (sp_str_valid(request.dir)) {
     ctx->paths.project = sp_fs_canonicalize_path(ctx->heap, request.dir);
@@ -139,25 +202,10 @@ static spn_err_t open_ctx(spn_ctx_t* ctx, spn_open_request_t request) {
     ctx->paths.project = ctx->paths.cwd;
   }
   ctx->paths.project = spn_path_roots_set(&ctx->roots, ctx->heap, SPN_PATH_ROOT_PROJECT, ctx->paths.project);
+  ctx->config.index_refresh = request.index_refresh_seconds;
 
-  // Make sure any per-machine directories we need exist
-  sp_str_t dirs [] = {
-    ctx->paths.caches.dir,
-    ctx->paths.caches.git.dir,
-    ctx->paths.caches.build.dir,
-    ctx->paths.caches.store.dir,
-    ctx->paths.index,
-    ctx->paths.toolchain,
-  };
-  sp_carr_for(dirs, it) {
-    if (sp_fs_create_dir(dirs[it])) {
-      return spn_err_emit(ctx, (spn_err_union_t) {
-        .kind = SPN_ERR_FS_CREATE_DIR,
-        .fs = { .path = dirs[it] }
-      });
-    }
-  }
-
+  // Nothing here touches the per-machine dirs. The git cache makes its own on
+  // the first clone, and the rest wait for a session or a require
   spn_git_cache_init(&ctx->caches.git, ctx->mem, ctx->intern, ctx->paths.caches.git.dir);
 
   ctx->caches.toolchains = (spn_toolchain_store_t) {
@@ -167,8 +215,6 @@ static spn_err_t open_ctx(spn_ctx_t* ctx, spn_open_request_t request) {
     .fetch = spn_fetch_curl,
   };
 
-  spn_try(extract_runtime(ctx));
-
   spn_event_buffer_push(ctx->events, (spn_event_t) {
     .kind = SPN_EVENT_OPEN,
     .open = {
@@ -177,49 +223,11 @@ static spn_err_t open_ctx(spn_ctx_t* ctx, spn_open_request_t request) {
     },
   });
 
-  // Load the per-machine config file
-  ctx->config.indexes = sp_da_new(ctx->heap, spn_index_info_t);
-  if (sp_fs_exists(ctx->paths.config.toml)) {
-    spn_cg_config_t config = sp_zero;
-    spn_toml_loader_t loader = sp_zero;
-    spn_toml_loader_init(&loader, ctx->mem, ctx->intern);
-    spn_err_t loaded = spn_codegen_load_config(&loader, ctx->paths.config.toml, &config);
-    sp_da(spn_index_info_t) indexes = sp_da_new(ctx->heap, spn_index_info_t);
-    if (!loaded) {
-      sp_da_for(config.index, it) {
-        sp_da_push(indexes, spn_index_lower(&loader, it, SPN_INDEX_KIND_USER, &config.index[it]));
-      }
-    }
-    if (loaded || !sp_da_empty(loader.issues)) {
-      return spn_err_emit(ctx, (spn_err_union_t) {
-        .kind = SPN_ERR_MANIFEST_ISSUES,
-        .manifest = { .path = ctx->paths.config.toml, .issues = spn_codegen_issues_to_err(ctx->mem, loader.issues) },
-      });
-    }
-    ctx->config.indexes = indexes;
-  }
-
   spn_try(spn_project_load(ctx, ctx->paths.project, &ctx->project));
   if (!request.project_optional) {
     spn_try(spn_ctx_require_project(ctx));
   }
 
-  if (ctx->project) {
-    sp_str_om_for(ctx->project->package.toolchains, it) {
-      spn_toolchain_catalog_add(&ctx->catalog, *sp_str_om_at(ctx->project->package.toolchains, it));
-    }
-  }
-
-  spn_index_assemble(ctx->heap, ctx->project ? &ctx->project->package.indexes : SP_NULLPTR, ctx->config.indexes, &ctx->indexes);
-
-  sp_da_for(ctx->indexes, it) {
-    spn_index_info_t* index = &ctx->indexes[it];
-    index->location = spn_index_location(index, ctx->heap, ctx->paths.index);
-    if (!index->refresh) {
-      index->refresh = request.index_refresh_seconds ? request.index_refresh_seconds : SPN_INDEX_DEFAULT_REFRESH;
-    }
-  }
-
   return SPN_OK;
 }
 
@@ -238,9 +246,6 @@ spn_ctx_t* spn_ctx_new(spn_wake_fn_t wake, void* wake_data) {
   ctx->events = spn_event_buffer_new(ctx->mem);
   ctx->events->wake = &ctx->wake;
 
-  sp_str_t builtins = sp_str((const c8*)toolchains_json, toolchains_json_size);
-  sp_assert(spn_toolchain_catalog_init(&ctx->catalog, builtins, ctx->heap) == SPN_OK);
-
   ctx->paths.cwd = sp_fs_get_cwd(ctx->heap);
   ctx->paths.patches = sp_env_get(ctx->env, sp_str_lit("SPN_PATCH_DIR"));
   ctx->paths.config.dir = join_path(ctx, env_or(ctx, "SPN_CONFIG_DIR", sp_fs_get_config_path(ctx->heap)), "spn");
@@ -251,6 +256,7 @@ spn_ctx_t* spn_ctx_new(spn_wake_fn_t wake, void* wake_data) {
         ctx->paths.caches.git.checkouts = join_path(ctx, ctx->paths.caches.git.dir, "checkouts");
       ctx->paths.caches.store.dir = join_path(ctx, ctx->paths.caches.dir, "store");
       ctx->paths.caches.build.dir = join_path(ctx, ctx->paths.caches.dir, "build");
+      ctx->paths.caches.resolve.dir = join_path(ctx, ctx->paths.caches.dir, "resolve");
     ctx->paths.index = join_path(ctx, ctx->paths.storage, "index");
     ctx->paths.runtime = join_path(ctx, ctx->paths.storage, "runtime");
       ctx->paths.version = join_path(ctx, ctx->paths.runtime, "version.stamp");
@@ -263,15 +269,119 @@ spn_ctx_t* spn_ctx_new(spn_wake_fn_t wake, void* wake_data) {
   spn_path_roots_set(&ctx->roots, ctx->heap, SPN_PATH_ROOT_RUNTIME, ctx->paths.runtime);
   ctx->paths.toolchain = spn_path_roots_set(&ctx->roots, ctx->heap, SPN_PATH_ROOT_TOOLCHAIN, env_or(ctx, "SPN_TOOLCHAIN_DIR", join_path(ctx, ctx->paths.caches.dir, "toolchain")));
 
-  spn_op_thread_start(ctx);
   return ctx;
 }
 
 static spn_err_t open_session(spn_ctx_t* ctx, spn_session_config_t config) {
   spn_try(spn_ctx_require_project(ctx));
 
-  ctx->session = sp_alloc_type(ctx->heap, spn_session_t);
-  return spn_session_init(ctx->session, ctx, ctx->heap, ctx->project, config);
+  // Make sure the per-machine directories a build writes into exist
+  sp_str_t dirs [] = {
+    ctx->paths.caches.build.dir,
+    ctx->paths.caches.store.dir,
+    ctx->paths.caches.resolve.dir,
+    ctx->paths.toolchain,
+  };
+  sp_carr_for(dirs, it) {
+    if (sp_fs_create_dir(dirs[it])) {
+      return spn_err_emit(ctx, (spn_err_union_t) {
+        .kind = SPN_ERR_FS_CREATE_DIR,
+        .fs = { .path = dirs[it] }
+      });
+    }
+  }
+
+  // A watch opens a session per pass; the last one goes first, so a pass only
+  // ever holds its own. Its events were drained when its op finished
+  if (ctx->session) {
+    sp_mem_arena_t* arena = ctx->session->arena;
+    spn_session_deinit(ctx->session);
+    sp_mem_arena_destroy(arena);
+    ctx->session = SP_NULLPTR;
+  }
+
+  // Only a session selects toolchains, so only a session needs the catalog.
+  // It's built once per project rather than once per pass
+  if (!ctx->ready.catalog) {
+    sp_str_om_free(ctx->catalog.entries);
+    spn_toolchain_catalog_init_builtins(&ctx->catalog, ctx->heap);
+    sp_str_om_for(ctx->project->package.toolchains, it) {
+      spn_toolchain_catalog_add(&ctx->catalog, *sp_str_om_at(ctx->project->package.toolchains, it));
+    }
+    ctx->ready.catalog = true;
+  }
+
+  sp_mem_arena_t* arena = sp_mem_arena_new(ctx->mem);
+  sp_mem_t mem = sp_mem_arena_as_allocator(arena);
+  ctx->session = sp_alloc_type(mem, spn_session_t);
+  *ctx->session = (spn_session_t) { .arena = arena };
+  return spn_session_init(ctx->session, ctx, mem, ctx->project, config);
+}
+
+spn_err_t spn_ctx_watch(spn_ctx_t* ctx) {
+  spn_try(spn_ctx_require_project(ctx));
+  if (ctx->watch) {
+    return SPN_OK;
+  }
+
+  // Builds write under the session's build dir and rewrite a couple of files
+  // at the root; none of that should ask for another build
+  sp_da(sp_str_t) skip = sp_da_new(ctx->heap, sp_str_t);
+  sp_da_push(skip, join_path(ctx, ctx->paths.project, "build"));
+  sp_da(sp_str_t) quiet = sp_da_new(ctx->heap, sp_str_t);
+  sp_da_push(quiet, join_path(ctx, ctx->paths.project, "compile_commands.json"));
+  sp_da_push(quiet, ctx->project->paths.lock);
+
+  spn_watch_t* watch = sp_alloc_type(ctx->heap, spn_watch_t);
+  spn_watch_config_t config = {
+    .mem = ctx->heap,
+    .roots = &ctx->roots,
+    .root = ctx->paths.project,
+    .manifest = ctx->project->paths.manifest,
+    .skip = skip,
+    .quiet = quiet,
+  };
+  if (spn_watch_init(watch, config)) {
+    return spn_err_emit(ctx, (spn_err_union_t) {
+      .kind = SPN_ERR_WATCH_FAILED,
+      .fs = { .path = ctx->paths.project }
+    });
+  }
+
+  ctx->watch = watch;
+  return SPN_OK;
+}
+
+sp_sys_fd_t spn_ctx_watch_fd(spn_ctx_t* ctx) {
+  sp_assert(ctx->watch);
+  return ctx->watch->fd;
+}
+
+bool spn_ctx_watch_changed(spn_ctx_t* ctx) {
+  spn_watch_changes_t changes = spn_watch_drain(ctx->watch);
+  if (!changes.rebuild) {
+    return false;
+  }
+
+  // A manifest that doesn't load leaves the last good project in place; the
+  // error is reported and the next change gets another try.
+  //
+  // Whatever was read from the old manifest is read again: the indexes on
+  // their next require, the toolchain catalog with the next session. The old
+  // project itself is kept, since the git cache holds ids that point into it;
+  // it's one per edit to spn.toml, not one per pass
+  if (changes.manifest) {
+    spn_project_t* project = SP_NULLPTR;
+    if (spn_project_load(ctx, ctx->paths.project, &project) || !project) {
+      return false;
+    }
+    ctx->project = project;
+    ctx->ready.indexes = false;
+    ctx->ready.catalog = false;
+  }
+
+  spn_watch_settle(ctx->watch);
+  return true;
 }
 
 spn_err_t spn_ctx_open(spn_ctx_t* ctx, spn_open_request_t request) {
@@ -287,6 +397,11 @@ spn_err_t spn_ctx_open_session(spn_ctx_t* ctx, const spn_session_config_t* confi
 void spn_ctx_close(spn_ctx_t* ctx, bool ok) {
   spn_op_thread_stop(ctx);
 
+  if (ctx->watch) {
+    spn_watch_deinit(ctx->watch);
+    ctx->watch = SP_NULLPTR;
+  }
+
   spn_err_t result = SPN_OK;
   if (!ok) {
     result = (spn_err_t)sp_atomic_s32_load(&ctx->error, SP_ATOMIC_SEQ_CST);
@@ -303,7 +418,10 @@ void spn_ctx_close(spn_ctx_t* ctx, bool ok) {
     },
   });
 
-  ctx->session = SP_NULLPTR;
+  if (ctx->session) {
+    spn_session_deinit(ctx->session);
+    ctx->session = SP_NULLPTR;
+  }
 
   spn_lazy_log_close(&ctx->events->log);
 }
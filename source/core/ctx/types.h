@@ -13,18 +13,26 @@
 #include "paths/types.h"
 #include "session/types.h"
 #include "toolchain/types.h"
+#include "watch/types.h"
 
 typedef struct spn_op_t spn_op_t;
 
 struct spn_ctx_t {
   spn_project_t* project;
   spn_session_t* session;
+  spn_watch_t* watch;
   sp_atomic_s32_t error;
   sp_atomic_ptr_t progress;
   sp_da(spn_index_info_t) indexes;
   struct {
     sp_da(spn_index_info_t) indexes;
+    u32 index_refresh;
   } config;
+  struct {
+    bool indexes;
+    bool runtime;
+    bool catalog;
+  } ready;
   spn_event_buffer_t* events;
   sp_intern_t* intern;
   sp_mem_t mem;
@@ -44,6 +52,7 @@ struct spn_ctx_t {
     sp_thread_t thread;
     sp_queue_t queue;
     sp_atomic_u32_t running;
+    bool started;
   } ops;
 
   spn_wake_t wake;
@@ -68,6 +68,7 @@ void                spn_dag_file_cache_flush(spn_dag_file_cache_t* c, sp_str_t p
 void                spn_dag_file_cache_seed(spn_dag_file_cache_t* c, spn_dag_file_meta_t meta);
 void                spn_dag_file_cache_invalidate(spn_dag_file_cache_t* c, spn_path_t path);
 void                spn_dag_file_cache_invalidate_dir(spn_dag_file_cache_t* c, spn_path_t dir);
+void                spn_dag_file_cache_retain_dir(spn_dag_file_cache_t* c, spn_path_t dir);
 void                spn_dag_file_cache_invalidate_all(spn_dag_file_cache_t* c);
 spn_err_t           spn_dag_file_cache_stat(spn_dag_file_cache_t* c, spn_path_t path, sp_sys_file_meta_t* meta);
 spn_err_t           spn_dag_file_cache_digest(spn_dag_file_cache_t* c, spn_path_t path, spn_dag_digest_t* digest);
@@ -106,6 +106,24 @@ void spn_dag_file_cache_invalidate_dir(spn_dag_file_cache_t* c, spn_path_t dir)
   sp_mem_end_scratch(s);
 }
 
+void spn_dag_file_cache_retain_dir(spn_dag_file_cache_t* c, spn_path_t dir) {
+  sp_mem_arena_marker_t s = sp_mem_begin_scratch();
+  sp_mutex_lock(&c->mutex);
+
+  sp_da(spn_path_t) stale = sp_da_new(s.mem, spn_path_t);
+  sp_ht_for_kv(c->metadata, it) {
+    if (!spn_path_within(dir, *it.key).within) {
+      sp_da_push(stale, *it.key);
+    }
+  }
+  sp_da_for(stale, it) {
+    sp_ht_erase(c->metadata, stale[it]);
+  }
+
+  sp_mutex_unlock(&c->mutex);
+  sp_mem_end_scratch(s);
+}
+
 void spn_dag_file_cache_invalidate_all(spn_dag_file_cache_t* c) {
   sp_mutex_lock(&c->mutex);
   sp_ht_clear(c->metadata);
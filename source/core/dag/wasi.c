@@ -36,6 +36,7 @@ struct spn_dag_wasi_t {
   sp_str_ht(u8) writes;
   sp_mem_t obs_mem;
   sp_da(spn_dag_obs_t)* obs;
+  bool observe_writes;
 };
 
 static sp_str_t wasi_guest_path(spn_dag_wasi_t* w, sp_mem_t mem, u32 fd, const c8* path, u32 path_len) {
@@ -89,6 +90,11 @@ static bool wasi_written(spn_dag_wasi_t* w, sp_str_t host) {
 }
 
 static void wasi_record_write(spn_dag_wasi_t* w, sp_str_t host) {
+  // A caller that replays a call instead of rerunning it needs whatever the
+  // call wrote to still be there, so the write becomes an observation too
+  if (w->observe_writes) {
+    wasi_push_obs(w, SPN_DAG_OBS_FILE, host);
+  }
   if (!wasi_written(w, host)) {
     sp_str_ht_insert(w->writes, sp_str_copy(w->mem, host), (u8)true);
   }
@@ -244,13 +250,15 @@ void spn_dag_wasi_bind(spn_dag_wasi_t* w, wasm_module_inst_t instance) {
   wasm_runtime_set_custom_data(instance, w);
 }
 
-void spn_dag_wasi_begin(spn_dag_wasi_t* w, sp_mem_t mem, sp_da(spn_dag_obs_t)* obs) {
+void spn_dag_wasi_begin(spn_dag_wasi_t* w, sp_mem_t mem, sp_da(spn_dag_obs_t)* obs, bool writes) {
   w->obs_mem = mem;
   w->obs = obs;
+  w->observe_writes = writes;
 }
 
 void spn_dag_wasi_end(spn_dag_wasi_t* w) {
   w->obs = SP_NULLPTR;
+  w->observe_writes = false;
 }
 
 static spn_dag_wasi_t* wasi_of(wasm_module_inst_t instance) {
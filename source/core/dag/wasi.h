@@ -16,7 +16,7 @@ typedef struct spn_dag_wasi_t spn_dag_wasi_t;
 spn_err_t       spn_dag_wasi_install(void);
 spn_dag_wasi_t* spn_dag_wasi_new(sp_mem_t mem, const spn_path_roots_t* roots, const spn_dag_wasi_mount_t* mounts, u32 count);
 void            spn_dag_wasi_bind(spn_dag_wasi_t* w, wasm_module_inst_t instance);
-void            spn_dag_wasi_begin(spn_dag_wasi_t* w, sp_mem_t mem, sp_da(spn_dag_obs_t)* obs);
+void            spn_dag_wasi_begin(spn_dag_wasi_t* w, sp_mem_t mem, sp_da(spn_dag_obs_t)* obs, bool writes);
 void            spn_dag_wasi_end(spn_dag_wasi_t* w);
 void            spn_dag_wasi_observe_read(wasm_module_inst_t instance, sp_str_t host);
 void            spn_dag_wasi_observe_write(wasm_module_inst_t instance, sp_str_t host);
@@ -2,6 +2,7 @@
 #include "sp/macro.h"
 #include "external/cc.h"
 #include "sp/io.h"
+#include "sha256/sha256.h"
 
 sp_str_t spn_cc_symbol_from_embedded_file(sp_mem_t mem, sp_str_t file_path) {
   c8* data = sp_alloc_n(mem, c8, file_path.len);
@@ -16,6 +17,7 @@ void spn_cc_embed_ctx_init(spn_cc_embed_ctx_t* c, sp_mem_t mem, spn_os_t os, spn
   c->arena = sp_mem_arena_new(mem);
   c->mem = sp_mem_arena_as_allocator(c->arena);
   sp_da_init(c->mem, c->entries);
+  sp_str_ht_init(c->mem, c->blobs);
 
   spn_obj_kind_t format;
   switch (os) {
@@ -35,30 +37,68 @@ void spn_cc_embed_ctx_free(spn_cc_embed_ctx_t* ctx) {
 
 spn_err_t spn_cc_embed_ctx_add(
   spn_cc_embed_ctx_t* ctx,
-  sp_mem_buffer_t data,
+  sp_str_t file,
   sp_str_t symbol,
   sp_str_t path,
   sp_str_t data_type,
   sp_str_t size_type
 ) {
-  symbol = sp_str_copy(ctx->mem, symbol);
+  // Only the digest and size are kept; the contents are streamed into the
+  // object when it's written. Identical files share one blob.
+  u8 digest [32];
+  u64 size = 0;
+  if (spn_sha256_file_digest(file, digest, &size)) {
+    return SPN_ERROR;
+  }
 
-  spn_obj_add_symbol(&ctx->obj, symbol, data.data, data.len);
-  spn_obj_add_symbol(&ctx->obj, sp_fmt(ctx->mem, "{}_size", sp_fmt_str(symbol)).value, &data.len, sizeof(u64));
+  sp_str_t key = spn_sha256_digest_hex(ctx->mem, digest);
+  spn_cc_embed_blob_t* blob = sp_str_ht_get(ctx->blobs, key);
+  if (!blob) {
+    sp_str_ht_insert(ctx->blobs, key, ((spn_cc_embed_blob_t) {
+      .data = spn_obj_add_file(&ctx->obj, file, size),
+      .size = spn_obj_add_data(&ctx->obj, &size, sizeof(u64)),
+    }));
+    blob = sp_str_ht_get(ctx->blobs, key);
+  }
+
+  symbol = sp_str_copy(ctx->mem, symbol);
+  spn_obj_add_symbol(&ctx->obj, symbol, blob->data);
+  spn_obj_add_symbol(&ctx->obj, sp_fmt(ctx->mem, "{}_size", sp_fmt_str(symbol)).value, blob->size);
 
-  sp_da_push(ctx->entries, ((spn_cc_embed_t) {
+  spn_cc_embed_t entry = {
     .path = sp_str_copy(ctx->mem, path),
     .symbol = symbol,
-    .size = data.len,
+    .size = size,
     .types = {
       .size = sp_str_copy(ctx->mem, size_type),
       .data = sp_str_copy(ctx->mem, data_type),
     }
-  }));
+  };
+  sp_mem_copy(entry.digest, digest, sizeof(entry.digest));
+  sp_da_push(ctx->entries, entry);
 
   return SPN_OK;
 }
 
+// Covers every path and its contents, in manifest order. Consumers compare it
+// to decide whether something derived from the embedded files is current
+// without hashing them again at runtime.
+sp_str_t spn_cc_embed_ctx_digest(spn_cc_embed_ctx_t* ctx, sp_mem_t mem) {
+  spn_sha256_ctx_t sha = sp_zero;
+  spn_sha256_init(&sha);
+  sp_da_for(ctx->entries, it) {
+    spn_cc_embed_t* entry = &ctx->entries[it];
+    u8 separator = 0;
+    spn_sha256_update(&sha, (const u8*)entry->path.data, entry->path.len);
+    spn_sha256_update(&sha, &separator, 1);
+    spn_sha256_update(&sha, entry->digest, sizeof(entry->digest));
+  }
+
+  u8 digest [32];
+  spn_sha256_final(&sha, digest);
+  return spn_sha256_digest_hex(mem, digest);
+}
+
 spn_err_t spn_cc_embed_ctx_write(spn_cc_embed_ctx_t* ctx, sp_str_t object, sp_str_t header) {
   spn_try(spn_obj_write(&ctx->obj, object));
 
@@ -98,6 +138,8 @@ spn_err_t spn_cc_embed_ctx_write(spn_cc_embed_ctx_t* ctx, sp_str_t object, sp_st
   sp_io_write_new_line(io);
   sp_fmt_io(io, "static const unsigned int spn_embed_count = {};", SP_FMT_U32(sp_da_size(ctx->entries)));
   sp_io_write_new_line(io);
+  sp_fmt_io(io, "static const char spn_embed_digest[] = \"{}\";", SP_FMT_STR(spn_cc_embed_ctx_digest(ctx, ctx->mem)));
+  sp_io_write_new_line(io);
   sp_io_write_str(io, sp_str_lit("static const spn_embed_entry_t spn_embed_manifest[] = {"), SP_NULLPTR);
   sp_io_write_new_line(io);
   sp_da_for(ctx->entries, it) {
@@ -318,6 +318,13 @@ spn_err_t spn_git_apply(sp_mem_t mem, sp_str_t repo, sp_str_t patch, sp_str_t* e
       SP_LIT("apply"), SP_LIT("--whitespace=nowarn"),
       patch
     },
+    // Checkouts aren't repos themselves, and git apply run inside some other
+    // repo skips every path outside its own cwd
+    .env = {
+      .extra = {
+        { SP_LIT("GIT_CEILING_DIRECTORIES"), sp_fs_parent_path(repo) },
+      },
+    },
     .io.err.mode = SP_PS_IO_MODE_REDIRECT,
   });
 
@@ -1,5 +1,8 @@
 #include "obj.h"
 
+#define SPN_OBJ_ALIGN 8
+#define SPN_OBJ_CHUNK 65536
+
 spn_obj_kind_t spn_obj_get_native_format() {
   switch (sp_os_get_kind()) {
     case SP_OS_WIN32: return SPN_OBJ_COFF;
@@ -10,75 +13,183 @@ spn_obj_kind_t spn_obj_get_native_format() {
 }
 
 void spn_obj_init(spn_obj_builder_t* obj, sp_mem_t mem, spn_obj_kind_t kind, spn_arch_t arch) {
-  obj->kind = kind;
-  switch (kind) {
-    case SPN_OBJ_COFF: {
-      obj->coff.coff = sp_coff_new(mem);
-      obj->coff.section = sp_coff_add_section(obj->coff.coff, sp_str_lit(".rdata"),
-        SP_COFF_SCN_CNT_INITIALIZED_DATA |
-        SP_COFF_SCN_ALIGN_8BYTES |
-        SP_COFF_SCN_MEM_READ);
-    } break;
-    case SPN_OBJ_ELF: {
-      obj->elf.elf = sp_elf_new(mem);
-      obj->elf.rodata = sp_elf_add_section(obj->elf.elf, (sp_elf_section_t){
-        .name = sp_str_lit(".rodata"),
-        .type = SHT_PROGBITS,
-        .flags = SHF_ALLOC | SHF_WRITE,
-        .align = 8,
-      });
-    } break;
-    case SPN_OBJ_MACHO: {
-      u32 cpu = arch == SPN_ARCH_X64 ? SP_MACHO_CPU_X86_64 : SP_MACHO_CPU_ARM64;
-      u32 subtype = arch == SPN_ARCH_X64 ? SP_MACHO_SUBTYPE_X86_64 : SP_MACHO_SUBTYPE_ARM64;
-      obj->macho.macho = sp_macho_new(mem, cpu, subtype);
-      obj->macho.section = sp_macho_add_section(obj->macho.macho, sp_str_lit("__DATA"), sp_str_lit("__const"), 3);
-    } break;
-    default: SP_ASSERT(false); break;
+  *obj = (spn_obj_builder_t) {
+    .kind = kind,
+    .arch = arch,
+    .mem = mem,
+  };
+  sp_da_init(mem, obj->blobs);
+  sp_da_init(mem, obj->symbols);
+}
+
+static u32 obj_push_blob(spn_obj_builder_t* obj, spn_obj_blob_t blob) {
+  blob.offset = sp_align_offset(obj->size, SPN_OBJ_ALIGN);
+  obj->size = blob.offset + blob.size;
+  sp_da_push(obj->blobs, blob);
+  return (u32)(sp_da_size(obj->blobs) - 1);
+}
+
+u32 spn_obj_add_data(spn_obj_builder_t* obj, const void* data, u64 size) {
+  u8* copy = sp_alloc_n(obj->mem, u8, size);
+  sp_mem_copy(copy, data, size);
+  return obj_push_blob(obj, (spn_obj_blob_t) {
+    .data = { .data = copy, .len = size },
+    .size = size,
+  });
+}
+
+u32 spn_obj_add_file(spn_obj_builder_t* obj, sp_str_t path, u64 size) {
+  return obj_push_blob(obj, (spn_obj_blob_t) {
+    .path = sp_str_copy(obj->mem, path),
+    .size = size,
+  });
+}
+
+void spn_obj_add_symbol(spn_obj_builder_t* obj, sp_str_t name, u32 blob) {
+  SP_ASSERT(blob < sp_da_size(obj->blobs));
+  sp_da_push(obj->symbols, ((spn_obj_symbol_t) {
+    .name = sp_str_copy(obj->mem, name),
+    .blob = blob,
+  }));
+}
+
+// Copies a file into the object a chunk at a time. The symbols were sized
+// when the file was added, so a file that has since grown or shrunk fails the
+// write rather than being cut short or padded out
+static sp_err_t obj_stream_file(sp_io_writer_t* out, spn_obj_blob_t* blob) {
+  sp_io_file_reader_t reader = sp_zero;
+  sp_try(sp_io_file_reader_from_path(&reader, blob->path));
+
+  u8 chunk [SPN_OBJ_CHUNK];
+  u64 streamed = 0;
+  sp_err_t err = SP_OK;
+  while (!err) {
+    u64 bytes_read = 0;
+    err = sp_io_read(&reader.base, chunk, sizeof(chunk), &bytes_read);
+    if (!bytes_read) break;
+    streamed += bytes_read;
+    if (streamed > blob->size) break;
+    if ((err = sp_io_write(out, chunk, bytes_read, SP_NULLPTR))) break;
   }
+  sp_io_file_reader_close(&reader);
+
+  if (err && err != SP_ERR_IO_EOF) return err;
+  return streamed == blob->size ? SP_OK : SP_ERR;
 }
 
-void spn_obj_add_symbol(spn_obj_builder_t* obj, sp_str_t name, const void* data, u64 size) {
-  switch (obj->kind) {
-    case SPN_OBJ_COFF: {
-      u64 offset = obj->coff.section->writer.storage.len;
-      sp_io_write(&obj->coff.section->writer.base, data, size, SP_NULLPTR);
-      sp_coff_add_symbol(obj->coff.coff, name, (u32)offset, 1, SP_COFF_SYM_CLASS_EXTERNAL);
-    } break;
-    case SPN_OBJ_ELF: {
-      u64 offset = sp_elf_append_aligned(obj->elf.elf, obj->elf.rodata, data, size, 8);
-      sp_elf_add_symbol(obj->elf.elf, (sp_elf_symbol_t){
-        .name = name,
-        .section = obj->elf.rodata,
-        .value = offset,
-        .size = size,
-        .bind = STB_GLOBAL,
-        .type = STT_OBJECT,
-      });
-    } break;
-    case SPN_OBJ_MACHO: {
-      sp_io_dyn_mem_writer_t* writer = &obj->macho.section->writer;
-      u64 offset = (writer->storage.len + 7) & ~7ull;
-      if (offset > writer->storage.len) {
-        sp_io_pad(&writer->base, offset - writer->storage.len, SP_NULLPTR);
-      }
-      sp_io_write(&writer->base, data, size, SP_NULLPTR);
-
-      sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
-      sp_macho_add_symbol(obj->macho.macho, sp_fmt(scratch.mem, "_{}", sp_fmt_str(name)).value, 1, offset);
-      sp_mem_end_scratch(scratch);
-    } break;
-    default: SP_ASSERT(false); break;
+// The data section's source. Every blob's offset and size were fixed as it
+// was added, so the writers lay out headers and tables from obj->size alone
+// and the blobs go straight to the output file, padded up to their offsets
+static sp_err_t obj_write_section(sp_io_writer_t* out, void* user) {
+  spn_obj_builder_t* obj = (spn_obj_builder_t*)user;
+  u64 written = 0;
+  sp_da_for(obj->blobs, it) {
+    spn_obj_blob_t* blob = &obj->blobs[it];
+    if (blob->offset > written) {
+      sp_try(sp_io_pad(out, blob->offset - written, SP_NULLPTR));
+    }
+    if (sp_str_empty(blob->path)) {
+      sp_try(sp_io_write(out, blob->data.data, blob->size, SP_NULLPTR));
+    } else {
+      sp_try(obj_stream_file(out, blob));
+    }
+    written = blob->offset + blob->size;
+  }
+  return SP_OK;
+}
+
+static sp_err_t obj_write_elf(spn_obj_builder_t* obj, sp_str_t path) {
+  sp_elf_t* elf = sp_elf_new(obj->mem);
+  elf->machine = obj->arch == SPN_ARCH_ARM64 ? EM_AARCH64 : EM_X86_64;
+  u32 rodata = sp_elf_add_section(elf, (sp_elf_section_t){
+    .name = sp_str_lit(".rodata"),
+    .type = SHT_PROGBITS,
+    .flags = SHF_ALLOC | SHF_WRITE,
+    .align = SPN_OBJ_ALIGN,
+    .size = obj->size,
+    .source = obj_write_section,
+    .user = obj,
+  });
+
+  sp_da_for(obj->symbols, it) {
+    spn_obj_symbol_t* symbol = &obj->symbols[it];
+    spn_obj_blob_t* blob = &obj->blobs[symbol->blob];
+    sp_elf_add_symbol(elf, (sp_elf_symbol_t){
+      .name = symbol->name,
+      .section = rodata,
+      .value = blob->offset,
+      .size = blob->size,
+      .bind = STB_GLOBAL,
+      .type = STT_OBJECT,
+    });
+  }
+
+  sp_err_t err = sp_elf_write_to_file(elf, path);
+  sp_elf_free(elf);
+  return err;
+}
+
+static sp_err_t obj_write_coff(spn_obj_builder_t* obj, sp_str_t path) {
+  sp_coff_t* coff = sp_coff_new(obj->mem);
+  coff->machine = obj->arch == SPN_ARCH_ARM64 ? SP_COFF_MACHINE_ARM64 : SP_COFF_MACHINE_AMD64;
+  sp_coff_section_t* rdata = sp_coff_add_section(coff, sp_str_lit(".rdata"),
+    SP_COFF_SCN_CNT_INITIALIZED_DATA |
+    SP_COFF_SCN_ALIGN_8BYTES |
+    SP_COFF_SCN_MEM_READ);
+  rdata->size = obj->size;
+  rdata->source = obj_write_section;
+  rdata->user = obj;
+
+  sp_da_for(obj->symbols, it) {
+    spn_obj_symbol_t* symbol = &obj->symbols[it];
+    sp_coff_add_symbol(coff, symbol->name, (u32)obj->blobs[symbol->blob].offset, 1, SP_COFF_SYM_CLASS_EXTERNAL);
+  }
+
+  sp_err_t err = sp_coff_write_to_file(coff, path);
+  sp_coff_free(coff);
+  return err;
+}
+
+static sp_err_t obj_write_macho(spn_obj_builder_t* obj, sp_str_t path) {
+  bool x64 = obj->arch == SPN_ARCH_X64;
+  sp_macho_t* macho = sp_macho_new(obj->mem, x64 ? SP_MACHO_CPU_X86_64 : SP_MACHO_CPU_ARM64, x64 ? SP_MACHO_SUBTYPE_X86_64 : SP_MACHO_SUBTYPE_ARM64);
+  sp_macho_section_t* data = sp_macho_add_section(macho, sp_str_lit("__DATA"), sp_str_lit("__const"), 3);
+  data->size = obj->size;
+  data->source = obj_write_section;
+  data->user = obj;
+
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  sp_da_for(obj->symbols, it) {
+    spn_obj_symbol_t* symbol = &obj->symbols[it];
+    // Darwin mangles C identifiers with a leading underscore
+    sp_str_t name = sp_fmt(scratch.mem, "_{}", sp_fmt_str(symbol->name)).value;
+    sp_macho_add_symbol(macho, name, 1, obj->blobs[symbol->blob].offset);
   }
+  sp_mem_end_scratch(scratch);
+
+  sp_err_t err = sp_macho_write_to_file(macho, path);
+  sp_macho_free(macho);
+  return err;
 }
 
 spn_err_t spn_obj_write(spn_obj_builder_t* obj, sp_str_t path) {
+  // COFF and Mach-O record section offsets in 32 bits
+  if (obj->kind != SPN_OBJ_ELF && obj->size > 0xFFFFFFFFull) {
+    return SPN_ERROR;
+  }
+
   sp_err_t err = SP_OK;
   switch (obj->kind) {
-    case SPN_OBJ_COFF:  err = sp_coff_write_to_file(obj->coff.coff, path); break;
-    case SPN_OBJ_ELF:   err = sp_elf_write_to_file(obj->elf.elf, path); break;
-    case SPN_OBJ_MACHO: err = sp_macho_write_to_file(obj->macho.macho, path); break;
+    case SPN_OBJ_COFF:  err = obj_write_coff(obj, path); break;
+    case SPN_OBJ_ELF:   err = obj_write_elf(obj, path); break;
+    case SPN_OBJ_MACHO: err = obj_write_macho(obj, path); break;
     default: SP_ASSERT(false); break;
   }
-  return err ? SPN_ERROR : SPN_OK;
+
+  // A file that changed size mid-write leaves a truncated object behind
+  if (err) {
+    sp_fs_remove_file(path);
+    return SPN_ERROR;
+  }
+  return SPN_OK;
 }
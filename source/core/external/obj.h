@@ -13,18 +13,35 @@ typedef enum {
   SPN_OBJ_MACHO,
 } spn_obj_kind_t;
 
+// A run of bytes in the object's single data section. File blobs are streamed
+// from disk when the object is written, so nothing is held in memory up front
+typedef struct {
+  sp_str_t path;
+  sp_mem_slice_t data;
+  u64 size;
+  u64 offset;
+} spn_obj_blob_t;
+
+// Several symbols may name the same blob
+typedef struct {
+  sp_str_t name;
+  u32 blob;
+} spn_obj_symbol_t;
+
 typedef struct {
   spn_obj_kind_t kind;
-  union {
-    struct { sp_coff_t* coff; sp_coff_section_t* section; } coff;
-    struct { sp_elf_t* elf; u32 rodata; } elf;
-    struct { sp_macho_t* macho; sp_macho_section_t* section; } macho;
-  };
+  spn_arch_t arch;
+  sp_mem_t mem;
+  sp_da(spn_obj_blob_t) blobs;
+  sp_da(spn_obj_symbol_t) symbols;
+  u64 size;
 } spn_obj_builder_t;
 
 spn_obj_kind_t spn_obj_get_native_format();
 void           spn_obj_init(spn_obj_builder_t* obj, sp_mem_t mem, spn_obj_kind_t kind, spn_arch_t arch);
-void           spn_obj_add_symbol(spn_obj_builder_t* obj, sp_str_t name, const void* data, u64 size);
+u32            spn_obj_add_data(spn_obj_builder_t* obj, const void* data, u64 size);
+u32            spn_obj_add_file(spn_obj_builder_t* obj, sp_str_t path, u64 size);
+void           spn_obj_add_symbol(spn_obj_builder_t* obj, sp_str_t name, u32 blob);
 spn_err_t      spn_obj_write(spn_obj_builder_t* obj, sp_str_t path);
 
 #endif
@@ -0,0 +1,157 @@
+#include "sp.h"
+#include "external/wasm/module.h"
+#include "spn/errors.h"
+
+#include "sha256/sha256.h"
+#include "wasm_export.h"
+
+#define SPN_WASM_STACK_SIZE (8 * 1024 * 1024)
+#define SPN_WASM_HEAP_SIZE  (16 * 1024 * 1024)
+
+#define SPN_WASM_NO_ENV SP_NULL
+#define SPN_WASM_NO_DIRS SP_NULL
+#define SPN_WASM_NO_ARGS SP_NULL
+
+// Under Fast JIT (Linux, and macOS on x86_64) compiled code belongs to the
+// module as well, so instances of a cached module share it. It can't outlive
+// the process: Fast JIT has no way to serialize its code, and loading native
+// code from disk needs the AOT runtime, which vmlib is built without.
+void spn_wasm_modules_init(spn_wasm_modules_t* modules, sp_mem_t mem) {
+  *modules = (spn_wasm_modules_t) { .mem = mem };
+  sp_str_ht_init(mem, modules->loaded);
+}
+
+void spn_wasm_modules_deinit(spn_wasm_modules_t* modules) {
+  sp_ht_for_kv(modules->loaded, it) {
+    wasm_runtime_unload(*it.val);
+  }
+  sp_ht_clear(modules->loaded);
+}
+
+u32 spn_wasm_modules_size(spn_wasm_modules_t* modules) {
+  sp_mutex_lock(&modules->mutex);
+  u32 size = (u32)sp_ht_size(modules->loaded);
+  sp_mutex_unlock(&modules->mutex);
+  return size;
+}
+
+spn_err_t spn_wasm_modules_load(spn_wasm_modules_t* modules, sp_str_t path, spn_wasm_module_t** module, c8* error, u32 len) {
+  *module = SP_NULLPTR;
+
+  u8 digest [32];
+  u64 size = 0;
+  if (spn_sha256_file_digest(path, digest, &size)) {
+    return SPN_ERR_WASM_READ_FAILED;
+  }
+
+  spn_err_t err = SPN_OK;
+  sp_mutex_lock(&modules->mutex);
+  sp_str_t key = spn_sha256_digest_hex(modules->mem, digest);
+  spn_wasm_module_t** loaded = sp_str_ht_get(modules->loaded, key);
+  if (loaded) {
+    *module = *loaded;
+  }
+  else {
+    // WAMR may point into the binary for as long as the module lives
+    sp_str_t blob = sp_zero;
+    if (sp_io_read_file(modules->mem, path, &blob)) {
+      err = SPN_ERR_WASM_READ_FAILED;
+    }
+    else if (!(*module = wasm_runtime_load((u8*)blob.data, blob.len, error, len))) {
+      err = SPN_ERR_WASM_MODULE_LOAD_FAILED;
+    }
+    else {
+      sp_str_ht_insert(modules->loaded, key, *module);
+    }
+  }
+  sp_mutex_unlock(&modules->mutex);
+
+  return err;
+}
+
+spn_wasm_instance_t* spn_wasm_modules_instantiate(spn_wasm_modules_t* modules, spn_wasm_module_t* module, const c8** preopens, u32 num_preopens, spn_wasm_limits_t limits, c8* error, u32 len) {
+  sp_mutex_lock(&modules->mutex);
+  wasm_runtime_set_wasi_args(
+    module,
+    SPN_WASM_NO_DIRS, SPN_WASM_NO_DIRS,
+    preopens, num_preopens,
+    SPN_WASM_NO_ENV, SPN_WASM_NO_ENV,
+    SPN_WASM_NO_ARGS, SPN_WASM_NO_ARGS
+  );
+  spn_wasm_instance_t* instance = wasm_runtime_instantiate(module, spn_wasm_limits_stack(limits), spn_wasm_limits_heap(limits), error, len);
+  sp_mutex_unlock(&modules->mutex);
+  return instance;
+}
+
+spn_wasm_runner_t* spn_wasm_script_take(spn_wasm_script_t* script) {
+  sp_mutex_lock(&script->mutex);
+  SP_ASSERT(script->state == SPN_WASM_SCRIPT_OPEN);
+  spn_wasm_runner_t* runner = script->idle;
+  if (runner) {
+    script->idle = runner->next;
+    runner->next = SP_NULLPTR;
+  }
+  sp_mutex_unlock(&script->mutex);
+  return runner;
+}
+
+void spn_wasm_script_adopt(spn_wasm_script_t* script, spn_wasm_runner_t* runner) {
+  SP_UNUSED(runner);
+  sp_mutex_lock(&script->mutex);
+  script->num_runners++;
+  sp_mutex_unlock(&script->mutex);
+}
+
+void spn_wasm_script_put(spn_wasm_script_t* script, spn_wasm_runner_t* runner) {
+  sp_mutex_lock(&script->mutex);
+  runner->next = script->idle;
+  script->idle = runner;
+  sp_mutex_unlock(&script->mutex);
+}
+
+// Instances in the middle of a call aren't idle, so they're left alone
+void spn_wasm_script_trim(spn_wasm_script_t* script) {
+  sp_mutex_lock(&script->mutex);
+  spn_wasm_runner_t* idle = script->idle;
+  script->idle = SP_NULLPTR;
+  for (spn_wasm_runner_t* runner = idle; runner; runner = runner->next) {
+    script->num_runners--;
+  }
+  sp_mutex_unlock(&script->mutex);
+
+  while (idle) {
+    spn_wasm_runner_t* next = idle->next;
+    spn_wasm_runner_free(idle);
+    idle = next;
+  }
+}
+
+// The runner itself is in its arena, so nothing may touch it afterwards
+void spn_wasm_runner_free(spn_wasm_runner_t* runner) {
+  wasm_runtime_destroy_exec_env(runner->env);
+  wasm_runtime_deinstantiate(runner->instance);
+  sp_mem_arena_destroy(runner->arena);
+}
+
+void spn_wasm_scripts_retain(spn_wasm_scripts_t* scripts) {
+  sp_atomic_s32_add(&scripts->pending, 1, SP_ATOMIC_SEQ_CST);
+}
+
+void spn_wasm_scripts_release(spn_wasm_scripts_t* scripts) {
+  if (sp_atomic_s32_add(&scripts->pending, -1, SP_ATOMIC_SEQ_CST) == 1) {
+    spn_wasm_scripts_trim(scripts);
+  }
+}
+
+void spn_wasm_scripts_trim(spn_wasm_scripts_t* scripts) {
+  spn_wasm_script_trim(&scripts->configure);
+  spn_wasm_script_trim(&scripts->build);
+}
+
+u32 spn_wasm_limits_stack(spn_wasm_limits_t limits) {
+  return limits.stack ? limits.stack : SPN_WASM_STACK_SIZE;
+}
+
+u32 spn_wasm_limits_heap(spn_wasm_limits_t limits) {
+  return limits.heap ? limits.heap : SPN_WASM_HEAP_SIZE;
+}
@@ -0,0 +1,39 @@
+#ifndef SPN_WASM_MODULE_H
+#define SPN_WASM_MODULE_H
+
+#include "sp.h"
+#include "spn/core.h"
+#include "external/wasm/types.h"
+
+// Scripts built from the same source (every package pulling in the same build
+// tool, say) share one parsed and validated module and only pay for their own
+// instances. Nothing is unloaded until deinit, since any script may still hold
+// a module.
+void                 spn_wasm_modules_init(spn_wasm_modules_t* modules, sp_mem_t mem);
+void                 spn_wasm_modules_deinit(spn_wasm_modules_t* modules);
+spn_err_t            spn_wasm_modules_load(spn_wasm_modules_t* modules, sp_str_t path, spn_wasm_module_t** module, c8* error, u32 len);
+u32                  spn_wasm_modules_size(spn_wasm_modules_t* modules);
+
+// WASI args live on the module until instantiation copies them, so setting
+// them and instantiating go through the cache's lock
+spn_wasm_instance_t* spn_wasm_modules_instantiate(spn_wasm_modules_t* modules, spn_wasm_module_t* module, const c8** preopens, u32 num_preopens, spn_wasm_limits_t limits, c8* error, u32 len);
+
+// Idle instances of a script. A call takes one, or makes and adopts its own
+// when every instance is busy, then puts it back. Trimming frees the idle
+// ones; the module stays loaded, so the next call just instantiates again.
+spn_wasm_runner_t*   spn_wasm_script_take(spn_wasm_script_t* script);
+void                 spn_wasm_script_adopt(spn_wasm_script_t* script, spn_wasm_runner_t* runner);
+void                 spn_wasm_script_put(spn_wasm_script_t* script, spn_wasm_runner_t* runner);
+void                 spn_wasm_script_trim(spn_wasm_script_t* script);
+void                 spn_wasm_runner_free(spn_wasm_runner_t* runner);
+
+// Counts the DAG actions that may still call into a package's scripts; the
+// last release trims both
+void                 spn_wasm_scripts_retain(spn_wasm_scripts_t* scripts);
+void                 spn_wasm_scripts_release(spn_wasm_scripts_t* scripts);
+void                 spn_wasm_scripts_trim(spn_wasm_scripts_t* scripts);
+
+u32                  spn_wasm_limits_stack(spn_wasm_limits_t limits);
+u32                  spn_wasm_limits_heap(spn_wasm_limits_t limits);
+
+#endif
@@ -20,9 +20,11 @@ typedef struct WASMExecEnv spn_wasm_exec_env_t;
 typedef struct spn_wasm_handles_t spn_wasm_handles_t;
 typedef struct spn_dag_wasi_t spn_dag_wasi_t;
 
+// With writes set, files the call writes are observed alongside what it reads
 typedef struct {
   sp_mem_t mem;
   sp_da(spn_dag_obs_t)* out;
+  bool writes;
 } spn_wasm_obs_t;
 
 typedef union {
@@ -42,18 +44,59 @@ typedef enum {
   SPN_WASM_SCRIPT_FAILED,
 } spn_wasm_script_state_t;
 
+// One instance of a script's module, with everything a call needs. Calls
+// into the same script on different threads each take their own runner.
+// The runner, its handles and its WASI state live in its own arena, so
+// trimming an idle runner gives all of it back.
+typedef struct spn_wasm_runner_t spn_wasm_runner_t;
+struct spn_wasm_runner_t {
+  sp_mem_arena_t* arena;
+  spn_wasm_instance_t* instance;
+  spn_wasm_exec_env_t* env;
+  spn_wasm_handles_t* handles;
+  spn_dag_wasi_t* wasi;
+  u32 ctx;
+  spn_wasm_runner_t* next;
+};
+
+// Loaded modules, keyed by the digest of their bytes
+typedef struct {
+  sp_mem_t mem;
+  sp_mutex_t mutex;
+  sp_str_ht(spn_wasm_module_t*) loaded;
+} spn_wasm_modules_t;
+
+// Per package, from the manifest; zero takes the runtime default
+typedef struct {
+  u32 stack;
+  u32 heap;
+} spn_wasm_limits_t;
+
 typedef struct {
   spn_wasm_script_state_t state;
   spn_err_t err;
   sp_str_t path;
+  spn_wasm_limits_t limits;
   sp_mutex_t mutex;
   spn_wasm_module_t* module;
-  spn_wasm_instance_t* instance;
-  spn_wasm_exec_env_t* env;
-  spn_wasm_handles_t* handles;
-  spn_dag_wasi_t* wasi;
-  u32 ctx;
   spn_wasm_preopens_t preopens;
+  struct {
+    sp_str_t work;
+    sp_str_t source;
+    sp_str_t manifest;
+    sp_str_t store;
+  } mounts;
+  spn_wasm_runner_t* idle;
+  u32 num_runners;
 } spn_wasm_script_t;
 
+// A package's scripts
+typedef struct {
+  spn_wasm_script_t configure;
+  spn_wasm_script_t build;
+  // DAG actions that may still call into either script; the last one out
+  // tears down their instances
+  sp_atomic_s32_t pending;
+} spn_wasm_scripts_t;
+
 #endif
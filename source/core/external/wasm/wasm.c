@@ -13,21 +13,16 @@
 #include "external/wasm/abi.h"
 #include "dag/dag.h"
 #include "dag/wasi.h"
+#include "external/wasm/module.h"
 #include "paths/paths.h"
 
-#define SPN_WASM_STACK_SIZE (8 * 1024 * 1024)
-#define SPN_WASM_HEAP_SIZE  (16 * 1024 * 1024)
 #define SPN_WASM_EXPORT_MAX 128
 
-#define SPN_WASM_NO_ENV SP_NULL
-#define SPN_WASM_NO_DIRS SP_NULL
-#define SPN_WASM_NO_ARGS SP_NULL
-
-spn_err_t spn_wasm_init() {
-  static bool initialized = false;
-  if (initialized) return SPN_OK;
-  initialized = true;
+// Every script in the process loads through here, so packages whose scripts
+// have the same bytes share a module
+static spn_wasm_modules_t modules;
 
+static spn_err_t spn_wasm_init_runtime() {
   if (!wasm_runtime_init()) {
     return SPN_ERR_WASM_INIT_FAILED;
   }
@@ -38,6 +33,8 @@ spn_err_t spn_wasm_init() {
     }
   }
 
+  spn_wasm_modules_init(&modules, spn.mem);
+
   if (!spn_wasm_register_api()) {
     return SPN_ERR_WASM_REGISTER_FAILED;
   }
@@ -45,6 +42,18 @@ spn_err_t spn_wasm_init() {
   return spn_dag_wasi_install();
 }
 
+// Sync starts the runtime early on the main thread; configure asks again and
+// must see the same answer
+spn_err_t spn_wasm_init() {
+  static bool initialized = false;
+  static spn_err_t result = SPN_OK;
+  if (initialized) return result;
+  initialized = true;
+
+  result = spn_wasm_init_runtime();
+  return result;
+}
+
 // WAMR mprotects guard pages at the bottom of any thread that runs a script;
 // a thread that exits without destroying its env leaves those pages PROT_NONE
 // on a stack glibc will hand to the next pthread, which then faults on it
@@ -54,10 +63,11 @@ void spn_wasm_thread_exit() {
   }
 }
 
-void spn_wasm_script_init(spn_wasm_script_t* script, sp_str_t module) {
+void spn_wasm_script_init(spn_wasm_script_t* script, sp_str_t module, spn_wasm_limits_t limits) {
   *script = (spn_wasm_script_t) {
     .state = SPN_WASM_SCRIPT_CLOSED,
     .path = module,
+    .limits = limits,
   };
 }
 
@@ -76,79 +86,85 @@ static const c8* preopen(const c8* guest, sp_str_t host) {
   return sp_fmt_mem_cstr(spn.mem, "{}::{}", sp_fmt_cstr(guest), sp_fmt_str(host));
 }
 
-static spn_err_t script_open(spn_wasm_script_t* script, spn_pkg_unit_t* unit) {
-  if (!wasm_runtime_init_thread_env()) {
-    return script_fail(unit, SPN_ERR_WASM_THREAD_ENV_FAILED, (spn_err_wasm_t) { .path = script->path });
-  }
-
-  sp_str_t blob = sp_zero;
-  if (sp_io_read_file(spn.mem, script->path, &blob)) {
-    return script_fail(unit, SPN_ERR_WASM_READ_FAILED, (spn_err_wasm_t) { .path = script->path });
-  }
-
+static spn_err_t script_load(spn_wasm_script_t* script, spn_pkg_unit_t* unit) {
   c8 error [128] = sp_zero;
-  script->module = wasm_runtime_load((u8*)blob.data, blob.len, error, sizeof(error));
-  if (!script->module) {
-    return script_fail(unit, SPN_ERR_WASM_MODULE_LOAD_FAILED, (spn_err_wasm_t) {
+  spn_err_t err = spn_wasm_modules_load(&modules, script->path, &script->module, error, sizeof(error));
+  if (err) {
+    return script_fail(unit, err, (spn_err_wasm_t) {
       .path = script->path,
       .error = sp_cstr_as_str(error),
     });
   }
+  return SPN_OK;
+}
 
-  spn_pkg_unit_create_layout(unit);
-  const spn_path_roots_t* roots = &spn.roots;
-  sp_str_t work = spn_path_str(roots, spn.mem, unit->paths.work);
-  sp_str_t store = spn_path_str(roots, spn.mem, unit->paths.store);
-  sp_str_t source = spn_path_str(roots, spn.mem, unit->paths.roots.source);
-  sp_str_t manifest = spn_path_str(roots, spn.mem, unit->paths.roots.recipe);
-  script->preopens = (spn_wasm_preopens_t) {
-    .work = preopen("/work", work),
-    .source = preopen("/source", source),
-    .manifest = preopen("/manifest", manifest),
-    .store = preopen("/store", store),
-  };
-  wasm_runtime_set_wasi_args(
-    script->module,
-    SPN_WASM_NO_DIRS, SPN_WASM_NO_DIRS,
-    script->preopens.array, sp_carr_len(script->preopens.array),
-    SPN_WASM_NO_ENV, SPN_WASM_NO_ENV,
-    SPN_WASM_NO_ARGS, SPN_WASM_NO_ARGS
-  );
-
-  script->instance = wasm_runtime_instantiate(script->module, SPN_WASM_STACK_SIZE, SPN_WASM_HEAP_SIZE, error, sizeof(error));
-  if (!script->instance) {
-    wasm_runtime_unload(script->module);
-    script->module = SP_NULLPTR;
+static spn_wasm_instance_t* script_instantiate(spn_wasm_script_t* script, c8* error, u32 len) {
+  return spn_wasm_modules_instantiate(&modules, script->module, script->preopens.array, sp_carr_len(script->preopens.array), script->limits, error, len);
+}
+
+static spn_err_t runner_new(spn_wasm_script_t* script, spn_pkg_unit_t* unit, spn_wasm_runner_t** out) {
+  c8 error [128] = sp_zero;
+  spn_wasm_instance_t* instance = script_instantiate(script, error, sizeof(error));
+  if (!instance) {
     return script_fail(unit, SPN_ERR_WASM_MODULE_INSTANCE_FAILED, (spn_err_wasm_t) {
       .path = script->path,
       .error = sp_cstr_as_str(error),
     });
   }
 
-  script->env = wasm_runtime_create_exec_env(script->instance, SPN_WASM_STACK_SIZE);
-  if (!script->env) {
-    wasm_runtime_deinstantiate(script->instance);
-    script->instance = SP_NULLPTR;
-    wasm_runtime_unload(script->module);
-    script->module = SP_NULLPTR;
+  spn_wasm_exec_env_t* env = wasm_runtime_create_exec_env(instance, spn_wasm_limits_stack(script->limits));
+  if (!env) {
+    wasm_runtime_deinstantiate(instance);
     return script_fail(unit, SPN_ERR_WASM_CTX_FAILED, (spn_err_wasm_t) { .path = script->path });
   }
 
-  script->handles = sp_alloc_type(spn.mem, spn_wasm_handles_t);
-  sp_ht_init(spn.mem, script->handles->map);
-  script->handles->ctx = sp_ptr_cast(spn_t*, unit);
-  script->ctx = spn_wasm_add_handle(script->handles, unit, SPN_ABI_KIND_CTX);
-  wasm_runtime_set_user_data(script->env, script->handles);
+  sp_mem_arena_t* arena = sp_mem_arena_new(sp_mem_os_new());
+  sp_mem_t mem = sp_mem_arena_as_allocator(arena);
+  spn_wasm_runner_t* runner = sp_alloc_type(mem, spn_wasm_runner_t);
+  runner->arena = arena;
+  runner->instance = instance;
+  runner->env = env;
+  runner->handles = sp_alloc_type(mem, spn_wasm_handles_t);
+  sp_ht_init(mem, runner->handles->map);
+  runner->handles->ctx = sp_ptr_cast(spn_t*, unit);
+  runner->ctx = spn_wasm_add_handle(runner->handles, unit, SPN_ABI_KIND_CTX);
+  wasm_runtime_set_user_data(runner->env, runner->handles);
 
   spn_dag_wasi_mount_t mounts [] = {
-    { .guest = "/work",     .host = work },
-    { .guest = "/source",   .host = source },
-    { .guest = "/manifest", .host = manifest },
-    { .guest = "/store",    .host = store },
+    { .guest = "/work",     .host = script->mounts.work },
+    { .guest = "/source",   .host = script->mounts.source },
+    { .guest = "/manifest", .host = script->mounts.manifest },
+    { .guest = "/store",    .host = script->mounts.store },
+  };
+  runner->wasi = spn_dag_wasi_new(mem, &spn.roots, mounts, sp_carr_len(mounts));
+  spn_dag_wasi_bind(runner->wasi, runner->instance);
+
+  *out = runner;
+  return SPN_OK;
+}
+
+static spn_err_t script_open(spn_wasm_script_t* script, spn_pkg_unit_t* unit) {
+  if (!wasm_runtime_init_thread_env()) {
+    return script_fail(unit, SPN_ERR_WASM_THREAD_ENV_FAILED, (spn_err_wasm_t) { .path = script->path });
+  }
+
+  spn_try(script_load(script, unit));
+
+  spn_pkg_unit_create_layout(unit);
+  const spn_path_roots_t* roots = &spn.roots;
+  script->mounts.work = spn_path_str(roots, spn.mem, unit->paths.work);
+  script->mounts.store = spn_path_str(roots, spn.mem, unit->paths.store);
+  script->mounts.source = spn_path_str(roots, spn.mem, unit->paths.roots.source);
+  script->mounts.manifest = spn_path_str(roots, spn.mem, unit->paths.roots.recipe);
+  script->preopens = (spn_wasm_preopens_t) {
+    .work = preopen("/work", script->mounts.work),
+    .source = preopen("/source", script->mounts.source),
+    .manifest = preopen("/manifest", script->mounts.manifest),
+    .store = preopen("/store", script->mounts.store),
   };
-  script->wasi = spn_dag_wasi_new(spn.mem, roots, mounts, sp_carr_len(mounts));
-  spn_dag_wasi_bind(script->wasi, script->instance);
 
+  // Opening only loads the module, which is enough to answer export queries.
+  // Instances are made by the first call that needs one.
   return SPN_OK;
 }
 
@@ -179,46 +195,70 @@ spn_err_t spn_wasm_script_open(spn_wasm_script_t* script, spn_pkg_unit_t* unit)
   return err;
 }
 
+// Takes an idle instance, or makes a new one when every instance is busy.
+// Concurrent callers are DAG workers, so the pool never outgrows the number
+// of threads that actually call into the script at once.
+static spn_err_t script_acquire(spn_wasm_script_t* script, spn_pkg_unit_t* unit, spn_wasm_runner_t** runner) {
+  *runner = spn_wasm_script_take(script);
+  if (*runner) {
+    return SPN_OK;
+  }
+
+  spn_try(runner_new(script, unit, runner));
+  spn_wasm_script_adopt(script, *runner);
+  return SPN_OK;
+}
+
 static void export_name(sp_str_t name, c8* buffer) {
   sp_str_copy_to(name, buffer, SPN_WASM_EXPORT_MAX - 1);
 }
 
 bool spn_wasm_script_exports(spn_wasm_script_t* script, sp_str_t name) {
-  bool exported = false;
-
   sp_mutex_lock(&script->mutex);
-  if (script->state == SPN_WASM_SCRIPT_OPEN) {
-    c8 buffer [SPN_WASM_EXPORT_MAX] = sp_zero;
-    export_name(name, buffer);
-    exported = wasm_runtime_lookup_function(script->instance, buffer) != SP_NULLPTR;
-  }
+  bool open = script->state == SPN_WASM_SCRIPT_OPEN;
   sp_mutex_unlock(&script->mutex);
+  if (!open) {
+    return false;
+  }
 
-  return exported;
+  // The export table lives on the module, so no instance is needed
+  s32 count = wasm_runtime_get_export_count(script->module);
+  for (s32 it = 0; it < count; it++) {
+    wasm_export_t info = sp_zero;
+    wasm_runtime_get_export_type(script->module, it, &info);
+    if (info.kind == WASM_IMPORT_EXPORT_KIND_FUNC && sp_str_equal_cstr(name, info.name)) {
+      return true;
+    }
+  }
+  return false;
 }
 
-static spn_err_t script_call_invoke(spn_wasm_script_t* script, spn_pkg_unit_t* unit, wasm_function_inst_t fn, spn_abi_kind_t kind, void* arg) {
+// The runner executing guest code on this thread, so host functions can trap
+// the call that reached them
+static _Thread_local spn_wasm_runner_t* active;
+
+static spn_err_t script_call_invoke(spn_wasm_script_t* script, spn_wasm_runner_t* runner, spn_pkg_unit_t* unit, wasm_function_inst_t fn, spn_abi_kind_t kind, void* arg) {
   wasm_val_t args [2] = {
-    { .kind = WASM_I32, .of.i32 = (s32)script->ctx },
+    { .kind = WASM_I32, .of.i32 = (s32)runner->ctx },
   };
   u32 num_args = 1;
   u32 token = 0;
   if (kind != SPN_ABI_KIND_NONE) {
-    token = spn_wasm_add_handle(script->handles, arg, kind);
+    token = spn_wasm_add_handle(runner->handles, arg, kind);
     args[1] = (wasm_val_t) { .kind = WASM_I32, .of.i32 = (s32)token };
     num_args = 2;
   }
 
   wasm_val_t results [1] = sp_zero;
-  bool called = wasm_runtime_call_wasm_a(script->env, fn, 1, results, num_args, args);
+  bool called = wasm_runtime_call_wasm_a(runner->env, fn, 1, results, num_args, args);
   if (token) {
-    spn_wasm_remove_handle(script->handles, token);
+    spn_wasm_remove_handle(runner->handles, token);
   }
 
   if (!called) {
     return script_fail(unit, SPN_ERR_WASM_MODULE_CALL_FAILED, (spn_err_wasm_t) {
       .path = script->path,
-      .error = sp_cstr_as_str(wasm_runtime_get_exception(script->instance)),
+      .error = sp_cstr_as_str(wasm_runtime_get_exception(runner->instance)),
     });
   }
   if (results[0].of.i32) {
@@ -238,11 +278,11 @@ spn_err_t spn_wasm_script_call_ex(spn_wasm_script_t* script, spn_pkg_unit_t* uni
   c8 buffer [SPN_WASM_EXPORT_MAX] = sp_zero;
   export_name(name, buffer);
 
-  sp_mutex_lock(&script->mutex);
-  SP_ASSERT(script->state == SPN_WASM_SCRIPT_OPEN);
+  spn_wasm_runner_t* runner = SP_NULLPTR;
+  spn_try(script_acquire(script, unit, &runner));
 
   spn_err_t err = SPN_OK;
-  wasm_function_inst_t fn = wasm_runtime_lookup_function(script->instance, buffer);
+  wasm_function_inst_t fn = wasm_runtime_lookup_function(runner->instance, buffer);
 
   if (!fn) {
     err = script_fail(unit, SPN_ERR_WASM_EXPORT_NOT_FOUND, (spn_err_wasm_t) {
@@ -252,18 +292,18 @@ spn_err_t spn_wasm_script_call_ex(spn_wasm_script_t* script, spn_pkg_unit_t* uni
   }
   else {
     if (obs.out) {
-      spn_dag_wasi_begin(script->wasi, obs.mem, obs.out);
+      spn_dag_wasi_begin(runner->wasi, obs.mem, obs.out, obs.writes);
     }
-    spn_wasm_script_t* previous = unit->wasm.active;
-    unit->wasm.active = script;
-    err = script_call_invoke(script, unit, fn, kind, arg);
-    unit->wasm.active = previous;
+    spn_wasm_runner_t* previous = active;
+    active = runner;
+    err = script_call_invoke(script, runner, unit, fn, kind, arg);
+    active = previous;
     if (obs.out) {
-      spn_dag_wasi_end(script->wasi);
+      spn_dag_wasi_end(runner->wasi);
     }
   }
 
-  sp_mutex_unlock(&script->mutex);
+  spn_wasm_script_put(script, runner);
   return err;
 }
 
@@ -272,16 +312,19 @@ spn_err_t spn_wasm_script_call(spn_wasm_script_t* script, spn_pkg_unit_t* unit,
 }
 
 bool spn_wasm_trap_active(spn_pkg_unit_t* unit, sp_str_t message) {
-  spn_wasm_script_t* script = unit->wasm.active;
-  if (!script) {
+  if (!active || active->handles->ctx != sp_ptr_cast(spn_t*, unit)) {
     return false;
   }
   sp_mem_arena_marker_t s = sp_mem_begin_scratch();
-  wasm_runtime_set_exception(script->instance, sp_str_to_cstr(s.mem, message));
+  wasm_runtime_set_exception(active->instance, sp_str_to_cstr(s.mem, message));
   sp_mem_end_scratch(s);
   return true;
 }
 
+spn_pkg_unit_t* spn_wasm_active_unit() {
+  return active ? sp_ptr_cast(spn_pkg_unit_t*, active->handles->ctx) : SP_NULLPTR;
+}
+
 spn_err_t spn_wasm_find_export(spn_pkg_unit_t* unit, sp_str_t name, spn_wasm_script_t** script) {
   *script = SP_NULLPTR;
 
@@ -326,3 +369,15 @@ spn_err_t spn_wasm_call_export_ex(spn_pkg_unit_t* unit, sp_str_t name, spn_abi_k
 spn_err_t spn_wasm_call_export(spn_pkg_unit_t* unit, sp_str_t name, spn_abi_kind_t kind, void* arg) {
   return spn_wasm_call_export_ex(unit, name, kind, arg, (spn_wasm_obs_t) sp_zero);
 }
+
+void spn_wasm_unit_retain(spn_pkg_unit_t* unit) {
+  spn_wasm_scripts_retain(&unit->wasm);
+}
+
+void spn_wasm_unit_release(spn_pkg_unit_t* unit) {
+  spn_wasm_scripts_release(&unit->wasm);
+}
+
+void spn_wasm_unit_trim(spn_pkg_unit_t* unit) {
+  spn_wasm_scripts_trim(&unit->wasm);
+}
@@ -3,18 +3,25 @@
 
 #include "core/types.h"
 
+#include "external/wasm/module.h"
 #include "external/wasm/types.h"
 
 spn_err_t spn_wasm_init();
 void      spn_wasm_thread_exit();
-void      spn_wasm_script_init(spn_wasm_script_t* script, sp_str_t module);
+void      spn_wasm_script_init(spn_wasm_script_t* script, sp_str_t module, spn_wasm_limits_t limits);
 spn_err_t spn_wasm_script_open(spn_wasm_script_t* script, spn_pkg_unit_t* unit);
 bool      spn_wasm_script_exports(spn_wasm_script_t* script, sp_str_t name);
 spn_err_t spn_wasm_script_call(spn_wasm_script_t* script, spn_pkg_unit_t* unit, sp_str_t name, spn_abi_kind_t kind, void* arg);
 spn_err_t spn_wasm_script_call_ex(spn_wasm_script_t* script, spn_pkg_unit_t* unit, sp_str_t name, spn_abi_kind_t kind, void* arg, spn_wasm_obs_t obs);
 bool      spn_wasm_trap_active(spn_pkg_unit_t* unit, sp_str_t message);
+// The package whose script is running on this thread, whichever handle it
+// called the API through
+spn_pkg_unit_t* spn_wasm_active_unit();
 spn_err_t spn_wasm_find_export(spn_pkg_unit_t* unit, sp_str_t name, spn_wasm_script_t** script);
 spn_err_t spn_wasm_call_export(spn_pkg_unit_t* unit, sp_str_t name, spn_abi_kind_t kind, void* arg);
 spn_err_t spn_wasm_call_export_ex(spn_pkg_unit_t* unit, sp_str_t name, spn_abi_kind_t kind, void* arg, spn_wasm_obs_t obs);
+void      spn_wasm_unit_retain(spn_pkg_unit_t* unit);
+void      spn_wasm_unit_release(spn_pkg_unit_t* unit);
+void      spn_wasm_unit_trim(spn_pkg_unit_t* unit);
 
 #endif
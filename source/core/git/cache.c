@@ -4,8 +4,17 @@
 
 #include "external/git.h"
 #include "git/key.h"
+#include "git/tree.h"
 #include "sp/fs.h"
 
+// Pooled files are dated by when they were adopted, and the pool is swept for
+// old ones at most once a day
+#define SPN_GIT_BLOB_MAX_AGE (30 * 24 * 60 * 60)
+#define SPN_GIT_BLOB_PRUNE_EVERY (24 * 60 * 60)
+
+// Blob ids and paths go on git's command line this many at a time
+#define SPN_GIT_BATCH 256
+
 void spn_git_cache_init(spn_git_cache_t* cache, sp_mem_t mem, sp_intern_t* intern, sp_str_t root) {
   *cache = (spn_git_cache_t) {
     .mem = mem,
@@ -13,25 +22,73 @@ void spn_git_cache_init(spn_git_cache_t* cache, sp_mem_t mem, sp_intern_t* inter
     .root = root,
     .db.dir = sp_fs_join_path(mem, root, SP_LIT("db")),
     .checkouts.dir = sp_fs_join_path(mem, root, SP_LIT("checkouts")),
+    .blobs.dir = sp_fs_join_path(mem, root, SP_LIT("blobs")),
   };
 
   sp_str_ht_init(mem, cache->db.entries);
   sp_str_om_init(cache->checkouts.entries);
+}
+
+// Removing a pooled file only drops its name; checkouts linked to it or cloned
+// from it keep their data, so anything in the pool can go
+void spn_git_cache_prune_blobs(spn_git_cache_t* cache, u64 max_age) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  u64 now = sp_tm_now_epoch().s;
+
+  sp_da(sp_fs_entry_t) entries = sp_zero;
+  sp_fs_collect_recursive(scratch.mem, cache->blobs.dir, &entries);
+  sp_da_for(entries, it) {
+    if (entries[it].kind == SP_FS_KIND_DIR) {
+      continue;
+    }
+    sp_sys_file_meta_t meta = sp_zero;
+    if (sp_sys_get_path_metadata_s(sp_sys_get_root(0), entries[it].path, &meta)) {
+      continue;
+    }
+    if ((u64)meta.mtime.tv_sec + max_age <= now) {
+      sp_fs_remove_file(entries[it].path);
+    }
+  }
 
-  sp_fs_create_dir(cache->db.dir);
-  sp_fs_create_dir(cache->checkouts.dir);
+  sp_mem_end_scratch(scratch);
+}
+
+static void spn_git_cache_sweep_blobs(spn_git_cache_t* cache) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  sp_str_t marker = sp_fs_join_path(scratch.mem, cache->root, SP_LIT("blobs.swept"));
+
+  sp_sys_file_meta_t meta = sp_zero;
+  u64 now = sp_tm_now_epoch().s;
+  if (sp_sys_get_path_metadata_s(sp_sys_get_root(0), marker, &meta) || (u64)meta.mtime.tv_sec + SPN_GIT_BLOB_PRUNE_EVERY <= now) {
+    spn_git_cache_prune_blobs(cache, SPN_GIT_BLOB_MAX_AGE);
+    sp_fs_create_file_str(marker, SP_LIT(""));
+  }
+
+  sp_mem_end_scratch(scratch);
 }
 
 static spn_git_db_t* spn_git_cache_db_entry(spn_git_cache_t* cache, sp_str_t url) {
   sp_mutex_lock(&cache->mutex);
 
+  // Every checkout goes through its db first, so this is the one place the
+  // cache needs its dirs; runs that never touch git never create them
+  if (!cache->ready) {
+    cache->ready = true;
+    sp_fs_create_dir(cache->db.dir);
+    sp_fs_create_dir(cache->checkouts.dir);
+    sp_fs_create_dir(cache->blobs.dir);
+    spn_git_cache_sweep_blobs(cache);
+  }
+
   sp_str_t key = spn_git_db_key(cache->mem, url);
   spn_git_db_t** existing = sp_str_ht_get(cache->db.entries, key);
   spn_git_db_t* db = existing ? *existing : SP_NULLPTR;
   if (!db) {
     db = sp_alloc_type(cache->mem, spn_git_db_t);
+    db->mem = cache->mem;
     db->url = url;
     db->path = sp_fs_join_path(cache->mem, cache->db.dir, key);
+    sp_str_ht_init(cache->mem, db->revs);
     sp_str_ht_insert(cache->db.entries, key, db);
   }
 
@@ -52,7 +109,8 @@ spn_err_t spn_git_cache_ensure_db(spn_git_cache_t* cache, sp_str_t url, spn_git_
       sp_ps_output_t result = sp_ps_run(scratch.mem, (sp_ps_config_t) {
         .command = SP_LIT("git"),
         .args = {
-          SP_LIT("clone"), SP_LIT("--bare"), SP_LIT("--quiet"),
+          // Commits and trees only; checkouts pull the blobs they need
+          SP_LIT("clone"), SP_LIT("--bare"), SP_LIT("--quiet"), SP_LIT("--filter=blob:none"),
           SP_LIT("-c"), SP_LIT("core.autocrlf=false"),
           url,
           entry->path
@@ -60,6 +118,22 @@ spn_err_t spn_git_cache_ensure_db(spn_git_cache_t* cache, sp_str_t url, spn_git_
         .io.err.mode = SP_PS_IO_MODE_REDIRECT,
       });
 
+      // Some transports and mirrors refuse a filter outright; a full clone
+      // costs more but works against anything
+      if (result.status.exit_code) {
+        sp_fs_remove_dir(entry->path);
+        result = sp_ps_run(scratch.mem, (sp_ps_config_t) {
+          .command = SP_LIT("git"),
+          .args = {
+            SP_LIT("clone"), SP_LIT("--bare"), SP_LIT("--quiet"),
+            SP_LIT("-c"), SP_LIT("core.autocrlf=false"),
+            url,
+            entry->path
+          },
+          .io.err.mode = SP_PS_IO_MODE_REDIRECT,
+        });
+      }
+
       if (result.status.exit_code) {
         entry->err = SPN_ERROR;
         entry->error = sp_str_copy(cache->mem, sp_str_trim_right(result.out));
@@ -72,8 +146,59 @@ spn_err_t spn_git_cache_ensure_db(spn_git_cache_t* cache, sp_str_t url, spn_git_
   return entry->err;
 }
 
+static void spn_git_db_add_rev(spn_git_db_t* db, sp_str_t rev) {
+  if (sp_str_empty(rev) || sp_str_ht_get(db->revs, rev)) {
+    return;
+  }
+  sp_str_ht_insert(db->revs, sp_str_copy(db->mem, rev), (u8)true);
+}
+
+// One for-each-ref answers every branch, tag and tip commit in the db, which
+// covers nearly every rev a manifest pins; only bare commits deeper in the
+// history need a cat-file of their own
+static void spn_git_db_list_refs(spn_git_db_t* db) {
+  db->listed = true;
+
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  sp_ps_output_t result = sp_ps_run(scratch.mem, (sp_ps_config_t) {
+    .command = SP_LIT("git"),
+    .args = {
+      SP_LIT("-C"), db->path,
+      SP_LIT("for-each-ref"), SP_LIT("--format=%(objectname) %(*objectname) %(refname)")
+    },
+    .io.err.mode = SP_PS_IO_MODE_NULL,
+  });
+
+  if (!result.status.exit_code) {
+    sp_str_for_line(result.out, it) {
+      sp_str_pair_t object = sp_str_cleave_c8(sp_str_trim(it.line), ' ');
+      sp_str_pair_t peeled = sp_str_cleave_c8(object.second, ' ');
+      sp_str_t ref = peeled.second;
+
+      spn_git_db_add_rev(db, object.first);
+      spn_git_db_add_rev(db, peeled.first);
+      spn_git_db_add_rev(db, ref);
+      if (sp_str_starts_with(ref, SP_LIT("refs/heads/"))) {
+        spn_git_db_add_rev(db, sp_str_suffix(ref, ref.len - SP_LIT("refs/heads/").len));
+      }
+      else if (sp_str_starts_with(ref, SP_LIT("refs/tags/"))) {
+        spn_git_db_add_rev(db, sp_str_suffix(ref, ref.len - SP_LIT("refs/tags/").len));
+      }
+    }
+  }
+  sp_mem_end_scratch(scratch);
+}
+
 spn_err_t spn_git_db_ensure_rev(spn_git_db_t* db, sp_str_t rev) {
   sp_mutex_lock(&db->mutex);
+  if (!db->listed) {
+    spn_git_db_list_refs(db);
+  }
+  if (sp_str_ht_get(db->revs, rev)) {
+    sp_mutex_unlock(&db->mutex);
+    return SPN_OK;
+  }
+
   sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
 
   sp_ps_config_t cat_file = {
@@ -95,7 +220,7 @@ spn_err_t spn_git_db_ensure_rev(spn_git_db_t* db, sp_str_t rev) {
       .command = SP_LIT("git"),
       .args = {
         SP_LIT("-C"), db->path,
-        SP_LIT("fetch"), SP_LIT("--quiet"), SP_LIT("origin"), rev
+        SP_LIT("fetch"), SP_LIT("--quiet"), SP_LIT("--filter=blob:none"), SP_LIT("origin"), rev
       },
       .io.err.mode = SP_PS_IO_MODE_NULL,
     });
@@ -105,7 +230,7 @@ spn_err_t spn_git_db_ensure_rev(spn_git_db_t* db, sp_str_t rev) {
         .command = SP_LIT("git"),
         .args = {
           SP_LIT("-C"), db->path,
-          SP_LIT("fetch"), SP_LIT("--quiet"), SP_LIT("origin"),
+          SP_LIT("fetch"), SP_LIT("--quiet"), SP_LIT("--filter=blob:none"), SP_LIT("origin"),
           SP_LIT("+refs/heads/*:refs/heads/*"), SP_LIT("+refs/tags/*:refs/tags/*")
         },
         .io.err.mode = SP_PS_IO_MODE_NULL,
@@ -117,42 +242,290 @@ spn_err_t spn_git_db_ensure_rev(spn_git_db_t* db, sp_str_t rev) {
     }
   }
 
+  if (!result.status.exit_code) {
+    spn_git_db_add_rev(db, rev);
+  }
+
   sp_mem_end_scratch(scratch);
   sp_mutex_unlock(&db->mutex);
   return result.status.exit_code ? SPN_ERROR : SPN_OK;
 }
 
-static spn_err_t spn_git_cache_fill_checkout(spn_git_cache_t* cache, spn_git_checkout_t* entry, spn_git_db_t* db, sp_str_t work) {
+// Unfiltered, and without negotiating: the db already has the commits and
+// trees, so an ordinary fetch would decide there's nothing to send
+static spn_err_t spn_git_db_fetch_full(spn_git_db_t* db, sp_str_t rev) {
+  sp_mutex_lock(&db->mutex);
   sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
-  // Checkouts must be byte-identical to the committed content no matter
-  // what the machine's autocrlf is; hashes and golden comparisons depend
-  // on it. -c on clone persists into the new repo's config.
   sp_ps_output_t result = sp_ps_run(scratch.mem, (sp_ps_config_t) {
     .command = SP_LIT("git"),
     .args = {
-      SP_LIT("clone"), SP_LIT("--shared"), SP_LIT("--quiet"),
-      SP_LIT("-c"), SP_LIT("core.autocrlf=false"),
-      db->path,
-      work
+      SP_LIT("-C"), db->path,
+      SP_LIT("-c"), SP_LIT("remote.origin.partialclonefilter="),
+      SP_LIT("fetch"), SP_LIT("--quiet"), SP_LIT("--refetch"), SP_LIT("origin"), rev
     },
-    .io.err.mode = SP_PS_IO_MODE_REDIRECT,
+    .io.err.mode = SP_PS_IO_MODE_NULL,
   });
+  sp_mem_end_scratch(scratch);
+  sp_mutex_unlock(&db->mutex);
+  return result.status.exit_code ? SPN_ERROR : SPN_OK;
+}
+
+static spn_err_t spn_git_cache_list_tree(spn_git_cache_t* cache, spn_git_checkout_t* entry, spn_git_db_t* db, sp_mem_t mem, sp_da(spn_git_tree_entry_t)* entries) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch_for(mem);
+
+  // The db holds every tree, so listing one never touches the network
+  sp_ps_config_t config = {
+    .command = SP_LIT("git"),
+    .args = {
+      SP_LIT("-C"), db->path,
+      SP_LIT("ls-tree"), SP_LIT("-r"), SP_LIT("-z"), entry->id.rev
+    },
+    .io.err.mode = SP_PS_IO_MODE_NULL,
+  };
+  if (!sp_str_empty(entry->id.dir)) {
+    sp_ps_config_add_arg(scratch.mem, &config, SP_LIT("--"));
+    sp_ps_config_add_arg(scratch.mem, &config, entry->id.dir);
+  }
 
+  sp_ps_output_t result = sp_ps_run(scratch.mem, config);
   spn_err_t err = SPN_OK;
-  if (result.status.exit_code) {
-    entry->error = sp_str_copy(cache->mem, sp_str_trim_right(result.out));
+  if (result.status.exit_code || spn_git_tree_parse(mem, result.out, entries)) {
+    entry->error = sp_fmt(cache->mem, "failed to list {}", sp_fmt_str(entry->id.rev)).value;
     err = SPN_ERROR;
   }
+
   sp_mem_end_scratch(scratch);
-  if (err) {
-    return err;
+  return err;
+}
+
+// Blobs the db doesn't have yet, out of the ones a checkout is about to write.
+// rev-list reports them without lazily fetching each one
+static void spn_git_db_missing_blobs(spn_git_db_t* db, sp_str_t rev, sp_mem_t mem, sp_da(spn_git_tree_entry_t) files, sp_da(sp_str_t)* ids) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch_for(mem);
+  sp_ps_output_t result = sp_ps_run(scratch.mem, (sp_ps_config_t) {
+    .command = SP_LIT("git"),
+    .args = {
+      SP_LIT("-C"), db->path,
+      SP_LIT("rev-list"), SP_LIT("--objects"), SP_LIT("--no-walk"), SP_LIT("--missing=print"), rev
+    },
+    .io.err.mode = SP_PS_IO_MODE_NULL,
+  });
+
+  sp_str_ht(u8) missing = sp_zero;
+  sp_str_ht_init(scratch.mem, missing);
+  sp_str_for_line(result.out, it) {
+    sp_str_t line = sp_str_trim(it.line);
+    if (sp_str_starts_with(line, SP_LIT("?"))) {
+      sp_str_ht_insert(missing, sp_str_suffix(line, line.len - 1), (u8)true);
+    }
+  }
+
+  sp_da_for(files, it) {
+    u8* wanted = sp_str_ht_get(missing, files[it].id);
+    if (wanted && *wanted) {
+      sp_da_push(*ids, sp_str_copy(mem, files[it].id));
+      *wanted = false;
+    }
+  }
+  sp_mem_end_scratch(scratch);
+}
+
+// The same request git makes for a single lazy fetch, with every blob at once
+static spn_err_t spn_git_db_fetch_blobs(spn_git_db_t* db, sp_da(sp_str_t) ids) {
+  sp_mutex_lock(&db->mutex);
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  spn_err_t err = SPN_OK;
+  u64 count = sp_da_size(ids);
+  for (u64 batch = 0; batch < count && !err; batch += SPN_GIT_BATCH) {
+    sp_ps_config_t fetch = {
+      .command = SP_LIT("git"),
+      .args = {
+        SP_LIT("-C"), db->path,
+        SP_LIT("-c"), SP_LIT("fetch.negotiationAlgorithm=noop"),
+        SP_LIT("fetch"), SP_LIT("--quiet"), SP_LIT("--no-tags"), SP_LIT("--no-write-fetch-head"),
+        SP_LIT("--recurse-submodules=no"), SP_LIT("--filter=blob:none"), SP_LIT("origin")
+      },
+      .io.err.mode = SP_PS_IO_MODE_NULL,
+    };
+    sp_for_range(it, batch, sp_min(batch + SPN_GIT_BATCH, count)) {
+      sp_ps_config_add_arg(scratch.mem, &fetch, ids[it]);
+    }
+    err = sp_ps_run(scratch.mem, fetch).status.exit_code ? SPN_ERROR : SPN_OK;
+  }
+  sp_mem_end_scratch(scratch);
+  sp_mutex_unlock(&db->mutex);
+  return err;
+}
+
+// Git run against the db with the checkout as its work tree and an index of
+// the checkout's own, so nothing the db has checked out or staged is touched.
+// Checkouts must be byte-identical to the committed content no matter what
+// the machine's autocrlf is; hashes and golden comparisons depend on it.
+static sp_ps_config_t spn_git_cache_export_config(spn_git_db_t* db, sp_str_t work, sp_str_t index) {
+  return (sp_ps_config_t) {
+    .command = SP_LIT("git"),
+    .args = {
+      SP_LIT("--git-dir"), db->path,
+      SP_LIT("--work-tree"), work,
+      SP_LIT("-c"), SP_LIT("core.autocrlf=false"),
+    },
+    .env = {
+      .extra = {
+        { SP_LIT("GIT_INDEX_FILE"), index },
+      },
+    },
+    .io.err.mode = SP_PS_IO_MODE_NULL,
+  };
+}
+
+// Writes files straight out of the db, with no clone in between. A subdir is
+// read in under its own path, so attributes above it don't apply, the same
+// scope the listing used to decide what to pool
+static spn_err_t spn_git_cache_export(spn_git_cache_t* cache, spn_git_checkout_t* entry, spn_git_db_t* db, sp_str_t work, sp_da(spn_git_tree_entry_t) files) {
+  if (sp_da_empty(files)) {
+    return SPN_OK;
+  }
+
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+
+  // The db has no blobs, so fetch the ones these files need in a single
+  // request rather than one lazy fetch per file. A remote that won't serve
+  // blobs by id gets the rev fetched in full instead.
+  sp_da(sp_str_t) ids = sp_da_new(scratch.mem, sp_str_t);
+  spn_git_db_missing_blobs(db, entry->id.rev, scratch.mem, files, &ids);
+  if (!sp_da_empty(ids) && spn_git_db_fetch_blobs(db, ids)) {
+    spn_git_db_fetch_full(db, entry->id.rev);
+  }
+
+  sp_str_t index = sp_fs_staging_path(scratch.mem, work, SP_LIT("index"));
+  sp_ps_config_t read_tree = spn_git_cache_export_config(db, work, index);
+  sp_ps_config_add_arg(scratch.mem, &read_tree, SP_LIT("read-tree"));
+  if (sp_str_empty(entry->id.dir)) {
+    sp_ps_config_add_arg(scratch.mem, &read_tree, entry->id.rev);
+  }
+  else {
+    sp_ps_config_add_arg(scratch.mem, &read_tree, sp_fmt(scratch.mem, "--prefix={}/", sp_fmt_str(entry->id.dir)).value);
+    sp_ps_config_add_arg(scratch.mem, &read_tree, sp_fmt(scratch.mem, "{}:{}", sp_fmt_str(entry->id.rev), sp_fmt_str(entry->id.dir)).value);
+  }
+  spn_err_t err = sp_ps_run(scratch.mem, read_tree).status.exit_code ? SPN_ERROR : SPN_OK;
+
+  // Paths go on the command line, a batch at a time to stay under its limit
+  u64 count = sp_da_size(files);
+  for (u64 batch = 0; batch < count && !err; batch += SPN_GIT_BATCH) {
+    sp_ps_config_t checkout = spn_git_cache_export_config(db, work, index);
+    sp_ps_config_add_arg(scratch.mem, &checkout, SP_LIT("checkout-index"));
+    sp_ps_config_add_arg(scratch.mem, &checkout, SP_LIT("--force"));
+    sp_ps_config_add_arg(scratch.mem, &checkout, SP_LIT("--"));
+    sp_for_range(it, batch, sp_min(batch + SPN_GIT_BATCH, count)) {
+      sp_ps_config_add_arg(scratch.mem, &checkout, files[it].path);
+    }
+    err = sp_ps_run(scratch.mem, checkout).status.exit_code ? SPN_ERROR : SPN_OK;
   }
+  sp_fs_remove_file(index);
 
-  if (spn_git_checkout(work, entry->id.rev)) {
+  if (err) {
     entry->error = sp_fmt(cache->mem, "failed to check out {}", sp_fmt_str(entry->id.rev)).value;
+  }
+  sp_mem_end_scratch(scratch);
+  return err;
+}
+
+// Every file in the pool is read-only, so whatever is hard linked to it is
+// too, and a build can't write through one checkout into the pool and every
+// other checkout. A clone shares blocks, not the inode, so it's left alone.
+static void spn_git_cache_adopt(sp_mem_t mem, sp_str_t file, sp_str_t blob) {
+  if (sp_fs_exists(blob)) {
+    return;
+  }
+  sp_fs_create_dir(sp_fs_parent_path(blob));
+
+  // A hard link shares the checkout's own inode, so it's the one place the
+  // checkout's file becomes read-only; if that can't be done, it's undone
+  sp_str_t staged = sp_fs_staging_path(mem, blob, SP_LIT("tmp"));
+  if (sp_fs_clone_file(file, staged)) {
+    if (!sp_fs_link(file, blob, SP_FS_LINK_HARD)) {
+      if (sp_fs_set_read_only(blob)) {
+        sp_fs_remove_file(blob);
+      }
+      return;
+    }
+    if (sp_fs_link(file, staged, SP_FS_LINK_COPY)) {
+      return;
+    }
+  }
+
+  sp_sys_fd_t cwd = sp_sys_get_root(0);
+  if (sp_fs_set_read_only(staged) || sp_sys_rename_s(cwd, staged, cwd, blob)) {
+    sp_fs_remove_file(staged);
+  }
+}
+
+// Cloned where the filesystem can share blocks, hard linked to the read-only
+// pool file where it can't, and copied only when neither works
+static spn_err_t spn_git_cache_place(sp_str_t blob, sp_str_t target) {
+  if (!sp_fs_clone_file(blob, target)) {
+    return SPN_OK;
+  }
+  if (!sp_fs_set_read_only(blob) && !sp_fs_link(blob, target, SP_FS_LINK_HARD)) {
+    return SPN_OK;
+  }
+  return sp_fs_link(blob, target, SP_FS_LINK_COPY) ? SPN_ERROR : SPN_OK;
+}
+
+static spn_err_t spn_git_cache_fill_checkout(spn_git_cache_t* cache, spn_git_checkout_t* entry, spn_git_db_t* db, sp_str_t work) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+
+  sp_da(spn_git_tree_entry_t) tree = sp_da_new(scratch.mem, spn_git_tree_entry_t);
+  if (spn_git_cache_list_tree(cache, entry, db, scratch.mem, &tree)) {
+    sp_mem_end_scratch(scratch);
+    return SPN_ERROR;
+  }
+
+  // Attributes can filter what git writes (eol, ident, smudge), so the bytes
+  // on disk aren't the blob's. Such a tree is left to git entirely.
+  bool pooled = !spn_git_tree_has_attributes(tree);
+
+  // Git only writes the files the pool doesn't have
+  sp_da(spn_git_tree_entry_t) fresh = sp_da_new(scratch.mem, spn_git_tree_entry_t);
+  sp_da_for(tree, it) {
+    spn_git_tree_entry_t file = tree[it];
+    if (file.kind == SPN_GIT_TREE_SUBMODULE) {
+      continue;
+    }
+    if (pooled && spn_git_tree_is_pooled(file) && sp_fs_exists(spn_git_tree_blob_path(scratch.mem, cache->blobs.dir, file))) {
+      continue;
+    }
+    sp_da_push(fresh, file);
+  }
+
+  if (spn_git_cache_export(cache, entry, db, work, fresh)) {
+    sp_mem_end_scratch(scratch);
     return SPN_ERROR;
   }
 
+  // Fresh files are adopted by the pool; everything else comes out of it
+  sp_da_for(tree, it) {
+    spn_git_tree_entry_t file = tree[it];
+    if (!pooled || !spn_git_tree_is_pooled(file)) {
+      continue;
+    }
+
+    sp_str_t blob = spn_git_tree_blob_path(scratch.mem, cache->blobs.dir, file);
+    sp_str_t target = sp_fs_join_path(scratch.mem, work, file.path);
+    if (sp_fs_exists(target)) {
+      spn_git_cache_adopt(scratch.mem, target, blob);
+      continue;
+    }
+
+    sp_fs_create_dir(sp_fs_parent_path(target));
+    if (spn_git_cache_place(blob, target)) {
+      entry->error = sp_fmt(cache->mem, "failed to place {}", sp_fmt_str(file.path)).value;
+      sp_mem_end_scratch(scratch);
+      return SPN_ERROR;
+    }
+  }
+  sp_mem_end_scratch(scratch);
+
   sp_da_for(entry->id.patches.files, it) {
     sp_str_t error = sp_zero;
     if (spn_git_apply(cache->mem, work, entry->id.patches.files[it], &error)) {
@@ -172,12 +545,15 @@ static spn_err_t spn_git_cache_materialize_checkout(spn_git_cache_t* cache, spn_
     return SPN_ERROR;
   }
 
-  if (spn_git_db_ensure_rev(db, entry->id.rev)) {
+  // A checkout is keyed by its rev, so one on disk already proves the db has
+  // it; a warm sync never asks git anything
+  bool placed = sp_fs_is_dir(entry->path);
+  if (!placed && spn_git_db_ensure_rev(db, entry->id.rev)) {
     entry->error = sp_fmt(cache->mem, "{} has no rev {}", sp_fmt_str(entry->id.url), sp_fmt_str(entry->id.rev)).value;
     return SPN_ERROR;
   }
 
-  if (!sp_fs_is_dir(entry->path)) {
+  if (!placed) {
     entry->fetched = true;
 
     // Fill a claimed staging dir and rename into place, so a crash never
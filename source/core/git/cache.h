@@ -9,6 +9,7 @@ void      spn_git_cache_init(spn_git_cache_t* cache, sp_mem_t mem, sp_intern_t*
 spn_err_t spn_git_cache_ensure_db(spn_git_cache_t* cache, sp_str_t url, spn_git_db_t** db);
 spn_err_t spn_git_cache_ensure_checkout(spn_git_cache_t* cache, spn_git_checkout_id_t id, spn_git_checkout_t** checkout);
 bool      spn_git_cache_is_checkout_cached(spn_git_cache_t* cache, spn_git_checkout_id_t id);
+void      spn_git_cache_prune_blobs(spn_git_cache_t* cache, u64 max_age);
 spn_err_t spn_git_db_ensure_rev(spn_git_db_t* db, sp_str_t rev);
 
 #endif
@@ -0,0 +1,75 @@
+#include "sp.h"
+#include "git/tree.h"
+
+static bool spn_git_tree_kind(sp_str_t mode, spn_git_tree_kind_t* kind) {
+  if (sp_str_equal(mode, sp_str_lit("100644"))) {
+    *kind = SPN_GIT_TREE_FILE;
+  }
+  else if (sp_str_equal(mode, sp_str_lit("100755"))) {
+    *kind = SPN_GIT_TREE_EXECUTABLE;
+  }
+  else if (sp_str_equal(mode, sp_str_lit("120000"))) {
+    *kind = SPN_GIT_TREE_SYMLINK;
+  }
+  else if (sp_str_equal(mode, sp_str_lit("160000"))) {
+    *kind = SPN_GIT_TREE_SUBMODULE;
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+// Parses ls-tree -r -z: "<mode> <type> <id>\t<path>\0" per entry, with paths
+// unquoted
+spn_err_t spn_git_tree_parse(sp_mem_t mem, sp_str_t listing, sp_da(spn_git_tree_entry_t)* entries) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch_for(mem);
+  sp_da(sp_str_t) records = sp_str_split_c8(scratch.mem, listing, '\0');
+
+  sp_da_for(records, it) {
+    sp_str_t record = records[it];
+    if (sp_str_empty(record)) {
+      continue;
+    }
+
+    sp_str_pair_t row = sp_str_cleave_c8(record, '\t');
+    sp_str_pair_t mode = sp_str_cleave_c8(row.first, ' ');
+    sp_str_pair_t type = sp_str_cleave_c8(mode.second, ' ');
+
+    spn_git_tree_entry_t entry = sp_zero;
+    if (!spn_git_tree_kind(mode.first, &entry.kind) || sp_str_empty(type.second) || sp_str_empty(row.second)) {
+      sp_mem_end_scratch(scratch);
+      return SPN_ERROR;
+    }
+    entry.id = sp_str_copy(mem, type.second);
+    entry.path = sp_str_copy(mem, row.second);
+    sp_da_push(*entries, entry);
+  }
+
+  sp_mem_end_scratch(scratch);
+  return SPN_OK;
+}
+
+// Symlinks are left to git, which knows how the platform wants them written
+bool spn_git_tree_is_pooled(spn_git_tree_entry_t entry) {
+  return entry.kind == SPN_GIT_TREE_FILE || entry.kind == SPN_GIT_TREE_EXECUTABLE;
+}
+
+bool spn_git_tree_has_attributes(sp_da(spn_git_tree_entry_t) entries) {
+  sp_da_for(entries, it) {
+    sp_str_t path = entries[it].path;
+    if (sp_str_equal(path, sp_str_lit(".gitattributes")) || sp_str_ends_with(path, sp_str_lit("/.gitattributes"))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+sp_str_t spn_git_tree_blob_path(sp_mem_t mem, sp_str_t pool, spn_git_tree_entry_t entry) {
+  sp_str_t fan = sp_str_prefix(entry.id, sp_min(entry.id.len, 2));
+  sp_str_t rest = sp_str_sub(entry.id, fan.len, entry.id.len - fan.len);
+  if (entry.kind == SPN_GIT_TREE_EXECUTABLE) {
+    rest = sp_str_concat(mem, rest, sp_str_lit("-x"));
+  }
+  return sp_fs_join_path(mem, sp_fs_join_path(mem, pool, fan), rest);
+}
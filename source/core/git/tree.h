@@ -0,0 +1,16 @@
+#ifndef SPN_GIT_TREE_H
+#define SPN_GIT_TREE_H
+
+#include "sp.h"
+
+#include "git/types.h"
+
+// Checkouts are assembled from a pool of files named by blob id, cloned or
+// linked into place, so a file shared by many revisions is fetched and stored
+// once. The executable bit lives on the inode, so it's part of the name
+spn_err_t spn_git_tree_parse(sp_mem_t mem, sp_str_t listing, sp_da(spn_git_tree_entry_t)* entries);
+bool      spn_git_tree_is_pooled(spn_git_tree_entry_t entry);
+bool      spn_git_tree_has_attributes(sp_da(spn_git_tree_entry_t) entries);
+sp_str_t  spn_git_tree_blob_path(sp_mem_t mem, sp_str_t pool, spn_git_tree_entry_t entry);
+
+#endif
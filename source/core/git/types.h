@@ -7,11 +7,17 @@
 #include "intern/types.h"
 #include "spn/core.h"
 
+// revs holds every name and object id this session has seen resolve in the
+// db: ref names and their tips are read in one listing the first time a rev
+// is asked for, and anything else is added once cat-file confirms it
 typedef struct {
+  sp_mem_t mem;
   sp_str_t url;
   sp_str_t path;
   sp_mutex_t mutex;
   bool ready;
+  bool listed;
+  sp_str_ht(u8) revs;
   spn_err_t err;
   sp_str_t error;
 } spn_git_db_t;
@@ -30,6 +36,20 @@ typedef struct {
   spn_git_patch_set_t patches;
 } spn_git_checkout_id_t;
 
+typedef enum {
+  SPN_GIT_TREE_FILE,
+  SPN_GIT_TREE_EXECUTABLE,
+  SPN_GIT_TREE_SYMLINK,
+  SPN_GIT_TREE_SUBMODULE,
+} spn_git_tree_kind_t;
+
+// One row of ls-tree -r; id is the blob (or, for a submodule, commit) hash
+typedef struct {
+  spn_git_tree_kind_t kind;
+  sp_str_t id;
+  sp_str_t path;
+} spn_git_tree_entry_t;
+
 typedef struct {
   spn_git_checkout_id_t id;
   sp_str_t path;
@@ -45,6 +65,7 @@ typedef struct {
   sp_intern_t* intern;
   sp_str_t root;
   sp_mutex_t mutex;
+  bool ready;
   struct {
     sp_str_t dir;
     sp_str_ht(spn_git_db_t*) entries;
@@ -53,6 +74,9 @@ typedef struct {
     sp_str_t dir;
     sp_str_om(spn_git_checkout_t*) entries;
   } checkouts;
+  struct {
+    sp_str_t dir;
+  } blobs;
 } spn_git_cache_t;
 
 #endif
@@ -35,10 +35,6 @@ spn_path_t spn_target_exports_path(sp_mem_t mem, spn_target_unit_t* target) {
   return path;
 }
 
-spn_path_t spn_target_exports_archive(sp_mem_t mem, spn_path_t exports) {
-  return spn_path_suffix(mem, exports, sp_str_lit(".a"));
-}
-
 spn_path_t spn_target_unit_staged_path(sp_mem_t mem, spn_target_unit_t* target) {
   if (target->kind != SPN_CC_OUTPUT_EXE) return sp_zero_s(spn_path_t);
 
@@ -34,9 +34,15 @@
 typedef struct {
   spn_target_unit_t* target;
   sp_da(spn_dag_id_t) objects;
+  sp_da(spn_dag_id_t) symbols;
   spn_dag_id_t exports;
 } spn_dag_link_ctx_t;
 
+typedef struct {
+  spn_target_unit_t* target;
+  spn_dag_id_t object;
+} spn_dag_symbols_ctx_t;
+
 typedef struct {
   spn_pkg_unit_t* pkg;
   sp_da(spn_dag_obs_t) obs;
@@ -84,7 +90,7 @@ static sp_da(spn_path_t) dag_declared_paths(sp_mem_t mem, spn_dag_t* g, sp_da(sp
 static spn_dag_digest_t hash_embedding(spn_target_unit_t* target) {
   spn_sha256_ctx_t ctx = sp_zero;
   spn_sha256_init(&ctx);
-  spn_dag_hash_str(&ctx, sp_str_lit("spn.build.embed.v6"));
+  spn_dag_hash_str(&ctx, sp_str_lit("spn.build.embed.v8"));
   spn_dag_hash_str(&ctx, target->pkg->info->qualified);
   spn_dag_hash_str(&ctx, target->info->name);
   spn_dag_hash_u8(&ctx, (u8)target->info->kind);
@@ -177,14 +183,19 @@ static s32 dag_link_exec(spn_dag_t* g, spn_dag_action_t* action, void* user_data
   return spn_link_target_run(target, dag_artifact_path(g, action->produces[0]), objects, exports);
 }
 
+static s32 dag_symbols_exec(spn_dag_t* g, spn_dag_action_t* action, void* user_data) {
+  spn_dag_symbols_ctx_t* symbols = (spn_dag_symbols_ctx_t*)user_data;
+  return spn_link_symbols_run(symbols->target, dag_artifact_path(g, symbols->object), dag_artifact_path(g, action->produces[0]));
+}
+
 static s32 dag_exports_exec(spn_dag_t* g, spn_dag_action_t* action, void* user_data) {
   spn_dag_link_ctx_t* link = (spn_dag_link_ctx_t*)user_data;
 
-  sp_da(spn_path_t) objects = sp_da_new(spn.mem, spn_path_t);
-  sp_da_for(link->objects, it) {
-    sp_da_push(objects, dag_artifact_path(g, link->objects[it]));
+  sp_da(spn_path_t) lists = sp_da_new(spn.mem, spn_path_t);
+  sp_da_for(link->symbols, it) {
+    sp_da_push(lists, dag_artifact_path(g, link->symbols[it]));
   }
-  return spn_link_exports_run(link->target, objects, dag_artifact_path(g, action->produces[0]));
+  return spn_link_exports_run(link->target, lists, dag_artifact_path(g, action->produces[0]));
 }
 
 static s32 generate_embedding(spn_dag_t* g, spn_dag_action_t* action, void* user_data) {
@@ -218,7 +229,9 @@ static s32 dag_user_exec(spn_dag_t* g, spn_dag_action_t* action, void* user_data
 
   sp_da_init(spn.mem, ctx->obs);
   if (!sp_str_empty(node->fn)) {
-    if (spn_wasm_call_export_ex(pkg, node->fn, SPN_ABI_KIND_NONE, SP_NULLPTR, (spn_wasm_obs_t) { .mem = spn.mem, .out = &ctx->obs })) {
+    spn_err_t err = spn_wasm_call_export_ex(pkg, node->fn, SPN_ABI_KIND_NONE, SP_NULLPTR, (spn_wasm_obs_t) { .mem = spn.mem, .out = &ctx->obs });
+    spn_wasm_unit_release(pkg);
+    if (err) {
       return 1;
     }
   }
@@ -440,21 +453,25 @@ static s32 dag_package_exec(spn_dag_t* g, spn_dag_action_t* action, void* user_d
   }
 
   spn_wasm_script_t* script = SP_NULLPTR;
-  if (spn_wasm_find_export(unit, sp_str_lit("package"), &script)) {
-    return 1;
-  }
-  if (script) {
+  spn_err_t err = spn_wasm_find_export(unit, sp_str_lit("package"), &script);
+  if (!err && script) {
     spn_event_buffer_push(spn.events, (spn_event_t) {
       .kind = SPN_EVENT_SCRIPT_PACKAGE,
       .pkg = unit->info->name,
     });
 
     sp_tm_timer_t timer = sp_tm_start_timer();
-    if (spn_wasm_script_call_ex(script, unit, sp_str_lit("package"), SPN_ABI_KIND_NONE, SP_NULLPTR, (spn_wasm_obs_t) { .mem = spn.mem, .out = &ctx->obs })) {
-      return 1;
-    }
+    err = spn_wasm_script_call_ex(script, unit, sp_str_lit("package"), SPN_ABI_KIND_NONE, SP_NULLPTR, (spn_wasm_obs_t) { .mem = spn.mem, .out = &ctx->obs });
     unit->time.package = sp_tm_read_timer(&timer);
+  }
+  if (unit->metaprogram) {
+    spn_wasm_unit_release(unit);
+  }
+  if (err) {
+    return 1;
+  }
 
+  if (script) {
     spn_event_buffer_push(spn.events, (spn_event_t) {
       .kind = SPN_EVENT_PACKAGE_OK,
       .pkg = unit->info->name,
@@ -512,6 +529,12 @@ static spn_err_t dag_add_user_nodes(spn_dag_build_t* b, spn_pkg_unit_t* unit, sp
       sp_da_push(node->outputs, spn_pkg_unit_get_node_stamp_file(unit, node));
     }
 
+    // Each node that calls into the script keeps its instances alive until it
+    // has run; the last one out frees them
+    if (!sp_str_empty(node->fn)) {
+      spn_wasm_unit_retain(unit);
+    }
+
     spn_dag_id_t action = spn_dag_add_action(g, (spn_dag_action_config_t) {
       .identity = spn_build_user_identity(node, &pin),
       .execute = dag_user_exec,
@@ -593,23 +616,37 @@ static spn_err_t dag_add_exports(spn_dag_build_t* b, spn_dag_link_ctx_t* link) {
   spn_dag_t* g = b->graph;
   spn_target_unit_t* target = link->target;
 
-  spn_path_t output = spn_target_exports_path(b->mem, target);
-  spn_dag_digest_t identity = sp_zero;
-  sp_mem_arena_marker_t s = sp_mem_begin_scratch();
-  spn_err_t err = spn_build_exports_identity(s.mem, target, output, dag_declared_paths(s.mem, g, link->objects), &identity);
-  sp_mem_end_scratch(s);
-  spn_try(err);
+  // Each object's symbols are read by their own action, so they run in
+  // parallel and hit the cache per object instead of per target
+  spn_dag_digest_t symbols = spn_build_symbols_identity(target);
+  sp_da_init(b->mem, link->symbols);
+  sp_da_for(link->objects, it) {
+    spn_dag_symbols_ctx_t* ctx = sp_alloc_type(b->mem, spn_dag_symbols_ctx_t);
+    ctx->target = target;
+    ctx->object = link->objects[it];
+
+    spn_dag_id_t action = spn_dag_add_action(g, (spn_dag_action_config_t) {
+      .identity = symbols,
+      .execute = dag_symbols_exec,
+      .user_data = ctx,
+    });
+    spn_dag_action_add_input(g, action, link->objects[it]);
+    spn_dag_id_t list = spn_dag_add_output(g, sp_str_lit("symbols"));
+    spn_try(spn_dag_action_add_output(g, action, list));
+    sp_da_push(link->symbols, list);
+  }
 
+  spn_path_t output = spn_target_exports_path(b->mem, target);
   spn_dag_id_t action = spn_dag_add_action(g, (spn_dag_action_config_t) {
-    .identity = identity,
+    .identity = spn_build_exports_identity(target, output),
     .execute = dag_exports_exec,
     .user_data = link,
   });
   link->exports = spn_dag_add_file(g, output);
   spn_try(spn_dag_action_add_output(g, action, link->exports));
 
-  sp_da_for(link->objects, it) {
-    spn_dag_action_add_input(g, action, link->objects[it]);
+  sp_da_for(link->symbols, it) {
+    spn_dag_action_add_input(g, action, link->symbols[it]);
   }
   sp_da_for(target->link.archives, it) {
     spn_dag_action_add_input(g, action, spn_dag_add_file(g, target->link.archives[it]));
@@ -716,6 +753,9 @@ spn_err_t spn_dag_build_add_target(spn_dag_build_t* b, spn_target_unit_t* target
   }
   ids.output = spn_dag_add_file(g, output);
   spn_try(spn_dag_action_add_output(g, ids.action, ids.output));
+  if (spn_target_is_thin_archive(target)) {
+    ids.members = link->objects;
+  }
 
   sp_ht_insert(b->ids.targets, target, ids);
   return SPN_OK;
@@ -796,6 +836,9 @@ static spn_err_t dag_add_package_action(spn_dag_build_t* b, spn_pkg_unit_t* unit
   sp_da_init(b->mem, ctx->obs);
 
   spn_build_source_pin_t pin = spn_build_source_pin(unit);
+  if (unit->metaprogram) {
+    spn_wasm_unit_retain(unit);
+  }
   pkg->action = spn_dag_add_action(g, (spn_dag_action_config_t) {
     .identity = spn_build_package_identity(unit, &pin),
     .execute = dag_package_exec,
@@ -863,6 +906,9 @@ static void dag_add_link_deps(spn_dag_build_t* b, spn_target_unit_t* target, spn
     spn_dag_target_ids_t* dep = sp_ht_getp(b->ids.targets, target->link.libs[it].lib);
     if (dep) {
       spn_dag_action_add_input(g, action, dep->output);
+      sp_da_for(dep->members, mt) {
+        spn_dag_action_add_input(g, action, dep->members[mt]);
+      }
     }
   }
 }
@@ -1031,7 +1077,7 @@ static void dag_stage_link(spn_dag_build_t* b, dag_staged_t* staged, spn_path_t
   }
   sp_mem_end_scratch(scratch);
 
-  spn_dag_file_cache_invalidate(&b->files, to);
+  spn_dag_file_cache_invalidate(b->files, to);
 }
 
 static void dag_stage_dir(spn_dag_build_t* b, dag_staged_t* staged, spn_path_t from, spn_path_t to) {
@@ -1068,8 +1114,8 @@ static void dag_stage_copy(spn_dag_build_t* b, dag_staged_t* staged, spn_dag_id_
   sp_sys_file_meta_t staged_meta = sp_zero;
   spn_dag_digest_t staged_digest = sp_zero;
   if (spn_dag_digest_valid(artifact->digest) &&
-      !spn_dag_file_cache_stat(&b->files, to, &staged_meta) && staged_meta.nlink == 1 &&
-      !spn_dag_file_cache_digest(&b->files, to, &staged_digest) &&
+      !spn_dag_file_cache_stat(b->files, to, &staged_meta) && staged_meta.nlink == 1 &&
+      !spn_dag_file_cache_digest(b->files, to, &staged_digest) &&
       spn_dag_digest_equal(staged_digest, artifact->digest)) {
     return;
   }
@@ -1094,7 +1140,7 @@ static void dag_stage_copy(spn_dag_build_t* b, dag_staged_t* staged, spn_dag_id_
   }
   sp_mem_end_scratch(scratch);
 
-  spn_dag_file_cache_invalidate(&b->files, to);
+  spn_dag_file_cache_invalidate(b->files, to);
 }
 
 static void dag_stage_pkg_store(spn_dag_build_t* b, dag_staged_t* staged, spn_pkg_unit_t* unit, spn_path_t root) {
@@ -1279,18 +1325,29 @@ spn_dag_build_t* spn_dag_build_new(spn_op_t* op) {
     .roots = &spn.roots,
     .dir = spn_path_join(session->mem, root, sp_str_lit("store")),
   });
-  spn_dag_file_cache_init(&b->files, spn.mem, &spn.roots);
   spn_dag_action_cache_init(&b->actions, spn.mem, sp_fs_join_path(session->mem, dir, sp_str_lit("strong")));
   spn_dag_obs_table_init(&b->discovery, spn.mem, sp_fs_join_path(session->mem, dir, sp_str_lit("weak")));
-  b->files.stats = &b->stats;
+  b->files_path = sp_fs_join_path(session->mem, dir, sp_str_lit("files"));
+
+  // Under a watch the file cache outlives the build; the watcher keeps it
+  // honest in between, so only the first build stats and reads hints
+  b->files = spn.watch ? spn.watch->files : SP_NULLPTR;
+  if (!b->files) {
+    b->files = sp_alloc_type(spn.mem, spn_dag_file_cache_t);
+    sp_mem_zero(b->files, sizeof(spn_dag_file_cache_t));
+    spn_dag_file_cache_init(b->files, spn.mem, &spn.roots);
+    spn_dag_file_cache_load(b->files, b->files_path);
+    if (spn.watch) {
+      spn.watch->files = b->files;
+    }
+  }
+  b->files->stats = &b->stats;
   b->actions.stats = &b->stats;
   b->discovery.stats = &b->stats;
   b->store.stats = &b->stats;
-  b->files_path = sp_fs_join_path(session->mem, dir, sp_str_lit("files"));
-  spn_dag_file_cache_load(&b->files, b->files_path);
 
   b->env = (spn_dag_env_t) {
-    .files = &b->files,
+    .files = b->files,
     .cache = &b->actions,
     .store = &b->store,
     .discovery = &b->discovery,
@@ -1313,7 +1370,14 @@ spn_err_t spn_dag_build_run(spn_dag_build_t* b, u32 workers) {
   b->timer = sp_tm_start_timer();
   b->result = spn_dag_run_executor(b->graph, &b->env, &b->pool.executor);
   spn_thread_pool_deinit(&b->pool);
-  spn_dag_file_cache_flush(&b->files, b->files_path);
+  spn_dag_file_cache_flush(b->files, b->files_path);
+
+  // Cache hits and failed dependencies never reach the release in their
+  // executor, so sweep whatever instances are left
+  sp_ht_for_kv(b->ids.packages, it) {
+    sp_atomic_s32_store(&(*it.key)->wasm.pending, 0, SP_ATOMIC_SEQ_CST);
+    spn_wasm_unit_trim(*it.key);
+  }
   return dag_result(b);
 }
 
@@ -1352,7 +1416,7 @@ spn_err_t spn_dag_build_session(spn_op_t* op) {
       spn_try(spn_project_update_lock(session->ctx, project, session->resolve));
     }
     dag_stage(b);
-    spn_dag_file_cache_flush(&b->files, b->files_path);
+    spn_dag_file_cache_flush(b->files, b->files_path);
   }
 
   dag_emit_reports(b, elapsed);
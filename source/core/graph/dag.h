@@ -14,6 +14,9 @@ typedef struct {
 typedef struct {
   spn_dag_id_t action;
   spn_dag_id_t output;
+  // A thin archive's digest covers member names and symbols, not code, so
+  // whatever links it must also depend on the objects it points at
+  sp_da(spn_dag_id_t) members;
   struct {
     spn_dag_id_t action;
     spn_dag_id_t object;
@@ -23,6 +26,8 @@ typedef struct {
 
 typedef struct {
   spn_dag_id_t action;
+  // Configure only: the cached run of the package's configure script
+  spn_dag_id_t script;
   spn_dag_id_t stamp;
   spn_dag_id_t tree;
   sp_da(spn_dag_id_t) user_outputs;
@@ -44,7 +49,7 @@ struct spn_dag_build_t {
     sp_ht(spn_target_unit_t*, spn_dag_target_ids_t) targets;
     sp_ht(spn_compile_unit_t*, spn_dag_object_ids_t) objects;
   } ids;
-  spn_dag_file_cache_t files;
+  spn_dag_file_cache_t* files;
   spn_dag_action_cache_t actions;
   spn_dag_obs_table_t discovery;
   sp_str_t files_path;
@@ -1,6 +1,7 @@
 #include "graph/identity.h"
 
 #include "compiler/driver.h"
+#include "ctx/types.h"
 #include "dag/dag.h"
 #include "graph/build.h"
 #include "paths/paths.h"
@@ -92,6 +93,19 @@ spn_dag_digest_t spn_build_package_identity(spn_pkg_unit_t* unit, const spn_buil
   return spn_dag_hash_final(&ctx);
 }
 
+// The unit fingerprint covers the resolved options, profile, toolchain and
+// deps; the script itself is an input, and what it reads is discovered
+spn_dag_digest_t spn_build_configure_identity(spn_pkg_unit_t* unit, const spn_build_source_pin_t* pin) {
+  spn_sha256_ctx_t ctx = sp_zero;
+  spn_sha256_init(&ctx);
+  spn_dag_hash_str(&ctx, sp_str_lit("spn.configure.v1"));
+  spn_dag_hash_str(&ctx, unit->info->qualified);
+  identity_hash_pin(&ctx, pin);
+  spn_dag_hash_u64(&ctx, spn_unit_fingerprint(unit->session, unit->build, unit->id.pkg));
+  spn_dag_hash_path(&ctx, unit->paths.work);
+  return spn_dag_hash_final(&ctx);
+}
+
 spn_dag_digest_t spn_build_user_identity(spn_user_node_t* node, const spn_build_source_pin_t* pin) {
   spn_sha256_ctx_t ctx = sp_zero;
   spn_sha256_init(&ctx);
@@ -116,7 +130,7 @@ spn_dag_digest_t spn_build_compile_identity(const spn_compile_unit_t* unit) {
   sp_assert(!spn_arg_empty(unit->invocation.program));
   spn_sha256_ctx_t ctx = sp_zero;
   spn_sha256_init(&ctx);
-  spn_dag_hash_str(&ctx, sp_str_lit("spn.build.compile.v5"));
+  spn_dag_hash_str(&ctx, sp_str_lit("spn.build.compile.v6"));
   identity_hash_invocation(&ctx, unit->target->pkg->build->toolchain, &unit->invocation);
   spn_dag_hash_path(&ctx, unit->paths.file);
   return spn_dag_hash_final(&ctx);
@@ -134,30 +148,42 @@ spn_err_t spn_build_link_identity(sp_mem_t mem, spn_target_unit_t* target, spn_p
 
   spn_sha256_ctx_t ctx = sp_zero;
   spn_sha256_init(&ctx);
-  spn_dag_hash_str(&ctx, sp_str_lit("spn.build.link.v5"));
+  spn_dag_hash_str(&ctx, sp_str_lit("spn.build.link.v6"));
   identity_hash_invocation(&ctx, target->pkg->build->toolchain, &invocation);
+
+  // A thin archive records its members by absolute path, and objects settle
+  // at their declared paths, so a cached one is only good where they are
+  if (spn_target_is_thin_archive(target)) {
+    sp_da_for(objects, it) {
+      spn_dag_hash_str(&ctx, spn_path_str(&spn.roots, mem, objects[it]));
+    }
+  }
   *identity = spn_dag_hash_final(&ctx);
   return SPN_OK;
 }
 
-spn_err_t spn_build_exports_identity(sp_mem_t mem, spn_target_unit_t* target, spn_path_t output, sp_da(spn_path_t) objects, spn_dag_digest_t* identity) {
+// Keyed on the object's digest alone, not its path, so identical objects
+// share one entry
+spn_dag_digest_t spn_build_symbols_identity(spn_target_unit_t* target) {
   spn_build_unit_t* build = target->pkg->build;
-  spn_cc_archive_files_t files = {
-    .output = spn_target_exports_archive(mem, output),
-    .objects = objects,
-  };
-
-  spn_invocation_t invocation = sp_zero;
-  spn_try(spn_cc_render_archive(mem, &build->toolchain->cc, &build->profile, &files, &invocation));
-  invocation.cwd = target->pkg->paths.work;
+  spn_sha256_ctx_t ctx = sp_zero;
+  spn_sha256_init(&ctx);
+  spn_dag_hash_str(&ctx, sp_str_lit("spn.build.symbols.v1"));
+  // The archiver is the fallback for objects the reader can't parse
+  spn_dag_hash_u64(&ctx, build->toolchain->identity);
+  spn_dag_hash_u8(&ctx, (u8)build->profile.os);
+  return spn_dag_hash_final(&ctx);
+}
 
+spn_dag_digest_t spn_build_exports_identity(spn_target_unit_t* target, spn_path_t output) {
+  spn_build_unit_t* build = target->pkg->build;
   spn_sha256_ctx_t ctx = sp_zero;
   spn_sha256_init(&ctx);
-  spn_dag_hash_str(&ctx, sp_str_lit("spn.build.exports.v3"));
-  identity_hash_invocation(&ctx, build->toolchain, &invocation);
+  spn_dag_hash_str(&ctx, sp_str_lit("spn.build.exports.v5"));
+  spn_dag_hash_path(&ctx, output);
+  spn_dag_hash_str(&ctx, target->info->name);
   spn_dag_hash_u8(&ctx, (u8)target->kind);
   spn_dag_hash_u8(&ctx, (u8)build->profile.os);
   spn_dag_hash_paths(&ctx, target->link.archives);
-  *identity = spn_dag_hash_final(&ctx);
-  return SPN_OK;
+  return spn_dag_hash_final(&ctx);
 }
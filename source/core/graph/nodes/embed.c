@@ -39,7 +39,7 @@ s32 spn_embed_write(spn_target_unit_t* unit, spn_path_t object, spn_path_t heade
     spn_embed_t embed = info->embed[it];
     sp_str_t symbol = embed.symbol;
     spn_embed_types_t types = embed.types;
-    sp_mem_buffer_t data = sp_zero;
+    sp_str_t file = sp_zero;
 
     if (sp_str_empty(types.data)) {
       types.data = sp_str_lit("unsigned char");
@@ -52,9 +52,8 @@ s32 spn_embed_write(spn_target_unit_t* unit, spn_path_t object, spn_path_t heade
     switch (embed.kind) {
       case SPN_EMBED_FILE: {
         embed_obs(obs, SPN_DAG_OBS_FILE, embed.file.path);
-        sp_str_t file = spn_path_str(&spn.roots, embedder.mem, embed.file.path);
-        sp_str_t content = sp_zero;
-        if (sp_io_read_file(embedder.mem, file, &content) != SP_OK) {
+        file = spn_path_str(&spn.roots, embedder.mem, embed.file.path);
+        if (!sp_fs_is_file(file)) {
           spn_event_buffer_push(spn.events, (spn_event_t) {
             .kind = SPN_EVENT_EMBED_FAILED,
             .pkg = unit->pkg->info->name,
@@ -63,12 +62,6 @@ s32 spn_embed_write(spn_target_unit_t* unit, spn_path_t object, spn_path_t heade
           return SPN_ERROR;
         }
 
-        data = (sp_mem_buffer_t) {
-          .data = (u8*)(uintptr_t)content.data,
-          .len = content.len,
-          .capacity = content.len,
-        };
-
         if (sp_str_empty(symbol)) {
           symbol = spn_cc_symbol_from_embedded_file(embedder.mem, spn_tree_rel(unit->pkg->paths.roots, embed.file.path).sub);
         }
@@ -92,19 +85,8 @@ s32 spn_embed_write(spn_target_unit_t* unit, spn_path_t object, spn_path_t heade
           if (!sp_str_empty(embed.dir.dest)) {
             rel = sp_fs_join_path(embedder.mem, embed.dir.dest, rel);
           }
-          sp_str_t content = sp_zero;
-          spn_err_t err = SPN_OK;
-          if (sp_io_read_file(embedder.mem, entries[e].path, &content) != SP_OK) {
-            err = SPN_ERROR;
-          } else {
-            sp_mem_buffer_t entry_data = {
-              .data = (u8*)(uintptr_t)content.data,
-              .len = content.len,
-              .capacity = content.len,
-            };
-            err = spn_cc_embed_ctx_add(&embedder, entry_data, spn_cc_symbol_from_embedded_file(embedder.mem, rel), rel, types.data, types.size);
-          }
-          if (err) {
+          sp_str_t entry_symbol = spn_cc_symbol_from_embedded_file(embedder.mem, rel);
+          if (spn_cc_embed_ctx_add(&embedder, entries[e].path, entry_symbol, rel, types.data, types.size)) {
             spn_event_buffer_push(spn.events, (spn_event_t) {
               .kind = SPN_EVENT_EMBED_FAILED,
               .pkg = unit->pkg->info->name,
@@ -120,11 +102,11 @@ s32 spn_embed_write(spn_target_unit_t* unit, spn_path_t object, spn_path_t heade
     }
 
     sp_str_t path = embed.kind == SPN_EMBED_FILE ? spn_tree_rel(unit->pkg->paths.roots, embed.file.path).sub : sp_str_lit("");
-    if (spn_cc_embed_ctx_add(&embedder, data, symbol, path, types.data, types.size)) {
+    if (spn_cc_embed_ctx_add(&embedder, file, symbol, path, types.data, types.size)) {
       spn_event_buffer_push(spn.events, (spn_event_t) {
         .kind = SPN_EVENT_EMBED_FAILED,
         .pkg = unit->pkg->info->name,
-        .embed_failed = { .target = info->name, .error = sp_str_lit("embed add failed") },
+        .embed_failed = { .target = info->name, .path = file, .error = sp_str_lit("embed add failed") },
       });
       return SPN_ERROR;
     }
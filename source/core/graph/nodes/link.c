@@ -7,6 +7,7 @@
 #include "external/cc.h"
 #include "compiler/driver.h"
 #include "compiler/exports.h"
+#include "compiler/symtab.h"
 #include "compiler/toc.h"
 #include "error/error.h"
 #include "event/event.h"
@@ -82,15 +83,30 @@ static spn_err_t read_archive_symbols(sp_str_t path, sp_da(sp_str_t)* symbols, s
   return SPN_OK;
 }
 
-static spn_err_t link_exports_exec(sp_mem_t scratch, spn_target_unit_t* target, sp_da(spn_path_t) objects, spn_path_t output) {
+static spn_err_t write_symbols(sp_mem_t scratch, spn_path_t output, sp_da(sp_str_t) symbols) {
+  sp_str_t path = spn_path_str(&spn.roots, scratch, output);
+  sp_io_file_writer_t writer = sp_zero;
+  if (sp_io_file_writer_from_path(&writer, path) != SP_OK) {
+    return spn_err_emit(&spn, (spn_err_union_t) { .kind = SPN_ERR_FS_WRITE, .fs.path = path });
+  }
+  spn_exports_render_symbol_list(&writer.base, symbols);
+  sp_io_file_writer_close(&writer);
+  return SPN_OK;
+}
+
+// For objects the symbol table reader doesn't understand (bitcode, wasm),
+// let the archiver do it: archive just this object and read back the TOC
+static spn_err_t archive_object_symbols(sp_mem_t scratch, spn_target_unit_t* target, spn_path_t object, spn_path_t output, sp_da(sp_str_t)* symbols) {
   spn_pkg_unit_t* pkg = target->pkg;
   spn_profile_info_t* profile = &pkg->build->profile;
   spn_cc_toolchain_t* toolchain = &pkg->build->toolchain->cc;
 
   spn_cc_archive_files_t files = {
-    .output = spn_target_exports_archive(spn.mem, output),
-    .objects = objects,
+    .output = spn_path_suffix(scratch, output, sp_str_lit(".a")),
+    .objects = sp_da_new(scratch, spn_path_t),
+    .thin = spn_cc_supports_thin_archive(toolchain, profile),
   };
+  sp_da_push(files.objects, object);
   spn_invocation_t* invocation = sp_alloc_type(spn.mem, spn_invocation_t);
   spn_try(spn_cc_render_archive(spn.mem, toolchain, profile, &files, invocation));
   invocation->cwd = pkg->paths.work;
@@ -100,10 +116,66 @@ static spn_err_t link_exports_exec(sp_mem_t scratch, spn_target_unit_t* target,
     return emit_link_failed(target, invocation, run.result.status.exit_code, run.result.out, run.result.err);
   }
 
+  spn_symbol_set_t seen;
+  sp_str_ht_init(scratch, seen);
+  return read_archive_symbols(spn_path_str(&spn.roots, scratch, files.output), symbols, &seen);
+}
+
+static spn_err_t link_symbols_exec(sp_mem_t scratch, spn_target_unit_t* target, spn_path_t object, spn_path_t output) {
+  sp_str_t path = spn_path_str(&spn.roots, scratch, object);
+  sp_str_t content = sp_zero;
+  if (sp_io_read_file(scratch, path, &content)) {
+    return spn_err_emit(&spn, (spn_err_union_t) { .kind = SPN_ERR_FS_READ, .fs.path = path });
+  }
+
+  sp_da(sp_str_t) symbols = sp_da_new(scratch, sp_str_t);
+  if (!spn_symtab_read((const u8*)content.data, content.len, &symbols)) {
+    symbols = sp_da_new(scratch, sp_str_t);
+    spn_try(archive_object_symbols(scratch, target, object, output, &symbols));
+  }
+  return write_symbols(scratch, output, symbols);
+}
+
+spn_err_t spn_link_symbols_run(spn_target_unit_t* target, spn_path_t object, spn_path_t output) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  spn_err_t result = link_symbols_exec(scratch.mem, target, object, output);
+  sp_mem_end_scratch(scratch);
+  return result;
+}
+
+static spn_err_t read_export_symbols(sp_mem_t mem, sp_str_t path, sp_da(sp_str_t)* symbols) {
+  sp_str_t content = sp_zero;
+  if (sp_io_read_file(mem, path, &content)) {
+    return spn_err_emit(&spn, (spn_err_union_t) { .kind = SPN_ERR_FS_READ, .fs.path = path });
+  }
+
+  sp_da(sp_str_t) lines = sp_str_split_c8(mem, content, '\n');
+  sp_da_for(lines, it) {
+    if (!sp_str_empty(lines[it])) {
+      sp_da_push(*symbols, lines[it]);
+    }
+  }
+  return SPN_OK;
+}
+
+static spn_err_t link_exports_exec(sp_mem_t scratch, spn_target_unit_t* target, sp_da(spn_path_t) lists, spn_path_t output) {
+  spn_profile_info_t* profile = &target->pkg->build->profile;
+
   spn_symbol_set_t seen;
   sp_str_ht_init(scratch, seen);
   sp_da(sp_str_t) symbols = sp_da_new(scratch, sp_str_t);
-  spn_try(read_archive_symbols(spn_path_str(&spn.roots, scratch, files.output), &symbols, &seen));
+  sp_da_for(lists, it) {
+    sp_da(sp_str_t) found = sp_da_new(scratch, sp_str_t);
+    spn_try(read_export_symbols(scratch, spn_path_str(&spn.roots, scratch, lists[it]), &found));
+    sp_da_for(found, st) {
+      sp_str_t interned = spn_intern(found[st]);
+      if (sp_str_ht_exists(seen, interned)) {
+        continue;
+      }
+      sp_str_ht_insert(seen, interned, (u8)true);
+      sp_da_push(symbols, interned);
+    }
+  }
   sp_da_for(target->link.archives, it) {
     spn_try(read_archive_symbols(spn_path_str(&spn.roots, scratch, target->link.archives[it]), &symbols, &seen));
   }
@@ -134,30 +206,15 @@ static spn_err_t link_exports_exec(sp_mem_t scratch, spn_target_unit_t* target,
   return SPN_OK;
 }
 
-spn_err_t spn_link_exports_run(spn_target_unit_t* target, sp_da(spn_path_t) objects, spn_path_t output) {
+spn_err_t spn_link_exports_run(spn_target_unit_t* target, sp_da(spn_path_t) lists, spn_path_t output) {
   spn_pkg_unit_announce_compile(target->pkg);
 
   sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
-  spn_err_t result = link_exports_exec(scratch.mem, target, objects, output);
+  spn_err_t result = link_exports_exec(scratch.mem, target, lists, output);
   sp_mem_end_scratch(scratch);
   return result;
 }
 
-static spn_err_t read_export_symbols(sp_mem_t mem, sp_str_t path, sp_da(sp_str_t)* symbols) {
-  sp_str_t content = sp_zero;
-  if (sp_io_read_file(mem, path, &content)) {
-    return spn_err_emit(&spn, (spn_err_union_t) { .kind = SPN_ERR_FS_READ, .fs.path = path });
-  }
-
-  sp_da(sp_str_t) lines = sp_str_split_c8(mem, content, '\n');
-  sp_da_for(lines, it) {
-    if (!sp_str_empty(lines[it])) {
-      sp_da_push(*symbols, lines[it]);
-    }
-  }
-  return SPN_OK;
-}
-
 static spn_err_t link_target_exec(sp_mem_t scratch, spn_target_unit_t* target, spn_path_t output, sp_da(spn_path_t) objects, spn_path_t exports) {
   spn_cc_link_files_t files = {
     .output = output,
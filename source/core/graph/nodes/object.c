@@ -22,6 +22,7 @@ s32 spn_compile_object_run(spn_compile_unit_t* unit, spn_path_t object, spn_path
     .source = unit->paths.file,
     .output = object,
     .depfile = depfile,
+    .relocate = &spn.roots,
   };
   spn_invocation_t invocation = spn_cc_render_compile_command(spn.mem, &pkg->build->toolchain->cc, &pkg->build->profile, &unit->invocation, &files);
   sp_str_t source = spn_path_str(&spn.roots, spn.mem, files.source);
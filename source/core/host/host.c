@@ -32,6 +32,10 @@ spn_path_t spn_ctx_collapse_path(spn_ctx_t* ctx, sp_str_t path) {
 }
 
 spn_index_arr_t spn_get_indexes(sp_mem_t mem, spn_ctx_t* ctx) {
+  if (spn_ctx_require_indexes(ctx)) {
+    return (spn_index_arr_t) sp_zero;
+  }
+
   spn_index_arr_t indexes = {
     .items = sp_alloc_n(mem, spn_index_desc_t, sp_da_size(ctx->indexes)),
     .count = (u32)sp_da_size(ctx->indexes),
@@ -47,6 +51,10 @@ spn_index_arr_t spn_get_indexes(sp_mem_t mem, spn_ctx_t* ctx) {
 }
 
 bool spn_get_index(spn_ctx_t* ctx, sp_str_t name, spn_index_desc_t* index) {
+  if (spn_ctx_require_indexes(ctx)) {
+    return false;
+  }
+
   spn_index_info_t* info = spn_find_index(ctx, name);
   if (!info) {
     return false;
@@ -1,12 +1,90 @@
 #include "index/cache.h"
+#include "external/git.h"
 #include "index/index.h"
+#include "index/snapshot.h"
 #include "pkg/id.h"
+#include "thread_pool/thread_pool.h"
 
 void spn_index_cache_init(spn_index_cache_t* cache, sp_mem_t mem, sp_intern_t* intern, sp_da(spn_index_info_t)* indexes) {
   cache->mem = mem;
   cache->intern = intern;
   cache->indexes = indexes;
+  sp_da_init(mem, cache->snapshots);
+  sp_da_for(*indexes, it) {
+    sp_da_push(cache->snapshots, SP_ZERO_STRUCT(spn_index_cache_snapshot_t));
+  }
   sp_str_om_new(cache->packages);
+  sp_da_init(mem, cache->lookups);
+  sp_da_init(mem, cache->prefetch.arenas);
+}
+
+// Packages loaded by a prefetch live in its arenas, so nothing the cache
+// handed out may be used after this
+void spn_index_cache_deinit(spn_index_cache_t* cache) {
+  if (cache->prefetch.started) {
+    spn_thread_pool_deinit(&cache->prefetch.pool);
+    cache->prefetch.started = false;
+  }
+  sp_da_for(cache->prefetch.arenas, it) {
+    sp_mem_arena_destroy(cache->prefetch.arenas[it]);
+  }
+  sp_da_clear(cache->prefetch.arenas);
+}
+
+static void cache_insert(spn_index_cache_t* cache, sp_str_t qualified, spn_pkg_name_t id, spn_index_pkg_t* pkg) {
+  sp_str_om_insert(cache->packages, qualified, pkg);
+  sp_da_push(cache->lookups, ((spn_pkg_name_t) {
+    .namespace = sp_str_copy(cache->mem, id.namespace),
+    .name = sp_str_copy(cache->mem, id.name),
+  }));
+}
+
+static spn_index_snapshot_t* cache_snapshot(spn_index_cache_t* cache, u32 slot) {
+  if (slot >= sp_da_size(cache->snapshots)) {
+    return SP_NULLPTR;
+  }
+
+  spn_index_info_t* index = &(*cache->indexes)[slot];
+  if (index->protocol != SPN_INDEX_PROTOCOL_GIT) {
+    return SP_NULLPTR;
+  }
+
+  spn_index_cache_snapshot_t* entry = &cache->snapshots[slot];
+  if (!entry->loaded) {
+    entry->loaded = true;
+    sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+    sp_str_t path = spn_index_snapshot_path(scratch.mem, index);
+
+    // Anything that moves HEAD outside of a sync leaves the snapshot behind;
+    // one built from another revision is ignored in favor of the jsonl files
+    sp_str_t head = sp_zero;
+    if (!spn_git_get_commit_full(scratch.mem, index->location, sp_str_lit("HEAD"), &head)) {
+      entry->open = !spn_index_snapshot_open(&entry->snapshot, cache->mem, path) && sp_str_equal(entry->snapshot.rev, head);
+    }
+    sp_mem_end_scratch(scratch);
+  }
+  return entry->open ? &entry->snapshot : SP_NULLPTR;
+}
+
+static spn_err_t cache_load(spn_index_cache_t* cache, sp_mem_t mem, spn_pkg_name_t id, spn_index_pkg_t** pkg, spn_index_diag_t* diag) {
+  *pkg = SP_NULLPTR;
+
+  sp_da_for(*cache->indexes, it) {
+    spn_index_info_t* index = &(*cache->indexes)[it];
+    spn_index_snapshot_t* snapshot = cache_snapshot(cache, it);
+    if (snapshot && spn_index_snapshot_find(snapshot, mem, id, pkg)) {
+      if (*pkg) {
+        break;
+      }
+      continue;
+    }
+
+    spn_try(spn_index_get_package(index, mem, cache->intern, id, pkg, diag));
+    if (*pkg) {
+      break;
+    }
+  }
+  return SPN_OK;
 }
 
 spn_err_t spn_index_cache_get_package(spn_index_cache_t* cache, spn_pkg_name_t id, spn_index_pkg_t** pkg, spn_index_diag_t* diag) {
@@ -19,16 +97,85 @@ spn_err_t spn_index_cache_get_package(spn_index_cache_t* cache, spn_pkg_name_t i
   }
 
   spn_index_pkg_t* package = SP_NULLPTR;
-  sp_da_for(*cache->indexes, it) {
-    spn_index_info_t* index = &(*cache->indexes)[it];
-    spn_try(spn_index_get_package(index, cache->mem, cache->intern, id, &package, diag));
-    if (package) {
-      break;
-    }
-  }
+  spn_try(cache_load(cache, cache->mem, id, &package, diag));
 
-  sp_str_om_insert(cache->packages, qualified, package);
+  cache_insert(cache, qualified, id, package);
   *pkg = package;
   return SPN_OK;
 }
 
+typedef struct {
+  spn_index_cache_t* cache;
+  spn_pkg_name_t id;
+  sp_str_t qualified;
+  sp_mem_t mem;
+  spn_index_pkg_t* pkg;
+  spn_err_t err;
+} prefetch_job_t;
+
+static void prefetch_package(void* data) {
+  prefetch_job_t* job = (prefetch_job_t*)data;
+  spn_index_diag_t diag = sp_zero;
+  job->err = cache_load(job->cache, job->mem, job->id, &job->pkg, &diag);
+}
+
+void spn_index_cache_prefetch(spn_index_cache_t* cache, spn_pkg_name_t* ids, u32 count) {
+  if (!cache->prefetch.workers) {
+    return;
+  }
+
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+
+  sp_da(prefetch_job_t) jobs = sp_da_new(scratch.mem, prefetch_job_t);
+  sp_for(it, count) {
+    sp_str_t qualified = spn_pkg_name_to_qualified(ids[it]);
+    if (sp_str_om_has(cache->packages, qualified)) {
+      continue;
+    }
+
+    bool queued = false;
+    sp_da_for(jobs, n) {
+      queued |= sp_str_equal(jobs[n].qualified, qualified);
+    }
+    if (!queued) {
+      sp_da_push(jobs, ((prefetch_job_t) { .cache = cache, .id = ids[it], .qualified = qualified }));
+    }
+  }
+
+  // A single miss is no faster on a worker than on demand
+  if (sp_da_size(jobs) < 2) {
+    sp_mem_end_scratch(scratch);
+    return;
+  }
+
+  // Snapshots open lazily; do it here so workers only ever read them
+  sp_da_for(*cache->indexes, it) {
+    cache_snapshot(cache, it);
+  }
+
+  spn_thread_pool_t* pool = &cache->prefetch.pool;
+  if (!cache->prefetch.started) {
+    spn_thread_pool_init(pool, cache->mem, (spn_thread_pool_config_t) { .workers = cache->prefetch.workers });
+    cache->prefetch.started = true;
+  }
+
+  // Arenas are made here rather than on the workers, which only allocate
+  // from their own; the os allocator under each one is safe to share
+  sp_da_for(jobs, it) {
+    sp_mem_arena_t* arena = sp_mem_arena_new(sp_mem_os_new());
+    sp_da_push(cache->prefetch.arenas, arena);
+    jobs[it].mem = sp_mem_arena_as_allocator(arena);
+    spn_thread_pool_submit(&pool->executor, (spn_thread_pool_job_t) { .fn = prefetch_package, .data = &jobs[it] });
+  }
+  spn_thread_pool_wait(pool);
+
+  // Failures aren't cached, so the solver hits them again on demand and gets
+  // the diagnostic only if it actually needs that package
+  sp_da_for(jobs, it) {
+    if (!jobs[it].err) {
+      cache_insert(cache, jobs[it].qualified, jobs[it].id, jobs[it].pkg);
+    }
+  }
+
+  sp_mem_end_scratch(scratch);
+}
@@ -6,6 +6,8 @@
 #include "index/types.h"
 
 void spn_index_cache_init(spn_index_cache_t* cache, sp_mem_t mem, sp_intern_t* intern, sp_da(spn_index_info_t)* indexes);
+void spn_index_cache_deinit(spn_index_cache_t* cache);
 spn_err_t spn_index_cache_get_package(spn_index_cache_t* cache, spn_pkg_name_t id, spn_index_pkg_t** pkg, spn_index_diag_t* diag);
+void spn_index_cache_prefetch(spn_index_cache_t* cache, spn_pkg_name_t* ids, u32 count);
 
 #endif
@@ -0,0 +1,251 @@
+#include "index/http.h"
+
+#include "spn/errors.h"
+
+#include "index/jsonl.h"
+#include "sp/io.h"
+#include "sp/str.h"
+
+#define SPN_INDEX_HTTP_SYNCED ".synced"
+#define SPN_INDEX_HTTP_META ".meta"
+
+static u32 http_status_code(sp_str_t line) {
+  s32 space = sp_str_find(line, sp_str_lit(" "));
+  if (space == SP_STR_NO_MATCH || line.len < (u32)space + 4) {
+    return 0;
+  }
+
+  u32 code = 0;
+  sp_for(it, 3) {
+    c8 c = line.data[space + 1 + it];
+    if (c < '0' || c > '9') {
+      return 0;
+    }
+    code = code * 10 + (u32)(c - '0');
+  }
+  return code;
+}
+
+static bool http_header(sp_mem_t mem, sp_str_t line, sp_str_t name, sp_str_t* value) {
+  sp_str_pair_t pair = sp_str_cleave_c8(line, ':');
+  if (!sp_str_equal(sp_str_to_lower(mem, sp_str_trim(pair.first)), name)) {
+    return false;
+  }
+  *value = sp_str_trim(pair.second);
+  return true;
+}
+
+spn_index_http_status_t spn_index_http_parse_curl(sp_mem_t mem, sp_str_t out, spn_index_http_validators_t* validators, sp_str_t* body) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch_for(mem);
+
+  // Headers come first, one block per hop when redirects are followed; the
+  // last block describes the body that follows it
+  u32 code = 0;
+  spn_index_http_validators_t response = sp_zero;
+  sp_str_t rest = out;
+  while (sp_str_starts_with(rest, sp_str_lit("HTTP/"))) {
+    s32 end = sp_str_find(rest, sp_str_lit("\r\n\r\n"));
+    if (end == SP_STR_NO_MATCH) {
+      sp_mem_end_scratch(scratch);
+      return SPN_INDEX_HTTP_FAILED;
+    }
+
+    sp_str_t block = sp_str_prefix(rest, end);
+    rest = sp_str_sub(rest, end + 4, rest.len - end - 4);
+
+    code = 0;
+    response = SP_ZERO_STRUCT(spn_index_http_validators_t);
+    sp_str_for_line(block, it) {
+      sp_str_t line = sp_str_trim(it.line);
+      if (!code) {
+        code = http_status_code(line);
+        continue;
+      }
+      http_header(scratch.mem, line, sp_str_lit("etag"), &response.etag);
+      http_header(scratch.mem, line, sp_str_lit("last-modified"), &response.modified);
+    }
+  }
+
+  spn_index_http_status_t status = SPN_INDEX_HTTP_FAILED;
+  switch (code) {
+    case 200: {
+      validators->etag = sp_str_copy(mem, response.etag);
+      validators->modified = sp_str_copy(mem, response.modified);
+      *body = sp_str_copy(mem, rest);
+      status = SPN_INDEX_HTTP_OK;
+      break;
+    }
+    case 304: {
+      status = SPN_INDEX_HTTP_NOT_MODIFIED;
+      break;
+    }
+    case 404:
+    case 410: {
+      status = SPN_INDEX_HTTP_NOT_FOUND;
+      break;
+    }
+    default: {
+      break;
+    }
+  }
+
+  sp_mem_end_scratch(scratch);
+  return status;
+}
+
+spn_index_http_status_t spn_index_http_fetch_curl(sp_mem_t mem, sp_str_t url, spn_index_http_validators_t* validators, sp_str_t* body, void* user_data) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch_for(mem);
+
+  sp_da(sp_str_t) args = sp_da_new(scratch.mem, sp_str_t);
+  sp_da_push(args, sp_str_lit("-sSL"));
+  sp_da_push(args, sp_str_lit("-D"));
+  sp_da_push(args, sp_str_lit("-"));
+  if (!sp_str_empty(validators->etag)) {
+    sp_da_push(args, sp_str_lit("-H"));
+    sp_da_push(args, sp_fmt(scratch.mem, "If-None-Match: {}", sp_fmt_str(validators->etag)).value);
+  }
+  if (!sp_str_empty(validators->modified)) {
+    sp_da_push(args, sp_str_lit("-H"));
+    sp_da_push(args, sp_fmt(scratch.mem, "If-Modified-Since: {}", sp_fmt_str(validators->modified)).value);
+  }
+  sp_da_push(args, url);
+
+  sp_ps_output_t result = sp_ps_run(scratch.mem, (sp_ps_config_t) {
+    .command = sp_str_lit("curl"),
+    .dyn_args = args,
+    .io = {
+      .in.mode = SP_PS_IO_MODE_NULL,
+      .err.mode = SP_PS_IO_MODE_NULL,
+    },
+  });
+
+  spn_index_http_status_t status = SPN_INDEX_HTTP_FAILED;
+  if (!result.status.exit_code) {
+    status = spn_index_http_parse_curl(mem, result.out, validators, body);
+  }
+
+  sp_mem_end_scratch(scratch);
+  return status;
+}
+
+static sp_str_t http_meta_path(sp_mem_t mem, sp_str_t path) {
+  return sp_str_concat(mem, path, sp_str_lit(SPN_INDEX_HTTP_META));
+}
+
+static bool http_entry_fresh(spn_index_info_t* index, sp_str_t meta) {
+  if (!sp_fs_exists(meta)) {
+    return false;
+  }
+
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  sp_str_t synced = sp_fs_join_path(scratch.mem, index->location, sp_str_lit(SPN_INDEX_HTTP_SYNCED));
+  sp_tm_epoch_t sync_time = sp_fs_get_mod_time(synced);
+  sp_mem_end_scratch(scratch);
+
+  // A forced sync in the same second as the last fetch still has to win
+  sp_tm_epoch_t mod_time = sp_fs_get_mod_time(meta);
+  sp_tm_epoch_t now = sp_tm_now_epoch();
+  bool synced_since = sync_time.s > mod_time.s || (sync_time.s == mod_time.s && sync_time.ns >= mod_time.ns);
+  return !synced_since && mod_time.s + index->refresh > now.s;
+}
+
+static void http_read_meta(sp_mem_t mem, sp_str_t meta, spn_index_http_validators_t* validators) {
+  sp_str_t content = sp_zero;
+  if (sp_io_read_file(mem, meta, &content) != SP_OK) {
+    return;
+  }
+
+  sp_str_for_line(content, it) {
+    sp_str_t line = sp_str_trim(it.line);
+    http_header(mem, line, sp_str_lit("etag"), &validators->etag);
+    http_header(mem, line, sp_str_lit("last-modified"), &validators->modified);
+  }
+}
+
+static void http_write_meta(sp_mem_t mem, sp_str_t meta, spn_index_http_validators_t validators) {
+  sp_str_t content = sp_fmt(mem, "etag: {}\nlast-modified: {}\n",
+    sp_fmt_str(validators.etag),
+    sp_fmt_str(validators.modified)).value;
+  sp_fs_write_atomic(meta, content);
+}
+
+static spn_err_t http_revalidate(spn_index_info_t* index, sp_mem_t mem, spn_pkg_name_t id, sp_str_t path) {
+  sp_str_t meta = http_meta_path(mem, path);
+  bool cached = sp_fs_exists(meta);
+
+  // A meta with no body records that the server had nothing for this name
+  spn_index_http_validators_t validators = sp_zero;
+  if (cached && sp_fs_exists(path)) {
+    http_read_meta(mem, meta, &validators);
+  }
+
+  sp_str_t base = index->http.url;
+  while (sp_str_ends_with(base, sp_str_lit("/"))) {
+    base = sp_str_prefix(base, base.len - 1);
+  }
+  sp_str_t url = sp_fmt(mem, "{}/{}/{}.jsonl", sp_fmt_str(base), sp_fmt_str(id.namespace), sp_fmt_str(id.name)).value;
+
+  spn_index_http_fetch_fn fetch = index->http.fetch ? index->http.fetch : spn_index_http_fetch_curl;
+  sp_str_t body = sp_zero;
+  switch (fetch(mem, url, &validators, &body, index->http.fetch_user_data)) {
+    case SPN_INDEX_HTTP_OK: {
+      sp_fs_create_dir(index->location);
+      sp_fs_create_dir(sp_fs_parent_path(path));
+      if (sp_fs_write_atomic(path, body)) {
+        return SPN_ERR_INDEX_SYNC;
+      }
+      break;
+    }
+    case SPN_INDEX_HTTP_NOT_MODIFIED: {
+      break;
+    }
+    case SPN_INDEX_HTTP_NOT_FOUND: {
+      sp_fs_create_dir(index->location);
+      sp_fs_create_dir(sp_fs_parent_path(path));
+      sp_fs_remove_file(path);
+      validators = SP_ZERO_STRUCT(spn_index_http_validators_t);
+      break;
+    }
+    case SPN_INDEX_HTTP_FAILED: {
+      // Offline with a copy on disk: a stale entry beats no entry
+      return cached ? SPN_OK : SPN_ERR_INDEX_SYNC;
+    }
+  }
+
+  http_write_meta(mem, meta, validators);
+  return SPN_OK;
+}
+
+spn_err_t spn_index_http_sync(spn_index_info_t* index, bool force) {
+  sp_fs_create_dir(index->location);
+  if (!sp_fs_is_dir(index->location)) {
+    return SPN_ERROR;
+  }
+
+  // Nothing is fetched up front. A forced sync only marks every entry as
+  // needing revalidation, which is a 304 for anything that hasn't changed
+  if (force) {
+    sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+    sp_str_t synced = sp_fs_join_path(scratch.mem, index->location, sp_str_lit(SPN_INDEX_HTTP_SYNCED));
+    sp_fs_write_atomic(synced, sp_str_lit(""));
+    sp_mem_end_scratch(scratch);
+  }
+  return SPN_OK;
+}
+
+spn_err_t spn_index_http_get_package(spn_index_info_t* index, sp_mem_t mem, spn_pkg_name_t id, spn_index_pkg_t** pkg, spn_index_diag_t* diag) {
+  *pkg = SP_NULLPTR;
+
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch_for(mem);
+  sp_str_t path = spn_index_jsonl_path(scratch.mem, index, id);
+  if (!http_entry_fresh(index, http_meta_path(scratch.mem, path))) {
+    spn_err_t err = http_revalidate(index, scratch.mem, id, path);
+    if (err) {
+      sp_mem_end_scratch(scratch);
+      return err;
+    }
+  }
+  sp_mem_end_scratch(scratch);
+
+  return spn_index_jsonl_get_package(index, mem, id, pkg, diag);
+}
@@ -0,0 +1,18 @@
+#ifndef SPN_INDEX_HTTP_H
+#define SPN_INDEX_HTTP_H
+
+#include "sp.h"
+#include "spn/core.h"
+#include "index/types.h"
+
+// The sparse protocol: <url>/<ns>/<name>.jsonl is fetched only when the
+// resolver asks for that package, and kept under the index location next to a
+// .meta file holding its validators. The meta's mtime is when the entry was
+// last confirmed; past the index's refresh interval (or a forced sync) the
+// entry is revalidated with a conditional request
+spn_index_http_status_t spn_index_http_parse_curl(sp_mem_t mem, sp_str_t out, spn_index_http_validators_t* validators, sp_str_t* body);
+spn_index_http_status_t spn_index_http_fetch_curl(sp_mem_t mem, sp_str_t url, spn_index_http_validators_t* validators, sp_str_t* body, void* user_data);
+spn_err_t spn_index_http_sync(spn_index_info_t* index, bool force);
+spn_err_t spn_index_http_get_package(spn_index_info_t* index, sp_mem_t mem, spn_pkg_name_t id, spn_index_pkg_t** pkg, spn_index_diag_t* diag);
+
+#endif
@@ -10,9 +10,11 @@
 #include "external/git.h"
 #include "git/key.h"
 #include "index/dir.h"
+#include "index/http.h"
 #include "index/index.h"
 #include "index/json.h"
 #include "index/jsonl.h"
+#include "index/snapshot.h"
 #include "pkg/id.h"
 #include "semver/compare.h"
 #include "semver/convert.h"
@@ -66,34 +68,40 @@ static spn_err_t git_index_freshen(spn_index_info_t* index) {
   return err;
 }
 
-spn_err_t spn_index_sync(spn_index_info_t* index, bool force) {
-  switch (index->protocol) {
-    case SPN_INDEX_PROTOCOL_GIT: {
-      bool pinned = !sp_str_empty(index->git.rev);
+static spn_err_t git_index_sync(spn_index_info_t* index, bool force) {
+  bool pinned = !sp_str_empty(index->git.rev);
 
-      if (sp_fs_exists(index->location)) {
-        if (pinned) {
-          if (force) {
-            spn_try(spn_git_fetch(index->location));
-          }
-          spn_try(spn_git_checkout(index->location, index->git.rev));
-          return SPN_OK;
-        }
-
-        if (force || git_index_stale(index)) {
-          spn_try(git_index_freshen(index));
-        }
-        return SPN_OK;
+  if (sp_fs_exists(index->location)) {
+    if (pinned) {
+      if (force) {
+        spn_try(spn_git_fetch(index->location));
       }
+      spn_try(spn_git_checkout(index->location, index->git.rev));
+      return SPN_OK;
+    }
 
-      spn_try(spn_git_clone(index->git.url, index->location));
-      if (pinned) {
-        spn_try(spn_git_checkout(index->location, index->git.rev));
-      }
+    if (force || git_index_stale(index)) {
+      spn_try(git_index_freshen(index));
+    }
+    return SPN_OK;
+  }
+
+  spn_try(spn_git_clone(index->git.url, index->location));
+  if (pinned) {
+    spn_try(spn_git_checkout(index->location, index->git.rev));
+  }
+  return SPN_OK;
+}
+
+spn_err_t spn_index_sync(spn_index_info_t* index, bool force) {
+  switch (index->protocol) {
+    case SPN_INDEX_PROTOCOL_GIT: {
+      spn_try(git_index_sync(index, force));
+      spn_index_snapshot_refresh(index);
       return SPN_OK;
     }
     case SPN_INDEX_PROTOCOL_HTTP: {
-      return SPN_ERROR;
+      return spn_index_http_sync(index, force);
     }
     case SPN_INDEX_PROTOCOL_DIR: {
       return sp_fs_is_dir(index->location) ? SPN_OK : SPN_ERROR;
@@ -117,7 +125,7 @@ bool spn_index_needs_fetch(spn_index_info_t* index) {
       return git_index_stale(index);
     }
     case SPN_INDEX_PROTOCOL_HTTP: {
-      return false;
+      return !sp_fs_is_dir(index->location);
     }
     case SPN_INDEX_PROTOCOL_DIR: {
       return false;
@@ -128,10 +136,12 @@ bool spn_index_needs_fetch(spn_index_info_t* index) {
 
 spn_err_t spn_index_get_package(spn_index_info_t* index, sp_mem_t mem, sp_intern_t* intern, spn_pkg_name_t id, spn_index_pkg_t** pkg, spn_index_diag_t* diag) {
   switch (index->protocol) {
-    case SPN_INDEX_PROTOCOL_GIT:
-    case SPN_INDEX_PROTOCOL_HTTP: {
+    case SPN_INDEX_PROTOCOL_GIT: {
       return spn_index_jsonl_get_package(index, mem, id, pkg, diag);
     }
+    case SPN_INDEX_PROTOCOL_HTTP: {
+      return spn_index_http_get_package(index, mem, id, pkg, diag);
+    }
     case SPN_INDEX_PROTOCOL_DIR: {
       return spn_index_dir_get_package(index, mem, intern, id, pkg, diag);
     }
@@ -139,6 +149,34 @@ spn_err_t spn_index_get_package(spn_index_info_t* index, sp_mem_t mem, sp_intern
   sp_unreachable_return(SPN_ERROR);
 }
 
+bool spn_index_revision(sp_mem_t mem, spn_index_info_t* index, sp_str_t* rev) {
+  *rev = sp_zero_s(sp_str_t);
+  if (index->protocol != SPN_INDEX_PROTOCOL_GIT) {
+    return false;
+  }
+
+  // Read HEAD rather than the snapshot's rev; anything that moves HEAD outside
+  // of a sync leaves the snapshot behind
+  return !spn_git_get_commit_full(mem, index->location, sp_str_lit("HEAD"), rev);
+}
+
+sp_str_t spn_index_entry_path(sp_mem_t mem, spn_index_info_t* index, spn_pkg_name_t id) {
+  switch (index->protocol) {
+    case SPN_INDEX_PROTOCOL_GIT:
+    case SPN_INDEX_PROTOCOL_HTTP: {
+      return spn_index_jsonl_path(mem, index, id);
+    }
+    case SPN_INDEX_PROTOCOL_DIR: {
+      sp_mem_arena_marker_t scratch = sp_mem_begin_scratch_for(mem);
+      sp_str_t dir = sp_fs_join_path(scratch.mem, index->location, id.name);
+      sp_str_t path = sp_fs_join_path(mem, dir, sp_str_lit("spn.toml"));
+      sp_mem_end_scratch(scratch);
+      return path;
+    }
+  }
+  sp_unreachable_return(sp_str_lit(""));
+}
+
 static spn_err_t index_release_exists(spn_index_info_t* index, sp_mem_t mem, spn_index_release_t* rel, bool* exists, spn_index_diag_t* diag) {
   *exists = false;
 
@@ -194,6 +232,9 @@ static spn_err_t publish_git(spn_index_info_t* index, sp_mem_t mem, spn_index_re
   spn_err_t result = SPN_OK;
   sp_str_t output = sp_zero;
 
+  // The replica is about to move past the revision its snapshot was built from
+  sp_fs_remove_file(spn_index_snapshot_path(scratch.mem, index));
+
   sp_for(attempt, SPN_INDEX_PUBLISH_ATTEMPTS) {
     if (git_index_freshen(index)) {
       result = spn_err_emit(&spn, (spn_err_union_t) {
@@ -257,6 +298,7 @@ static spn_err_t publish_git(spn_index_info_t* index, sp_mem_t mem, spn_index_re
 
     sp_str_t refspec = sp_fmt(scratch.mem, "HEAD:refs/heads/{}", sp_fmt_str(branch)).value;
     if (!spn_git_push(scratch.mem, index->location, url, refspec, &output)) {
+      spn_index_snapshot_refresh(index);
       sp_mem_end_scratch(scratch);
       return SPN_OK;
     }
@@ -82,6 +82,17 @@ static spn_err_t spn_index_parse_rel(sp_mem_t mem, spn_pkg_name_t id, sp_str_t j
   return SPN_OK;
 }
 
+spn_err_t spn_index_release_load(sp_mem_t mem, spn_index_release_t* release) {
+  if (sp_str_empty(release->raw)) {
+    return SPN_OK;
+  }
+
+  spn_index_release_t loaded = sp_zero;
+  spn_try(spn_index_parse_rel(mem, release->id, release->raw, &loaded));
+  *release = loaded;
+  return SPN_OK;
+}
+
 static s32 sort_release_by_version(const void* a, const void* b) {
   const spn_index_release_t* lhs = (const spn_index_release_t*)a;
   const spn_index_release_t* rhs = (const spn_index_release_t*)b;
@@ -159,13 +170,6 @@ spn_err_t spn_index_parse_pkg(sp_mem_t mem, spn_pkg_name_t id, sp_str_t blob, sp
 
     spn_index_release_t release = sp_zero;
     spn_try(spn_index_parse_rel(mem, id, line, &release));
-
-    sp_da_for(pkg->releases, n) {
-      if (spn_semver_eq(pkg->releases[n].version, release.version)) {
-        return SPN_ERROR;
-      }
-    }
-
     sp_da_push(pkg->releases, release);
   }
 
@@ -173,6 +177,12 @@ spn_err_t spn_index_parse_pkg(sp_mem_t mem, spn_pkg_name_t id, sp_str_t blob, sp
     return SPN_ERROR;
   }
 
+  // Once sorted, a duplicate version can only sit next to its twin
   sp_da_sort(pkg->releases, sort_release_by_version);
+  for (u64 it = 1; it < sp_da_size(pkg->releases); it++) {
+    if (spn_semver_eq(pkg->releases[it - 1].version, pkg->releases[it].version)) {
+      return SPN_ERROR;
+    }
+  }
   return SPN_OK;
 }
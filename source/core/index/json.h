@@ -6,6 +6,7 @@
 #include "index/types.h"
 
 spn_err_t spn_index_parse_pkg(sp_mem_t mem, spn_pkg_name_t id, sp_str_t blob, spn_index_pkg_t* pkg);
+spn_err_t spn_index_release_load(sp_mem_t mem, spn_index_release_t* release);
 sp_str_t spn_index_release_to_json(sp_mem_t mem, spn_index_release_t* rel);
 
 #endif
@@ -2,6 +2,7 @@
 
 #include "pkg/id.h"
 #include "pkg/pkg.h"
+#include "semver/compare.h"
 #include "target/mutate.h"
 
 static spn_index_dep_kind_t dep_kind_to_index(spn_dep_kind_t kind) {
@@ -69,3 +70,57 @@ spn_err_t spn_index_release_from_pkg(sp_mem_t mem, spn_pkg_info_t* info, spn_pkg
 
   return SPN_OK;
 }
+
+// First release newer than version, or at least as new when inclusive
+static u32 release_bound(spn_index_pkg_t* pkg, spn_semver_t version, bool inclusive) {
+  u32 low = 0;
+  u32 high = sp_da_size(pkg->releases);
+  while (low < high) {
+    u32 mid = low + (high - low) / 2;
+    s32 order = spn_semver_cmp(pkg->releases[mid].version, version);
+    if (order < 0 || (order == 0 && !inclusive)) {
+      low = mid + 1;
+    }
+    else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+spn_index_release_t* spn_index_release_find(spn_index_pkg_t* pkg, spn_semver_t version) {
+  u32 it = release_bound(pkg, version, true);
+  if (it < sp_da_size(pkg->releases) && spn_semver_eq(pkg->releases[it].version, version)) {
+    return &pkg->releases[it];
+  }
+  return SP_NULLPTR;
+}
+
+// Each bound of a range admits a prefix, a suffix or (for =) a single point of
+// the sorted list, so the range is the intersection of the two
+static spn_index_release_span_t bound_span(spn_index_pkg_t* pkg, spn_semver_bound_t bound) {
+  u32 size = sp_da_size(pkg->releases);
+  switch (bound.op) {
+    case SPN_SEMVER_OP_LT:  return (spn_index_release_span_t) { 0, release_bound(pkg, bound.version, true) };
+    case SPN_SEMVER_OP_LEQ: return (spn_index_release_span_t) { 0, release_bound(pkg, bound.version, false) };
+    case SPN_SEMVER_OP_GT:  return (spn_index_release_span_t) { release_bound(pkg, bound.version, false), size };
+    case SPN_SEMVER_OP_GEQ: return (spn_index_release_span_t) { release_bound(pkg, bound.version, true), size };
+    case SPN_SEMVER_OP_EQ: {
+      return (spn_index_release_span_t) { release_bound(pkg, bound.version, true), release_bound(pkg, bound.version, false) };
+    }
+  }
+  sp_unreachable_return(sp_zero_struct(spn_index_release_span_t));
+}
+
+spn_index_release_span_t spn_index_release_span(spn_index_pkg_t* pkg, spn_semver_range_t range) {
+  spn_index_release_span_t low = bound_span(pkg, range.low);
+  spn_index_release_span_t high = bound_span(pkg, range.high);
+  spn_index_release_span_t span = {
+    .begin = sp_max(low.begin, high.begin),
+    .end = sp_min(low.end, high.end),
+  };
+  if (span.end < span.begin) {
+    span.end = span.begin;
+  }
+  return span;
+}
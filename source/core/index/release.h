@@ -5,6 +5,8 @@
 #include "spn/core.h"
 #include "index/types.h"
 
-spn_err_t spn_index_release_from_pkg(sp_mem_t mem, spn_pkg_info_t* info, spn_pkg_root_t published, spn_index_release_t* release, sp_str_t* dep);
+spn_err_t                spn_index_release_from_pkg(sp_mem_t mem, spn_pkg_info_t* info, spn_pkg_root_t published, spn_index_release_t* release, sp_str_t* dep);
+spn_index_release_t*     spn_index_release_find(spn_index_pkg_t* pkg, spn_semver_t version);
+spn_index_release_span_t spn_index_release_span(spn_index_pkg_t* pkg, spn_semver_range_t range);
 
 #endif
@@ -0,0 +1,289 @@
+#include "index/snapshot.h"
+
+#include "external/git.h"
+#include "index/json.h"
+#include "pkg/id.h"
+#include "semver/compare.h"
+#include "sp/io.h"
+#include "sp/str.h"
+
+typedef struct {
+  spn_semver_t version;
+  bool yanked;
+  sp_str_t json;
+} snapshot_line_t;
+
+typedef struct {
+  sp_str_t name;
+  sp_da(snapshot_line_t) lines;
+} snapshot_entry_t;
+
+typedef struct {
+  sp_io_dyn_mem_writer_t io;
+  u32 len;
+} snapshot_strings_t;
+
+static s32 sort_line_by_version(const void* a, const void* b) {
+  return spn_semver_cmp(((const snapshot_line_t*)a)->version, ((const snapshot_line_t*)b)->version);
+}
+
+static s32 sort_entry_by_name(const void* a, const void* b) {
+  return sp_str_compare_alphabetical(((const snapshot_entry_t*)a)->name, ((const snapshot_entry_t*)b)->name);
+}
+
+// Keeps each release's original line, so loading it later is exactly what
+// reading the jsonl would have produced
+static spn_err_t collect_lines(sp_mem_t mem, spn_pkg_name_t id, sp_str_t blob, sp_da(snapshot_line_t)* lines) {
+  sp_str_for_line(blob, it) {
+    sp_str_t line = sp_str_trim(it.line);
+    if (sp_str_empty(line)) {
+      continue;
+    }
+
+    spn_index_pkg_t pkg = sp_zero;
+    spn_try(spn_index_parse_pkg(mem, id, line, &pkg));
+
+    spn_index_release_t* release = &pkg.releases[0];
+    sp_da_for(*lines, n) {
+      if (spn_semver_eq((*lines)[n].version, release->version)) {
+        return SPN_ERROR;
+      }
+    }
+    sp_da_push(*lines, ((snapshot_line_t) { .version = release->version, .yanked = release->yanked, .json = line }));
+  }
+
+  if (sp_da_empty(*lines)) {
+    return SPN_ERROR;
+  }
+
+  sp_da_sort(*lines, sort_line_by_version);
+  return SPN_OK;
+}
+
+static u32 write_string(snapshot_strings_t* strings, sp_str_t str) {
+  u32 offset = strings->len;
+  sp_io_write(&strings->io.base, str.data, str.len, SP_NULLPTR);
+  strings->len += str.len;
+  return offset;
+}
+
+sp_str_t spn_index_snapshot_path(sp_mem_t mem, spn_index_info_t* index) {
+  return sp_fmt(mem, "{}.snapshot", sp_fmt_str(index->location)).value;
+}
+
+spn_err_t spn_index_snapshot_build(sp_str_t location, sp_str_t rev, sp_str_t path) {
+  sp_mem_arena_marker_t s = sp_mem_begin_scratch();
+
+  sp_da(snapshot_entry_t) entries = sp_da_new(s.mem, snapshot_entry_t);
+  sp_da(sp_fs_entry_t) namespaces = sp_zero;
+  sp_fs_collect(s.mem, location, &namespaces);
+  sp_da_for(namespaces, n) {
+    sp_fs_entry_t* ns = &namespaces[n];
+    if (ns->kind != SP_FS_KIND_DIR || sp_str_starts_with(ns->name, sp_str_lit("."))) {
+      continue;
+    }
+
+    sp_str_t dir = sp_fs_join_path(s.mem, location, ns->name);
+    sp_da(sp_fs_entry_t) files = sp_zero;
+    sp_fs_collect(s.mem, dir, &files);
+    sp_da_for(files, f) {
+      sp_fs_entry_t* file = &files[f];
+      if (file->kind == SP_FS_KIND_DIR || !sp_str_ends_with(file->name, sp_str_lit(".jsonl"))) {
+        continue;
+      }
+
+      spn_pkg_name_t id = {
+        .namespace = ns->name,
+        .name = sp_str_prefix(file->name, file->name.len - sp_str_lit(".jsonl").len),
+      };
+      snapshot_entry_t entry = {
+        .name = spn_pkg_name_to_qualified(id),
+        .lines = sp_da_new(s.mem, snapshot_line_t),
+      };
+
+      // A broken file goes in with no releases rather than failing the sync
+      sp_str_t blob = sp_zero;
+      if (sp_io_read_file(s.mem, sp_fs_join_path(s.mem, dir, file->name), &blob) != SP_OK ||
+          collect_lines(s.mem, id, blob, &entry.lines)) {
+        entry.lines = sp_da_new(s.mem, snapshot_line_t);
+      }
+      sp_da_push(entries, entry);
+    }
+  }
+  sp_da_sort(entries, sort_entry_by_name);
+
+  snapshot_strings_t strings = sp_zero;
+  sp_io_dyn_mem_writer_init(s.mem, &strings.io);
+
+  spn_index_snapshot_header_t header = {
+    .magic = SPN_INDEX_SNAPSHOT_MAGIC,
+    .version = SPN_INDEX_SNAPSHOT_VERSION,
+    .rev = write_string(&strings, rev),
+    .rev_len = rev.len,
+    .num_packages = sp_da_size(entries),
+  };
+
+  sp_da(spn_index_snapshot_pkg_t) packages = sp_da_new(s.mem, spn_index_snapshot_pkg_t);
+  sp_da(spn_index_snapshot_rel_t) releases = sp_da_new(s.mem, spn_index_snapshot_rel_t);
+  sp_da_for(entries, it) {
+    snapshot_entry_t* entry = &entries[it];
+    sp_da_push(packages, ((spn_index_snapshot_pkg_t) {
+      .name = write_string(&strings, entry->name),
+      .name_len = entry->name.len,
+      .release = sp_da_size(releases),
+      .num_releases = sp_da_size(entry->lines),
+    }));
+
+    sp_da_for(entry->lines, n) {
+      snapshot_line_t* line = &entry->lines[n];
+      sp_da_push(releases, ((spn_index_snapshot_rel_t) {
+        .major = line->version.major,
+        .minor = line->version.minor,
+        .patch = line->version.patch,
+        .yanked = line->yanked,
+        .json = write_string(&strings, line->json),
+        .json_len = line->json.len,
+      }));
+    }
+  }
+  header.num_releases = sp_da_size(releases);
+  header.strings_len = strings.len;
+
+  sp_io_dyn_mem_writer_t out = sp_zero;
+  sp_io_dyn_mem_writer_init(s.mem, &out);
+  sp_io_write(&out.base, &header, sizeof(header), SP_NULLPTR);
+  sp_io_write(&out.base, packages, sp_da_size(packages) * sizeof(spn_index_snapshot_pkg_t), SP_NULLPTR);
+  sp_io_write(&out.base, releases, sp_da_size(releases) * sizeof(spn_index_snapshot_rel_t), SP_NULLPTR);
+  sp_io_write_str(&out.base, sp_io_dyn_mem_writer_as_str(&strings.io), SP_NULLPTR);
+
+  spn_err_t result = sp_fs_write_atomic(path, sp_io_dyn_mem_writer_as_str(&out)) ? SPN_ERROR : SPN_OK;
+  sp_mem_end_scratch(s);
+  return result;
+}
+
+spn_err_t spn_index_snapshot_open(spn_index_snapshot_t* snapshot, sp_mem_t mem, sp_str_t path) {
+  *snapshot = SP_ZERO_STRUCT(spn_index_snapshot_t);
+
+  sp_mem_slice_t data = sp_zero;
+  if (!sp_fs_exists(path) || sp_io_read_file_slice(mem, path, &data)) {
+    return SPN_ERROR;
+  }
+  if (data.len < sizeof(spn_index_snapshot_header_t)) {
+    return SPN_ERROR;
+  }
+
+  spn_index_snapshot_header_t header = sp_zero;
+  sp_mem_copy(&header, data.data, sizeof(header));
+  if (header.magic != SPN_INDEX_SNAPSHOT_MAGIC || header.version != SPN_INDEX_SNAPSHOT_VERSION) {
+    return SPN_ERROR;
+  }
+
+  u64 packages = sizeof(header);
+  u64 releases = packages + (u64)header.num_packages * sizeof(spn_index_snapshot_pkg_t);
+  u64 strings = releases + (u64)header.num_releases * sizeof(spn_index_snapshot_rel_t);
+  if (strings + header.strings_len != data.len || (u64)header.rev + header.rev_len > header.strings_len) {
+    return SPN_ERROR;
+  }
+
+  snapshot->data = data;
+  snapshot->packages = (const spn_index_snapshot_pkg_t*)(data.data + packages);
+  snapshot->releases = (const spn_index_snapshot_rel_t*)(data.data + releases);
+  snapshot->strings = (const c8*)(data.data + strings);
+  snapshot->num_packages = header.num_packages;
+  snapshot->rev = sp_str(snapshot->strings + header.rev, header.rev_len);
+
+  // Validate every offset once here so lookups can index without checking
+  sp_for(it, header.num_packages) {
+    const spn_index_snapshot_pkg_t* pkg = &snapshot->packages[it];
+    if ((u64)pkg->name + pkg->name_len > header.strings_len) {
+      return SPN_ERROR;
+    }
+    if ((u64)pkg->release + pkg->num_releases > header.num_releases) {
+      return SPN_ERROR;
+    }
+  }
+  sp_for(it, header.num_releases) {
+    const spn_index_snapshot_rel_t* rel = &snapshot->releases[it];
+    if ((u64)rel->json + rel->json_len > header.strings_len) {
+      return SPN_ERROR;
+    }
+  }
+
+  return SPN_OK;
+}
+
+void spn_index_snapshot_refresh(spn_index_info_t* index) {
+  if (index->protocol != SPN_INDEX_PROTOCOL_GIT) {
+    return;
+  }
+
+  sp_mem_arena_marker_t s = sp_mem_begin_scratch();
+  sp_str_t path = spn_index_snapshot_path(s.mem, index);
+
+  sp_str_t rev = sp_zero;
+  if (spn_git_get_commit_full(s.mem, index->location, sp_str_lit("HEAD"), &rev)) {
+    sp_fs_remove_file(path);
+    sp_mem_end_scratch(s);
+    return;
+  }
+
+  spn_index_snapshot_t snapshot = sp_zero;
+  if (!spn_index_snapshot_open(&snapshot, s.mem, path) && sp_str_equal(snapshot.rev, rev)) {
+    sp_mem_end_scratch(s);
+    return;
+  }
+
+  // Lookups trust whatever snapshot is on disk, so never leave a stale one
+  if (spn_index_snapshot_build(index->location, rev, path)) {
+    sp_fs_remove_file(path);
+  }
+  sp_mem_end_scratch(s);
+}
+
+bool spn_index_snapshot_find(spn_index_snapshot_t* snapshot, sp_mem_t mem, spn_pkg_name_t id, spn_index_pkg_t** pkg) {
+  *pkg = SP_NULLPTR;
+
+  sp_str_t qualified = spn_pkg_name_to_qualified(id);
+  u32 low = 0;
+  u32 high = snapshot->num_packages;
+  while (low < high) {
+    u32 mid = low + (high - low) / 2;
+    const spn_index_snapshot_pkg_t* entry = &snapshot->packages[mid];
+    s32 order = sp_str_compare_alphabetical(sp_str(snapshot->strings + entry->name, entry->name_len), qualified);
+    if (order < 0) {
+      low = mid + 1;
+      continue;
+    }
+    if (order > 0) {
+      high = mid;
+      continue;
+    }
+
+    if (!entry->num_releases) {
+      return false;
+    }
+
+    spn_index_pkg_t* package = sp_alloc_type(mem, spn_index_pkg_t);
+    *package = SP_ZERO_STRUCT(spn_index_pkg_t);
+    package->id = (spn_pkg_name_t) {
+      .namespace = sp_str_copy(mem, id.namespace),
+      .name = sp_str_copy(mem, id.name),
+    };
+    sp_da_init(mem, package->releases);
+    sp_for(it, entry->num_releases) {
+      const spn_index_snapshot_rel_t* rel = &snapshot->releases[entry->release + it];
+      sp_da_push(package->releases, ((spn_index_release_t) {
+        .id = package->id,
+        .version = spn_semver_lit(rel->major, rel->minor, rel->patch),
+        .yanked = rel->yanked,
+        .raw = sp_str(snapshot->strings + rel->json, rel->json_len),
+      }));
+    }
+
+    *pkg = package;
+    return true;
+  }
+
+  // Every package in the index is in the table, so a miss is a real miss
+  return true;
+}
@@ -0,0 +1,18 @@
+#ifndef SPN_INDEX_SNAPSHOT_H
+#define SPN_INDEX_SNAPSHOT_H
+
+#include "sp.h"
+#include "spn/core.h"
+#include "index/types.h"
+
+// A jsonl index compiled into one file at sync time, keyed by the revision it
+// was built from. Lookups binary search the package table and hand back
+// releases with only their version read; the JSON for a release is parsed when
+// the resolver actually tries it
+sp_str_t  spn_index_snapshot_path(sp_mem_t mem, spn_index_info_t* index);
+spn_err_t spn_index_snapshot_build(sp_str_t location, sp_str_t rev, sp_str_t path);
+spn_err_t spn_index_snapshot_open(spn_index_snapshot_t* snapshot, sp_mem_t mem, sp_str_t path);
+void      spn_index_snapshot_refresh(spn_index_info_t* index);
+bool      spn_index_snapshot_find(spn_index_snapshot_t* snapshot, sp_mem_t mem, spn_pkg_name_t id, spn_index_pkg_t** pkg);
+
+#endif
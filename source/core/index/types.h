@@ -7,6 +7,7 @@
 #include "sp/sp_om.h"
 #include "pkg/types.h"
 #include "semver/types.h"
+#include "thread_pool/types.h"
 
 // @spader this is just kind of a shim for now because the code that generates
 // this error doesn't know whether it's really an error yet (resolver calls
@@ -56,13 +57,41 @@ typedef struct {
   sp_da(spn_index_dep_t) deps;
   sp_da(spn_index_target_t) targets;
   spn_option_map_t options;
+
+  // Set when the release came out of a snapshot and only its version has been
+  // read; spn_index_release_load() parses the rest on first use
+  sp_str_t raw;
 } spn_index_release_t;
 
+// Releases are sorted by version, oldest first, and versions are unique; every
+// loader guarantees it so lookups can binary search
 typedef struct {
   spn_pkg_name_t id;
   sp_da(spn_index_release_t) releases;
 } spn_index_pkg_t;
 
+// The releases [begin, end) whose versions fall in a range
+typedef struct {
+  u32 begin;
+  u32 end;
+} spn_index_release_span_t;
+
+typedef enum {
+  SPN_INDEX_HTTP_OK,
+  SPN_INDEX_HTTP_NOT_MODIFIED,
+  SPN_INDEX_HTTP_NOT_FOUND,
+  SPN_INDEX_HTTP_FAILED,
+} spn_index_http_status_t;
+
+typedef struct {
+  sp_str_t etag;
+  sp_str_t modified;
+} spn_index_http_validators_t;
+
+// Sends the validators as If-None-Match / If-Modified-Since and, on a 200,
+// replaces them with the response's and fills body
+typedef spn_index_http_status_t (*spn_index_http_fetch_fn)(sp_mem_t mem, sp_str_t url, spn_index_http_validators_t* validators, sp_str_t* body, void* user_data);
+
 struct spn_index_info {
   sp_str_t name;
   spn_index_kind_t kind;
@@ -75,6 +104,8 @@ struct spn_index_info {
     } git;
     struct {
       sp_str_t url;
+      spn_index_http_fetch_fn fetch;
+      void* fetch_user_data;
     } http;
     struct {
       sp_str_t path;
@@ -86,11 +117,75 @@ struct spn_index_info {
 
 
 
+#define SPN_INDEX_SNAPSHOT_MAGIC 0x584e5053
+#define SPN_INDEX_SNAPSHOT_VERSION 1
+
+// On-disk layout: header, packages sorted by qualified name, releases sorted by
+// version within each package, then a string section. Offsets are bytes into
+// the string section
+typedef struct {
+  u32 magic;
+  u32 version;
+  u32 rev;
+  u32 rev_len;
+  u32 num_packages;
+  u32 num_releases;
+  u32 strings_len;
+  u32 padding;
+} spn_index_snapshot_header_t;
+
+// A package whose jsonl didn't parse is kept with no releases, so lookups fall
+// back to the file and report the error from there
+typedef struct {
+  u32 name;
+  u32 name_len;
+  u32 release;
+  u32 num_releases;
+} spn_index_snapshot_pkg_t;
+
+typedef struct {
+  u32 major;
+  u32 minor;
+  u32 patch;
+  u32 yanked;
+  u32 json;
+  u32 json_len;
+} spn_index_snapshot_rel_t;
+
+typedef struct {
+  sp_mem_slice_t data;
+  sp_str_t rev;
+  const spn_index_snapshot_pkg_t* packages;
+  const spn_index_snapshot_rel_t* releases;
+  const c8* strings;
+  u32 num_packages;
+} spn_index_snapshot_t;
+
+typedef struct {
+  bool loaded;
+  bool open;
+  spn_index_snapshot_t snapshot;
+} spn_index_cache_snapshot_t;
+
 typedef struct {
   sp_mem_t mem;
   sp_intern_t* intern;
   sp_da(spn_index_info_t)* indexes;
+  sp_da(spn_index_cache_snapshot_t) snapshots;
   sp_str_om(spn_index_pkg_t*) packages;
+
+  // Every name that went to the indexes, found or not
+  sp_da(spn_pkg_name_t) lookups;
+
+  // Zero workers turns prefetching off. The pool is made the first time a
+  // batch has more than one miss and kept for every batch after; each job
+  // loads into its own arena, since the cache's allocator isn't thread safe
+  struct {
+    u32 workers;
+    bool started;
+    spn_thread_pool_t pool;
+    sp_da(sp_mem_arena_t*) arenas;
+  } prefetch;
 } spn_index_cache_t;
 
 #endif
@@ -6,6 +6,7 @@
 #include "index/types.h"
 #include "intern/intern.h"
 #include "lock/lock.h"
+#include "semver/compare.h"
 #include "semver/convert.h"
 #include "sp/ht.h"
 #include "version.h"
@@ -220,3 +221,51 @@ sp_str_t spn_lock_file_to_str(sp_mem_t mem, spn_lock_file_t* lock) {
   sp_mem_end_scratch(scratch);
   return spn_toml_writer_write(&toml);
 }
+
+static bool lock_deps_agree(sp_da(sp_str_t) a, sp_da(sp_str_t) b) {
+  if (sp_da_size(a) != sp_da_size(b)) {
+    return false;
+  }
+
+  sp_da_for(a, it) {
+    bool found = false;
+    sp_da_for(b, jt) {
+      found |= sp_str_equal(a[it], b[jt]);
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Everything the locked walk reads from an entry, so a hand edit to spn.lock
+// that moves a rev or a dep edge can't be papered over by the memo
+static bool lock_entry_agrees(spn_lock_entry_t* a, spn_lock_entry_t* b) {
+  return a->kind == b->kind
+    && spn_semver_eq(a->version, b->version)
+    && sp_str_equal(a->commit, b->commit)
+    && sp_str_equal(a->source.url, b->source.url)
+    && sp_str_equal(a->source.rev, b->source.rev)
+    && sp_str_equal(a->source.dir, b->source.dir)
+    && sp_str_equal(a->manifest.url, b->manifest.url)
+    && sp_str_equal(a->manifest.rev, b->manifest.rev)
+    && sp_str_equal(a->manifest.dir, b->manifest.dir)
+    && sp_str_equal(a->paths.manifest, b->paths.manifest)
+    && sp_str_equal(a->paths.script, b->paths.script)
+    && lock_deps_agree(a->deps, b->deps);
+}
+
+bool spn_lock_file_agrees(spn_lock_file_t* a, spn_lock_file_t* b) {
+  if (sp_ht_size(a->entries) != sp_ht_size(b->entries)) {
+    return false;
+  }
+
+  sp_ht_for_kv(a->entries, it) {
+    spn_lock_entry_t* other = sp_ht_getp(b->entries, *it.key);
+    if (!other || !lock_entry_agrees(it.val, other)) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -10,5 +10,6 @@ spn_lock_file_t spn_build_lock_file(sp_mem_t mem, sp_intern_t* intern, spn_resol
 spn_lock_file_t spn_lock_file_parse(sp_mem_t mem, sp_str_t toml, spn_event_buffer_t* events);
 spn_lock_file_t spn_lock_file_load(sp_mem_t mem, sp_str_t path, spn_event_buffer_t* events);
 sp_str_t spn_lock_file_to_str(sp_mem_t mem, spn_lock_file_t* lock);
+bool spn_lock_file_agrees(spn_lock_file_t* a, spn_lock_file_t* b);
 
 #endif
@@ -0,0 +1,126 @@
+#include "lock/memo.h"
+
+#include "external/tom.h"
+#include "lock/lock.h"
+#include "sha256/sha256.h"
+#include "sp/io.h"
+
+static sp_str_t memo_digest(sp_mem_t mem, sp_str_t path) {
+  sp_str_t digest = sp_zero;
+  if (!sp_fs_exists(path) || spn_sha256_file(mem, path, &digest)) {
+    return sp_str_lit("");
+  }
+  return digest;
+}
+
+void spn_lock_memo_init(sp_mem_t mem, spn_lock_memo_t* memo, sp_str_t key) {
+  *memo = (spn_lock_memo_t) {
+    .mem = mem,
+    .key = sp_str_copy(mem, key),
+  };
+  sp_da_init(mem, memo->inputs);
+}
+
+void spn_lock_memo_add_input(spn_lock_memo_t* memo, sp_str_t path) {
+  sp_da_for(memo->inputs, it) {
+    if (sp_str_equal(memo->inputs[it].path, path)) {
+      return;
+    }
+  }
+
+  sp_da_push(memo->inputs, ((spn_lock_memo_input_t) {
+    .path = sp_str_copy(memo->mem, path),
+    .digest = memo_digest(memo->mem, path),
+  }));
+}
+
+sp_str_t spn_lock_memo_path(sp_mem_t mem, sp_str_t dir, sp_str_t key) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch_for(mem);
+  sp_str_t file = sp_str_concat(scratch.mem, key, sp_str_lit(".lock"));
+  sp_str_t path = sp_fs_join_path(mem, dir, file);
+  sp_mem_end_scratch(scratch);
+  return path;
+}
+
+// Succeeds only when the file was written under the same key and every input
+// still hashes the way it did then
+spn_err_t spn_lock_memo_load(spn_lock_memo_t* memo, sp_str_t path) {
+  memo->lock.some = false;
+  if (!sp_fs_exists(path)) {
+    return SPN_ERROR;
+  }
+
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch_for(memo->mem);
+  sp_str_t contents = sp_zero;
+  if (sp_io_read_file(scratch.mem, path, &contents) != SP_OK) {
+    sp_mem_end_scratch(scratch);
+    return SPN_ERROR;
+  }
+
+  c8 parse_err[256] = {0};
+  toml_table_t* root = toml_parse(sp_str_to_cstr(scratch.mem, contents), parse_err, SP_CARR_LEN(parse_err));
+  if (!root) {
+    sp_mem_end_scratch(scratch);
+    return SPN_ERROR;
+  }
+
+  spn_err_t result = SPN_ERROR;
+  toml_table_t* table = toml_table_table(root, "memo");
+  toml_array_t* inputs = table ? toml_table_array(table, "inputs") : SP_NULLPTR;
+  toml_array_t* digests = table ? toml_table_array(table, "digests") : SP_NULLPTR;
+  if (inputs && digests && sp_str_equal(spn_toml_str(scratch.mem, table, "key"), memo->key)) {
+    sp_da(sp_str_t) paths = spn_toml_arr_to_str_arr(scratch.mem, inputs);
+    sp_da(sp_str_t) expected = spn_toml_arr_to_str_arr(scratch.mem, digests);
+    if (sp_da_size(paths) == sp_da_size(expected)) {
+      result = SPN_OK;
+      sp_da_for(paths, it) {
+        if (!sp_str_equal(memo_digest(scratch.mem, paths[it]), expected[it])) {
+          result = SPN_ERROR;
+          break;
+        }
+        sp_da_push(memo->inputs, ((spn_lock_memo_input_t) {
+          .path = sp_str_copy(memo->mem, paths[it]),
+          .digest = sp_str_copy(memo->mem, expected[it]),
+        }));
+      }
+    }
+  }
+  toml_free(root);
+
+  if (result) {
+    sp_da_clear(memo->inputs);
+  }
+  else {
+    sp_opt_set(memo->lock, spn_lock_file_parse(memo->mem, contents, SP_NULLPTR));
+  }
+
+  sp_mem_end_scratch(scratch);
+  return result;
+}
+
+spn_err_t spn_lock_memo_save(spn_lock_memo_t* memo, spn_lock_file_t* lock, sp_str_t path) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch_for(memo->mem);
+
+  sp_da(sp_str_t) paths = sp_da_new(scratch.mem, sp_str_t);
+  sp_da(sp_str_t) digests = sp_da_new(scratch.mem, sp_str_t);
+  sp_da_for(memo->inputs, it) {
+    sp_da_push(paths, memo->inputs[it].path);
+    sp_da_push(digests, memo->inputs[it].digest);
+  }
+
+  spn_toml_writer_t toml = spn_toml_writer_new(scratch.mem);
+  spn_toml_begin_table_cstr(&toml, "memo");
+  spn_toml_append_str_cstr(&toml, "key", memo->key);
+  spn_toml_append_str_array_cstr(&toml, "inputs", paths);
+  spn_toml_append_str_array_cstr(&toml, "digests", digests);
+  spn_toml_end_table(&toml);
+
+  // The rest is an ordinary lock file, which ignores the extra table
+  sp_str_t output = sp_fmt(scratch.mem, "{}\n{}",
+    sp_fmt_str(spn_toml_writer_write(&toml)),
+    sp_fmt_str(spn_lock_file_to_str(scratch.mem, lock))).value;
+
+  spn_err_t result = sp_fs_write_atomic(path, output) ? SPN_ERROR : SPN_OK;
+  sp_mem_end_scratch(scratch);
+  return result;
+}
@@ -0,0 +1,14 @@
+#ifndef SPN_LOCK_MEMO_H
+#define SPN_LOCK_MEMO_H
+
+#include "sp.h"
+#include "spn/core.h"
+#include "lock/types.h"
+
+void      spn_lock_memo_init(sp_mem_t mem, spn_lock_memo_t* memo, sp_str_t key);
+void      spn_lock_memo_add_input(spn_lock_memo_t* memo, sp_str_t path);
+sp_str_t  spn_lock_memo_path(sp_mem_t mem, sp_str_t dir, sp_str_t key);
+spn_err_t spn_lock_memo_load(spn_lock_memo_t* memo, sp_str_t path);
+spn_err_t spn_lock_memo_save(spn_lock_memo_t* memo, spn_lock_file_t* lock, sp_str_t path);
+
+#endif
@@ -44,4 +44,20 @@ typedef struct {
   sp_ht(sp_str_t, bool) system_deps;
 } spn_lock_file_t;
 
+// A file the memoized resolution read. The digest is empty when the file
+// didn't exist, since its later appearance can change the answer too
+typedef struct {
+  sp_str_t path;
+  sp_str_t digest;
+} spn_lock_memo_input_t;
+
+// A resolution cached under a key covering everything the caller can hash up
+// front, plus the files that only turned out to matter once it had resolved
+typedef struct {
+  sp_mem_t mem;
+  sp_str_t key;
+  sp_da(spn_lock_memo_input_t) inputs;
+  sp_opt(spn_lock_file_t) lock;
+} spn_lock_memo_t;
+
 #endif
@@ -8,27 +8,92 @@
 #include "spn/core.h"
 #include "unit/types.h"
 
+#include "api/api.h"
+#include "api/journal.h"
 #include "cpu/cpu.h"
+#include "ctx/ctx.h"
 #include "dag/dag.h"
 #include "error/error.h"
 #include "external/wasm/wasm.h"
 #include "graph/build.h"
 #include "graph/dag.h"
+#include "graph/identity.h"
 #include "op/types.h"
 #include "paths/paths.h"
 #include "session/session.h"
+#include "sha256/sha256.h"
 #include "unit/package.h"
 #include "unit/unit.h"
 
-static s32 on_configure_package(spn_dag_t* g, spn_dag_action_t* action, void* user_data) {
-  spn_pkg_unit_t* unit = (spn_pkg_unit_t*)user_data;
+// Running the configure script is cached apart from publishing. The script's
+// API calls are journaled into a store-only artifact; when the action hits,
+// the script never runs and the publish action replays the journal instead
+typedef struct {
+  spn_pkg_unit_t* unit;
+  spn_dag_id_t journal;
+  sp_da(spn_dag_obs_t) obs;
+  bool live;
+} spn_configure_ctx_t;
+
+static s32 on_configure_script(spn_dag_t* g, spn_dag_action_t* action, void* user_data) {
+  spn_configure_ctx_t* ctx = (spn_configure_ctx_t*)user_data;
+  spn_pkg_unit_t* unit = ctx->unit;
   spn_pkg_unit_create_layout(unit);
+  sp_da_init(spn.mem, ctx->obs);
+
+  spn_api_journal_t journal = sp_zero;
+  spn_api_journal_init(&journal, spn.mem);
+
   spn_wasm_script_t* configure = &unit->wasm.configure;
-  if (configure->state != SPN_WASM_SCRIPT_NONE) {
-    spn_try(spn_wasm_script_open(configure, unit));
-    if (spn_wasm_script_exports(configure, sp_str_lit("configure"))) {
-      spn_try(spn_wasm_script_call(configure, unit, sp_str_lit("configure"), SPN_ABI_KIND_CONFIG, unit));
+  spn_try(spn_wasm_script_open(configure, unit));
+  if (spn_wasm_script_exports(configure, sp_str_lit("configure"))) {
+    // Writes are observed too: a hit replays the journal, not the script's own
+    // file writes, so those have to still be on disk for the entry to apply
+    unit->journal = &journal;
+    spn_err_t err = spn_wasm_script_call_ex(configure, unit, sp_str_lit("configure"), SPN_ABI_KIND_CONFIG, unit, (spn_wasm_obs_t) {
+      .mem = spn.mem,
+      .out = &ctx->obs,
+      .writes = true,
+    });
+    unit->journal = SP_NULLPTR;
+
+    // Configure runs once; build nodes that call into this script later get
+    // a fresh instance on demand
+    spn_wasm_script_trim(configure);
+    spn_try(err);
+  }
+  ctx->live = true;
+
+  spn_dag_artifact_t* artifact = spn_dag_find_artifact(g, ctx->journal);
+  return spn_api_journal_write(&journal, spn_path_str(g->roots, spn.mem, artifact->materialized));
+}
+
+static spn_err_t on_configure_discover(spn_dag_t* g, spn_dag_action_t* action, void* user_data, spn_dag_env_t* env, sp_mem_t mem, sp_da(spn_dag_obs_t)* out) {
+  spn_configure_ctx_t* ctx = (spn_configure_ctx_t*)user_data;
+  sp_da_for(ctx->obs, it) {
+    sp_da_push(*out, ctx->obs[it]);
+  }
+  return SPN_OK;
+}
+
+static spn_err_t replay_configure(spn_dag_t* g, spn_configure_ctx_t* ctx) {
+  spn_api_journal_t journal = sp_zero;
+  spn_api_journal_init(&journal, spn.mem);
+  spn_dag_artifact_t* artifact = spn_dag_find_artifact(g, ctx->journal);
+  spn_try(spn_api_journal_read(&journal, spn_path_str(g->roots, spn.mem, artifact->materialized)));
+  return spn_api_replay(ctx->unit, &journal);
+}
+
+static s32 on_configure_package(spn_dag_t* g, spn_dag_action_t* action, void* user_data) {
+  spn_configure_ctx_t* ctx = (spn_configure_ctx_t*)user_data;
+  spn_pkg_unit_t* unit = ctx->unit;
+  spn_pkg_unit_create_layout(unit);
+  if (ctx->journal.occupied) {
+    if (!ctx->live) {
+      spn_try(replay_configure(g, ctx));
     }
+    spn_dag_artifact_t* journal = spn_dag_find_artifact(g, ctx->journal);
+    spn_try(spn_sha256_file(spn.mem, spn_path_str(g->roots, spn.mem, journal->materialized), &unit->journal_digest));
   }
   sp_str_t include = spn_path_str(g->roots, spn.mem, unit->paths.include);
   spn_try(spn_pkg_unit_publish_existing_headers(unit, include));
@@ -40,15 +105,31 @@ static s32 on_configure_package(spn_dag_t* g, spn_dag_action_t* action, void* us
 static spn_err_t add_configure_action(spn_dag_build_t* b, spn_pkg_unit_t* unit) {
   spn_dag_t* g = b->graph;
 
+  spn_configure_ctx_t* ctx = sp_alloc_type(b->mem, spn_configure_ctx_t);
+  ctx->unit = unit;
+
   spn_dag_pkg_ids_t ids = sp_zero;
   ids.action = spn_dag_add_action(g, (spn_dag_action_config_t) {
     .execute = on_configure_package,
-    .user_data = unit,
+    .user_data = ctx,
     .uncacheable = true,
   });
   ids.stamp = spn_dag_add_file(g, unit->paths.stamp.configure);
   spn_try(spn_dag_action_add_output(g, ids.action, ids.stamp));
 
+  if (unit->wasm.configure.state != SPN_WASM_SCRIPT_NONE) {
+    spn_build_source_pin_t pin = spn_build_source_pin(unit);
+    ids.script = spn_dag_add_action(g, (spn_dag_action_config_t) {
+      .identity = spn_build_configure_identity(unit, &pin),
+      .execute = on_configure_script,
+      .discover = on_configure_discover,
+      .user_data = ctx,
+    });
+    ctx->journal = spn_dag_add_output(g, sp_str_lit("journal"));
+    spn_try(spn_dag_action_add_output(g, ids.script, ctx->journal));
+    spn_dag_action_add_input(g, ids.action, ctx->journal);
+  }
+
   sp_ht_insert(b->ids.packages, unit, ids);
   return SPN_OK;
 }
@@ -58,7 +139,7 @@ static void add_configure_edges(spn_dag_build_t* b, spn_pkg_unit_t* unit) {
 
   spn_dag_pkg_ids_t* unit_ids = sp_ht_getp(b->ids.packages, unit);
   sp_assert(unit_ids);
-  spn_dag_id_t action = unit_ids->action;
+  spn_dag_id_t action = unit_ids->script.occupied ? unit_ids->script : unit_ids->action;
 
   sp_da_for(unit->deps, it) {
     spn_dag_pkg_ids_t* dep = sp_ht_getp(b->ids.packages, unit->deps[it].unit);
@@ -101,6 +182,12 @@ spn_err_t configure(spn_op_t* op) {
   spn_try(spn_units_add_packages(s));
   spn_try(spn_units_add_targets(s, SPN_UNIT_SCOPE_METAPROGRAM));
 
+  // Scripts compile against the extracted runtime headers; a graph with no
+  // scripts never needs them on disk
+  if (!sp_da_empty(s->units.metaprogram->packages)) {
+    spn_try(spn_ctx_require_runtime(s->ctx));
+  }
+
   spn_dag_build_t* dag = spn_dag_build_new(op);
   s->dag.configure = dag;
 
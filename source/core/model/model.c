@@ -1,19 +1,37 @@
 #include "model/model.h"
 
+#include "ctx/ctx.h"
+#include "lock/types.h"
 #include "op/types.h"
 #include "session/types.h"
 #include "unit/unit.h"
 
-spn_err_t resolve(spn_op_t* op);
+void resolve_memo_load(spn_op_t* op, spn_lock_memo_t* memo);
+void resolve_memo_save(spn_op_t* op, spn_lock_memo_t* memo);
+spn_err_t resolve(spn_op_t* op, spn_lock_memo_t* memo);
 spn_err_t sync_packages(spn_op_t* op, bool* reresolve);
 spn_err_t configure(spn_op_t* op);
 
 spn_err_t spn_model_establish(spn_op_t* op) {
+  if (spn_ctx_uses_indexes(op->ctx)) {
+    spn_try(spn_ctx_require_indexes(op->ctx));
+  }
+
+  spn_lock_memo_t memo = sp_zero;
+  resolve_memo_load(op, &memo);
+
+  // Sync is a barrier before configure, not a per-package pipeline. A
+  // package's options come from the manifests of its consumers, not its deps,
+  // so it isn't settled until every package that depends on it has synced.
+  // Gated deps those options turn on can also send the whole set back to
+  // resolve. Within sync, downloads are queued ahead of cached loads instead.
   bool reresolve = sp_zero;
   do {
-    spn_try(resolve(op));
+    spn_try(resolve(op, &memo));
     spn_try(sync_packages(op, &reresolve));
   } while (reresolve);
+
+  resolve_memo_save(op, &memo);
   spn_try(configure(op));
   return spn_units_add_targets(op->session, SPN_UNIT_SCOPE_TARGET);
 }
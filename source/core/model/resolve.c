@@ -5,11 +5,16 @@
 #include "project/types.h"
 #include "resolve/types.h"
 
+#include "cpu/cpu.h"
+#include "dag/dag.h"
 #include "error/error.h"
 #include "event/event.h"
 #include "index/cache.h"
+#include "index/index.h"
 #include "op/types.h"
 #include "intern/intern.h"
+#include "lock/lock.h"
+#include "lock/memo.h"
 #include "pkg/id.h"
 #include "pkg/load.h"
 #include "toml/issue.h"
@@ -17,7 +22,10 @@
 #include "resolve/resolve.h"
 #include "semver/convert.h"
 #include "session/session.h"
+#include "sha256/sha256.h"
 #include "unit/types.h"
+#include "version.h"
+#include "when/when.h"
 
 static sp_str_t patch_dir(sp_mem_t mem, spn_index_release_t* release) {
   if (sp_str_empty(spn.paths.patches)) {
@@ -82,6 +90,187 @@ static void add_root(spn_session_t* session, spn_resolve_query_t* query) {
   });
 }
 
+// Trusts spn.lock when it still satisfies every manifest. The locked walk
+// never backtracks, so a lock that can't answer some request (a new dep, a
+// range it now falls outside of, a release whose sources moved) is dropped
+// and the caller solves from scratch, after which the build writes a fresh lock.
+static bool resolve_from_lock(spn_session_t* session, spn_resolver_t* resolver, spn_resolve_query_t* query) {
+  spn_project_t* project = session->project;
+  if (!project || !project->lock.some) {
+    return false;
+  }
+
+  spn_resolve_query_init(session->mem, query);
+  add_root(session, query);
+
+  resolver->lock = &project->lock.value;
+  spn_err_t err = spn_resolve_from_solver(resolver, query);
+  resolver->lock = SP_NULLPTR;
+
+  if (err) {
+    project->lock.some = false;
+    return false;
+  }
+
+  // Entries nothing reaches anymore are harmless to the walk, but the lock
+  // should stop carrying them
+  u64 locked = 0;
+  sp_ht_for_kv(query->result, it) {
+    if (it.val->source != SPN_PKG_SOURCE_ROOT) {
+      locked++;
+    }
+  }
+  if (locked != sp_ht_size(project->lock.value.entries)) {
+    project->lock.some = false;
+  }
+  return true;
+}
+
+// Everything the resolver reads that can be hashed before it runs. Git indexes
+// contribute their revision; other indexes change entry by entry, so the
+// entries a resolve looked at are recorded as inputs instead
+static bool memo_key(sp_mem_t mem, spn_session_t* session, sp_str_t* key) {
+  spn_sha256_ctx_t ctx = sp_zero;
+  spn_sha256_init(&ctx);
+  spn_dag_hash_str(&ctx, sp_str_lit("spn.resolve.memo.v1"));
+  spn_dag_hash_str(&ctx, sp_str_lit(SPN_VERSION));
+  spn_dag_hash_str(&ctx, sp_str_lit(SPN_BUILD_COMMIT));
+  spn_dag_hash_str(&ctx, session->project->paths.manifest);
+  spn_dag_hash_str(&ctx, spn.paths.patches);
+
+  spn_profile_info_t* profile = &session->profile;
+  spn_dag_hash_str(&ctx, profile->name);
+  spn_dag_hash_str(&ctx, profile->toolchain);
+  spn_dag_hash_u8(&ctx, (u8)profile->os);
+  spn_dag_hash_u8(&ctx, (u8)profile->arch);
+  spn_dag_hash_u8(&ctx, (u8)profile->abi);
+  spn_dag_hash_u8(&ctx, (u8)profile->linkage);
+  spn_dag_hash_u8(&ctx, (u8)profile->standard);
+  spn_dag_hash_u8(&ctx, (u8)profile->mode);
+  spn_dag_hash_u8(&ctx, (u8)profile->opt);
+  spn_dag_hash_bytes(&ctx, &profile->sanitizers, sizeof(profile->sanitizers));
+  spn_dag_hash_u8(&ctx, (u8)profile->targeted);
+  spn_dag_hash_path(&ctx, profile->sysroot);
+  spn_dag_hash_str(&ctx, spn_when_to_str(mem, &profile->options));
+
+  spn_dag_hash_u64(&ctx, sp_da_size(spn.indexes));
+  sp_da_for(spn.indexes, it) {
+    spn_index_info_t* index = &spn.indexes[it];
+    spn_dag_hash_str(&ctx, index->name);
+    spn_dag_hash_u8(&ctx, (u8)index->protocol);
+    spn_dag_hash_str(&ctx, spn_index_source(index));
+    spn_dag_hash_str(&ctx, index->location);
+
+    if (index->protocol == SPN_INDEX_PROTOCOL_GIT) {
+      sp_str_t rev = sp_zero;
+      if (!spn_index_revision(mem, index, &rev)) {
+        return false;
+      }
+      spn_dag_hash_str(&ctx, rev);
+    }
+  }
+
+  spn_dag_digest_t digest = spn_dag_hash_final(&ctx);
+  *key = spn_sha256_digest_hex(mem, digest.bytes);
+  return true;
+}
+
+static void memo_record_lookups(spn_lock_memo_t* memo, spn_index_cache_t* cache) {
+  if (sp_str_empty(memo->key)) {
+    return;
+  }
+
+  sp_da_for(spn.indexes, it) {
+    spn_index_info_t* index = &spn.indexes[it];
+    if (index->protocol == SPN_INDEX_PROTOCOL_GIT) {
+      continue;
+    }
+
+    sp_da_for(cache->lookups, jt) {
+      sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+      spn_lock_memo_add_input(memo, spn_index_entry_path(scratch.mem, index, cache->lookups[jt]));
+      sp_mem_end_scratch(scratch);
+    }
+  }
+}
+
+// Only the first pass may use the memo; its lock is the fixed point of the
+// option loop, so a pass after that means something no longer matches. A
+// committed spn.lock still wins over a memo that disagrees with it
+static bool resolve_from_memo(spn_session_t* session, spn_resolver_t* resolver, spn_resolve_query_t* query, spn_lock_memo_t* memo) {
+  if (!memo->lock.some) {
+    return false;
+  }
+
+  spn_project_t* project = session->project;
+  bool usable = !session->gates.resolves && (!project->lock.some || spn_lock_file_agrees(&project->lock.value, &memo->lock.value));
+  if (!usable) {
+    memo->lock.some = false;
+    return false;
+  }
+
+  spn_resolve_query_init(session->mem, query);
+  add_root(session, query);
+
+  resolver->lock = &memo->lock.value;
+  resolver->lock_edges = true;
+  spn_err_t err = spn_resolve_from_solver(resolver, query);
+  resolver->lock = SP_NULLPTR;
+  resolver->lock_edges = false;
+
+  if (err) {
+    memo->lock.some = false;
+    return false;
+  }
+  return true;
+}
+
+void resolve_memo_load(spn_op_t* op, spn_lock_memo_t* memo) {
+  spn_session_t* session = op->session;
+  *memo = SP_ZERO_STRUCT(spn_lock_memo_t);
+
+  sp_str_t key = sp_zero;
+  if (!session->project || !memo_key(session->mem, session, &key)) {
+    return;
+  }
+
+  spn_lock_memo_init(session->mem, memo, key);
+  sp_str_t path = spn_lock_memo_path(session->mem, spn.paths.caches.resolve.dir, key);
+  spn_lock_memo_load(memo, path);
+}
+
+// Called once the option loop has settled. A graph that came straight from the
+// memo is already on disk; anything else replaces it
+void resolve_memo_save(spn_op_t* op, spn_lock_memo_t* memo) {
+  spn_session_t* session = op->session;
+  if (sp_str_empty(memo->key) || memo->lock.some) {
+    return;
+  }
+
+  sp_ht_for_kv(session->registry, it) {
+    if (!sp_str_empty(it.val->manifest)) {
+      spn_lock_memo_add_input(memo, it.val->manifest);
+    }
+  }
+
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  if (!sp_str_empty(spn.paths.patches)) {
+    sp_ht_for_kv(session->resolve, it) {
+      spn_resolved_pkg_t* pkg = it.val;
+      if (pkg->source != SPN_PKG_SOURCE_INDEX) {
+        continue;
+      }
+
+      sp_str_t dir = sp_fs_join_path(scratch.mem, spn.paths.patches, pkg->origin.release->id.name);
+      spn_lock_memo_add_input(memo, sp_fs_join_path(scratch.mem, dir, pkg->origin.release->paths.manifest));
+    }
+  }
+
+  spn_lock_file_t lock = spn_build_lock_file(scratch.mem, session->ctx->intern, session->resolve, session->pkg);
+  spn_lock_memo_save(memo, &lock, spn_lock_memo_path(scratch.mem, spn.paths.caches.resolve.dir, memo->key));
+  sp_mem_end_scratch(scratch);
+}
+
 static void emit_resolved(sp_mem_t mem, spn_resolve_query_t* query) {
   sp_ht_for_kv(query->result, it) {
     spn_event_buffer_push(spn.events, (spn_event_t) {
@@ -102,7 +291,7 @@ static void emit_resolved(sp_mem_t mem, spn_resolve_query_t* query) {
   });
 }
 
-spn_err_t resolve(spn_op_t* op) {
+spn_err_t resolve(spn_op_t* op, spn_lock_memo_t* memo) {
   spn_session_t* session = op->session;
   spn_event_buffer_push(spn.events, (spn_event_t) {
     .kind = SPN_EVENT_RESOLVE_START,
@@ -115,18 +304,27 @@ spn_err_t resolve(spn_op_t* op) {
     .manifest = session->project->paths.manifest,
   }));
 
-  spn_index_cache_t index = sp_zero;
-  spn_index_cache_init(&index, session->mem, session->ctx->intern, &spn.indexes);
+  // Every pass shares one cache, and with it the prefetch pool
+  spn_index_cache_t* index = &session->index;
+  if (!index->indexes) {
+    spn_index_cache_init(index, session->mem, session->ctx->intern, &spn.indexes);
+    index->prefetch.workers = spn_cpu_count();
+  }
 
   spn_resolver_t resolver = sp_zero;
-  spn_resolver_init(&resolver, spn.mem, session->ctx->intern, &index, &session->registry, session->profile, session->pkg->config, 0);
+  spn_resolver_init(&resolver, spn.mem, session->ctx->intern, index, &session->registry, session->profile, session->pkg->config, 0);
   resolver.seeds = session->gates.seeds;
 
   spn_resolve_query_t query = sp_zero_initialize();
-  spn_resolve_query_init(session->mem, &query);
-  add_root(session, &query);
+  spn_err_t err = SPN_OK;
+  if (!resolve_from_memo(session, &resolver, &query, memo) && !resolve_from_lock(session, &resolver, &query)) {
+    spn_resolve_query_init(session->mem, &query);
+    add_root(session, &query);
+    err = spn_resolve_from_solver(&resolver, &query);
+  }
+  memo_record_lookups(memo, index);
 
-  if (spn_resolve_from_solver(&resolver, &query)) {
+  if (err) {
     sp_da_for(query.errors, it) {
       spn_err_emit(session->ctx, query.errors[it]);
     }
@@ -37,27 +37,34 @@ typedef struct {
   spn_session_t* session;
   spn_resolved_pkg_t* pkg;
   spn_loaded_pkg_t loaded;
+  bool cached;
   spn_err_t err;
 } pkg_job_t;
 
 typedef struct {
   spn_op_t* op;
   spn_toolchain_unit_t* unit;
+  bool cached;
   spn_err_t err;
 } toolchain_job_t;
 
+static bool toolchain_is_cached(spn_toolchain_store_t* store, spn_toolchain_unit_t* unit) {
+  if (unit->info->source != SPN_TOOLCHAIN_SOURCE_DISTRIBUTION) {
+    return true;
+  }
+  return sp_fs_is_dir(spn_toolchain_store_path(store, sp_opt_get(unit->artifact)));
+}
+
 static spn_err_t setup_toolchain_unit(spn_toolchain_store_t* store, spn_toolchain_unit_t* unit) {
   spn_toolchain_info_t* toolchain = unit->info;
   sp_str_t name = toolchain->name;
 
   sp_tm_timer_t timer = sp_tm_start_timer();
 
-  bool cached = true;
+  bool cached = toolchain_is_cached(store, unit);
   sp_str_t url = sp_zero;
   if (toolchain->source == SPN_TOOLCHAIN_SOURCE_DISTRIBUTION) {
-    spn_artifact_t artifact = sp_opt_get(unit->artifact);
-    url = spn_artifact_resolve_url(spn.mem, artifact, store->mirror);
-    cached = sp_fs_is_dir(spn_toolchain_store_path(store, artifact));
+    url = spn_artifact_resolve_url(spn.mem, sp_opt_get(unit->artifact), store->mirror);
   }
 
   if (!cached) {
@@ -265,6 +272,14 @@ static sp_str_t sync_url(spn_pkg_root_t recipe, spn_pkg_root_t source) {
   return sp_str_lit("");
 }
 
+static bool tree_is_cached(spn_session_t* session, spn_pkg_root_t tree) {
+  return tree.kind != SPN_PKG_ROOT_GIT || spn_git_cache_is_checkout_cached(&session->ctx->caches.git, tree.git);
+}
+
+static bool package_is_cached(spn_session_t* session, spn_resolved_pkg_t* pkg) {
+  return tree_is_cached(session, pkg->origin.recipe) && tree_is_cached(session, pkg->origin.source);
+}
+
 static bool package_has_build_deps(spn_resolved_pkg_t* pkg) {
   sp_da_for(pkg->edges, it) {
     if (pkg->edges[it].kind == SPN_DEP_KIND_BUILD) {
@@ -454,6 +469,7 @@ spn_err_t sync_packages(spn_op_t* op, bool* reresolve) {
     job->op = op;
     job->session = session;
     job->pkg = pkg;
+    job->cached = package_is_cached(session, pkg);
     sp_da_push(packages, job);
   }
 
@@ -461,6 +477,7 @@ spn_err_t sync_packages(spn_op_t* op, bool* reresolve) {
     toolchain_job_t* job = sp_alloc_type(session->mem, toolchain_job_t);
     job->op = op;
     job->unit = session->units.toolchains[it];
+    job->cached = toolchain_is_cached(&spn.caches.toolchains, job->unit);
     sp_da_push(toolchains, job);
   }
 
@@ -483,13 +500,27 @@ spn_err_t sync_packages(spn_op_t* op, bool* reresolve) {
 
   sp_tm_timer_t timer = sp_tm_start_timer();
 
-  sp_da_for(packages, it) {
-    spn_thread_pool_submit(&pool.executor, (spn_thread_pool_job_t) { .fn = sync_package_node, .data = packages[it] });
-  }
-  sp_da_for(toolchains, it) {
-    spn_thread_pool_submit(&pool.executor, (spn_thread_pool_job_t) { .fn = sync_toolchain_node, .data = toolchains[it] });
+  // Downloads go first. The slowest clone bounds the whole phase, so it
+  // should never wait in the queue behind packages that are already on
+  // disk; those fill in the workers around it
+  sp_for(pass, 2) {
+    bool cached = pass > 0;
+    sp_da_for(packages, it) {
+      if (packages[it]->cached == cached) {
+        spn_thread_pool_submit(&pool.executor, (spn_thread_pool_job_t) { .fn = sync_package_node, .data = packages[it] });
+      }
+    }
+    sp_da_for(toolchains, it) {
+      if (toolchains[it]->cached == cached) {
+        spn_thread_pool_submit(&pool.executor, (spn_thread_pool_job_t) { .fn = sync_toolchain_node, .data = toolchains[it] });
+      }
+    }
   }
 
+  // The main thread would otherwise sit in the wait. Bring up the script
+  // runtime configure needs next; configure reports any failure
+  spn_wasm_init();
+
   spn_thread_pool_wait(&pool);
   spn_thread_pool_deinit(&pool);
   u64 elapsed = sp_tm_read_timer(&timer);
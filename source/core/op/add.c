@@ -4,6 +4,7 @@
 #include "error/error.h"
 #include "event/event.h"
 #include "index/cache.h"
+#include "index/release.h"
 #include "index/types.h"
 #include "op/op.h"
 #include "spn/host.h"
@@ -77,6 +78,7 @@ static spn_err_t index_err(spn_ctx_t* ctx, spn_pkg_name_t name, spn_err_t kind,
 
 static spn_err_t add(spn_ctx_t* ctx, spn_add_request_t request, spn_semver_range_t range) {
   spn_try(spn_ctx_require_project(ctx));
+  spn_try(spn_ctx_require_indexes(ctx));
 
   spn_pkg_name_t name = spn_pkg_name_from_qualified(request.name);
 
@@ -94,16 +96,12 @@ static spn_err_t add(spn_ctx_t* ctx, spn_add_request_t request, spn_semver_range
   }
 
   spn_index_release_t* release = SP_NULLPTR;
-  sp_da_rfor(pkg->releases, it) {
-    spn_index_release_t* candidate = &pkg->releases[it];
-    if (candidate->yanked) {
-      continue;
-    }
-    if (!spn_semver_in_range(candidate->version, range)) {
-      continue;
+  spn_index_release_span_t span = spn_index_release_span(pkg, range);
+  for (u32 it = span.end; it > span.begin; it--) {
+    if (!pkg->releases[it - 1].yanked) {
+      release = &pkg->releases[it - 1];
+      break;
     }
-    release = candidate;
-    break;
   }
 
   if (!release) {
@@ -35,6 +35,13 @@ static void sync_index_node(void* data) {
 static spn_err_t sync_indexes(spn_op_t* op) {
   spn_ctx_t* ctx = op->ctx;
   spn_sync_request_t request = op->request.indexes;
+
+  // The refresh ahead of a build is skipped outright when nothing in the
+  // project could be resolved from an index
+  if (request.lazy && !spn_ctx_uses_indexes(ctx)) {
+    return SPN_OK;
+  }
+  spn_try(spn_ctx_require_indexes(ctx));
   if (!sp_str_empty(request.only) && !spn_find_index(ctx, request.only)) {
     return spn_err_emit(ctx, (spn_err_union_t) {
       .kind = SPN_ERR_INDEX_UNKNOWN,
@@ -121,6 +128,7 @@ spn_op_t* spn_sync_indexes(spn_ctx_t* ctx, spn_sync_request_t request) {
   spn_op_t* op = spn_op_new(ctx, SP_NULLPTR, SPN_OP_SYNC_INDEXES);
   op->request.indexes = (spn_sync_request_t) {
     .force = request.force,
+    .lazy = request.lazy,
     .only = sp_str_copy(ctx->heap, request.only),
   };
   spn_op_submit(op);
@@ -67,18 +67,27 @@ static s32 op_thread(void* data) {
 }
 
 void spn_op_thread_start(spn_ctx_t* ctx) {
+  ctx->ops.started = true;
   sp_queue_init(&ctx->ops.queue);
   sp_atomic_u32_store(&ctx->ops.running, 1, SP_ATOMIC_RELEASE);
   sp_thread_init(&ctx->ops.thread, op_thread, ctx);
 }
 
 void spn_op_thread_stop(spn_ctx_t* ctx) {
+  if (!ctx->ops.started) {
+    return;
+  }
   sp_atomic_u32_store(&ctx->ops.running, 0, SP_ATOMIC_RELEASE);
   sp_queue_wake(&ctx->ops.queue);
   sp_thread_join(&ctx->ops.thread);
 }
 
+// The thread comes up with the first op, so commands that never submit one
+// (help, version, bad arguments) exit without spawning it
 void spn_op_submit(spn_op_t* op) {
+  if (!op->ctx->ops.started) {
+    spn_op_thread_start(op->ctx);
+  }
   sp_queue_push(&op->ctx->ops.queue, &op->node);
 }
 
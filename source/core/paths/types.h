@@ -43,11 +43,16 @@ typedef struct {
   sp_str_t dir;
 } spn_build_cache_paths_t;
 
+typedef struct {
+  sp_str_t dir;
+} spn_resolve_cache_paths_t;
+
 typedef struct {
   sp_str_t dir;
   spn_git_cache_paths_t git;
   spn_store_cache_paths_t store;
   spn_build_cache_paths_t build;
+  spn_resolve_cache_paths_t resolve;
 } spn_cache_paths_t;
 
 typedef struct {
@@ -10,6 +10,8 @@
 
 #include "index/cache.h"
 #include "index/index.h"
+#include "index/json.h"
+#include "index/release.h"
 #include "intern/intern.h"
 #include "pkg/id.h"
 #include "pkg/load.h"
@@ -62,6 +64,44 @@ typedef struct {
   bool private;
 } spn_scope_edge_t;
 
+// # LEARNING
+//
+// Everything the search does under a candidate is a function of the index,
+// the manifests, and the answers to a handful of per-name lookups: is the
+// name on the current path, has this scope picked it, is it pinned. A touch
+// records one name's answers the first time a subtree asks.
+//
+// When a candidate's subtree fails, its touches are an incompatibility: the
+// same release fails again wherever every touched name reads the same. The
+// table outlives any one branch, so a conflict found under one pick prunes
+// every later branch that walks back into it, which is most of what
+// backjumping buys without having to unwind past the pick.
+//
+// Besides the names, an incompatibility holds the scope it was found in and
+// how many scope edges existed then. Both only ever grow between passes, and
+// a subtree classifies its deps against them, so a clause found before a
+// scope gained an edge isn't trusted after.
+typedef struct {
+  sp_intern_id_t name;
+  bool visited;
+  bool named;
+  spn_semver_t version;
+  bool held;
+  bool contradiction;
+  spn_semver_t pinned;
+} spn_touch_t;
+
+typedef struct {
+  sp_intern_id_t name;
+  spn_semver_t version;
+  u32 scope;
+  u64 edges;
+  sp_da(spn_touch_t) touches;
+  spn_err_union_t err;
+} spn_nogood_t;
+
+typedef sp_da(spn_nogood_t) spn_nogood_list_t;
+
 typedef struct {
   spn_resolve_query_t* query;
   sp_da(spn_scope_t) scopes;
@@ -76,6 +116,9 @@ typedef struct {
   bool has_forced;
   spn_pin_t retry[2];
   u32 retries;
+  sp_da(spn_touch_t) trail;
+  u32 depth;
+  sp_ht(sp_hash_t, spn_nogood_list_t) learned;
 } spn_resolve_run_t;
 
 typedef struct {
@@ -120,6 +163,7 @@ void spn_resolver_init(spn_resolver_t* r, sp_mem_t mem, sp_intern_t* intern, spn
     .profile = profile,
     .config = config,
     .budget = budget ? budget : SPN_RESOLVE_DEFAULT_BUDGET,
+    .learn = true,
   };
 }
 
@@ -264,6 +308,21 @@ static void node_options_env(spn_resolver_t* resolver, spn_resolved_pkg_t* node,
   spn_pkg_options_env(resolver->mem, node, &resolver->profile, resolver->config, seeds ? *seeds : SP_NULLPTR, env);
 }
 
+static bool dep_gate_open(spn_resolver_t* resolver, spn_resolved_pkg_t* node, const spn_when_t* when, sp_str_t qualified, spn_when_env_t* env) {
+  if (resolver->lock && resolver->lock_edges && !sp_da_empty(when->clauses)) {
+    spn_lock_entry_t* entry = sp_ht_getp(resolver->lock->entries, sp_intern_str_from_id(resolver->intern, node->id.qualified));
+    if (entry) {
+      sp_da_for(entry->deps, it) {
+        if (sp_str_equal(entry->deps[it], qualified)) {
+          return true;
+        }
+      }
+      return false;
+    }
+  }
+  return spn_when_eval(when, env);
+}
+
 static bool node_is_shared(spn_resolver_t* resolver, spn_resolved_pkg_t* node) {
   spn_kind_query_t query = kind_query(resolver, node->name);
 
@@ -435,9 +494,141 @@ static u32 find_or_create_scope(spn_resolver_t* resolver, spn_resolve_run_t* run
   return (u32)(sp_da_size(run->scopes) - 1);
 }
 
+static spn_touch_t touch_state(spn_resolve_run_t* run, spn_scope_t* scope, sp_intern_id_t name) {
+  spn_touch_t touch = { .name = name };
+  touch.visited = sp_ht_getp(run->visited, name) != SP_NULLPTR;
+
+  spn_resolved_pkg_t* named = sp_ht_getp(scope->named, name);
+  if (named) {
+    touch.named = true;
+    touch.version = named->id.version;
+  }
+
+  touch.held = find_forced(run, name, &touch.pinned) || find_pin(scope, name, &touch.pinned, &touch.contradiction);
+  return touch;
+}
+
+static bool touch_eq(spn_touch_t a, spn_touch_t b) {
+  if (a.visited != b.visited || a.named != b.named || a.held != b.held || a.contradiction != b.contradiction) return false;
+  if (a.named && !spn_semver_eq(a.version, b.version)) return false;
+  if (a.held && !spn_semver_eq(a.pinned, b.pinned)) return false;
+  return true;
+}
+
+// Only candidates learn, so lookups outside of one needn't be kept
+static void touch(spn_resolve_run_t* run, spn_scope_t* scope, sp_intern_id_t name) {
+  if (run->depth) {
+    sp_da_push(run->trail, touch_state(run, scope, name));
+  }
+}
+
+static sp_hash_t nogood_key(sp_intern_id_t name, spn_semver_t version) {
+  return sp_hash_bytes(&version, sizeof(spn_semver_t), (sp_hash_t)name);
+}
+
+static spn_nogood_t* find_nogood(spn_resolve_run_t* run, spn_scope_t* scope, sp_intern_id_t name, spn_semver_t version) {
+  spn_nogood_list_t* list = sp_ht_getp(run->learned, nogood_key(name, version));
+  if (!list) {
+    return SP_NULLPTR;
+  }
+
+  sp_da_for(*list, it) {
+    spn_nogood_t* nogood = &(*list)[it];
+    if (nogood->name != name || !spn_semver_eq(nogood->version, version)) {
+      continue;
+    }
+    if (nogood->scope != run->scope || nogood->edges != sp_da_size(run->edges)) {
+      continue;
+    }
+
+    bool holds = true;
+    sp_da_for(nogood->touches, jt) {
+      if (!touch_eq(nogood->touches[jt], touch_state(run, scope, nogood->touches[jt].name))) {
+        holds = false;
+        break;
+      }
+    }
+    if (holds) {
+      return nogood;
+    }
+  }
+  return SP_NULLPTR;
+}
+
+// The stored cause describes the path it was learned on. A conflict over a
+// name the pruned path also holds is reported with the version this path
+// holds; anything else is a function of manifests the subtree reads, so it's
+// the same wherever the clause applies.
+static spn_err_union_t nogood_err(spn_resolver_t* resolver, spn_resolve_run_t* run, spn_scope_t* scope, spn_nogood_t* nogood) {
+  spn_err_union_t err = nogood->err;
+  switch (err.kind) {
+    case SPN_ERR_PKG_NO_MATCH:
+    case SPN_ERR_PKG_CONFLICT:
+    case SPN_ERR_PKG_CONFLICT_EXACT: {
+      sp_intern_id_t cause = sp_intern_get_or_insert(resolver->intern, err.unsatisfiable.qualified);
+      sp_da_for(nogood->touches, it) {
+        if (nogood->touches[it].name != cause) {
+          continue;
+        }
+        spn_touch_t state = touch_state(run, scope, cause);
+        if (state.named) {
+          err.unsatisfiable.selected = state.version;
+        }
+        else if (state.held) {
+          err.unsatisfiable.selected = state.pinned;
+        }
+        break;
+      }
+      return err;
+    }
+    default: {
+      return err;
+    }
+  }
+}
+
+// A name's first touch is the one that matters: later touches of the same
+// name see what the subtree itself did to it. The candidate's own entry
+// state leads the list, since its subtree rewrites that name before anything
+// below could touch it.
+static void learn_nogood(spn_resolver_t* resolver, spn_resolve_run_t* run, spn_touch_t self, spn_semver_t version, u64 trail, spn_err_union_t err) {
+  spn_nogood_t nogood = {
+    .name = self.name,
+    .version = version,
+    .scope = run->scope,
+    .edges = sp_da_size(run->edges),
+    .touches = sp_da_new(resolver->mem, spn_touch_t),
+    .err = err,
+  };
+  sp_da_push(nogood.touches, self);
+
+  for (u64 it = trail; it < sp_da_size(run->trail); it++) {
+    bool seen = false;
+    sp_da_for(nogood.touches, jt) {
+      if (nogood.touches[jt].name == run->trail[it].name) {
+        seen = true;
+        break;
+      }
+    }
+    if (!seen) {
+      sp_da_push(nogood.touches, run->trail[it]);
+    }
+  }
+
+  sp_hash_t key = nogood_key(self.name, version);
+  spn_nogood_list_t* list = sp_ht_getp(run->learned, key);
+  if (!list) {
+    sp_ht_insert(run->learned, key, sp_da_new(resolver->mem, spn_nogood_t));
+    list = sp_ht_getp(run->learned, key);
+  }
+  sp_da_push(*list, nogood);
+  resolver->stats.learned++;
+}
+
 static spn_err_union_t resolve_local_package(spn_resolver_t* resolver, spn_resolve_run_t* run, spn_resolved_pkg_t* from, spn_requested_dep_t* request) {
   spn_scope_t* scope = &run->scopes[run->scope];
   sp_intern_id_t name = sp_intern_get_or_insert(resolver->intern, request->qualified);
+  touch(run, scope, name);
 
   if (sp_ht_getp(run->visited, name)) {
     return (spn_err_union_t) {
@@ -500,7 +691,7 @@ static spn_err_union_t resolve_local_package(spn_resolver_t* resolver, spn_resol
   spn_when_env_t env;
   node_options_env(resolver, &node, &env);
   sp_da_for(pkg->info->deps, it) {
-    if (!spn_when_eval(&pkg->info->deps[it].when, &env)) {
+    if (!dep_gate_open(resolver, &node, &pkg->info->deps[it].when, pkg->info->deps[it].qualified, &env)) {
       continue;
     }
     sp_da_push(node.deps, pkg->info->deps[it]);
@@ -510,6 +701,18 @@ static spn_err_union_t resolve_local_package(spn_resolver_t* resolver, spn_resol
   return solve_node(resolver, run, scope, name, &node);
 }
 
+// Snapshot releases arrive with only a version; read the rest once something
+// actually needs it
+static spn_err_union_t load_release(spn_resolver_t* resolver, spn_index_release_t* release) {
+  if (spn_index_release_load(resolver->index->mem, release)) {
+    return (spn_err_union_t) {
+      .kind = SPN_ERR_INDEX_CORRUPT,
+      .index_corrupt = { .name = spn_pkg_name_to_qualified(release->id) },
+    };
+  }
+  return ok_union();
+}
+
 static spn_err_union_t try_candidate(spn_resolver_t* resolver, spn_resolve_run_t* run, spn_index_release_t* release) {
   if (run->fatal || !run->budget) {
     run->fatal = true;
@@ -519,11 +722,27 @@ static spn_err_union_t try_candidate(spn_resolver_t* resolver, spn_resolve_run_t
     };
   }
   run->budget--;
+  resolver->stats.candidates++;
 
   spn_scope_t* scope = &run->scopes[run->scope];
   sp_str_t qualified = spn_pkg_name_to_qualified(release->id);
   sp_intern_id_t name = sp_intern_get_or_insert(resolver->intern, qualified);
 
+  spn_touch_t self = touch_state(run, scope, name);
+  if (resolver->learn) {
+    spn_nogood_t* nogood = find_nogood(run, scope, name, release->version);
+    if (nogood) {
+      // Any candidate above now fails for the same reasons this one does
+      sp_da_for(nogood->touches, it) {
+        touch(run, scope, nogood->touches[it].name);
+      }
+      resolver->stats.pruned++;
+      return nogood_err(resolver, run, scope, nogood);
+    }
+  }
+
+  try_union(load_release(resolver, release));
+
   spn_resolved_pkg_t node = {
     .id = {
       .qualified = name,
@@ -545,12 +764,13 @@ static spn_err_union_t try_candidate(spn_resolver_t* resolver, spn_resolve_run_t
 
   sp_da_init(resolver->mem, node.deps);
   sp_da_for(release->deps, it) {
-    if (!spn_when_eval(&release->deps[it].when, &env)) {
+    sp_str_t qualified = spn_pkg_name_to_qualified(release->deps[it].id);
+    if (!dep_gate_open(resolver, &node, &release->deps[it].when, qualified, &env)) {
       continue;
     }
 
     sp_da_push(node.deps, ((spn_requested_dep_t) {
-      .qualified = spn_pkg_name_to_qualified(release->deps[it].id),
+      .qualified = qualified,
       .source = SPN_PKG_SOURCE_INDEX,
       .kind = dep_kind_from_index(release->deps[it].kind),
       .private = release->deps[it].private,
@@ -563,12 +783,51 @@ static spn_err_union_t try_candidate(spn_resolver_t* resolver, spn_resolve_run_t
   }
   sp_da_sort(node.deps, sort_req_canonical);
 
-  return solve_node(resolver, run, scope, name, &node);
+  u64 trail = sp_da_size(run->trail);
+  run->depth++;
+  spn_err_union_t err = solve_node(resolver, run, scope, name, &node);
+  run->depth--;
+
+  // A blown budget says nothing about the release
+  if (err.kind && !run->fatal && resolver->learn) {
+    learn_nogood(resolver, run, self, release->version, trail, err);
+  }
+  if (!run->depth) {
+    sp_da_clear(run->trail);
+  }
+  return err;
+}
+
+static bool lock_root_matches(spn_pkg_root_t root, sp_str_t rev) {
+  return root.kind != SPN_PKG_ROOT_GIT || sp_str_equal(root.git.rev, rev);
+}
+
+// A locked release is trusted as long as the manifests that reach it still
+// accept it and the index still describes the same sources. Yanking doesn't
+// matter here; only a fresh solve avoids yanked releases.
+static spn_err_union_t resolve_locked_package(spn_resolver_t* resolver, spn_resolve_run_t* run, spn_resolved_pkg_t* from, spn_requested_dep_t* request, spn_index_pkg_t* pkg) {
+  spn_lock_entry_t* entry = sp_ht_getp(resolver->lock->entries, request->qualified);
+  if (!entry || entry->kind != SPN_PKG_SOURCE_INDEX || !spn_semver_in_range(entry->version, request->index.range)) {
+    run->fatal = true;
+    return unsatisfiable_err(resolver, from, request, SPN_ERR_PKG_CONFLICT, entry ? entry->version : sp_zero_s(spn_semver_t));
+  }
+
+  spn_index_release_t* release = spn_index_release_find(pkg, entry->version);
+  if (release) {
+    try_union(load_release(resolver, release));
+    if (lock_root_matches(release->source, entry->source.rev) && lock_root_matches(release->manifest, entry->manifest.rev)) {
+      return try_candidate(resolver, run, release);
+    }
+  }
+
+  run->fatal = true;
+  return unsatisfiable_err(resolver, from, request, SPN_ERR_PKG_CONFLICT, entry->version);
 }
 
 static spn_err_union_t resolve_index_package(spn_resolver_t* resolver, spn_resolve_run_t* run, spn_resolved_pkg_t* from, spn_requested_dep_t* request) {
   spn_scope_t* scope = &run->scopes[run->scope];
   sp_intern_id_t name = sp_intern_get_or_insert(resolver->intern, request->qualified);
+  touch(run, scope, name);
 
   if (sp_ht_getp(run->visited, name)) {
     return (spn_err_union_t) {
@@ -604,6 +863,10 @@ static spn_err_union_t resolve_index_package(spn_resolver_t* resolver, spn_resol
     };
   }
 
+  if (resolver->lock) {
+    return resolve_locked_package(resolver, run, from, request, pkg);
+  }
+
   // By definition, if a name is pinned and a candidatae version doesn't satisfy
   // the pin, this branch of resolution fails.
   spn_semver_t pinned = sp_zero;
@@ -614,10 +877,9 @@ static spn_err_union_t resolve_index_package(spn_resolver_t* resolver, spn_resol
       return unsatisfiable_err(resolver, from, request, SPN_ERR_PKG_CONFLICT, pinned);
     }
 
-    sp_da_for(pkg->releases, it) {
-      if (spn_semver_eq(pkg->releases[it].version, pinned)) {
-        return try_candidate(resolver, run, &pkg->releases[it]);
-      }
+    spn_index_release_t* release = spn_index_release_find(pkg, pinned);
+    if (release) {
+      return try_candidate(resolver, run, release);
     }
 
     return unsatisfiable_err(resolver, from, request, SPN_ERR_PKG_CONFLICT, pinned);
@@ -626,14 +888,12 @@ static spn_err_union_t resolve_index_package(spn_resolver_t* resolver, spn_resol
   // If the name is totally free, just pick the newest legal version. This
   // is just a simple, greedy heuristic, not for correctness.
   spn_err_union_t first = sp_zero;
-  sp_da_rfor(pkg->releases, it) {
-    spn_index_release_t* release = &pkg->releases[it];
+  spn_index_release_span_t span = spn_index_release_span(pkg, request->index.range);
+  for (u32 it = span.end; it > span.begin; it--) {
+    spn_index_release_t* release = &pkg->releases[it - 1];
     if (release->yanked) {
       continue;
     }
-    if (!spn_semver_in_range(release->version, request->index.range)) {
-      continue;
-    }
 
     spn_err_union_t err = try_candidate(resolver, run, release);
     if (!err.kind || run->fatal) {
@@ -697,8 +957,30 @@ static spn_err_union_t resolve_dep(spn_resolver_t* resolver, spn_resolve_run_t*
   sp_unreachable_return(ok_union());
 }
 
+// The index entries for all of a node's deps are loaded as soon as the node is
+// picked, ahead of the solver asking for them, when the cache has workers
+static void prefetch_deps(spn_resolver_t* resolver, spn_resolved_pkg_t* node, spn_requested_dep_t* deps, u64 count) {
+  if (!resolver->index->prefetch.workers) {
+    return;
+  }
+
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  sp_da(spn_pkg_name_t) ids = sp_da_new(scratch.mem, spn_pkg_name_t);
+  for (u64 it = 0; it < count; it++) {
+    spn_requested_dep_t* dep = &deps[it];
+    if (dep->source != SPN_PKG_SOURCE_INDEX || classify_dep(resolver, node, dep) == SPN_DEP_EDGE_PRUNED) {
+      continue;
+    }
+    sp_da_push(ids, spn_pkg_name_from_qualified(dep->qualified));
+  }
+
+  spn_index_cache_prefetch(resolver->index, ids, sp_da_size(ids));
+  sp_mem_end_scratch(scratch);
+}
+
 static spn_err_union_t resolve_deps(spn_resolver_t* resolver, spn_resolve_run_t* run, spn_resolved_pkg_t* node) {
   sp_ht_insert(run->visited, node->id.qualified, (u8)true);
+  prefetch_deps(resolver, node, node->deps, sp_da_size(node->deps));
 
   spn_err_union_t err = sp_zero;
   sp_da_for(node->deps, it) {
@@ -716,6 +998,8 @@ static spn_err_union_t solve_reqs(spn_resolver_t* resolver, spn_resolve_run_t* r
     .source = SPN_PKG_SOURCE_ROOT,
   };
 
+  prefetch_deps(resolver, &root, run->scopes[run->scope].reqs + from, to - from);
+
   for (u64 it = from; it < to; it++) {
     spn_requested_dep_t req = run->scopes[run->scope].reqs[it];
     try_union(resolve_dep(resolver, run, &root, &req));
@@ -1259,6 +1543,8 @@ static spn_err_union_t solve_once(spn_resolver_t* resolver, spn_resolve_query_t*
   sp_da_init(resolver->mem, run->boundaries);
   sp_da_init(resolver->mem, run->edges);
   sp_ht_init(resolver->mem, run->visited);
+  sp_da_init(resolver->mem, run->trail);
+  sp_ht_init(resolver->mem, run->learned);
 
   u32 root = find_or_create_scope(resolver, run, 0, sp_zero_s(spn_pkg_id_t));
   sp_da_for(query->reqs, it) {
@@ -1307,7 +1593,10 @@ spn_err_t spn_resolve_from_solver(spn_resolver_t* resolver, spn_resolve_query_t*
   spn_resolve_run_t run = sp_zero;
   spn_err_union_t err = solve_once(resolver, query, SP_NULLPTR, &run);
 
-  for (u32 it = 0; err.kind && it < run.retries; it++) {
+  // Retries re-pin a name to versions the lock didn't choose; under a lock
+  // the caller solves from scratch instead
+  u32 retries = resolver->lock ? 0 : run.retries;
+  for (u32 it = 0; err.kind && it < retries; it++) {
     query->result = SP_NULLPTR;
     sp_ht_init(resolver->mem, query->result);
 
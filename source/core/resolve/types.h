@@ -8,6 +8,7 @@
 #include "core/types.h"
 #include "index/types.h"
 #include "intern/types.h"
+#include "lock/types.h"
 #include "pkg/types.h"
 #include "profile/types.h"
 #include "semver/types.h"
@@ -62,6 +63,24 @@ typedef struct spn_resolver_t {
   sp_da(spn_pkg_config_entry_t) config;
   spn_option_seeds_t seeds;
   u64 budget;
+
+  // Failed candidates are remembered for the rest of a solve so that no
+  // later branch explores the same conflict twice
+  bool learn;
+  struct {
+    u64 candidates;
+    u64 learned;
+    u64 pruned;
+  } stats;
+
+  // When set, index deps only ever take their locked version: no candidate
+  // walk, no backtracking, and anything the lock can't answer is fatal
+  spn_lock_file_t* lock;
+
+  // A memoized lock's edges are already the fixed point of option gating, so
+  // gated deps follow the lock instead of being evaluated against seeds the
+  // first pass doesn't have yet
+  bool lock_edges;
 } spn_resolver_t;
 
 #endif
@@ -13,6 +13,7 @@
 #include "compiler/driver.h"
 #include "error/error.h"
 #include "event/event.h"
+#include "index/cache.h"
 #include "intern/intern.h"
 #include "paths/paths.h"
 #include "project/types.h"
@@ -80,6 +81,7 @@ static spn_session_config_t copy_config(sp_mem_t mem, spn_session_config_t confi
       .triple = config.profile.triple,
     },
     .force = config.force,
+    .thin_archives = config.thin_archives,
   };
 }
 
@@ -160,6 +162,18 @@ spn_err_t spn_session_init(spn_session_t* s, spn_ctx_t* ctx, sp_mem_t mem, spn_p
   return SPN_OK;
 }
 
+// Releases what the session holds outside its arena. The arena itself is
+// left to whoever made it, since events still in flight can point into it
+void spn_session_deinit(spn_session_t* s) {
+  if (s->index.indexes) {
+    spn_index_cache_deinit(&s->index);
+  }
+  sp_om_free(s->units.builds);
+  sp_om_free(s->units.packages);
+  sp_om_free(s->units.targets);
+  sp_om_free(s->units.objects);
+}
+
 sp_opt_spn_linkage_t spn_session_config_kind(spn_session_t* session, sp_str_t pkg_name) {
   sp_opt_spn_linkage_t requested = sp_zero;
 
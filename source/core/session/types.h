@@ -27,6 +27,7 @@ typedef struct {
 struct spn_session_t {
   spn_ctx_t* ctx;
   spn_project_t* project;
+  sp_mem_arena_t* arena;
   sp_mem_t mem;
   spn_pkg_info_t* pkg;
   sp_env_t env;
@@ -36,6 +37,7 @@ struct spn_session_t {
   spn_profile_info_t profile;
 
   spn_resolve_t resolve;
+  spn_index_cache_t index;
   spn_pkg_registry_t registry;
   sp_ht(spn_pkg_id_t, spn_loaded_pkg_t) packages;
   sp_ht(spn_pkg_id_t, spn_resolved_options_t) options;
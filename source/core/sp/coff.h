@@ -5,6 +5,7 @@
 
 #define SP_COFF_MACHINE_AMD64      0x8664
 #define SP_COFF_MACHINE_I386       0x014C
+#define SP_COFF_MACHINE_ARM64      0xAA64
 
 #define SP_COFF_SCN_CNT_CODE              0x00000020
 #define SP_COFF_SCN_CNT_INITIALIZED_DATA  0x00000040
@@ -31,10 +32,17 @@
 #define SP_COFF_SECTION_HEADER_SIZE  40
 #define SP_COFF_SYMBOL_SIZE          18
 
+// Writes a section's bytes straight to the output, in place of its writer.
+// Headers come first, so the section's size must be set up front
+typedef sp_err_t (*sp_coff_section_source_t)(sp_io_writer_t* out, void* user);
+
 typedef struct {
   sp_str_t name;
   u32 flags;
   sp_io_dyn_mem_writer_t writer;
+  sp_coff_section_source_t source;
+  void* user;
+  u64 size;
 } sp_coff_section_t;
 
 typedef struct {
@@ -51,6 +59,7 @@ typedef struct {
   sp_da(sp_coff_sym_entry_t) symbols;
   sp_io_dyn_mem_writer_t strtab;
   sp_mem_arena_t* arena;
+  u16 machine;
 } sp_coff_t;
 
 sp_coff_t*          sp_coff_new(sp_mem_t mem);
@@ -82,6 +91,7 @@ sp_coff_t* sp_coff_new(sp_mem_t mem) {
 
   sp_coff_t* coff = sp_alloc_type(alloc, sp_coff_t);
   coff->arena = arena;
+  coff->machine = SP_COFF_MACHINE_AMD64;
   sp_da_init(alloc, coff->sections);
   sp_da_init(alloc, coff->symbols);
 
@@ -98,6 +108,10 @@ void sp_coff_free(sp_coff_t* coff) {
   sp_mem_arena_destroy(coff->arena);
 }
 
+static u32 sp_coff_section_size(sp_coff_section_t* section) {
+  return (u32)(section->source ? section->size : section->writer.storage.len);
+}
+
 static u32 sp_coff_add_string(sp_coff_t* coff, sp_str_t str) {
   u64 offset = coff->strtab.storage.len;
   sp_io_write(&coff->strtab.base, str.data, str.len, SP_NULLPTR);
@@ -172,7 +186,7 @@ sp_err_t sp_coff_write(sp_coff_t* coff, sp_io_writer_t* out) {
   sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
   sp_da(u32) offsets = sp_da_new(scratch.mem, u32);
   sp_da_for(coff->sections, i) {
-    u32 data_len = (u32)coff->sections[i].writer.storage.len;
+    u32 data_len = sp_coff_section_size(&coff->sections[i]);
     u32 align_bits = (coff->sections[i].flags >> 20) & 0xF;
     u32 alignment = align_bits ? (1u << (align_bits - 1)) : 4;
     pos = (pos + alignment - 1) & ~(alignment - 1);
@@ -182,7 +196,7 @@ sp_err_t sp_coff_write(sp_coff_t* coff, sp_io_writer_t* out) {
   u32 symtab_offset = pos;
 
   // File header (20 bytes)
-  sp_coff_write_u16(out, SP_COFF_MACHINE_AMD64);   // machine
+  sp_coff_write_u16(out, coff->machine);           // machine
   sp_coff_write_u16(out, num_sections);             // number_of_sections
   sp_coff_write_u32(out, 0);                        // time_date_stamp
   sp_coff_write_u32(out, symtab_offset);            // pointer_to_symbol_table
@@ -193,7 +207,7 @@ sp_err_t sp_coff_write(sp_coff_t* coff, sp_io_writer_t* out) {
   // Section headers (40 bytes each)
   sp_da_for(coff->sections, i) {
     sp_coff_section_t* sec = &coff->sections[i];
-    u32 sz = (u32)sec->writer.storage.len;
+    u32 sz = sp_coff_section_size(sec);
 
     sp_coff_write_section_name(coff, out, sec->name);
     sp_coff_write_u32(out, 0);                      // virtual_size
@@ -210,11 +224,20 @@ sp_err_t sp_coff_write(sp_coff_t* coff, sp_io_writer_t* out) {
   // Section data
   u32 written = headers_end;
   sp_da_for(coff->sections, i) {
-    sp_mem_buffer_t buf = coff->sections[i].writer.storage;
-    if (buf.len) {
+    sp_coff_section_t* sec = &coff->sections[i];
+    u32 sz = sp_coff_section_size(sec);
+    if (sz) {
       if (offsets[i] > written) sp_io_pad(out, offsets[i] - written, SP_NULLPTR);
-      sp_io_write(out, buf.data, buf.len, SP_NULLPTR);
-      written = offsets[i] + (u32)buf.len;
+      if (sec->source) {
+        sp_err_t err = sec->source(out, sec->user);
+        if (err) {
+          sp_mem_end_scratch(scratch);
+          return err;
+        }
+      } else {
+        sp_io_write(out, sec->writer.storage.data, sz, SP_NULLPTR);
+      }
+      written = offsets[i] + sz;
     }
   }
   if (symtab_offset > written) sp_io_pad(out, symtab_offset - written, SP_NULLPTR);
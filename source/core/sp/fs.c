@@ -3,7 +3,13 @@
 
 #if defined(SP_MACOS) || defined(SP_COSMO)
   #include <sys/file.h>
+  #include <sys/stat.h>
   #include <errno.h>
+  #include <unistd.h>
+#endif
+
+#if defined(SP_MACOS)
+  #include <sys/clonefile.h>
 #endif
 
 #if defined(SP_LINUX) && !defined(SP_SYSCALL_NUM_FLOCK)
@@ -14,6 +20,41 @@
   #endif
 #endif
 
+#if defined(SP_LINUX) && !defined(SP_SYSCALL_NUM_FACCESSAT)
+  #if defined(SP_AMD64)
+    #define SP_SYSCALL_NUM_FACCESSAT 269
+  #elif defined(SP_ARM64)
+    #define SP_SYSCALL_NUM_FACCESSAT 48
+  #endif
+#endif
+
+#if defined(SP_LINUX) && !defined(SP_SYSCALL_NUM_IOCTL)
+  #if defined(SP_AMD64)
+    #define SP_SYSCALL_NUM_IOCTL 16
+  #elif defined(SP_ARM64)
+    #define SP_SYSCALL_NUM_IOCTL 29
+  #endif
+#endif
+
+#if defined(SP_LINUX) && !defined(SP_SYSCALL_NUM_FCHMODAT)
+  #if defined(SP_AMD64)
+    #define SP_SYSCALL_NUM_FCHMODAT 268
+  #elif defined(SP_ARM64)
+    #define SP_SYSCALL_NUM_FCHMODAT 53
+  #endif
+#endif
+
+#if defined(SP_LINUX) && !defined(SP_SYSCALL_NUM_MKNODAT)
+  #if defined(SP_AMD64)
+    #define SP_SYSCALL_NUM_MKNODAT 259
+  #elif defined(SP_ARM64)
+    #define SP_SYSCALL_NUM_MKNODAT 33
+  #endif
+#endif
+
+// _IOW(0x94, 9, int)
+#define SP_FICLONE 0x40049409
+
 #if !defined(SP_EAGAIN)
   #define SP_EAGAIN EAGAIN
 #endif
@@ -54,6 +95,126 @@ s32 sp_sys_flock(sp_sys_fd_t fd, s32 op) {
 #endif
 }
 
+bool sp_fs_is_executable(sp_str_t path) {
+#if defined(SP_WIN32)
+  return false;
+
+#else
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  const c8* cpath = sp_str_to_cstr(scratch.mem, path);
+  #if defined(SP_LINUX)
+    // AT_FDCWD, X_OK
+    s32 rc = (s32)sp_syscall(SP_SYSCALL_NUM_FACCESSAT, -100, (s64)cpath, 1);
+  #elif defined(SP_MACOS) || defined(SP_COSMO)
+    s32 rc = access(cpath, X_OK);
+  #else
+    #error "sp_fs_is_executable"
+  #endif
+  sp_mem_end_scratch(scratch);
+  return rc == 0;
+#endif
+}
+
+#if !defined(SP_WIN32)
+static s32 sp_fs_chmod(const c8* cpath, u32 mode) {
+  #if defined(SP_LINUX)
+    // AT_FDCWD
+    return (s32)sp_syscall(SP_SYSCALL_NUM_FCHMODAT, -100, (s64)cpath, mode);
+  #elif defined(SP_MACOS) || defined(SP_COSMO)
+    return chmod(cpath, (mode_t)mode);
+  #else
+    #error "sp_fs_chmod"
+  #endif
+}
+#endif
+
+sp_err_t sp_fs_set_read_only(sp_str_t path) {
+#if defined(SP_WIN32)
+  // A read-only file can't be deleted on Windows, which would wedge every
+  // cleanup that walks a tree holding one
+  SP_UNUSED(path);
+  return SP_ERR_SYS;
+
+#else
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  u32 mode = sp_fs_is_executable(path) ? 0555 : 0444;
+  s32 rc = sp_fs_chmod(sp_str_to_cstr(scratch.mem, path), mode);
+  sp_mem_end_scratch(scratch);
+  return rc ? SP_ERR_SYS : SP_OK;
+#endif
+}
+
+sp_err_t sp_fs_clone_file(sp_str_t from, sp_str_t to) {
+#if defined(SP_LINUX)
+  sp_sys_fd_t source = SP_SYS_INVALID_FD;
+  if (sp_sys_open_s(sp_sys_get_root(0), from, SP_SYS_OPEN_MODE_RO, 0, &source)) {
+    return SP_ERR_SYS;
+  }
+  sp_sys_fd_t target = SP_SYS_INVALID_FD;
+  if (sp_sys_open_s(sp_sys_get_root(0), to, SP_SYS_OPEN_MODE_RW, SP_SYS_OPEN_CREATE | SP_SYS_OPEN_EXCLUSIVE, &target)) {
+    sp_sys_close(source);
+    return SP_ERR_SYS;
+  }
+
+  s32 rc = (s32)sp_syscall(SP_SYSCALL_NUM_IOCTL, target, SP_FICLONE, source);
+  sp_sys_close(target);
+  sp_sys_close(source);
+
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  const c8* cpath = sp_str_to_cstr(scratch.mem, to);
+  if (!rc && sp_fs_is_executable(from)) {
+    rc = sp_fs_chmod(cpath, 0755);
+  }
+  sp_mem_end_scratch(scratch);
+
+  if (rc) {
+    sp_fs_remove_file(to);
+    return SP_ERR_SYS;
+  }
+  return SP_OK;
+
+#elif defined(SP_MACOS)
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  const c8* cpath = sp_str_to_cstr(scratch.mem, to);
+  s32 rc = clonefile(sp_str_to_cstr(scratch.mem, from), cpath, 0);
+  // The clone takes the source's mode, which may be read-only
+  if (!rc) {
+    rc = sp_fs_chmod(cpath, sp_fs_is_executable(from) ? 0755 : 0644);
+    if (rc) {
+      sp_fs_remove_file(to);
+    }
+  }
+  sp_mem_end_scratch(scratch);
+  return rc ? SP_ERR_SYS : SP_OK;
+
+#else
+  SP_UNUSED(from);
+  SP_UNUSED(to);
+  return SP_ERR_SYS;
+#endif
+}
+
+sp_err_t sp_fs_create_fifo(sp_str_t path) {
+#if defined(SP_WIN32)
+  SP_UNUSED(path);
+  return SP_ERR_SYS;
+
+#else
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  const c8* cpath = sp_str_to_cstr(scratch.mem, path);
+  #if defined(SP_LINUX)
+    // AT_FDCWD, S_IFIFO | 0600
+    s32 rc = (s32)sp_syscall(SP_SYSCALL_NUM_MKNODAT, -100, (s64)cpath, 010600, 0);
+  #elif defined(SP_MACOS) || defined(SP_COSMO)
+    s32 rc = mkfifo(cpath, 0600);
+  #else
+    #error "sp_fs_create_fifo"
+  #endif
+  sp_mem_end_scratch(scratch);
+  return rc ? SP_ERR_SYS : SP_OK;
+#endif
+}
+
 static sp_err_t sp_fs_lock_open(sp_fs_lock_t* lock, sp_str_t path) {
   *lock = sp_zero_s(sp_fs_lock_t);
   if (sp_sys_open_s(sp_sys_get_root(0), path, SP_SYS_OPEN_MODE_RW, SP_SYS_OPEN_CREATE, &lock->fd)) {
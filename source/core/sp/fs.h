@@ -25,6 +25,24 @@ sp_err_t sp_fs_lock_release(sp_fs_lock_t* lock);
 // directory so a clash surfaces as a retry instead of two writers sharing it
 sp_str_t sp_fs_staging_path(sp_mem_t mem, sp_str_t path, sp_str_t extension);
 
+// Whether the owner could run it; always false on Windows, where the bit
+// doesn't exist
+bool sp_fs_is_executable(sp_str_t path);
+
+// Clears the write bits and keeps the executable ones. Fails on Windows, where
+// a read-only file can't be deleted
+sp_err_t sp_fs_set_read_only(sp_str_t path);
+
+// A copy-on-write clone of a file (FICLONE on Linux, clonefile on macOS) that
+// shares the source's blocks until either side is written. The clone is
+// writable and keeps the executable bit. Fails, leaving nothing at to, when
+// the filesystem can't clone or the two sit on different filesystems
+sp_err_t sp_fs_clone_file(sp_str_t from, sp_str_t to);
+
+// A named pipe; opening either end blocks until the other end is opened too.
+// Fails on Windows, which has no named pipes in the filesystem
+sp_err_t sp_fs_create_fifo(sp_str_t path);
+
 sp_err_t sp_fs_staging_dir(sp_mem_t mem, sp_str_t path, sp_str_t extension, sp_str_t* dir);
 sp_err_t sp_fs_staging_dir_name(sp_mem_t mem, sp_str_t path, sp_str_t extension, sp_str_t* name);
 
@@ -26,11 +26,18 @@
 #define SP_MACHO_SYMTAB_SIZE                 24
 #define SP_MACHO_NLIST_64_SIZE               16
 
+// Writes a section's bytes straight to the output, in place of its writer.
+// Load commands come first, so the section's size must be set up front
+typedef sp_err_t (*sp_macho_section_source_t)(sp_io_writer_t* out, void* user);
+
 typedef struct {
   sp_str_t segname;
   sp_str_t sectname;
   u32 align;  // log2
   sp_io_dyn_mem_writer_t writer;
+  sp_macho_section_source_t source;
+  void* user;
+  u64 size;
 } sp_macho_section_t;
 
 typedef struct {
@@ -92,6 +99,10 @@ void sp_macho_free(sp_macho_t* macho) {
   sp_mem_arena_destroy(macho->arena);
 }
 
+static u64 sp_macho_section_size(sp_macho_section_t* section) {
+  return section->source ? section->size : section->writer.storage.len;
+}
+
 sp_macho_section_t* sp_macho_add_section(sp_macho_t* macho, sp_str_t segname, sp_str_t sectname, u32 align) {
   sp_mem_t alloc = sp_mem_arena_as_allocator(macho->arena);
   sp_macho_section_t section = {
@@ -129,7 +140,7 @@ sp_err_t sp_macho_write(sp_macho_t* macho, sp_io_writer_t* out) {
     u64 alignment = 1ull << macho->sections[i].align;
     addr = (addr + alignment - 1) & ~(alignment - 1);
     sp_da_push(addrs, addr);
-    addr += macho->sections[i].writer.storage.len;
+    addr += sp_macho_section_size(&macho->sections[i]);
   }
   u64 vmsize = addr;
 
@@ -177,7 +188,7 @@ sp_err_t sp_macho_write(sp_macho_t* macho, sp_io_writer_t* out) {
     sp_macho_write_name16(out, sec->sectname);
     sp_macho_write_name16(out, sec->segname);
     sp_macho_write_u64(out, addrs[i]);
-    sp_macho_write_u64(out, sec->writer.storage.len);
+    sp_macho_write_u64(out, sp_macho_section_size(sec));
     sp_macho_write_u32(out, data_start + (u32)addrs[i]);  // offset
     sp_macho_write_u32(out, sec->align);
     sp_macho_write_u32(out, 0);  // reloff
@@ -207,11 +218,20 @@ sp_err_t sp_macho_write(sp_macho_t* macho, sp_io_writer_t* out) {
   // Section data
   u64 written = data_start;
   sp_da_for(macho->sections, i) {
-    sp_mem_buffer_t buf = macho->sections[i].writer.storage;
+    sp_macho_section_t* sec = &macho->sections[i];
+    u64 size = sp_macho_section_size(sec);
     u64 offset = data_start + addrs[i];
     if (offset > written) sp_io_pad(out, offset - written, SP_NULLPTR);
-    sp_io_write(out, buf.data, buf.len, SP_NULLPTR);
-    written = offset + buf.len;
+    if (sec->source) {
+      sp_err_t err = sec->source(out, sec->user);
+      if (err) {
+        sp_mem_end_scratch(scratch);
+        return err;
+      }
+    } else {
+      sp_io_write(out, sec->writer.storage.data, size, SP_NULLPTR);
+    }
+    written = offset + size;
   }
   if (symoff > written) sp_io_pad(out, symoff - written, SP_NULLPTR);
 
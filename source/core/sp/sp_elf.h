@@ -143,6 +143,10 @@ typedef struct {
   s64 addend;
 } sp_elf_reloc_t;
 
+// Writes a section's bytes straight to the output. The section's size must be
+// set up front, since headers are written before any section data
+typedef sp_err_t (*sp_elf_section_source_t)(sp_io_writer_t* out, void* user);
+
 typedef struct {
   sp_str_t name;
   u32 index;
@@ -156,6 +160,8 @@ typedef struct {
   u64 size;
   sp_da(u8) data;
   sp_da(sp_elf_reloc_t) relocs;
+  sp_elf_section_source_t source;
+  void* user;
 } sp_elf_section_t;
 
 typedef struct {
@@ -416,7 +422,7 @@ SP_PRIVATE sp_err_t sp_elf_write_ex(sp_elf_t* elf, sp_io_writer_t* out, sp_mem_t
     header->sh_type = sec->type;
     header->sh_flags = sec->flags;
     header->sh_addr = sec->addr;
-    header->sh_size = sec->type == SHT_NOBITS ? sec->size : sp_da_size(sec->data);
+    header->sh_size = sec->type == SHT_NOBITS || sec->source ? sec->size : sp_da_size(sec->data);
     header->sh_link = sec->link;
     header->sh_info = sec->info;
     header->sh_addralign = sec->align;
@@ -523,6 +529,11 @@ SP_PRIVATE sp_err_t sp_elf_write_ex(sp_elf_t* elf, sp_io_writer_t* out, sp_mem_t
     if (!header->sh_size) continue;
     sp_try(sp_io_pad(out, header->sh_offset - written, &n));
     written += n;
+    if (it < num_user && elf->sections[it].source) {
+      sp_try(elf->sections[it].source(out, elf->sections[it].user));
+      written += header->sh_size;
+      continue;
+    }
     sp_try(sp_io_write(out, payloads[it], header->sh_size, &n));
     written += n;
   }
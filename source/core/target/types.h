@@ -8,6 +8,7 @@
 #include "compiler/types.h"
 #include "paths/types.h"
 #include "when/types.h"
+#include "external/wasm/types.h"
 
 #define SP_EMBED_DEFAULT_SYMBOL_S sp_str_lit("")
 #define SP_EMBED_DEFAULT_DATA_T_S sp_str_lit("")
@@ -79,6 +80,8 @@ struct spn_target_info {
   struct {
     spn_win_subsystem_t subsystem;
   } windows;
+  // Build and configure scripts only
+  spn_wasm_limits_t wasm;
   struct {
     spn_gated_path_list_t source;
     spn_gated_path_list_t headers;
@@ -1,5 +1,6 @@
 #include "toolchain/catalog.h"
 
+#include "enum/enum.h"
 #include "paths/paths.h"
 #include "toolchains.gen.h"
 #include "triple/triple.h"
@@ -11,6 +12,59 @@ SP_PRIVATE spn_toolchain_launcher_t spn_toolchain_catalog_load_launcher(const sp
   };
 }
 
+SP_PRIVATE spn_toolchain_launcher_t spn_toolchain_catalog_load_builtin_launcher(const spn_toolchain_builtin_launcher_t* in, sp_mem_t mem) {
+  spn_toolchain_launcher_t launcher = {
+    .program = spn_arg_lit(in->program),
+    .args = sp_da_new(mem, sp_str_t),
+  };
+  sp_for(it, in->num_args) {
+    sp_da_push(launcher.args, in->args[it]);
+  }
+  return launcher;
+}
+
+// Strings are used in place; only the dynamic arrays are allocated
+void spn_toolchain_catalog_init_builtins(spn_toolchain_catalog_t* catalog, sp_mem_t mem) {
+  sp_str_om_init(catalog->entries);
+
+  sp_for(index, spn_toolchain_num_builtins) {
+    const spn_toolchain_builtin_t* t = &spn_toolchain_builtins[index];
+
+    spn_toolchain_info_t toolchain = sp_zero;
+    toolchain.name = t->name;
+    toolchain.version = t->version;
+    toolchain.driver = spn_cc_driver_from_str(t->driver);
+    toolchain.compiler = spn_toolchain_catalog_load_builtin_launcher(&t->compiler, mem);
+    toolchain.cxx = spn_toolchain_catalog_load_builtin_launcher(&t->cxx, mem);
+    toolchain.linker = spn_toolchain_catalog_load_builtin_launcher(&t->linker, mem);
+    toolchain.archiver = spn_toolchain_catalog_load_builtin_launcher(&t->archiver, mem);
+
+    toolchain.hosts = sp_da_new(mem, spn_toolchain_host_t);
+    sp_for(it, t->num_hosts) {
+      sp_da_push(toolchain.hosts, ((spn_toolchain_host_t) {
+        .triple = spn_triple_from_str(t->hosts[it].triple),
+        .artifact = {
+          .url = t->hosts[it].url,
+          .sha256 = t->hosts[it].sha256,
+          .mirror_list = t->mirrors,
+        },
+      }));
+    }
+    toolchain.source = sp_da_empty(toolchain.hosts) ? SPN_TOOLCHAIN_SOURCE_LOCAL : SPN_TOOLCHAIN_SOURCE_DISTRIBUTION;
+
+    toolchain.targets = sp_da_new(mem, spn_triple_t);
+    sp_for(it, t->num_targets) {
+      sp_da_push(toolchain.targets, ((spn_triple_t) {
+        .arch = spn_arch_from_str(t->targets[it].arch),
+        .os = spn_os_from_str(t->targets[it].os),
+        .abi = spn_abi_from_str(t->targets[it].abi),
+      }));
+    }
+
+    spn_toolchain_catalog_add(catalog, toolchain);
+  }
+}
+
 spn_err_t spn_toolchain_catalog_init(spn_toolchain_catalog_t* catalog, sp_str_t builtins_json, sp_mem_t mem) {
   sp_str_om_init(catalog->entries);
 
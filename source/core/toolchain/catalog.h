@@ -3,6 +3,11 @@
 
 #include "toolchain/types.h"
 
+// Generated into builtins.gen.c
+extern const spn_toolchain_builtin_t spn_toolchain_builtins [];
+extern const u32 spn_toolchain_num_builtins;
+
+void              spn_toolchain_catalog_init_builtins(spn_toolchain_catalog_t* catalog, sp_mem_t mem);
 spn_err_t         spn_toolchain_catalog_init(spn_toolchain_catalog_t* catalog, sp_str_t builtins_json, sp_mem_t mem);
 void              spn_toolchain_catalog_add(spn_toolchain_catalog_t* catalog, spn_toolchain_info_t toolchain);
 spn_toolchain_info_t*  spn_toolchain_catalog_get(spn_toolchain_catalog_t* catalog, sp_str_t name);
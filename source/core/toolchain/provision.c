@@ -39,77 +39,323 @@ sp_str_t spn_artifact_resolve_url(sp_mem_t mem, spn_artifact_t artifact, sp_str_
   return sp_fmt(mem, "{}/{}", sp_fmt_str(mirror), sp_fmt_str(name)).value;
 }
 
-SP_PRIVATE spn_err_t spn_toolchain_provision_fetch(spn_toolchain_store_t* store, spn_artifact_t artifact, sp_str_t dest, sp_str_t* url) {
+// Tar only recognizes a compressed archive by seeking back over its first
+// bytes, which it can't do on a fifo, so the filter is picked from them here
+static sp_str_t spn_toolchain_provision_filter(const u8* data, u64 size) {
+  if (size >= 2 && data[0] == 0x1f && data[1] == 0x8b) return sp_str_lit("-z");
+  if (size >= 3 && data[0] == 'B' && data[1] == 'Z' && data[2] == 'h') return sp_str_lit("-j");
+  if (size >= 6 && data[0] == 0xfd && data[1] == '7' && data[2] == 'z' && data[3] == 'X' && data[4] == 'Z' && !data[5]) return sp_str_lit("-J");
+  if (size >= 4 && data[0] == 0x28 && data[1] == 0xb5 && data[2] == 0x2f && data[3] == 0xfd) return sp_str_lit("--zstd");
+  return sp_str_lit("");
+}
+
+static bool spn_toolchain_provision_tar(sp_str_t archive, sp_str_t filter, sp_str_t work) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch();
+  sp_ps_config_t config = {
+    .command = sp_str_lit("tar"),
+    .args = {
+      sp_str_lit("-x"),
+    },
+    .io = {
+      .err = { .mode = SP_PS_IO_MODE_NULL },
+    },
+  };
+  if (!sp_str_empty(filter)) {
+    sp_ps_config_add_arg(scratch.mem, &config, filter);
+  }
+  sp_ps_config_add_arg(scratch.mem, &config, sp_str_lit("-f"));
+  sp_ps_config_add_arg(scratch.mem, &config, archive);
+  sp_ps_config_add_arg(scratch.mem, &config, sp_str_lit("--strip-components=1"));
+  sp_ps_config_add_arg(scratch.mem, &config, sp_str_lit("-C"));
+  sp_ps_config_add_arg(scratch.mem, &config, work);
+
+  sp_ps_output_t result = sp_ps_run(scratch.mem, config);
+  sp_mem_end_scratch(scratch);
+  return !result.status.exit_code;
+}
+
+// A download is hashed and extracted in one pass: the fetch writes into one
+// fifo, and the bytes are hashed on their way into a second that tar reads,
+// so the tarball itself never lands on disk.
+//
+// Opening a fifo blocks until its other end is open, and reading one ends
+// once no writer is left, so every end is held for exactly as long as its
+// side of the transfer. The fetch's end stays open across the whole fetch,
+// which may fail before opening the file or open it more than once. Tar may
+// stop reading early or never start, so once it exits its end is taken over
+// and drained until the copy is done, rather than leaving writes to block.
+typedef struct {
+  spn_toolchain_store_t* store;
+  sp_str_t url;
+  sp_str_t path;
+  spn_err_t err;
+} spn_provision_fetch_t;
+
+typedef struct {
+  sp_str_t path;
+  sp_str_t filter;
+  sp_str_t work;
+  sp_sys_event_t done;
+  bool ok;
+} spn_provision_extract_t;
+
+static s32 spn_toolchain_provision_fetch_stream(void* data) {
+  spn_provision_fetch_t* fetch = (spn_provision_fetch_t*)data;
+  sp_sys_fd_t fd = SP_SYS_INVALID_FD;
+  sp_sys_open_s(sp_sys_get_root(0), fetch->path, SP_SYS_OPEN_MODE_WO, 0, &fd);
+  fetch->err = fetch->store->fetch(fetch->url, fetch->path, fetch->store->fetch_user_data);
+  sp_sys_close(fd);
+  return 0;
+}
+
+static s32 spn_toolchain_provision_extract_stream(void* data) {
+  spn_provision_extract_t* extract = (spn_provision_extract_t*)data;
+  extract->ok = spn_toolchain_provision_tar(extract->path, extract->filter, extract->work);
+
+  // Opened for both reading and writing, so this never waits on the copy
+  sp_sys_fd_t fd = SP_SYS_INVALID_FD;
+  if (sp_sys_open_s(sp_sys_get_root(0), extract->path, SP_SYS_OPEN_MODE_RW, 0, &fd)) {
+    return 0;
+  }
+
+  u8 chunk [65536];
+  while (true) {
+    sp_sys_fd_t fds [2] = { fd, extract->done.fd };
+    u64 signaled = 0;
+    if (sp_sys_wait(fds, 2, 0, &signaled) || signaled == 1) {
+      break;
+    }
+    u64 bytes_read = 0;
+    if (sp_sys_read(fd, chunk, sizeof(chunk), &bytes_read) || !bytes_read) {
+      break;
+    }
+  }
+  sp_sys_close(fd);
+  return 0;
+}
+
+static sp_err_t spn_toolchain_provision_write(sp_sys_fd_t fd, const u8* data, u64 size) {
+  while (size) {
+    u64 written = 0;
+    if (sp_sys_write(fd, data, size, &written) || !written) {
+      return SP_ERR_SYS;
+    }
+    data += written;
+    size -= written;
+  }
+  return SP_OK;
+}
+
+// Fetches url and extracts it into work, reporting the download's digest in
+// actual. Nothing is promoted here; the caller decides that on the digest
+static spn_err_t spn_toolchain_provision_fetch_url(spn_toolchain_store_t* store, sp_str_t url, sp_str_t work, sp_str_t* actual, bool* extracted) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch_for(store->mem);
+  sp_str_t download = sp_fs_staging_path(scratch.mem, work, sp_str_lit("download"));
+  sp_str_t archive = sp_fs_staging_path(scratch.mem, work, sp_str_lit("archive"));
+  *actual = sp_str_lit("");
+  *extracted = false;
+
+  // Without fifos (Windows) the download lands on disk and is read back twice
+  if (sp_fs_create_fifo(download) || sp_fs_create_fifo(archive)) {
+    sp_fs_remove_file(download);
+    spn_err_t err = store->fetch(url, download, store->fetch_user_data);
+    if (!err && !spn_sha256_file(store->mem, download, actual)) {
+      *extracted = spn_toolchain_provision_tar(download, sp_str_lit(""), work);
+    }
+    sp_fs_remove_file(download);
+    sp_mem_end_scratch(scratch);
+    return err;
+  }
+
+  spn_provision_fetch_t fetch = { .store = store, .url = url, .path = download };
+  sp_thread_t fetcher = sp_zero;
+  sp_thread_init(&fetcher, spn_toolchain_provision_fetch_stream, &fetch);
+
+  sp_sys_fd_t in = SP_SYS_INVALID_FD;
+  sp_sys_open_s(sp_sys_get_root(0), download, SP_SYS_OPEN_MODE_RO, 0, &in);
+
+  // Reads block until the fetch writes more, and end once it has returned.
+  // Enough of the start is read up front to tell how it's compressed.
+  spn_sha256_ctx_t sha;
+  spn_sha256_init(&sha);
+  u8 chunk [65536];
+  u64 size = 0;
+  bool complete = false;
+  while (size < 6) {
+    u64 bytes_read = 0;
+    if (sp_sys_read(in, chunk + size, sizeof(chunk) - size, &bytes_read)) {
+      break;
+    }
+    if (!bytes_read) {
+      complete = true;
+      break;
+    }
+    size += bytes_read;
+  }
+
+  spn_provision_extract_t extract = {
+    .path = archive,
+    .filter = spn_toolchain_provision_filter(chunk, size),
+    .work = work,
+  };
+  sp_thread_t extractor = sp_zero;
+  sp_sys_fd_t out = SP_SYS_INVALID_FD;
+  sp_sys_fd_t guard = SP_SYS_INVALID_FD;
+  bool started = size && !sp_sys_event_open(&extract.done);
+  if (started) {
+    sp_thread_init(&extractor, spn_toolchain_provision_extract_stream, &extract);
+
+    // Holding a read end of its own means tar exiting never turns a write
+    // into a broken pipe
+    sp_sys_open_s(sp_sys_get_root(0), archive, SP_SYS_OPEN_MODE_WO, 0, &out);
+    sp_sys_open_s(sp_sys_get_root(0), archive, SP_SYS_OPEN_MODE_RO, 0, &guard);
+  }
+
+  bool forward = started;
+  while (size) {
+    spn_sha256_update(&sha, chunk, size);
+    forward = forward && !spn_toolchain_provision_write(out, chunk, size);
+
+    u64 bytes_read = 0;
+    size = 0;
+    if (sp_sys_read(in, chunk, sizeof(chunk), &bytes_read)) {
+      break;
+    }
+    complete = !bytes_read;
+    size = bytes_read;
+  }
+
+  if (started) {
+    sp_sys_close(out);
+    sp_sys_close(guard);
+  }
+  sp_sys_close(in);
+  sp_thread_join(&fetcher);
+  if (started) {
+    sp_sys_event_signal(extract.done);
+    sp_thread_join(&extractor);
+    sp_sys_close(extract.done.fd);
+  }
+  sp_fs_remove_file(download);
+  sp_fs_remove_file(archive);
+
+  if (complete && !fetch.err) {
+    u8 digest [32];
+    spn_sha256_final(&sha, digest);
+    *actual = spn_sha256_digest_hex(store->mem, digest);
+    *extracted = forward && extract.ok;
+  }
+  sp_mem_end_scratch(scratch);
+  return fetch.err;
+}
+
+SP_PRIVATE spn_err_t spn_toolchain_provision_fetch(spn_toolchain_store_t* store, spn_artifact_t artifact, sp_str_t work, sp_str_t* url, sp_str_t* actual, bool* extracted) {
   if (!sp_str_empty(store->mirror)) {
     *url = spn_artifact_resolve_url(store->mem, artifact, store->mirror);
     if (!sp_str_equal(*url, artifact.url)) {
-      if (store->fetch(*url, dest, store->fetch_user_data) == SPN_OK) return SPN_OK;
+      if (spn_toolchain_provision_fetch_url(store, *url, work, actual, extracted) == SPN_OK) return SPN_OK;
+
+      // Whatever the failed attempt extracted would mix with the next one
+      sp_fs_remove_dir(work);
+      sp_fs_create_dir(work);
     }
   }
 
   *url = artifact.url;
-  return store->fetch(*url, dest, store->fetch_user_data);
+  return spn_toolchain_provision_fetch_url(store, *url, work, actual, extracted);
 }
 
-SP_PRIVATE spn_err_t spn_toolchain_provision_fill(spn_toolchain_store_t* store, spn_toolchain_info_t* toolchain, spn_artifact_t artifact, sp_str_t dest) {
-  sp_str_t tarball = sp_fs_staging_path(store->mem, dest, sp_str_lit("download"));
+// Adjacent versions of a toolchain mostly ship the same headers and sources.
+// Every extracted file is keyed by its content (and executable bit, which
+// lives on the inode) in a pool beside the versions; a file the pool already
+// has is replaced by a hard link to it, and a new one is adopted as is
+static void spn_toolchain_provision_pool(spn_toolchain_store_t* store, sp_str_t work) {
+  sp_mem_arena_marker_t scratch = sp_mem_begin_scratch_for(store->mem);
+  sp_str_t pool = sp_fs_join_path(scratch.mem, store->dir, sp_str_lit("blobs"));
 
-  sp_str_t url = sp_zero;
-  if (spn_toolchain_provision_fetch(store, artifact, tarball, &url)) {
-    sp_fs_remove_file(tarball);
+  sp_da(sp_fs_entry_t) files = sp_zero;
+  sp_fs_collect_recursive(scratch.mem, work, &files);
+  sp_da_for(files, it) {
+    sp_str_t path = files[it].path;
+    if (files[it].kind == SP_FS_KIND_DIR || sp_fs_is_symlink(path)) {
+      continue;
+    }
+
+    sp_str_t hex = sp_zero;
+    if (spn_sha256_file(scratch.mem, path, &hex)) {
+      continue;
+    }
+    if (sp_fs_is_executable(path)) {
+      hex = sp_str_concat(scratch.mem, hex, sp_str_lit("-x"));
+    }
+    sp_str_t fan = sp_fs_join_path(scratch.mem, pool, sp_str_prefix(hex, 2));
+    sp_str_t blob = sp_fs_join_path(scratch.mem, fan, sp_str_sub(hex, 2, hex.len - 2));
+
+    if (!sp_fs_exists(blob)) {
+      sp_fs_create_dir(fan);
+      sp_fs_link(path, blob, SP_FS_LINK_HARD);
+      continue;
+    }
+
+    // Link beside the file and rename over it, so a failure anywhere leaves
+    // the extracted copy in place
+    sp_str_t link = sp_fs_staging_path(scratch.mem, path, sp_str_lit("link"));
+    if (sp_fs_link(blob, link, SP_FS_LINK_HARD)) {
+      continue;
+    }
+    sp_sys_fd_t cwd = sp_sys_get_root(0);
+    if (sp_sys_rename_s(cwd, link, cwd, path)) {
+      sp_fs_remove_file(link);
+    }
+  }
+
+  sp_mem_end_scratch(scratch);
+}
+
+SP_PRIVATE spn_err_t spn_toolchain_provision_fill(spn_toolchain_store_t* store, spn_toolchain_info_t* toolchain, spn_artifact_t artifact, sp_str_t dest) {
+  sp_str_t work = sp_zero;
+  if (sp_fs_staging_dir(store->mem, dest, sp_str_lit("tmp"), &work)) {
     return spn_err_emit(&spn, (spn_err_union_t) {
-      .kind = SPN_ERR_TOOLCHAIN_FETCH,
+      .kind = SPN_ERR_TOOLCHAIN_EXTRACT,
       .artifact = {
         .name = toolchain->name,
-        .url = url,
+        .url = artifact.url,
       },
     });
   }
 
+  sp_str_t url = sp_zero;
   sp_str_t actual = sp_zero;
-  if (spn_sha256_file(store->mem, tarball, &actual) || !sp_str_equal(actual, artifact.sha256)) {
-    sp_fs_remove_file(tarball);
+  bool extracted = false;
+  if (spn_toolchain_provision_fetch(store, artifact, work, &url, &actual, &extracted)) {
+    sp_fs_remove_dir(work);
     return spn_err_emit(&spn, (spn_err_union_t) {
-      .kind = SPN_ERR_TOOLCHAIN_SHA,
+      .kind = SPN_ERR_TOOLCHAIN_FETCH,
       .artifact = {
         .name = toolchain->name,
         .url = url,
-        .expected = artifact.sha256,
-        .actual = actual,
       },
     });
   }
 
-  sp_str_t work = sp_zero;
-  if (sp_fs_staging_dir(store->mem, dest, sp_str_lit("tmp"), &work)) {
-    sp_fs_remove_file(tarball);
+  // Extraction ran alongside the download, so what's in work isn't trusted
+  // until the digest of the bytes it came from matches
+  if (!sp_str_equal(actual, artifact.sha256)) {
+    sp_fs_remove_dir(work);
     return spn_err_emit(&spn, (spn_err_union_t) {
-      .kind = SPN_ERR_TOOLCHAIN_EXTRACT,
+      .kind = SPN_ERR_TOOLCHAIN_SHA,
       .artifact = {
         .name = toolchain->name,
         .url = url,
+        .expected = artifact.sha256,
+        .actual = actual,
       },
     });
   }
 
-  sp_ps_output_t extract = sp_ps_run(store->mem, (sp_ps_config_t) {
-    .command = sp_str_lit("tar"),
-    .args = {
-      sp_str_lit("xf"), tarball,
-      sp_str_lit("--strip-components=1"),
-      sp_str_lit("-C"), work,
-    },
-    .io = {
-      .err = { .mode = SP_PS_IO_MODE_NULL },
-    },
-  });
-
-  sp_fs_remove_file(tarball);
-
-  sp_da(sp_fs_entry_t) extracted = sp_zero;
-  sp_fs_collect(store->mem, work, &extracted);
-  bool empty = sp_da_empty(extracted);
-  if (extract.status.exit_code || empty) {
+  sp_da(sp_fs_entry_t) entries = sp_zero;
+  sp_fs_collect(store->mem, work, &entries);
+  if (!extracted || sp_da_empty(entries)) {
     sp_fs_remove_dir(work);
     return spn_err_emit(&spn, (spn_err_union_t) {
       .kind = SPN_ERR_TOOLCHAIN_EXTRACT,
@@ -120,6 +366,8 @@ SP_PRIVATE spn_err_t spn_toolchain_provision_fill(spn_toolchain_store_t* store,
     });
   }
 
+  spn_toolchain_provision_pool(store, work);
+
   sp_sys_fd_t cwd = sp_sys_get_root(0);
   if (sp_sys_rename_s(cwd, work, cwd, dest)) {
     sp_fs_remove_dir(work);
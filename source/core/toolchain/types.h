@@ -56,6 +56,42 @@ typedef struct {
   sp_da(spn_triple_t) targets;
 } spn_toolchain_info_t;
 
+// The builtin catalog as static tables, generated from toolchains.json by
+// tools/gen. Enums and triples are left as strings and resolved by the same
+// spn_*_from_str the JSON reader uses.
+typedef struct {
+  sp_str_t program;
+  const sp_str_t* args;
+  u32 num_args;
+} spn_toolchain_builtin_launcher_t;
+
+typedef struct {
+  sp_str_t triple;
+  sp_str_t url;
+  sp_str_t sha256;
+} spn_toolchain_builtin_host_t;
+
+typedef struct {
+  sp_str_t arch;
+  sp_str_t os;
+  sp_str_t abi;
+} spn_toolchain_builtin_target_t;
+
+typedef struct {
+  sp_str_t name;
+  sp_str_t version;
+  sp_str_t driver;
+  sp_str_t mirrors;
+  spn_toolchain_builtin_launcher_t compiler;
+  spn_toolchain_builtin_launcher_t cxx;
+  spn_toolchain_builtin_launcher_t linker;
+  spn_toolchain_builtin_launcher_t archiver;
+  const spn_toolchain_builtin_host_t* hosts;
+  u32 num_hosts;
+  const spn_toolchain_builtin_target_t* targets;
+  u32 num_targets;
+} spn_toolchain_builtin_t;
+
 // Entries preserve declaration order; auto-selection takes the first match.
 struct spn_toolchain_catalog_t {
   sp_str_om(spn_toolchain_info_t) entries;
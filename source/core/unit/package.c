@@ -150,7 +150,11 @@ spn_err_t spn_pkg_unit_publish_existing_headers(spn_pkg_unit_t* unit, sp_str_t r
 
 void spn_pkg_unit_write_stamp(spn_pkg_unit_t* unit, spn_path_t path) {
   sp_mem_arena_marker_t s = sp_mem_begin_scratch();
-  sp_fs_create_file_str(spn_path_str(&spn.roots, s.mem, path), unit->info->name);
+  sp_str_t content = unit->info->name;
+  if (!sp_str_empty(unit->journal_digest)) {
+    content = sp_fmt(s.mem, "{} {}", SP_FMT_STR(unit->info->name), SP_FMT_STR(unit->journal_digest)).value;
+  }
+  sp_fs_create_file_str(spn_path_str(&spn.roots, s.mem, path), content);
   sp_mem_end_scratch(s);
 }
 
@@ -425,6 +425,20 @@ static spn_link_plan_t link_plan(spn_target_unit_t* target) {
   return plan;
 }
 
+// Thin archives name their members by path instead of copying them, so only
+// archives that never leave the build can be thin; the root package's libs
+// are staged and published as-is
+bool spn_target_is_thin_archive(spn_target_unit_t* target) {
+  spn_pkg_unit_t* pkg = target->pkg;
+  if (target->kind != SPN_CC_OUTPUT_STATIC_LIB || !pkg->session->config.thin_archives) {
+    return false;
+  }
+  if (pkg->source != SPN_PKG_SOURCE_INDEX) {
+    return false;
+  }
+  return spn_cc_supports_thin_archive(&pkg->build->toolchain->cc, &pkg->build->profile);
+}
+
 spn_err_t spn_target_link_invocation(sp_mem_t mem, spn_target_unit_t* target, const spn_cc_link_files_t* files, spn_invocation_t* invocation) {
   spn_profile_info_t* profile = &target->pkg->build->profile;
   spn_cc_toolchain_t* toolchain = &target->pkg->build->toolchain->cc;
@@ -434,6 +448,7 @@ spn_err_t spn_target_link_invocation(sp_mem_t mem, spn_target_unit_t* target, co
       spn_cc_archive_files_t archive_files = {
         .output = files->output,
         .objects = files->objects,
+        .thin = spn_target_is_thin_archive(target),
       };
       spn_try(spn_cc_render_archive(mem, toolchain, profile, &archive_files, invocation));
       break;
@@ -557,10 +572,12 @@ static void init_wasm_scripts(spn_session_t* s) {
     }
     const spn_path_roots_t* roots = &spn.roots;
     if (unit->metaprogram->scripts.configure) {
-      spn_wasm_script_init(&unit->wasm.configure, spn_path_str(roots, s->mem, spn_target_output_path(s->mem, unit->metaprogram->scripts.configure)));
+      spn_target_unit_t* script = unit->metaprogram->scripts.configure;
+      spn_wasm_script_init(&unit->wasm.configure, spn_path_str(roots, s->mem, spn_target_output_path(s->mem, script)), script->info->wasm);
     }
     if (unit->metaprogram->scripts.build) {
-      spn_wasm_script_init(&unit->wasm.build, spn_path_str(roots, s->mem, spn_target_output_path(s->mem, unit->metaprogram->scripts.build)));
+      spn_target_unit_t* script = unit->metaprogram->scripts.build;
+      spn_wasm_script_init(&unit->wasm.build, spn_path_str(roots, s->mem, spn_target_output_path(s->mem, script)), script->info->wasm);
     }
   }
 }
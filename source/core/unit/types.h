@@ -14,6 +14,8 @@
 #include "target/types.h"
 #include "external/wasm/types.h"
 
+typedef struct spn_api_journal_t spn_api_journal_t;
+
 typedef struct {
   spn_triple_t host;
   spn_profile_info_t profile;
@@ -167,11 +169,14 @@ struct spn_pkg_unit_t {
     u64 total;
   } time;
 
-  struct {
-    spn_wasm_script_t configure;
-    spn_wasm_script_t build;
-    spn_wasm_script_t* active;
-  } wasm;
+  spn_wasm_scripts_t wasm;
+
+  // Set while the configure script runs live, so its API calls can be replayed
+  // when a later configure is restored from the cache
+  spn_api_journal_t* journal;
+  // Digest of the journal configure ran or replayed. It goes in the package's
+  // stamps, so dependents keyed on them miss when the script did something else
+  sp_str_t journal_digest;
 
   sp_atomic_s32_t compile_announced;
 };
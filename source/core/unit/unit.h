@@ -21,6 +21,7 @@ typedef enum {
 } spn_unit_scope_t;
 spn_err_t spn_units_add_targets(spn_session_t* session, spn_unit_scope_t scope);
 
+bool      spn_target_is_thin_archive(spn_target_unit_t* target);
 spn_err_t spn_target_link_invocation(sp_mem_t mem, spn_target_unit_t* target, const spn_cc_link_files_t* files, spn_invocation_t* invocation);
 
 sp_da(spn_closure_entry_t) spn_target_link_closure(sp_mem_t mem, spn_target_unit_t* root);
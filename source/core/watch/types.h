@@ -0,0 +1,43 @@
+#ifndef SPN_WATCH_TYPES_H
+#define SPN_WATCH_TYPES_H
+
+#include "sp.h"
+#include "spn/core.h"
+
+#include "dag/types.h"
+#include "paths/types.h"
+
+typedef struct {
+  sp_mem_t mem;
+  const spn_path_roots_t* roots;
+  sp_str_t root;
+  sp_str_t manifest;
+  sp_da(sp_str_t) skip;
+  sp_da(sp_str_t) quiet;
+} spn_watch_config_t;
+
+typedef struct {
+  u32 paths;
+  bool overflow;
+  bool manifest;
+  bool rebuild;
+} spn_watch_changes_t;
+
+typedef struct {
+  sp_mem_t mem;
+  const spn_path_roots_t* roots;
+  sp_sys_fd_t fd;
+  sp_str_t root;
+  sp_str_t manifest;
+
+  // Subtrees a build writes into are never watched, and files it rewrites in
+  // the watched tree are invalidated without asking for another build
+  sp_da(sp_str_t) skip;
+  sp_da(sp_str_t) quiet;
+  sp_ht(s32, sp_str_t) dirs;
+
+  // Owned by whichever build made it first; null until then
+  spn_dag_file_cache_t* files;
+} spn_watch_t;
+
+#endif
@@ -0,0 +1,216 @@
+#include "watch/watch.h"
+
+#include "dag/dag.h"
+#include "paths/paths.h"
+
+#if defined(SP_LINUX)
+  #include <sys/inotify.h>
+
+#define WATCH_EVENTS (IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MOVE_SELF | IN_ONLYDIR)
+
+static bool is_hidden(sp_str_t name) {
+  return sp_str_starts_with(name, sp_str_lit("."));
+}
+
+static bool is_listed(sp_da(sp_str_t) paths, sp_str_t path) {
+  sp_da_for(paths, it) {
+    if (sp_str_equal(paths[it], path)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Hidden dirs (.git, a target's .spn) are skipped like the build dir; they're
+// remembered so settling can forget what the cache holds from them
+static bool watch_skip_dir(spn_watch_t* w, sp_str_t path, sp_str_t name) {
+  if (is_listed(w->skip, path)) {
+    return true;
+  }
+  if (is_hidden(name)) {
+    sp_da_push(w->skip, sp_str_copy(w->mem, path));
+    return true;
+  }
+  return false;
+}
+
+static void watch_add_tree(spn_watch_t* w, sp_str_t dir) {
+  sp_mem_arena_marker_t s = sp_mem_begin_scratch();
+  sp_da(sp_str_t) pending = sp_da_new(s.mem, sp_str_t);
+  sp_da_push(pending, sp_str_copy(w->mem, dir));
+
+  for (u32 index = 0; index < sp_da_size(pending); index++) {
+    sp_str_t path = pending[index];
+    s32 wd = inotify_add_watch((s32)w->fd, sp_str_to_cstr(s.mem, path), WATCH_EVENTS);
+    if (wd < 0) {
+      // Out of watches (ENOSPC) or gone already. Nothing would report changes
+      // under it, so it's skipped like the build dir and never trusted from
+      // the cache, rather than going quietly stale
+      sp_da_push(w->skip, path);
+      continue;
+    }
+    sp_ht_insert(w->dirs, wd, path);
+
+    sp_da(sp_fs_entry_t) entries = sp_zero;
+    sp_fs_collect(s.mem, path, &entries);
+    sp_da_for(entries, it) {
+      if (entries[it].kind != SP_FS_KIND_DIR) {
+        continue;
+      }
+      sp_str_t child = sp_fs_join_path(w->mem, path, entries[it].name);
+      if (!watch_skip_dir(w, child, entries[it].name)) {
+        sp_da_push(pending, child);
+      }
+    }
+  }
+
+  sp_mem_end_scratch(s);
+}
+
+static void watch_event(spn_watch_t* w, struct inotify_event* event, spn_watch_changes_t* changes) {
+  if (event->mask & IN_Q_OVERFLOW) {
+    // The kernel dropped events, so nothing cached can be vouched for
+    if (w->files) {
+      spn_dag_file_cache_invalidate_all(w->files);
+    }
+    changes->overflow = true;
+    changes->rebuild = true;
+    return;
+  }
+
+  sp_str_t* dir = sp_ht_getp(w->dirs, event->wd);
+  if (!dir) {
+    return;
+  }
+  if (event->mask & IN_IGNORED) {
+    sp_ht_erase(w->dirs, event->wd);
+    return;
+  }
+  if (event->mask & IN_MOVE_SELF) {
+    // The old name is stale; the parent's IN_MOVED_TO watches the new one
+    inotify_rm_watch((s32)w->fd, event->wd);
+    return;
+  }
+  if (!event->len) {
+    return;
+  }
+
+  sp_mem_arena_marker_t s = sp_mem_begin_scratch();
+  sp_str_t name = sp_cstr_as_str(event->name);
+  sp_str_t path = sp_fs_join_path(s.mem, *dir, name);
+  bool is_dir = event->mask & IN_ISDIR;
+
+  // A dir's mtime moves with its entries, so it goes stale with them
+  if (w->files) {
+    spn_path_t key = spn_path_make(w->roots, path);
+    if (is_dir) {
+      spn_dag_file_cache_invalidate_dir(w->files, key);
+    }
+    else {
+      spn_dag_file_cache_invalidate(w->files, key);
+    }
+    spn_dag_file_cache_invalidate(w->files, spn_path_make(w->roots, *dir));
+  }
+  changes->paths++;
+
+  if (is_dir && watch_skip_dir(w, path, name)) {
+    sp_mem_end_scratch(s);
+    return;
+  }
+  if (is_dir && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+    watch_add_tree(w, path);
+  }
+
+  if (sp_str_equal(path, w->manifest)) {
+    changes->manifest = true;
+  }
+  if (!is_hidden(name) && !is_listed(w->quiet, path)) {
+    changes->rebuild = true;
+  }
+  sp_mem_end_scratch(s);
+}
+
+spn_err_t spn_watch_init(spn_watch_t* w, spn_watch_config_t config) {
+  *w = sp_zero_s(spn_watch_t);
+  w->mem = config.mem;
+  w->roots = config.roots;
+  w->root = config.root;
+  w->manifest = config.manifest;
+  w->skip = sp_da_new(w->mem, sp_str_t);
+  w->quiet = sp_da_new(w->mem, sp_str_t);
+  sp_da_for(config.skip, it) {
+    sp_da_push(w->skip, sp_str_copy(w->mem, config.skip[it]));
+  }
+  sp_da_for(config.quiet, it) {
+    sp_da_push(w->quiet, sp_str_copy(w->mem, config.quiet[it]));
+  }
+  sp_ht_init(w->mem, w->dirs);
+
+  s32 fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+    return SPN_ERR_WATCH_FAILED;
+  }
+  w->fd = (sp_sys_fd_t)fd;
+
+  watch_add_tree(w, w->root);
+  if (!sp_ht_size(w->dirs)) {
+    spn_watch_deinit(w);
+    return SPN_ERR_WATCH_FAILED;
+  }
+  return SPN_OK;
+}
+
+void spn_watch_deinit(spn_watch_t* w) {
+  sp_sys_close(w->fd);
+  sp_ht_clear(w->dirs);
+}
+
+spn_watch_changes_t spn_watch_drain(spn_watch_t* w) {
+  spn_watch_changes_t changes = sp_zero;
+
+  // u64 storage keeps the records aligned; the fd is non-blocking, so a
+  // failed read means the queue is empty
+  u64 buffer [512];
+  while (true) {
+    u64 size = 0;
+    if (sp_sys_read(w->fd, buffer, sizeof(buffer), &size) || !size) {
+      break;
+    }
+
+    u8* bytes = (u8*)buffer;
+    for (u64 offset = 0; offset < size;) {
+      struct inotify_event* event = (struct inotify_event*)(bytes + offset);
+      offset += sizeof(struct inotify_event) + event->len;
+      watch_event(w, event, &changes);
+    }
+  }
+
+  return changes;
+}
+
+#else
+
+spn_err_t spn_watch_init(spn_watch_t* w, spn_watch_config_t config) {
+  *w = sp_zero_s(spn_watch_t);
+  return SPN_ERR_WATCH_FAILED;
+}
+
+void spn_watch_deinit(spn_watch_t* w) {
+}
+
+spn_watch_changes_t spn_watch_drain(spn_watch_t* w) {
+  return sp_zero_s(spn_watch_changes_t);
+}
+
+#endif
+
+void spn_watch_settle(spn_watch_t* w) {
+  if (!w->files) {
+    return;
+  }
+
+  spn_dag_file_cache_retain_dir(w->files, spn_path_make(w->roots, w->root));
+  sp_da_for(w->skip, it) {
+    spn_dag_file_cache_invalidate_dir(w->files, spn_path_make(w->roots, w->skip[it]));
+  }
+}
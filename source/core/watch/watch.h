@@ -0,0 +1,19 @@
+#ifndef SPN_WATCH_WATCH_H
+#define SPN_WATCH_WATCH_H
+
+#include "sp.h"
+#include "spn/core.h"
+#include "watch/types.h"
+
+// Keeps a file cache honest across builds of one project. Every change the
+// kernel reports under the root is dropped from the cache as it's drained, so
+// a rebuild only restats what moved. Linux (inotify) only; init fails elsewhere
+spn_err_t           spn_watch_init(spn_watch_t* w, spn_watch_config_t config);
+void                spn_watch_deinit(spn_watch_t* w);
+spn_watch_changes_t spn_watch_drain(spn_watch_t* w);
+
+// Nothing outside the watched tree is reported, so before a rebuild the cache
+// forgets whatever it holds from there
+void                spn_watch_settle(spn_watch_t* w);
+
+#endif
@@ -0,0 +1,103 @@
+#include "spn_test.h"
+
+#include "api/journal.h"
+
+typedef struct {
+  spn_api_call_kind_t kind;
+  const c8* dep;
+  u32 args [SPN_API_CALL_MAX_ARGS];
+  const c8* strs [SPN_API_CALL_MAX_STRS];
+} journal_call_t;
+
+typedef struct {
+  const c8* name;
+  journal_call_t calls [4];
+  u32 num_calls;
+} journal_test_t;
+
+static sp_str_t journal_str(const c8* str) {
+  return str ? sp_str_view(str) : sp_zero_s(sp_str_t);
+}
+
+static const journal_test_t tests [] = {
+  {
+    .name = "empty",
+  },
+  {
+    .name = "targets_and_nodes",
+    .calls = {
+      { .kind = SPN_API_CALL_ADD_LIB, .args = { 2 }, .strs = { "foo" } },
+      { .kind = SPN_API_CALL_TARGET_EMBED_FILE_EX, .strs = { "foo", "a.bin", "a", "char", "int" } },
+      { .kind = SPN_API_CALL_NODE_LINK, .args = { 0, 1 } },
+    },
+    .num_calls = 3,
+  },
+  {
+    .name = "content_with_newlines_and_colons",
+    .calls = {
+      { .kind = SPN_API_CALL_WRITE_FILE, .strs = { "config.h", "#define A 1\n#define B \"2:3\"\n" } },
+      { .kind = SPN_API_CALL_ADD_DEFINE, .strs = { "" } },
+    },
+    .num_calls = 2,
+  },
+  {
+    .name = "through_dep_handles",
+    .calls = {
+      { .kind = SPN_API_CALL_WRITE_FILE, .dep = "bar", .strs = { "gen.h", "" } },
+      { .kind = SPN_API_CALL_COPY, .dep = "bar", .args = { 1, 2 }, .strs = { "a", "b" } },
+      { .kind = SPN_API_CALL_LOG, .strs = { "configured: 3 targets" } },
+      { .kind = SPN_API_CALL_LOG, .dep = "bar", .strs = { "" } },
+    },
+    .num_calls = 4,
+  },
+};
+
+sp_test_each(api_journal, roundtrip, journal_test_t, tests) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_fs_create_dir(sp_test_dir(t));
+  sp_str_t path = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("journal"));
+
+  spn_api_journal_t written = sp_zero;
+  spn_api_journal_init(&written, mem);
+  sp_for(ct, it->num_calls) {
+    spn_api_call_t call = { .kind = it->calls[ct].kind, .dep = journal_str(it->calls[ct].dep) };
+    sp_for(at, SPN_API_CALL_MAX_ARGS) {
+      call.args[at] = it->calls[ct].args[at];
+    }
+    sp_for(st, SPN_API_CALL_MAX_STRS) {
+      call.strs[st] = journal_str(it->calls[ct].strs[st]);
+    }
+    spn_api_journal_push(&written, call);
+  }
+  sp_must_eq(t, spn_api_journal_write(&written, path), SPN_OK);
+
+  spn_api_journal_t read = sp_zero;
+  spn_api_journal_init(&read, mem);
+  sp_must_eq(t, spn_api_journal_read(&read, path), SPN_OK);
+  sp_must_eq(t, sp_da_size(read.calls), it->num_calls);
+
+  sp_for(ct, it->num_calls) {
+    const journal_call_t* expect = &it->calls[ct];
+    const spn_api_call_t* call = &read.calls[ct];
+    sp_expect_eq(t, call->kind, expect->kind);
+    sp_expect_eq(t, sp_str_equal(call->dep, journal_str(expect->dep)), true);
+    sp_expect_eq(t, call->args[0], expect->args[0]);
+    sp_expect_eq(t, call->args[1], expect->args[1]);
+    sp_for(st, SPN_API_CALL_MAX_STRS) {
+      sp_expect_eq(t, sp_str_equal(call->strs[st], journal_str(expect->strs[st])), true);
+    }
+  }
+  return SP_OK;
+}
+
+sp_test(api_journal, rejects_truncated) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_fs_create_dir(sp_test_dir(t));
+  sp_str_t path = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("journal"));
+  sp_fs_create_file_str(path, sp_str_lit("2\n0 0: 0 0 1 5:fo"));
+
+  spn_api_journal_t read = sp_zero;
+  spn_api_journal_init(&read, mem);
+  sp_expect_eq(t, spn_api_journal_read(&read, path), SPN_ERROR);
+  return SP_OK;
+}
@@ -4,6 +4,7 @@ typedef struct {
   const c8* name;
   spn_cc_driver_t compiler;
   spn_ar_driver_t archiver;
+  bool thin;
   render_expect_t expect;
 } archive_test_t;
 
@@ -17,6 +18,16 @@ static const archive_test_t tests [] = {
       .args = { "rcs", "libmain.a", "main.o" },
     },
   },
+  {
+    .name = "gnu_thin_archiver",
+    .compiler = SPN_CC_DRIVER_GCC,
+    .archiver = SPN_AR_DRIVER_GNU,
+    .thin = true,
+    .expect = {
+      .command = "ar",
+      .args = { "--thin", "rcs", "libmain.a", "main.o" },
+    },
+  },
   {
     .name = "msvc_archiver",
     .compiler = SPN_CC_DRIVER_GCC,
@@ -39,6 +50,7 @@ sp_test_each(render_archive, render, archive_test_t, tests, .setup = spn_test_ct
   };
   spn_cc_archive_files_t files = {
     .output = test_arg_path("libmain.a"),
+    .thin = it->thin,
   };
   sp_da_init(mem, files.objects);
   sp_da_push(files.objects, test_arg_path("main.o"));
@@ -55,3 +67,16 @@ sp_test_each(render_archive, render, archive_test_t, tests, .setup = spn_test_ct
   }
   return expect_args(t, &invocation, it->expect);
 }
+
+sp_test(render_archive, thin_only_in_gnu_format, .setup = spn_test_ctx_setup) {
+  spn_cc_toolchain_t toolchain = test_toolchain(SPN_CC_DRIVER_CLANG);
+  spn_profile_info_t elf = { .arch = SPN_ARCH_X64, .os = SPN_OS_LINUX, .abi = SPN_ABI_GNU };
+  spn_profile_info_t macos = { .arch = SPN_ARCH_ARM64, .os = SPN_OS_MACOS, .abi = SPN_ABI_NONE };
+
+  sp_expect_eq(t, spn_cc_supports_thin_archive(&toolchain, &elf), true);
+  sp_expect_eq(t, spn_cc_supports_thin_archive(&toolchain, &macos), false);
+
+  toolchain.archiver_driver = SPN_AR_DRIVER_MSVC;
+  sp_expect_eq(t, spn_cc_supports_thin_archive(&toolchain, &elf), false);
+  return SP_OK;
+}
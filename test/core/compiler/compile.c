@@ -364,3 +364,45 @@ sp_test(render_compile, base_shared_across_commands, .setup = spn_test_ctx_setup
     .args = { "-std=c99", "-c", "-Werror=return-type", "main.c", "-MD", "-MF", "b.o.d", "-o", "b.o" },
   });
 }
+
+sp_test(render_compile, relocate_maps_nested_roots_last, .setup = spn_test_ctx_setup) {
+  sp_mem_t mem = sp_test_arena(t);
+  spn_cc_toolchain_t toolchain = test_toolchain(SPN_CC_DRIVER_GCC);
+  spn_cc_compile_t compile = {
+    .lang = SPN_LANG_C,
+  };
+  sp_da_init(mem, compile.include);
+  sp_da_init(mem, compile.define);
+  sp_da_init(mem, compile.args);
+  spn_profile_info_t profile = {
+    .arch = SPN_ARCH_X64,
+    .os = SPN_OS_LINUX,
+    .abi = SPN_ABI_GNU,
+    .standard = SPN_C99,
+  };
+
+  spn_path_roots_t roots = sp_zero;
+  roots.dirs[SPN_PATH_ROOT_BUILD] = sp_str_lit("/work/app/.spn/build");
+  roots.dirs[SPN_PATH_ROOT_PROJECT] = sp_str_lit("/work/app");
+  roots.dirs[SPN_PATH_ROOT_CACHE] = sp_str_lit("/home/u/.cache/spn");
+
+  spn_invocation_t base = sp_zero;
+  sp_expect_eq(t, spn_cc_render_compile(mem, &toolchain, &profile, &compile, &base), SPN_OK);
+
+  spn_cc_compile_files_t files = {
+    .source = test_arg_path("main.c"),
+    .output = test_arg_path("main.o"),
+    .relocate = &roots,
+  };
+  spn_invocation_t invocation = spn_cc_render_compile_command(mem, &toolchain, &profile, &base, &files);
+  return expect_args(t, &invocation, (render_expect_t) {
+    .command = "cc",
+    .args = {
+      "-std=c99", "-c", "-Werror=return-type",
+      "-ffile-prefix-map=/work/app=/spn/project",
+      "-ffile-prefix-map=/home/u/.cache/spn=/spn/cache",
+      "-ffile-prefix-map=/work/app/.spn/build=/spn/build",
+      "main.c", "-o", "main.o",
+    },
+  });
+}
@@ -0,0 +1,276 @@
+#include "compiler.h"
+
+#include "compiler/symtab.h"
+#include "external/cc.h"
+
+#define embed_files_max 4
+#define embed_syms_max 8
+#define embed_file_size 4096
+
+typedef struct {
+  const c8* name;
+  c8 fill;
+} embed_file_t;
+
+typedef struct {
+  u32 blobs;
+  const c8* symbols [embed_syms_max];
+} embed_expect_t;
+
+typedef struct {
+  const c8* name;
+  spn_os_t os;
+  embed_file_t files [embed_files_max];
+  embed_expect_t expect;
+} embed_test_t;
+
+static const embed_test_t tests [] = {
+  {
+    .name = "elf_distinct",
+    .os = SPN_OS_LINUX,
+    .files = { { "a.bin", 'a' }, { "b.bin", 'b' } },
+    .expect = {
+      .blobs = 2,
+      .symbols = { "a_bin", "a_bin_size", "b_bin", "b_bin_size" },
+    },
+  },
+  {
+    .name = "elf_dedupes_identical_contents",
+    .os = SPN_OS_LINUX,
+    .files = { { "a.bin", 'a' }, { "copy.bin", 'a' }, { "b.bin", 'b' } },
+    .expect = {
+      .blobs = 2,
+      .symbols = { "a_bin", "a_bin_size", "copy_bin", "copy_bin_size", "b_bin", "b_bin_size" },
+    },
+  },
+  {
+    .name = "coff_long_and_short_names",
+    .os = SPN_OS_WINDOWS,
+    .files = { { "a", 'a' }, { "a_longer_name", 'a' } },
+    .expect = {
+      .blobs = 1,
+      .symbols = { "a", "a_size", "a_longer_name", "a_longer_name_size" },
+    },
+  },
+  {
+    .name = "macho_prefixes_symbols",
+    .os = SPN_OS_MACOS,
+    .files = { { "a.bin", 'a' }, { "b.bin", 'a' } },
+    .expect = {
+      .blobs = 1,
+      .symbols = { "_a_bin", "_a_bin_size", "_b_bin", "_b_bin_size" },
+    },
+  },
+};
+
+static sp_str_t write_sized_file(sp_test_t* t, sp_mem_t mem, embed_file_t file, u64 size) {
+  sp_str_t path = sp_fs_join_path(mem, sp_test_dir(t), sp_cstr_as_str(file.name));
+  c8* content = sp_alloc_n(mem, c8, size);
+  sp_mem_fill(content, size, &file.fill, 1);
+
+  sp_io_file_writer_t f = sp_zero;
+  sp_io_file_writer_from_path(&f, path);
+  sp_io_write(&f.base, content, size, SP_NULLPTR);
+  sp_io_file_writer_close(&f);
+  return path;
+}
+
+static sp_str_t write_embedded_file(sp_test_t* t, sp_mem_t mem, embed_file_t file) {
+  return write_sized_file(t, mem, file, embed_file_size);
+}
+
+static sp_str_t embed_run_of(sp_mem_t mem, c8 fill) {
+  c8* run = sp_alloc_n(mem, c8, embed_file_size);
+  sp_mem_fill(run, embed_file_size, &fill, 1);
+  return sp_str(run, embed_file_size);
+}
+
+sp_test_each(embed, write, embed_test_t, tests) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_fs_create_dir(sp_test_dir(t));
+
+  spn_cc_embed_ctx_t embedder = sp_zero;
+  spn_cc_embed_ctx_init(&embedder, mem, it->os, SPN_ARCH_X64);
+
+  u32 num_files = 0;
+  sp_carr_detect_len(it->files, num_files, it->files[num_files].name);
+  sp_for(f, num_files) {
+    sp_str_t path = write_embedded_file(t, mem, it->files[f]);
+    sp_str_t rel = sp_cstr_as_str(it->files[f].name);
+    sp_str_t symbol = spn_cc_symbol_from_embedded_file(mem, rel);
+    sp_must_eq(t, spn_cc_embed_ctx_add(&embedder, path, symbol, rel, sp_str_lit("unsigned char"), sp_str_lit("unsigned long long")), SPN_OK);
+  }
+
+  // One file blob and one size blob per distinct content
+  sp_expect_eq(t, sp_da_size(embedder.obj.blobs), it->expect.blobs * 2);
+
+  sp_str_t object = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("embed.o"));
+  sp_str_t header = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("embed.h"));
+  sp_must_eq(t, spn_cc_embed_ctx_write(&embedder, object, header), SPN_OK);
+  spn_cc_embed_ctx_free(&embedder);
+
+  sp_mem_slice_t bytes = sp_zero;
+  sp_must_eq(t, sp_io_read_file_slice(mem, object, &bytes), SP_OK);
+  sp_expect_eq(t, bytes.len >= it->expect.blobs * embed_file_size, true);
+  sp_expect_eq(t, bytes.len < (it->expect.blobs + 1) * embed_file_size, true);
+
+  // Every file's contents land in the object byte for byte
+  sp_str_t image = sp_str((const c8*)bytes.data, bytes.len);
+  sp_for(f, num_files) {
+    sp_expect(t, sp_str_find(image, embed_run_of(mem, it->files[f].fill)) != SP_STR_NO_MATCH);
+  }
+
+  sp_da(sp_str_t) symbols = sp_da_new(mem, sp_str_t);
+  sp_must_eq(t, spn_symtab_read(bytes.data, bytes.len, &symbols), true);
+
+  u32 n = 0;
+  sp_carr_detect_len(it->expect.symbols, n, it->expect.symbols[n]);
+  sp_must_eq(t, sp_da_size(symbols), n);
+  sp_must_strs_eq(t, symbols, n, it->expect.symbols);
+  return SP_OK;
+}
+
+sp_test(embed, elf_symbols_name_their_bytes) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_fs_create_dir(sp_test_dir(t));
+
+  embed_file_t files [] = { { "a.bin", 'a' }, { "copy.bin", 'a' }, { "b.bin", 'b' } };
+  spn_cc_embed_ctx_t embedder = sp_zero;
+  spn_cc_embed_ctx_init(&embedder, mem, SPN_OS_LINUX, SPN_ARCH_ARM64);
+  sp_carr_for(files, f) {
+    sp_str_t rel = sp_cstr_as_str(files[f].name);
+    sp_str_t symbol = spn_cc_symbol_from_embedded_file(mem, rel);
+    sp_must_eq(t, spn_cc_embed_ctx_add(&embedder, write_embedded_file(t, mem, files[f]), symbol, rel, sp_str_lit("unsigned char"), sp_str_lit("unsigned long long")), SPN_OK);
+  }
+
+  sp_str_t object = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("embed.o"));
+  sp_str_t header = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("embed.h"));
+  sp_must_eq(t, spn_cc_embed_ctx_write(&embedder, object, header), SPN_OK);
+  spn_cc_embed_ctx_free(&embedder);
+
+  sp_elf_t* elf = SP_NULLPTR;
+  sp_must_eq(t, sp_elf_read_from_file(mem, object, &elf), SP_OK);
+  sp_expect_eq(t, elf->machine, EM_AARCH64);
+  sp_elf_section_t* rodata = sp_elf_section(elf, sp_elf_find_section(elf, sp_str_lit(".rodata")));
+  sp_must(t, rodata);
+
+  sp_carr_for(files, f) {
+    sp_str_t symbol = spn_cc_symbol_from_embedded_file(mem, sp_cstr_as_str(files[f].name));
+    sp_elf_symbol_t* data = sp_elf_symbol(elf, sp_elf_find_symbol(elf, symbol));
+    sp_elf_symbol_t* size = sp_elf_symbol(elf, sp_elf_find_symbol(elf, sp_fmt(mem, "{}_size", sp_fmt_str(symbol)).value));
+    sp_must(t, data && size);
+
+    sp_must_eq(t, data->size, embed_file_size);
+    sp_must(t, data->value + data->size <= sp_da_size(rodata->data));
+    sp_expect(t, sp_str_equal(sp_str((const c8*)rodata->data + data->value, embed_file_size), embed_run_of(mem, files[f].fill)));
+
+    u64 recorded = 0;
+    sp_must_eq(t, size->size, sizeof(u64));
+    sp_mem_copy(&recorded, rodata->data + size->value, sizeof(u64));
+    sp_expect_eq(t, recorded, embed_file_size);
+  }
+
+  sp_elf_free(elf);
+  return SP_OK;
+}
+
+typedef struct {
+  const c8* name;
+  u64 size;
+} embed_resize_test_t;
+
+static const embed_resize_test_t resize_tests [] = {
+  { .name = "grown",   .size = embed_file_size + 1 },
+  { .name = "shrunk",  .size = embed_file_size - 1 },
+  { .name = "emptied", .size = 0 },
+};
+
+// The object's symbols are sized when a file is added; a file that changes
+// length before the object is written must fail it, not truncate or pad, and
+// leave no partly written object behind
+sp_test_each(embed, resized_after_add, embed_resize_test_t, resize_tests) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_fs_create_dir(sp_test_dir(t));
+
+  embed_file_t file = { "a.bin", 'a' };
+  spn_cc_embed_ctx_t embedder = sp_zero;
+  spn_cc_embed_ctx_init(&embedder, mem, SPN_OS_LINUX, SPN_ARCH_X64);
+  sp_str_t rel = sp_cstr_as_str(file.name);
+  sp_must_eq(t, spn_cc_embed_ctx_add(&embedder, write_embedded_file(t, mem, file), sp_str_lit("a_bin"), rel, sp_str_lit("unsigned char"), sp_str_lit("unsigned long long")), SPN_OK);
+  write_sized_file(t, mem, file, it->size);
+
+  sp_str_t object = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("embed.o"));
+  sp_str_t header = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("embed.h"));
+  sp_expect_eq(t, spn_cc_embed_ctx_write(&embedder, object, header), SPN_ERROR);
+  sp_expect_eq(t, sp_fs_exists(object), false);
+  spn_cc_embed_ctx_free(&embedder);
+  return SP_OK;
+}
+
+typedef struct {
+  const c8* name;
+  embed_file_t before [embed_files_max];
+  embed_file_t after [embed_files_max];
+  bool same;
+} embed_digest_test_t;
+
+static const embed_digest_test_t digest_tests [] = {
+  {
+    .name = "unchanged",
+    .before = { { "a.bin", 'a' }, { "b.bin", 'b' } },
+    .after = { { "a.bin", 'a' }, { "b.bin", 'b' } },
+    .same = true,
+  },
+  {
+    .name = "contents_changed",
+    .before = { { "a.bin", 'a' }, { "b.bin", 'b' } },
+    .after = { { "a.bin", 'a' }, { "b.bin", 'c' } },
+  },
+  {
+    .name = "path_changed",
+    .before = { { "a.bin", 'a' } },
+    .after = { { "c.bin", 'a' } },
+  },
+  {
+    .name = "file_added",
+    .before = { { "a.bin", 'a' } },
+    .after = { { "a.bin", 'a' }, { "b.bin", 'b' } },
+  },
+};
+
+// The header must carry the same digest so consumers never rehash the contents
+static sp_str_t embed_digest_of(sp_test_t* t, sp_mem_t mem, const embed_file_t* files) {
+  spn_cc_embed_ctx_t embedder = sp_zero;
+  spn_cc_embed_ctx_init(&embedder, mem, SPN_OS_LINUX, SPN_ARCH_X64);
+
+  u32 n = 0;
+  while (n < embed_files_max && files[n].name) n++;
+  sp_for(f, n) {
+    sp_str_t path = write_embedded_file(t, mem, files[f]);
+    sp_str_t rel = sp_cstr_as_str(files[f].name);
+    sp_str_t symbol = spn_cc_symbol_from_embedded_file(mem, rel);
+    sp_expect_eq(t, spn_cc_embed_ctx_add(&embedder, path, symbol, rel, sp_str_lit("unsigned char"), sp_str_lit("unsigned long long")), SPN_OK);
+  }
+
+  sp_str_t object = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("embed.o"));
+  sp_str_t header = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("embed.h"));
+  sp_expect_eq(t, spn_cc_embed_ctx_write(&embedder, object, header), SPN_OK);
+  sp_str_t digest = spn_cc_embed_ctx_digest(&embedder, mem);
+  spn_cc_embed_ctx_free(&embedder);
+
+  sp_str_t content = sp_zero;
+  sp_expect_eq(t, sp_io_read_file(mem, header, &content), SP_OK);
+  sp_expect(t, sp_str_find(content, digest) != SP_STR_NO_MATCH);
+  return digest;
+}
+
+sp_test_each(embed, digest, embed_digest_test_t, digest_tests) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_fs_create_dir(sp_test_dir(t));
+
+  sp_str_t before = embed_digest_of(t, mem, it->before);
+  sp_str_t after = embed_digest_of(t, mem, it->after);
+  sp_expect_eq(t, before.len, 64);
+  sp_expect_eq(t, sp_str_equal(before, after), it->same);
+  return SP_OK;
+}
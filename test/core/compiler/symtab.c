@@ -0,0 +1,338 @@
+#include "compiler.h"
+
+#include "compiler/symtab.h"
+
+#define symtab_syms_max 4
+
+typedef enum {
+  SYMTAB_OBJ_ELF,
+  SYMTAB_OBJ_ELF32_BE,
+  SYMTAB_OBJ_COFF,
+  SYMTAB_OBJ_MACHO,
+  SYMTAB_OBJ_BITCODE,
+  SYMTAB_OBJ_TRUNCATED,
+} symtab_obj_t;
+
+typedef struct {
+  bool ok;
+  const c8* symbols [symtab_syms_max];
+} symtab_expect_t;
+
+typedef struct {
+  const c8* name;
+  symtab_obj_t format;
+  symtab_expect_t expect;
+} symtab_test_t;
+
+typedef sp_io_dyn_mem_writer_t obj_buf_t;
+
+static void obj_bytes(obj_buf_t* b, const void* ptr, u32 len) {
+  sp_io_write(&b->base, ptr, len, SP_NULLPTR);
+}
+
+static void obj_zero(obj_buf_t* b, u32 len) {
+  sp_io_pad(&b->base, len, SP_NULLPTR);
+}
+
+static void obj_u8(obj_buf_t* b, u8 v) {
+  obj_bytes(b, &v, 1);
+}
+
+static void obj_u16(obj_buf_t* b, u16 v, bool big) {
+  u8 p [2] = { big ? (u8)(v >> 8) : (u8)v, big ? (u8)v : (u8)(v >> 8) };
+  obj_bytes(b, p, 2);
+}
+
+static void obj_u32(obj_buf_t* b, u32 v, bool big) {
+  obj_u16(b, big ? (u16)(v >> 16) : (u16)v, big);
+  obj_u16(b, big ? (u16)v : (u16)(v >> 16), big);
+}
+
+static void obj_u64(obj_buf_t* b, u64 v) {
+  obj_u32(b, (u32)v, false);
+  obj_u32(b, (u32)(v >> 32), false);
+}
+
+// null, local, global, undefined, weak, section
+static const c8 elf_strtab [] = "\0local\0exported\0imported\0weak\0";
+
+static void build_elf64(obj_buf_t* b) {
+  u32 strtab_size = sizeof(elf_strtab);
+  u32 symtab_off = 64;
+  u32 symtab_size = 6 * 24;
+  u32 strtab_off = symtab_off + symtab_size;
+  u32 shoff = strtab_off + strtab_size;
+
+  u8 ident [16] = { 0x7f, 'E', 'L', 'F', 2, 1, 1 };
+  obj_bytes(b, ident, 16);
+  obj_u16(b, 1, false);
+  obj_u16(b, 62, false);
+  obj_u32(b, 1, false);
+  obj_u64(b, 0);
+  obj_u64(b, 0);
+  obj_u64(b, shoff);
+  obj_u32(b, 0, false);
+  obj_u16(b, 64, false);
+  obj_u16(b, 0, false);
+  obj_u16(b, 0, false);
+  obj_u16(b, 64, false);
+  obj_u16(b, 3, false);
+  obj_u16(b, 0, false);
+
+  struct { u32 name; u8 info; u16 shndx; } syms [] = {
+    { 0, 0, 0 },
+    { 1, 0x02, 1 },   // local func
+    { 7, 0x11, 1 },   // global object
+    { 16, 0x10, 0 },  // global, undefined
+    { 25, 0x22, 1 },  // weak func
+    { 0, 0x03, 1 },   // local section
+  };
+  sp_carr_for(syms, it) {
+    obj_u32(b, syms[it].name, false);
+    obj_u8(b, syms[it].info);
+    obj_u8(b, 0);
+    obj_u16(b, syms[it].shndx, false);
+    obj_u64(b, 0);
+    obj_u64(b, 0);
+  }
+  obj_bytes(b, elf_strtab, strtab_size);
+
+  obj_zero(b, 64);
+  // .symtab
+  obj_u32(b, 0, false);
+  obj_u32(b, 2, false);
+  obj_u64(b, 0);
+  obj_u64(b, 0);
+  obj_u64(b, symtab_off);
+  obj_u64(b, symtab_size);
+  obj_u32(b, 2, false);
+  obj_u32(b, 2, false);
+  obj_u64(b, 8);
+  obj_u64(b, 24);
+  // .strtab
+  obj_u32(b, 0, false);
+  obj_u32(b, 3, false);
+  obj_u64(b, 0);
+  obj_u64(b, 0);
+  obj_u64(b, strtab_off);
+  obj_u64(b, strtab_size);
+  obj_u32(b, 0, false);
+  obj_u32(b, 0, false);
+  obj_u64(b, 1);
+  obj_u64(b, 0);
+}
+
+static void build_elf32_be(obj_buf_t* b) {
+  u32 strtab_size = sizeof(elf_strtab);
+  u32 symtab_off = 52;
+  u32 symtab_size = 3 * 16;
+  u32 strtab_off = symtab_off + symtab_size;
+  u32 shoff = strtab_off + strtab_size;
+
+  u8 ident [16] = { 0x7f, 'E', 'L', 'F', 1, 2, 1 };
+  obj_bytes(b, ident, 16);
+  obj_u16(b, 1, true);
+  obj_u16(b, 8, true);
+  obj_u32(b, 1, true);
+  obj_u32(b, 0, true);
+  obj_u32(b, 0, true);
+  obj_u32(b, shoff, true);
+  obj_u32(b, 0, true);
+  obj_u16(b, 52, true);
+  obj_u16(b, 0, true);
+  obj_u16(b, 0, true);
+  obj_u16(b, 40, true);
+  obj_u16(b, 3, true);
+  obj_u16(b, 0, true);
+
+  struct { u32 name; u8 info; u16 shndx; } syms [] = {
+    { 0, 0, 0 },
+    { 1, 0x02, 1 },
+    { 7, 0x11, 1 },
+  };
+  sp_carr_for(syms, it) {
+    obj_u32(b, syms[it].name, true);
+    obj_u32(b, 0, true);
+    obj_u32(b, 0, true);
+    obj_u8(b, syms[it].info);
+    obj_u8(b, 0);
+    obj_u16(b, syms[it].shndx, true);
+  }
+  obj_bytes(b, elf_strtab, strtab_size);
+
+  obj_zero(b, 40);
+  u32 symtab [10] = { 0, 2, 0, 0, symtab_off, symtab_size, 2, 2, 4, 16 };
+  u32 strtab [10] = { 0, 3, 0, 0, strtab_off, strtab_size, 0, 0, 1, 0 };
+  sp_carr_for(symtab, it) { obj_u32(b, symtab[it], true); }
+  sp_carr_for(strtab, it) { obj_u32(b, strtab[it], true); }
+}
+
+static void coff_symbol(obj_buf_t* b, const c8* name, u32 strx, u32 value, s16 section, u8 storage, u8 aux) {
+  c8 short_name [8] = sp_zero;
+  if (name) {
+    memcpy(short_name, name, sp_min(sp_cstr_len(name), 8));
+    obj_bytes(b, short_name, 8);
+  } else {
+    obj_u32(b, 0, false);
+    obj_u32(b, strx, false);
+  }
+  obj_u32(b, value, false);
+  obj_u16(b, (u16)section, false);
+  obj_u16(b, 0, false);
+  obj_u8(b, storage);
+  obj_u8(b, aux);
+}
+
+static void build_coff(obj_buf_t* b) {
+  obj_u16(b, 0x8664, false);
+  obj_u16(b, 0, false);
+  obj_u32(b, 0, false);
+  obj_u32(b, 20, false);
+  obj_u32(b, 7, false);
+  obj_u16(b, 0, false);
+  obj_u16(b, 0, false);
+
+  coff_symbol(b, ".text", 0, 0, 1, 3, 1);
+  obj_zero(b, 18);
+  coff_symbol(b, "short", 0, 0, 1, 2, 0);
+  coff_symbol(b, SP_NULLPTR, 4, 0, 1, 2, 0);
+  coff_symbol(b, "import", 0, 0, 0, 2, 0);
+  coff_symbol(b, "common", 0, 16, 0, 2, 0);
+  coff_symbol(b, "static", 0, 0, 1, 3, 0);
+
+  const c8 strtab [] = "a_long_symbol_name";
+  obj_u32(b, 4 + sizeof(strtab), false);
+  obj_bytes(b, strtab, sizeof(strtab));
+}
+
+static void build_macho(obj_buf_t* b) {
+  const c8 strtab [] = "\0_exported\0_hidden\0_import\0_local\0";
+  u32 symoff = 32 + 24;
+  u32 nsyms = 4;
+  u32 stroff = symoff + nsyms * 16;
+
+  obj_u32(b, 0xfeedfacf, false);
+  obj_u32(b, 0x0100000c, false);
+  obj_u32(b, 0, false);
+  obj_u32(b, 1, false);
+  obj_u32(b, 1, false);
+  obj_u32(b, 24, false);
+  obj_u32(b, 0, false);
+  obj_u32(b, 0, false);
+
+  obj_u32(b, 0x2, false);
+  obj_u32(b, 24, false);
+  obj_u32(b, symoff, false);
+  obj_u32(b, nsyms, false);
+  obj_u32(b, stroff, false);
+  obj_u32(b, sizeof(strtab), false);
+
+  struct { u32 strx; u8 type; } syms [] = {
+    { 1, 0x0f },  // N_SECT | N_EXT
+    { 11, 0x1f }, // N_PEXT | N_SECT | N_EXT
+    { 19, 0x01 }, // N_UNDF | N_EXT
+    { 27, 0x0e }, // N_SECT
+  };
+  sp_carr_for(syms, it) {
+    obj_u32(b, syms[it].strx, false);
+    obj_u8(b, syms[it].type);
+    obj_u8(b, 1);
+    obj_u16(b, 0, false);
+    obj_u64(b, 0);
+  }
+  obj_bytes(b, strtab, sizeof(strtab));
+}
+
+static void build_object(obj_buf_t* b, symtab_obj_t format) {
+  switch (format) {
+    case SYMTAB_OBJ_ELF: {
+      build_elf64(b);
+      break;
+    }
+    case SYMTAB_OBJ_ELF32_BE: {
+      build_elf32_be(b);
+      break;
+    }
+    case SYMTAB_OBJ_COFF: {
+      build_coff(b);
+      break;
+    }
+    case SYMTAB_OBJ_MACHO: {
+      build_macho(b);
+      break;
+    }
+    case SYMTAB_OBJ_BITCODE: {
+      obj_bytes(b, "BC\xc0\xde\x35\x14\x00\x00\x05\x00\x00\x00\x62\x0c\x30\x24\x4a\x59\xbe\x66", 20);
+      break;
+    }
+    case SYMTAB_OBJ_TRUNCATED: {
+      build_elf64(b);
+      b->storage.len = 200;
+      break;
+    }
+  }
+}
+
+static const symtab_test_t tests [] = {
+  {
+    .name = "elf64",
+    .format = SYMTAB_OBJ_ELF,
+    .expect = {
+      .ok = true,
+      .symbols = { "exported", "weak" },
+    },
+  },
+  {
+    .name = "elf32_big_endian",
+    .format = SYMTAB_OBJ_ELF32_BE,
+    .expect = {
+      .ok = true,
+      .symbols = { "exported" },
+    },
+  },
+  {
+    .name = "coff_long_names_and_commons",
+    .format = SYMTAB_OBJ_COFF,
+    .expect = {
+      .ok = true,
+      .symbols = { "short", "a_long_symbol_name", "common" },
+    },
+  },
+  {
+    .name = "macho_skips_private_externs",
+    .format = SYMTAB_OBJ_MACHO,
+    .expect = {
+      .ok = true,
+      .symbols = { "_exported" },
+    },
+  },
+  {
+    .name = "bitcode_unsupported",
+    .format = SYMTAB_OBJ_BITCODE,
+  },
+  {
+    .name = "truncated",
+    .format = SYMTAB_OBJ_TRUNCATED,
+  },
+};
+
+sp_test_each(symtab, read, symtab_test_t, tests) {
+  sp_mem_t mem = sp_test_arena(t);
+
+  obj_buf_t buf = sp_zero;
+  sp_io_dyn_mem_writer_init(mem, &buf);
+  build_object(&buf, it->format);
+  sp_str_t bytes = sp_io_dyn_mem_writer_as_str(&buf);
+
+  sp_da(sp_str_t) symbols = sp_da_new(mem, sp_str_t);
+  bool ok = spn_symtab_read((const u8*)bytes.data, bytes.len, &symbols);
+  sp_expect_eq(t, ok, it->expect.ok);
+
+  if (it->expect.ok) {
+    u32 n = 0;
+    sp_carr_detect_len(it->expect.symbols, n, it->expect.symbols[n]);
+    sp_must_eq(t, sp_da_size(symbols), n);
+    sp_must_strs_eq(t, symbols, n, it->expect.symbols);
+  }
+  return SP_OK;
+}
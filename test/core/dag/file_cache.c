@@ -7,6 +7,7 @@ typedef enum {
   FILE_CACHE_OP_REFRESH,
   FILE_CACHE_OP_INVALIDATE,
   FILE_CACHE_OP_INVALIDATE_DIR,
+  FILE_CACHE_OP_RETAIN_DIR,
   FILE_CACHE_OP_DIGEST,
   FILE_CACHE_OP_SEED,
 } file_cache_op_kind_t;
@@ -82,6 +83,26 @@ static const file_cache_test_t file_cache_tests [] = {
       { .kind = FILE_CACHE_OP_DIGEST, .path = "E/G", .blob = "C" },
     }
   },
+  {
+    .name = "retain_dir_unpins_outside",
+    .ops = {
+      { .kind = FILE_CACHE_OP_FILE, .path = "E/G", .blob = "C" },
+      { .kind = FILE_CACHE_OP_DIGEST, .path = "E/G", .blob = "C" },
+      { .kind = FILE_CACHE_OP_WRITE, .path = "E/G", .blob = "DD" },
+      { .kind = FILE_CACHE_OP_RETAIN_DIR, .path = "D" },
+      { .kind = FILE_CACHE_OP_DIGEST, .path = "E/G", .blob = "DD" },
+    }
+  },
+  {
+    .name = "retain_dir_keeps_subtree",
+    .ops = {
+      { .kind = FILE_CACHE_OP_FILE, .path = "D/F", .blob = "A" },
+      { .kind = FILE_CACHE_OP_DIGEST, .path = "D/F", .blob = "A" },
+      { .kind = FILE_CACHE_OP_WRITE, .path = "D/F", .blob = "BB" },
+      { .kind = FILE_CACHE_OP_RETAIN_DIR, .path = "D" },
+      { .kind = FILE_CACHE_OP_DIGEST, .path = "D/F", .blob = "A" },
+    }
+  },
   {
     .name = "seeded_digest_trusted_without_hash",
     .ops = {
@@ -139,6 +160,10 @@ sp_test_each(dag_file_cache, ops, file_cache_test_t, file_cache_tests) {
         spn_dag_file_cache_invalidate_dir(c, path);
         break;
       }
+      case FILE_CACHE_OP_RETAIN_DIR: {
+        spn_dag_file_cache_retain_dir(c, path);
+        break;
+      }
       case FILE_CACHE_OP_DIGEST: {
         spn_dag_digest_t digest = sp_zero;
         sp_expect_eq(t, op.expect.err, spn_dag_file_cache_digest(c, path, &digest));
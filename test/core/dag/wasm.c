@@ -28,6 +28,7 @@ typedef struct {
 
 typedef struct {
   const c8* fn;
+  bool writes;
   wasm_emit_op_t ops [DAG_WASM_MAX_OPS];
   wasm_expect_t expect;
 } wasm_call_t;
@@ -65,6 +66,15 @@ static const wasm_test_t wasm_tests [] = {
         .ops = { { WASM_EMIT_OPEN_WRITE, "O" } } },
     }
   },
+  {
+    .name = "open_write_observed",
+    .calls = {
+      { .fn = "run",
+        .writes = true,
+        .ops = { { WASM_EMIT_OPEN_WRITE, "O" } },
+        .expect = { .obs = { { .path = "work/O" } } } },
+    }
+  },
   {
     .name = "write_then_read",
     .calls = {
@@ -87,6 +97,19 @@ static const wasm_test_t wasm_tests [] = {
         } },
     }
   },
+  {
+    .name = "write_then_read_observed",
+    .calls = {
+      { .fn = "run",
+        .writes = true,
+        .ops = {
+          { WASM_EMIT_OPEN_WRITE, "O" },
+          { WASM_EMIT_CLOSE },
+          { WASM_EMIT_OPEN_READ, "O" },
+        },
+        .expect = { .obs = { { .path = "work/O" } } } },
+    }
+  },
   {
     .name = "stat_file",
     .files = { { "work/H" } },
@@ -172,19 +195,6 @@ static const wasm_test_t wasm_tests [] = {
   },
 };
 
-static sp_test_once_t wasm_runtime_once;
-
-static sp_err_t wasm_runtime_bring_up(void* user) {
-  SP_UNUSED(user);
-  if (!wasm_runtime_init()) {
-    return SP_ERR;
-  }
-  if (spn_dag_wasi_install() != SPN_OK) {
-    return SP_ERR;
-  }
-  return SP_OK;
-}
-
 static void expect_obs(sp_test_t* t, sp_mem_t mem, const spn_path_roots_t* roots, sp_str_t root, const wasm_expect_t* expect, sp_da(spn_dag_obs_t) obs) {
   u32 expected = 0;
   sp_carr_detect_len(expect->obs, expected, expect->obs[expected].path);
@@ -208,7 +218,7 @@ sp_test_each(dag_wasm, wasi, wasm_test_t, wasm_tests) {
     return sp_test_skip(t, "wamr syscalls bypass the sim filesystem");
   }
 
-  sp_must_ok(t, sp_test_once(&wasm_runtime_once, wasm_runtime_bring_up, SP_NULLPTR));
+  sp_must_ok(t, wasm_emit_runtime_init());
 
   sp_mem_t mem = sp_test_arena(t);
   sp_str_t root = sp_test_dir(t);
@@ -282,7 +292,7 @@ sp_test_each(dag_wasm, wasi, wasm_test_t, wasm_tests) {
     sp_must(t, fn != SP_NULLPTR);
 
     sp_da(spn_dag_obs_t) obs = sp_da_new(mem, spn_dag_obs_t);
-    spn_dag_wasi_begin(w, mem, &obs);
+    spn_dag_wasi_begin(w, mem, &obs, call->writes);
 
     wasm_val_t results [1] = sp_zero;
     bool called = wasm_runtime_call_wasm_a(env, fn, 1, results, 0, SP_NULLPTR);
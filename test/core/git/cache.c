@@ -458,3 +458,238 @@ sp_test_each(git_cache, ensure, cache_test_t, tests) {
 
   return SP_OK;
 }
+
+static git_repo_fixture_t revs_repo = {
+  .commits = {
+    {
+      .message = "v1",
+      .files = {
+        { "lib.h", "#define VERSION 1" },
+      },
+    },
+    {
+      .message = "v2",
+      .files = {
+        { "lib.h", "#define VERSION 2" },
+      },
+    },
+  },
+};
+
+sp_test(git_cache, ensure_rev_memoized) {
+  sp_mem_t mem = sp_test_arena(t);
+  git_repo_result_t repo = git_repo_build_at(sp_test_dir(t), "R", &revs_repo);
+
+  sp_str_t cache_root = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("cache"));
+  sp_fs_create_dir(cache_root);
+
+  spn_git_cache_t cache = sp_zero;
+  spn_git_cache_init(&cache, mem, SP_NULLPTR, cache_root);
+
+  spn_git_db_t* db = SP_NULLPTR;
+  sp_must_eq(t, spn_git_cache_ensure_db(&cache, repo.path, &db), SPN_OK);
+
+  // The tip comes from the ref listing, the older commit from cat-file
+  sp_expect_eq(t, spn_git_db_ensure_rev(db, repo.commits[1]), SPN_OK);
+  sp_expect(t, db->listed);
+  sp_expect_eq(t, spn_git_db_ensure_rev(db, repo.commits[0]), SPN_OK);
+  sp_expect_eq(t, spn_git_db_ensure_rev(db, sp_str_lit("0000000000000000000000000000000000000000")), SPN_ERROR);
+
+  // With the db gone, anything already confirmed is still answered without git
+  sp_fs_remove_dir(db->path);
+  sp_expect_eq(t, spn_git_db_ensure_rev(db, repo.commits[0]), SPN_OK);
+  sp_expect_eq(t, spn_git_db_ensure_rev(db, repo.commits[1]), SPN_OK);
+  return SP_OK;
+}
+
+static git_repo_fixture_t sparse_repo = {
+  .commits = {
+    {
+      .message = "initial",
+      .files = {
+        { "packages/math/spn.toml", r("[package]") "name = \"math\"" },
+        { "packages/audio/spn.toml", r("[package]") "name = \"audio\"" },
+      },
+    },
+  },
+};
+
+sp_test(git_cache, subdir_checkout_is_sparse) {
+  sp_mem_t mem = sp_test_arena(t);
+  git_repo_result_t repo = git_repo_build_at(sp_test_dir(t), "R", &sparse_repo);
+
+  sp_str_t cache_root = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("cache"));
+  sp_fs_create_dir(cache_root);
+
+  spn_git_cache_t cache = sp_zero;
+  spn_git_cache_init(&cache, mem, SP_NULLPTR, cache_root);
+
+  spn_git_checkout_id_t id = {
+    .url = repo.path,
+    .rev = repo.commits[0],
+    .dir = sp_str_lit("packages/math"),
+  };
+  spn_git_checkout_t* checkout = SP_NULLPTR;
+  sp_must_eq(t, spn_git_cache_ensure_checkout(&cache, id, &checkout), SPN_OK);
+
+  sp_str_t packages = sp_fs_parent_path(checkout->path);
+  sp_expect(t, sp_fs_exists(sp_fs_join_path(mem, checkout->path, sp_str_lit("spn.toml"))));
+  sp_expect(t, !sp_fs_exists(sp_fs_join_path(mem, packages, sp_str_lit("audio"))));
+  return SP_OK;
+}
+
+static git_repo_fixture_t pooled_repo = {
+  .commits = {
+    {
+      .message = "v1",
+      .files = {
+        { "lib.h", "#define VERSION 1" },
+        { "shared.h", "int shared(void);" },
+      },
+    },
+    {
+      .message = "v2",
+      .files = {
+        { "lib.h", "#define VERSION 2" },
+        { "shared.h", "int shared(void);" },
+      },
+    },
+  },
+};
+
+static u32 count_pooled_blobs(sp_mem_t mem, spn_git_cache_t* cache) {
+  sp_da(sp_fs_entry_t) entries = sp_zero;
+  sp_fs_collect_recursive(mem, cache->blobs.dir, &entries);
+  u32 blobs = 0;
+  sp_da_for(entries, it) {
+    blobs += entries[it].kind != SP_FS_KIND_DIR;
+  }
+  return blobs;
+}
+
+sp_test(git_cache, checkouts_share_blobs) {
+  sp_mem_t mem = sp_test_arena(t);
+  git_repo_result_t repo = git_repo_build_at(sp_test_dir(t), "R", &pooled_repo);
+
+  sp_str_t cache_root = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("cache"));
+  sp_fs_create_dir(cache_root);
+
+  spn_git_cache_t cache = sp_zero;
+  spn_git_cache_init(&cache, mem, SP_NULLPTR, cache_root);
+
+  sp_str_t shared [2] = sp_zero;
+  sp_for(c, 2) {
+    spn_git_checkout_id_t id = {
+      .url = repo.path,
+      .rev = repo.commits[c],
+    };
+    spn_git_checkout_t* checkout = SP_NULLPTR;
+    sp_must_eq(t, spn_git_cache_ensure_checkout(&cache, id, &checkout), SPN_OK);
+
+    shared[c] = sp_fs_join_path(mem, checkout->path, sp_str_lit("shared.h"));
+    sp_expect_str_eq_c(t, test_read_file(mem, shared[c]), "int shared(void);");
+  }
+
+  // shared.h once, lib.h once per revision
+  sp_expect_eq(t, count_pooled_blobs(mem, &cache), 3);
+
+  // Without reflinks both checkouts hold the pool's read-only inode, and
+  // there's nothing to write through. A clone is a file of its own, so
+  // writing it reaches neither the other checkout nor the pool.
+  sp_sys_file_meta_t meta [2] = sp_zero;
+  sp_for(c, 2) {
+    sp_must_eq(t, sp_sys_get_path_metadata_s(sp_sys_get_root(0), shared[c], &meta[c]), SP_OK);
+  }
+  if (meta[0].id != meta[1].id) {
+    sp_must_eq(t, sp_fs_create_file_str(shared[0], sp_str_lit("int changed(void);")), SP_OK);
+    sp_expect_str_eq_c(t, test_read_file(mem, shared[1]), "int shared(void);");
+  }
+
+  // The pool is only a cache of fetches; emptying it leaves checkouts alone
+  spn_git_cache_prune_blobs(&cache, 0);
+  sp_expect_eq(t, count_pooled_blobs(mem, &cache), 0);
+  sp_expect_str_eq_c(t, test_read_file(mem, shared[1]), "int shared(void);");
+  return SP_OK;
+}
+
+static git_repo_fixture_t attributes_repo = {
+  .commits = {
+    {
+      .message = "v1",
+      .files = {
+        { ".gitattributes", "lib.h ident" },
+        { "lib.h", "$Id$" },
+      },
+    },
+  },
+};
+
+sp_test(git_cache, attributes_bypass_pool) {
+  sp_mem_t mem = sp_test_arena(t);
+  git_repo_result_t repo = git_repo_build_at(sp_test_dir(t), "R", &attributes_repo);
+
+  sp_str_t cache_root = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("cache"));
+  sp_fs_create_dir(cache_root);
+
+  spn_git_cache_t cache = sp_zero;
+  spn_git_cache_init(&cache, mem, SP_NULLPTR, cache_root);
+
+  spn_git_checkout_id_t id = {
+    .url = repo.path,
+    .rev = repo.commits[0],
+  };
+  spn_git_checkout_t* checkout = SP_NULLPTR;
+  sp_must_eq(t, spn_git_cache_ensure_checkout(&cache, id, &checkout), SPN_OK);
+
+  // What git wrote isn't the blob, so none of it is pooled under the blob's id
+  sp_str_t lib = sp_fs_join_path(mem, checkout->path, sp_str_lit("lib.h"));
+  sp_expect(t, sp_str_starts_with(test_read_file(mem, lib), sp_str_lit("$Id: ")));
+  sp_expect_eq(t, count_pooled_blobs(mem, &cache), 0);
+  return SP_OK;
+}
+
+static u32 count_missing_objects(sp_str_t db) {
+  sp_ps_output_t output = git_repo_git(db, sp_str_lit("rev-list"), sp_str_lit("--objects"), sp_str_lit("--missing=print"), sp_str_lit("--all"));
+  u32 missing = 0;
+  sp_str_for_line(output.out, it) {
+    missing += sp_str_starts_with(it.line, sp_str_lit("?"));
+  }
+  return missing;
+}
+
+// A local path clones in full whatever it's asked; only a file:// URL to a
+// repo that allows filters takes the partial path the network would
+sp_test(git_cache, partial_db_over_file_url) {
+  sp_mem_t mem = sp_test_arena(t);
+  git_repo_result_t repo = git_repo_build_at(sp_test_dir(t), "R", &pooled_repo);
+  git_repo_git(repo.path, sp_str_lit("config"), sp_str_lit("uploadpack.allowFilter"), sp_str_lit("true"));
+  sp_str_t url = sp_fmt(mem, "file://{}", sp_fmt_str(repo.path)).value;
+
+  sp_str_t cache_root = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("cache"));
+  sp_fs_create_dir(cache_root);
+
+  spn_git_cache_t cache = sp_zero;
+  spn_git_cache_init(&cache, mem, SP_NULLPTR, cache_root);
+
+  spn_git_db_t* db = SP_NULLPTR;
+  sp_must_eq(t, spn_git_cache_ensure_db(&cache, url, &db), SPN_OK);
+  sp_must_eq(t, spn_git_db_ensure_rev(db, repo.commits[0]), SPN_OK);
+
+  // Three distinct blobs across both commits, none of them in the db
+  sp_expect_eq(t, count_missing_objects(db->path), 3);
+
+  sp_for(c, 2) {
+    spn_git_checkout_id_t id = {
+      .url = url,
+      .rev = repo.commits[c],
+    };
+    spn_git_checkout_t* checkout = SP_NULLPTR;
+    sp_must_eq(t, spn_git_cache_ensure_checkout(&cache, id, &checkout), SPN_OK);
+
+    sp_str_t lib = sp_fs_join_path(mem, checkout->path, sp_str_lit("lib.h"));
+    sp_expect_str_eq_c(t, test_read_file(mem, lib), c ? "#define VERSION 2" : "#define VERSION 1");
+    sp_str_t shared = sp_fs_join_path(mem, checkout->path, sp_str_lit("shared.h"));
+    sp_expect_str_eq_c(t, test_read_file(mem, shared), "int shared(void);");
+  }
+  return SP_OK;
+}
@@ -5,4 +5,5 @@
 #include "git/cache.h"
 #include "git/key.h"
 #include "git/patch.h"
+#include "git/tree.h"
 #include "git/url.h"
@@ -0,0 +1,93 @@
+#include "git.h"
+
+typedef struct {
+  spn_git_tree_kind_t kind;
+  const c8* id;
+  const c8* path;
+} tree_expect_t;
+
+typedef struct {
+  const c8* name;
+  const c8* listing;
+  u32 len;
+  spn_err_t err;
+  tree_expect_t entries [4];
+} tree_parse_t;
+
+#define TREE_LISTING(s) .listing = s, .len = sizeof(s) - 1
+
+static const tree_parse_t tree_parses [] = {
+  {
+    .name = "empty",
+    TREE_LISTING(""),
+  },
+  {
+    .name = "file_kinds",
+    TREE_LISTING(
+      "100644 blob f70f10e4db19068f79bc43844b49f3eece45c4e8\tsrc/lib.c\0"
+      "100755 blob 223b7836fb19fdf64ba2d3cd6173c6a283141f78\tbuild.sh\0"
+      "120000 blob 0a5e1d2b1b2ac7b3f4c5b0a9e0f0e7b0f2f1c7d1\tinclude\0"
+      "160000 commit 9c3f0ae62a1f3bbd9c14de4b7a2c92b7a1f0e2d4\tvendor/sp\0"
+    ),
+    .entries = {
+      { SPN_GIT_TREE_FILE,       "f70f10e4db19068f79bc43844b49f3eece45c4e8", "src/lib.c" },
+      { SPN_GIT_TREE_EXECUTABLE, "223b7836fb19fdf64ba2d3cd6173c6a283141f78", "build.sh" },
+      { SPN_GIT_TREE_SYMLINK,    "0a5e1d2b1b2ac7b3f4c5b0a9e0f0e7b0f2f1c7d1", "include" },
+      { SPN_GIT_TREE_SUBMODULE,  "9c3f0ae62a1f3bbd9c14de4b7a2c92b7a1f0e2d4", "vendor/sp" },
+    },
+  },
+  {
+    .name = "path_with_spaces_and_tabs",
+    TREE_LISTING("100644 blob f70f10e4db19068f79bc43844b49f3eece45c4e8\tdocs/a b\tc.md\0"),
+    .entries = {
+      { SPN_GIT_TREE_FILE, "f70f10e4db19068f79bc43844b49f3eece45c4e8", "docs/a b\tc.md" },
+    },
+  },
+  {
+    .name = "unknown_mode",
+    TREE_LISTING("040000 tree f70f10e4db19068f79bc43844b49f3eece45c4e8\tsrc\0"),
+    .err = SPN_ERROR,
+  },
+  {
+    .name = "truncated",
+    TREE_LISTING("100644 blob f70f10e4db19068f79bc43844b49f3eece45c4e8\0"),
+    .err = SPN_ERROR,
+  },
+};
+
+sp_test_each(git_tree, parse, tree_parse_t, tree_parses) {
+  sp_mem_t mem = sp_test_arena(t);
+
+  sp_da(spn_git_tree_entry_t) entries = sp_da_new(mem, spn_git_tree_entry_t);
+  spn_err_t err = spn_git_tree_parse(mem, sp_str(it->listing, it->len), &entries);
+  sp_must_eq(t, err, it->err);
+  if (err) {
+    return SP_OK;
+  }
+
+  u32 n = 0;
+  sp_carr_detect_len(it->entries, n, it->entries[n].path);
+  sp_must_eq(t, sp_da_size(entries), n);
+  sp_for(e, n) {
+    sp_expect_eq(t, entries[e].kind, it->entries[e].kind);
+    sp_expect_str_eq_c(t, entries[e].id, it->entries[e].id);
+    sp_expect_str_eq_c(t, entries[e].path, it->entries[e].path);
+  }
+  return SP_OK;
+}
+
+sp_test(git_tree, blob_path) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_str_t pool = sp_str_lit("/cache/blobs");
+
+  spn_git_tree_entry_t file = {
+    .kind = SPN_GIT_TREE_FILE,
+    .id = sp_str_lit("f70f10e4db19068f79bc43844b49f3eece45c4e8"),
+  };
+  sp_expect_str_eq_c(t, spn_git_tree_blob_path(mem, pool, file), "/cache/blobs/f7/0f10e4db19068f79bc43844b49f3eece45c4e8");
+
+  // Same content, different mode: two inodes
+  file.kind = SPN_GIT_TREE_EXECUTABLE;
+  sp_expect_str_eq_c(t, spn_git_tree_blob_path(mem, pool, file), "/cache/blobs/f7/0f10e4db19068f79bc43844b49f3eece45c4e8-x");
+  return SP_OK;
+}
@@ -1,6 +1,7 @@
 #include "index.h"
 
 #include "index/cache.h"
+#include "index/snapshot.h"
 
 typedef struct {
   const c8* name;
@@ -128,3 +129,109 @@ sp_test_each(index_cache, get_package, cache_test_t, tests, .setup = spn_test_ct
   }
   return SP_OK;
 }
+
+sp_test(index_cache, prefetch, .setup = spn_test_ctx_setup) {
+  sp_mem_t mem = sp_test_arena(t);
+
+  sp_da(spn_index_info_t) indexes = sp_da_new(mem, spn_index_info_t);
+  sp_da_push(indexes, ((spn_index_info_t) {
+    .location = test_repo_path(mem, sp_str_lit("test/core/index/indexes/dir")),
+    .protocol = SPN_INDEX_PROTOCOL_DIR,
+  }));
+
+  spn_index_cache_t cache = sp_zero;
+  spn_index_cache_init(&cache, mem, spn.intern, &indexes);
+
+  spn_pkg_name_t ids [] = {
+    { .namespace = sp_str_lit("core"), .name = sp_str_lit("A") },
+    { .namespace = sp_str_lit("core"), .name = sp_str_lit("missing") },
+    { .namespace = sp_str_lit("core"), .name = sp_str_lit("A") },
+  };
+
+  // Without workers nothing is loaded and no pool is made
+  spn_index_cache_prefetch(&cache, ids, sp_carr_len(ids));
+  sp_expect(t, !cache.prefetch.started);
+  sp_expect_eq(t, sp_str_om_size(cache.packages), 0);
+
+  cache.prefetch.workers = 2;
+  spn_index_cache_prefetch(&cache, ids, sp_carr_len(ids));
+  sp_must(t, cache.prefetch.started);
+
+  // Both names were loaded ahead of time, including the one that isn't there
+  sp_must_eq(t, sp_str_om_size(cache.packages), 2);
+  sp_expect_eq(t, sp_da_size(cache.prefetch.arenas), 2);
+
+  // A later batch runs on the same workers
+  sp_thread_t* workers = cache.prefetch.pool.workers;
+  spn_pkg_name_t more [] = {
+    { .namespace = sp_str_lit("core"), .name = sp_str_lit("B") },
+    { .namespace = sp_str_lit("core"), .name = sp_str_lit("C") },
+  };
+  spn_index_cache_prefetch(&cache, more, sp_carr_len(more));
+  sp_expect(t, cache.prefetch.pool.workers == workers);
+  sp_expect_eq(t, sp_str_om_size(cache.packages), 4);
+  sp_expect_eq(t, sp_da_size(cache.prefetch.arenas), 4);
+
+  spn_index_pkg_t* pkg = SP_NULLPTR;
+  spn_index_diag_t diag = sp_zero;
+  sp_must_eq(t, spn_index_cache_get_package(&cache, ids[0], &pkg, &diag), SPN_OK);
+  sp_must(t, pkg != SP_NULLPTR);
+  sp_expect(t, spn_semver_eq(spn_semver_lit(1, 5, 0), pkg->releases[0].version));
+
+  sp_must_eq(t, spn_index_cache_get_package(&cache, ids[1], &pkg, &diag), SPN_OK);
+  sp_expect(t, pkg == SP_NULLPTR);
+
+  spn_index_cache_deinit(&cache);
+  sp_expect(t, !cache.prefetch.started);
+  sp_expect_eq(t, sp_da_size(cache.prefetch.arenas), 0);
+  return SP_OK;
+}
+
+static void commit_release(sp_mem_t mem, sp_str_t repo, const c8* line) {
+  sp_str_t dir = sp_fs_join_path(mem, repo, sp_str_lit("core"));
+  sp_fs_create_dir(dir);
+  sp_fs_create_file_str(sp_fs_join_path(mem, dir, sp_str_lit("A.jsonl")), sp_cstr_as_str(line));
+
+  git_repo_stage_all(repo);
+  git_repo_commit(repo, sp_str_lit("release"));
+}
+
+sp_test(index_cache, stale_snapshot, .setup = spn_test_ctx_setup) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_fs_create_dir(sp_test_dir(t));
+
+  sp_str_t replica = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("replica"));
+  sp_fs_create_dir(replica);
+  git_repo_init(replica);
+  commit_release(mem, replica, "{\"namespace\":\"core\",\"name\":\"A\",\"version\":\"1.0.0\"}\n");
+
+  sp_da(spn_index_info_t) indexes = sp_da_new(mem, spn_index_info_t);
+  sp_da_push(indexes, ((spn_index_info_t) {
+    .location = replica,
+    .protocol = SPN_INDEX_PROTOCOL_GIT,
+  }));
+  spn_index_snapshot_refresh(&indexes[0]);
+  sp_must(t, sp_fs_exists(spn_index_snapshot_path(mem, &indexes[0])));
+
+  // HEAD moves without a sync, so the snapshot still describes 1.0.0
+  commit_release(mem, replica, "{\"namespace\":\"core\",\"name\":\"A\",\"version\":\"2.0.0\"}\n");
+
+  spn_index_cache_t cache = sp_zero;
+  spn_index_cache_init(&cache, mem, spn.intern, &indexes);
+
+  spn_pkg_name_t request = { .namespace = sp_str_lit("core"), .name = sp_str_lit("A") };
+  spn_index_pkg_t* pkg = SP_NULLPTR;
+  spn_index_diag_t diag = sp_zero;
+  sp_must_eq(t, spn_index_cache_get_package(&cache, request, &pkg, &diag), SPN_OK);
+  sp_must(t, pkg != SP_NULLPTR);
+  sp_must_eq(t, 1, sp_da_size(pkg->releases));
+  sp_expect(t, spn_semver_eq(spn_semver_lit(2, 0, 0), pkg->releases[0].version));
+
+  // The revision that keys memoized resolutions follows HEAD as well
+  sp_str_t head = sp_zero;
+  sp_must_eq(t, spn_git_get_commit_full(mem, replica, sp_str_lit("HEAD"), &head), SPN_OK);
+  sp_str_t rev = sp_zero;
+  sp_must(t, spn_index_revision(mem, &indexes[0], &rev));
+  sp_expect_str_eq(t, rev, head);
+  return SP_OK;
+}
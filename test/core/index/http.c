@@ -0,0 +1,356 @@
+#include "index.h"
+
+#include "index/http.h"
+
+// Stands in for a static file server: serves <root>/<ns>/<name>.jsonl with an
+// ETag derived from the content and answers If-None-Match with a 304
+typedef struct {
+  sp_str_t root;
+  bool down;
+  u32 requests;
+  u32 conditional;
+} http_server_t;
+
+#define HTTP_SERVER_URL "http://index.test/"
+
+static spn_index_http_status_t http_server_fetch(sp_mem_t mem, sp_str_t url, spn_index_http_validators_t* validators, sp_str_t* body, void* user_data) {
+  http_server_t* server = (http_server_t*)user_data;
+  server->requests++;
+  if (server->down) {
+    return SPN_INDEX_HTTP_FAILED;
+  }
+
+  sp_str_t prefix = sp_str_lit(HTTP_SERVER_URL);
+  if (!sp_str_starts_with(url, prefix)) {
+    return SPN_INDEX_HTTP_NOT_FOUND;
+  }
+  sp_str_t path = sp_fs_join_path(mem, server->root, sp_str_sub(url, prefix.len, url.len - prefix.len));
+  if (!sp_fs_exists(path)) {
+    return SPN_INDEX_HTTP_NOT_FOUND;
+  }
+
+  sp_str_t content = sp_zero;
+  sp_io_read_file(mem, path, &content);
+  sp_str_t etag = sp_fmt(mem, "\"{}\"", sp_fmt_uint(sp_hash_bytes(content.data, content.len, 0))).value;
+
+  if (!sp_str_empty(validators->etag)) {
+    server->conditional++;
+    if (sp_str_equal(validators->etag, etag)) {
+      return SPN_INDEX_HTTP_NOT_MODIFIED;
+    }
+  }
+
+  validators->etag = etag;
+  *body = content;
+  return SPN_INDEX_HTTP_OK;
+}
+
+typedef enum {
+  HTTP_THEN_NOTHING,
+  HTTP_THEN_AGAIN,
+  HTTP_THEN_UPDATE,
+  HTTP_THEN_OFFLINE,
+  HTTP_THEN_FORCE_SYNC,
+} http_then_t;
+
+typedef struct {
+  const c8* name;
+  const c8* package;
+  u32 refresh;
+  bool down;
+  bool forced;
+  http_then_t then;
+
+  struct {
+    spn_err_t err;
+    const c8* version;
+    u32 requests;
+    u32 conditional;
+  } expect;
+} http_test_t;
+
+static const http_test_t tests [] = {
+  {
+    .name = "first_lookup_fetches",
+    .package = "A",
+    .refresh = 600,
+    .expect = {
+      .version = "1.0.0",
+      .requests = 1,
+    },
+  },
+  {
+    .name = "fresh_entry_skips_network",
+    .package = "A",
+    .refresh = 600,
+    .then = HTTP_THEN_AGAIN,
+    .expect = {
+      .version = "1.0.0",
+      .requests = 1,
+    },
+  },
+  {
+    .name = "stale_entry_revalidates",
+    .package = "A",
+    .then = HTTP_THEN_AGAIN,
+    .expect = {
+      .version = "1.0.0",
+      .requests = 2,
+      .conditional = 1,
+    },
+  },
+  {
+    .name = "upstream_change_refetches",
+    .package = "A",
+    .then = HTTP_THEN_UPDATE,
+    .expect = {
+      .version = "1.1.0",
+      .requests = 2,
+      .conditional = 1,
+    },
+  },
+  {
+    .name = "forced_sync_revalidates",
+    .package = "A",
+    .refresh = 600,
+    .then = HTTP_THEN_FORCE_SYNC,
+    .expect = {
+      .version = "1.0.0",
+      .requests = 2,
+      .conditional = 1,
+    },
+  },
+  {
+    .name = "fetch_after_forced_sync_is_fresh",
+    .package = "A",
+    .refresh = 600,
+    .forced = true,
+    .then = HTTP_THEN_AGAIN,
+    .expect = {
+      .version = "1.0.0",
+      .requests = 1,
+    },
+  },
+  {
+    .name = "missing_is_remembered",
+    .package = "missing",
+    .refresh = 600,
+    .then = HTTP_THEN_AGAIN,
+    .expect = {
+      .requests = 1,
+    },
+  },
+  {
+    .name = "offline_keeps_cached",
+    .package = "A",
+    .then = HTTP_THEN_OFFLINE,
+    .expect = {
+      .version = "1.0.0",
+      .requests = 2,
+    },
+  },
+  {
+    .name = "offline_without_cache",
+    .package = "A",
+    .refresh = 600,
+    .down = true,
+    .expect = {
+      .err = SPN_ERR_INDEX_SYNC,
+      .requests = 1,
+    },
+  },
+};
+
+static void http_server_publish(sp_mem_t mem, http_server_t* server, const c8* versions) {
+  sp_str_t dir = sp_fs_join_path(mem, server->root, sp_str_lit("core"));
+  sp_fs_create_dir(server->root);
+  sp_fs_create_dir(dir);
+  sp_fs_create_file_str(sp_fs_join_path(mem, dir, sp_str_lit("A.jsonl")), sp_cstr_as_str(versions));
+}
+
+sp_test_each(index_http, get_package, http_test_t, tests, .setup = spn_test_ctx_setup) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_fs_create_dir(sp_test_dir(t));
+
+  http_server_t server = {
+    .root = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("server")),
+    .down = it->down,
+  };
+  http_server_publish(mem, &server,
+    "{\"namespace\":\"core\",\"name\":\"A\",\"version\":\"1.0.0\"}\n");
+
+  spn_index_info_t index = {
+    .name = sp_str_lit("sparse"),
+    .protocol = SPN_INDEX_PROTOCOL_HTTP,
+    .http = {
+      .url = sp_str_lit(HTTP_SERVER_URL),
+      .fetch = http_server_fetch,
+      .fetch_user_data = &server,
+    },
+    .location = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("cache")),
+    .refresh = it->refresh,
+  };
+  sp_must_eq(t, spn_index_sync(&index, it->forced), SPN_OK);
+
+  spn_pkg_name_t request = {
+    .namespace = sp_str_lit("core"),
+    .name = sp_cstr_as_str(it->package),
+  };
+  spn_index_pkg_t* pkg = SP_NULLPTR;
+  spn_index_diag_t diag = sp_zero;
+  spn_err_t err = spn_index_get_package(&index, mem, spn.intern, request, &pkg, &diag);
+
+  switch (it->then) {
+    case HTTP_THEN_NOTHING: {
+      break;
+    }
+    case HTTP_THEN_AGAIN: {
+      err = spn_index_get_package(&index, mem, spn.intern, request, &pkg, &diag);
+      break;
+    }
+    case HTTP_THEN_UPDATE: {
+      http_server_publish(mem, &server,
+        "{\"namespace\":\"core\",\"name\":\"A\",\"version\":\"1.0.0\"}\n"
+        "{\"namespace\":\"core\",\"name\":\"A\",\"version\":\"1.1.0\"}\n");
+      err = spn_index_get_package(&index, mem, spn.intern, request, &pkg, &diag);
+      break;
+    }
+    case HTTP_THEN_OFFLINE: {
+      server.down = true;
+      err = spn_index_get_package(&index, mem, spn.intern, request, &pkg, &diag);
+      break;
+    }
+    case HTTP_THEN_FORCE_SYNC: {
+      sp_must_eq(t, spn_index_sync(&index, true), SPN_OK);
+      err = spn_index_get_package(&index, mem, spn.intern, request, &pkg, &diag);
+      break;
+    }
+  }
+
+  sp_expect_eq(t, err, it->expect.err);
+  sp_expect_eq(t, server.requests, it->expect.requests);
+  sp_expect_eq(t, server.conditional, it->expect.conditional);
+  sp_must_eq(t, pkg != SP_NULLPTR, it->expect.version != SP_NULLPTR);
+
+  if (pkg) {
+    spn_semver_t version = sp_zero;
+    spn_semver_parse(sp_cstr_as_str(it->expect.version), &version);
+    sp_expect(t, spn_semver_eq(sp_da_back(pkg->releases)->version, version));
+  }
+  return SP_OK;
+}
+
+typedef struct {
+  const c8* name;
+  const c8* out;
+
+  struct {
+    spn_index_http_status_t status;
+    const c8* etag;
+    const c8* modified;
+    const c8* body;
+  } expect;
+} http_parse_test_t;
+
+static const http_parse_test_t parse_tests [] = {
+  {
+    .name = "ok_with_validators",
+    .out =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: application/jsonl\r\n"
+      "ETag: \"abc\"\r\n"
+      "Last-Modified: Tue, 01 Sep 2026 00:00:00 GMT\r\n"
+      "\r\n"
+      "{\"version\":\"1.0.0\"}\n",
+    .expect = {
+      .status = SPN_INDEX_HTTP_OK,
+      .etag = "\"abc\"",
+      .modified = "Tue, 01 Sep 2026 00:00:00 GMT",
+      .body = "{\"version\":\"1.0.0\"}\n",
+    },
+  },
+  {
+    .name = "header_names_ignore_case",
+    .out =
+      "HTTP/2 200\r\n"
+      "etag: W/\"weak\"\r\n"
+      "\r\n"
+      "body",
+    .expect = {
+      .status = SPN_INDEX_HTTP_OK,
+      .etag = "W/\"weak\"",
+      .body = "body",
+    },
+  },
+  {
+    .name = "redirect_uses_last_block",
+    .out =
+      "HTTP/1.1 301 Moved Permanently\r\n"
+      "Location: https://mirror.test/core/A.jsonl\r\n"
+      "ETag: \"redirect\"\r\n"
+      "\r\n"
+      "HTTP/1.1 200 OK\r\n"
+      "ETag: \"final\"\r\n"
+      "\r\n"
+      "body",
+    .expect = {
+      .status = SPN_INDEX_HTTP_OK,
+      .etag = "\"final\"",
+      .body = "body",
+    },
+  },
+  {
+    .name = "redirect_to_missing",
+    .out =
+      "HTTP/1.1 302 Found\r\n"
+      "Location: https://mirror.test/core/A.jsonl\r\n"
+      "\r\n"
+      "HTTP/1.1 404 Not Found\r\n"
+      "\r\n",
+    .expect = { .status = SPN_INDEX_HTTP_NOT_FOUND },
+  },
+  {
+    .name = "not_modified",
+    .out =
+      "HTTP/1.1 304 Not Modified\r\n"
+      "ETag: \"abc\"\r\n"
+      "\r\n",
+    .expect = { .status = SPN_INDEX_HTTP_NOT_MODIFIED },
+  },
+  {
+    .name = "gone",
+    .out = "HTTP/1.1 410 Gone\r\n\r\n",
+    .expect = { .status = SPN_INDEX_HTTP_NOT_FOUND },
+  },
+  {
+    .name = "server_error",
+    .out = "HTTP/1.1 503 Service Unavailable\r\n\r\n",
+    .expect = { .status = SPN_INDEX_HTTP_FAILED },
+  },
+  {
+    .name = "truncated_headers",
+    .out = "HTTP/1.1 200 OK\r\nETag: \"abc\"\r\n",
+    .expect = { .status = SPN_INDEX_HTTP_FAILED },
+  },
+  {
+    .name = "no_status_line",
+    .out = "{\"version\":\"1.0.0\"}\n",
+    .expect = { .status = SPN_INDEX_HTTP_FAILED },
+  },
+};
+
+sp_test_each(index_http, parse_curl, http_parse_test_t, parse_tests) {
+  sp_mem_t mem = sp_test_arena(t);
+
+  spn_index_http_validators_t validators = sp_zero;
+  sp_str_t body = sp_zero;
+  sp_must_eq(t, spn_index_http_parse_curl(mem, sp_cstr_as_str(it->out), &validators, &body), it->expect.status);
+  if (it->expect.status != SPN_INDEX_HTTP_OK) {
+    return SP_OK;
+  }
+
+  sp_expect_str_eq_c(t, validators.etag, it->expect.etag ? it->expect.etag : "");
+  sp_expect_str_eq_c(t, validators.modified, it->expect.modified ? it->expect.modified : "");
+  sp_expect_str_eq_c(t, body, it->expect.body);
+  return SP_OK;
+}
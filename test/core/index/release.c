@@ -1,5 +1,7 @@
 #include "index.h"
 
+#include "index/release.h"
+
 typedef struct {
   const c8* namespace;
   const c8* name;
@@ -429,3 +431,58 @@ sp_test_each(index_release, parse, release_test_t, tests) {
 
   return SP_OK;
 }
+
+static const c8* span_versions [] = { "0.9.0", "1.0.0", "1.2.0", "1.2.5", "2.0.0", "3.1.0" };
+
+typedef struct {
+  const c8* name;
+  const c8* range;
+  const c8* first;
+  const c8* last;
+} span_test_t;
+
+static const span_test_t span_tests [] = {
+  { .name = "caret",         .range = "^1.0.0", .first = "1.0.0", .last = "1.2.5" },
+  { .name = "tilde",         .range = "~1.2.0", .first = "1.2.0", .last = "1.2.5" },
+  { .name = "exact",         .range = "=2.0.0", .first = "2.0.0", .last = "2.0.0" },
+  { .name = "exact_missing", .range = "=1.1.0" },
+  { .name = "below_all",     .range = "<0.9.0" },
+  { .name = "above_all",     .range = ">3.1.0" },
+  { .name = "upper_open",    .range = ">=1.2.5", .first = "1.2.5", .last = "3.1.0" },
+  { .name = "upper_closed",  .range = "<=1.2.0", .first = "0.9.0", .last = "1.2.0" },
+  { .name = "wildcard",      .range = "*",      .first = "0.9.0", .last = "3.1.0" },
+};
+
+sp_test_each(index_release, span, span_test_t, span_tests) {
+  sp_mem_t mem = sp_test_arena(t);
+
+  spn_index_pkg_t pkg = sp_zero;
+  sp_da_init(mem, pkg.releases);
+  sp_carr_for(span_versions, at) {
+    sp_da_push(pkg.releases, ((spn_index_release_t) { .version = spn_semver_from_str(sp_cstr_as_str(span_versions[at])) }));
+  }
+
+  spn_semver_range_t range = sp_zero;
+  sp_must_eq(t, spn_semver_parse_range(sp_cstr_as_str(it->range), &range), SPN_OK);
+  spn_index_release_span_t span = spn_index_release_span(&pkg, range);
+
+  // Whatever the search finds has to be exactly what a linear filter finds
+  sp_da_for(pkg.releases, at) {
+    bool inside = at >= span.begin && at < span.end;
+    sp_expect_eq(t, inside, spn_semver_in_range(pkg.releases[at].version, range));
+  }
+
+  sp_must_eq(t, span.end > span.begin, it->first != SP_NULLPTR);
+  if (!it->first) {
+    return SP_OK;
+  }
+
+  spn_semver_t first = spn_semver_from_str(sp_cstr_as_str(it->first));
+  spn_semver_t last = spn_semver_from_str(sp_cstr_as_str(it->last));
+  sp_expect(t, spn_semver_eq(pkg.releases[span.begin].version, first));
+  sp_expect(t, spn_semver_eq(pkg.releases[span.end - 1].version, last));
+
+  sp_expect(t, spn_index_release_find(&pkg, first) == &pkg.releases[span.begin]);
+  sp_expect(t, spn_index_release_find(&pkg, spn_semver_lit(1, 1, 0)) == SP_NULLPTR);
+  return SP_OK;
+}
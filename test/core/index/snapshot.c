@@ -0,0 +1,116 @@
+#include "index.h"
+
+#include "index/snapshot.h"
+
+typedef struct {
+  const c8* version;
+  bool yanked;
+  u32 deps;
+} snapshot_rel_t;
+
+typedef struct {
+  const c8* name;
+  const c8* namespace;
+  const c8* package;
+  bool answered;
+  snapshot_rel_t releases [4];
+} snapshot_test_t;
+
+static const snapshot_test_t tests [] = {
+  {
+    .name = "sorted_by_version",
+    .namespace = "core",
+    .package = "A",
+    .answered = true,
+    .releases = {
+      { .version = "1.0.0", .yanked = true },
+      { .version = "1.2.0", .deps = 2 },
+    },
+  },
+  {
+    .name = "other_namespace",
+    .namespace = "other",
+    .package = "C",
+    .answered = true,
+    .releases = {
+      { .version = "2.0.0" },
+    },
+  },
+  {
+    .name = "absent",
+    .namespace = "core",
+    .package = "B",
+    .answered = true,
+  },
+  {
+    .name = "broken_falls_back",
+    .namespace = "core",
+    .package = "broken",
+  },
+};
+
+sp_test_each(index_snapshot, find, snapshot_test_t, tests, .setup = spn_test_ctx_setup) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_fs_create_dir(sp_test_dir(t));
+
+  sp_str_t location = test_repo_path(mem, sp_str_lit("test/core/index/indexes/snapshot"));
+  sp_str_t path = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("index.snapshot"));
+  sp_str_t rev = sp_str_lit("0123456789abcdef0123456789abcdef01234567");
+  sp_must_eq(t, spn_index_snapshot_build(location, rev, path), SPN_OK);
+
+  spn_index_snapshot_t snapshot = sp_zero;
+  sp_must_eq(t, spn_index_snapshot_open(&snapshot, mem, path), SPN_OK);
+  sp_expect(t, sp_str_equal(snapshot.rev, rev));
+  sp_expect_eq(t, snapshot.num_packages, 3);
+
+  spn_pkg_name_t request = {
+    .namespace = sp_cstr_as_str(it->namespace),
+    .name = sp_cstr_as_str(it->package),
+  };
+  spn_index_pkg_t* pkg = SP_NULLPTR;
+  bool answered = spn_index_snapshot_find(&snapshot, mem, request, &pkg);
+  sp_must_eq(t, answered, it->answered);
+
+  u32 n = 0;
+  sp_carr_detect_len(it->releases, n, it->releases[n].version);
+  sp_must_eq(t, pkg != SP_NULLPTR, n > 0);
+  if (!pkg) {
+    return SP_OK;
+  }
+
+  sp_must_eq(t, sp_da_size(pkg->releases), n);
+  sp_for(r, n) {
+    spn_index_release_t* release = &pkg->releases[r];
+    spn_semver_t version = sp_zero;
+    spn_semver_parse(sp_cstr_as_str(it->releases[r].version), &version);
+    sp_expect(t, spn_semver_eq(release->version, version));
+    sp_expect_eq(t, release->yanked, it->releases[r].yanked);
+
+    // Nothing past the version is read until the release is loaded
+    sp_expect(t, !sp_str_empty(release->raw));
+    sp_expect(t, release->deps == SP_NULLPTR);
+
+    sp_must_eq(t, spn_index_release_load(mem, release), SPN_OK);
+    sp_expect(t, sp_str_empty(release->raw));
+    sp_expect(t, spn_semver_eq(release->version, version));
+    sp_expect_eq(t, sp_da_size(release->deps), it->releases[r].deps);
+  }
+  return SP_OK;
+}
+
+sp_test(index_snapshot, rejects_truncated, .setup = spn_test_ctx_setup) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_fs_create_dir(sp_test_dir(t));
+
+  sp_str_t location = test_repo_path(mem, sp_str_lit("test/core/index/indexes/snapshot"));
+  sp_str_t path = sp_fs_join_path(mem, sp_test_dir(t), sp_str_lit("index.snapshot"));
+  sp_must_eq(t, spn_index_snapshot_build(location, sp_str_lit("rev"), path), SPN_OK);
+
+  sp_str_t bytes = sp_zero;
+  sp_must_eq(t, sp_io_read_file(mem, path, &bytes), SP_OK);
+  sp_must_eq(t, sp_fs_create_file_str(path, sp_str_prefix(bytes, bytes.len - 1)), SP_OK);
+
+  spn_index_snapshot_t snapshot = sp_zero;
+  sp_expect_eq(t, spn_index_snapshot_open(&snapshot, mem, path), SPN_ERROR);
+  return SP_OK;
+}
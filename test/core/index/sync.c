@@ -29,10 +29,10 @@ static const sync_test_t tests [] = {
     },
   },
   {
-    .name = "http_unimplemented",
+    .name = "http_creates_cache_only",
     .protocol = SPN_INDEX_PROTOCOL_HTTP,
     .expect = {
-      .result = SPN_ERROR,
+      .cached = true,
     },
   },
 };
@@ -276,3 +276,109 @@ sp_test_each(lock, roundtrip, test_t, tests) {
 
   return SP_OK;
 }
+
+typedef enum {
+  LOCK_EDIT_NONE,
+  LOCK_EDIT_VERSION,
+  LOCK_EDIT_COMMIT,
+  LOCK_EDIT_SOURCE_REV,
+  LOCK_EDIT_MANIFEST_REV,
+  LOCK_EDIT_DEP_RENAMED,
+  LOCK_EDIT_DEP_DROPPED,
+  LOCK_EDIT_DEPS_REORDERED,
+  LOCK_EDIT_ENTRY_DROPPED,
+} lock_edit_t;
+
+typedef struct {
+  const c8* name;
+  lock_edit_t edit;
+  bool agrees;
+} agree_test_t;
+
+static const agree_test_t agree_tests [] = {
+  { .name = "identical",      .edit = LOCK_EDIT_NONE,           .agrees = true },
+  { .name = "deps_reordered", .edit = LOCK_EDIT_DEPS_REORDERED, .agrees = true },
+  { .name = "version",        .edit = LOCK_EDIT_VERSION },
+  { .name = "commit",         .edit = LOCK_EDIT_COMMIT },
+  { .name = "source_rev",     .edit = LOCK_EDIT_SOURCE_REV },
+  { .name = "manifest_rev",   .edit = LOCK_EDIT_MANIFEST_REV },
+  { .name = "dep_renamed",    .edit = LOCK_EDIT_DEP_RENAMED },
+  { .name = "dep_dropped",    .edit = LOCK_EDIT_DEP_DROPPED },
+  { .name = "entry_dropped",  .edit = LOCK_EDIT_ENTRY_DROPPED },
+};
+
+static const test_t agree_fixture = {
+  .name = "agree",
+  .deps = {
+    {
+      .name = "A",
+      .version = "1.0.0",
+      .commit = "abc123",
+      .kind = SPN_PKG_SOURCE_INDEX,
+      .source_url = "https://github.com/example/a",
+      .source_rev = "aaa111",
+      .manifest_url = "https://github.com/example/a-recipe",
+      .manifest_rev = "bbb222",
+      .deps = { "B", "C" },
+    },
+    { .name = "B", .version = "2.0.0", .commit = "def456", .kind = SPN_PKG_SOURCE_INDEX },
+    { .name = "C", .version = "3.0.0", .commit = "fed789", .kind = SPN_PKG_SOURCE_INDEX },
+  },
+};
+
+sp_test_each(lock, agrees, agree_test_t, agree_tests) {
+  sp_mem_t mem = sp_test_arena(t);
+
+  spn_lock_file_t a = sp_zero;
+  spn_lock_file_t b = sp_zero;
+  build_lock(mem, &agree_fixture, &a);
+  build_lock(mem, &agree_fixture, &b);
+
+  sp_str_t name = sp_str_lit("A");
+  sp_str_t leaf = sp_str_lit("C");
+  spn_lock_entry_t* entry = sp_ht_getp(b.entries, name);
+  sp_must(t, entry != SP_NULLPTR);
+  switch (it->edit) {
+    case LOCK_EDIT_NONE: {
+      break;
+    }
+    case LOCK_EDIT_VERSION: {
+      entry->version = spn_semver_from_str(sp_str_lit("1.0.1"));
+      break;
+    }
+    case LOCK_EDIT_COMMIT: {
+      entry->commit = sp_str_lit("abc124");
+      break;
+    }
+    case LOCK_EDIT_SOURCE_REV: {
+      entry->source.rev = sp_str_lit("aaa112");
+      break;
+    }
+    case LOCK_EDIT_MANIFEST_REV: {
+      entry->manifest.rev = sp_str_lit("bbb223");
+      break;
+    }
+    case LOCK_EDIT_DEP_RENAMED: {
+      entry->deps[1] = sp_str_lit("D");
+      break;
+    }
+    case LOCK_EDIT_DEP_DROPPED: {
+      sp_da_pop(entry->deps);
+      break;
+    }
+    case LOCK_EDIT_DEPS_REORDERED: {
+      sp_str_t first = entry->deps[0];
+      entry->deps[0] = entry->deps[1];
+      entry->deps[1] = first;
+      break;
+    }
+    case LOCK_EDIT_ENTRY_DROPPED: {
+      sp_ht_erase(b.entries, leaf);
+      break;
+    }
+  }
+
+  sp_expect_eq(t, spn_lock_file_agrees(&a, &b), it->agrees);
+  sp_expect_eq(t, spn_lock_file_agrees(&b, &a), it->agrees);
+  return SP_OK;
+}
@@ -0,0 +1,107 @@
+#include "spn_test.h"
+
+#include "lock/lock.h"
+#include "lock/memo.h"
+#include "semver/convert.h"
+
+typedef enum {
+  MEMO_THEN_NOTHING,
+  MEMO_THEN_OTHER_KEY,
+  MEMO_THEN_EDIT_INPUT,
+  MEMO_THEN_CREATE_INPUT,
+  MEMO_THEN_REMOVE_INPUT,
+  MEMO_THEN_REMOVE_MEMO,
+} memo_then_t;
+
+typedef struct {
+  const c8* name;
+  memo_then_t then;
+  bool hit;
+} memo_test_t;
+
+static const memo_test_t tests [] = {
+  { .name = "unchanged",       .then = MEMO_THEN_NOTHING,      .hit = true },
+  { .name = "other_key",       .then = MEMO_THEN_OTHER_KEY },
+  { .name = "input_edited",    .then = MEMO_THEN_EDIT_INPUT },
+  { .name = "input_appeared",  .then = MEMO_THEN_CREATE_INPUT },
+  { .name = "input_removed",   .then = MEMO_THEN_REMOVE_INPUT },
+  { .name = "never_written",   .then = MEMO_THEN_REMOVE_MEMO },
+};
+
+sp_test_each(lock_memo, load, memo_test_t, tests) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_str_t dir = sp_test_dir(t);
+  sp_fs_create_dir(dir);
+
+  sp_str_t manifest = sp_fs_join_path(mem, dir, sp_str_lit("spn.toml"));
+  sp_str_t absent = sp_fs_join_path(mem, dir, sp_str_lit("absent.toml"));
+  sp_must_eq(t, sp_fs_create_file_str(manifest, sp_str_lit("[package]\nname = \"root\"\n")), SP_OK);
+
+  spn_lock_file_t lock = sp_zero;
+  spn_lock_file_init(mem, &lock);
+  spn_lock_entry_t entry = {
+    .name = sp_str_lit("core/A"),
+    .version = spn_semver_from_str(sp_str_lit("1.2.0")),
+    .commit = sp_str_lit("abc123"),
+    .kind = SPN_PKG_SOURCE_INDEX,
+  };
+  sp_da_init(mem, entry.deps);
+  sp_da_init(mem, entry.dependents);
+  sp_ht_insert(lock.entries, entry.name, entry);
+
+  spn_lock_memo_t memo = sp_zero;
+  spn_lock_memo_init(mem, &memo, sp_str_lit("0123abcd"));
+  spn_lock_memo_add_input(&memo, manifest);
+  spn_lock_memo_add_input(&memo, absent);
+  spn_lock_memo_add_input(&memo, manifest);
+  sp_expect_eq(t, sp_da_size(memo.inputs), 2);
+  sp_expect(t, sp_str_empty(memo.inputs[1].digest));
+
+  sp_str_t path = spn_lock_memo_path(mem, dir, memo.key);
+  sp_must_eq(t, spn_lock_memo_save(&memo, &lock, path), SPN_OK);
+
+  sp_str_t key = memo.key;
+  switch (it->then) {
+    case MEMO_THEN_NOTHING: {
+      break;
+    }
+    case MEMO_THEN_OTHER_KEY: {
+      key = sp_str_lit("4567ef01");
+      break;
+    }
+    case MEMO_THEN_EDIT_INPUT: {
+      sp_must_eq(t, sp_fs_create_file_str(manifest, sp_str_lit("[package]\nname = \"renamed\"\n")), SP_OK);
+      break;
+    }
+    case MEMO_THEN_CREATE_INPUT: {
+      sp_must_eq(t, sp_fs_create_file_str(absent, sp_str_lit("")), SP_OK);
+      break;
+    }
+    case MEMO_THEN_REMOVE_INPUT: {
+      sp_fs_remove_file(manifest);
+      break;
+    }
+    case MEMO_THEN_REMOVE_MEMO: {
+      sp_fs_remove_file(path);
+      break;
+    }
+  }
+
+  spn_lock_memo_t loaded = sp_zero;
+  spn_lock_memo_init(mem, &loaded, key);
+  spn_err_t err = spn_lock_memo_load(&loaded, path);
+  sp_expect_eq(t, err == SPN_OK, it->hit);
+  sp_must_eq(t, loaded.lock.some, it->hit);
+  if (!it->hit) {
+    sp_expect_eq(t, sp_da_size(loaded.inputs), 0);
+    return SP_OK;
+  }
+
+  sp_expect_eq(t, sp_da_size(loaded.inputs), 2);
+  sp_expect_eq(t, sp_ht_size(loaded.lock.value.entries), 1);
+  spn_lock_entry_t* got = sp_ht_getp(loaded.lock.value.entries, sp_str_lit("core/A"));
+  sp_must(t, got != SP_NULLPTR);
+  sp_expect_eq(t, got->version.minor, 2);
+  sp_expect_str_eq(t, got->commit, entry.commit);
+  return SP_OK;
+}
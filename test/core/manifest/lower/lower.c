@@ -134,6 +134,8 @@ typedef struct {
   gated_t include [4];
   gated_t build_source [4];
   gated_t build_include [4];
+  spn_wasm_limits_t build_wasm;
+  spn_wasm_limits_t configure_wasm;
   const c8* define [8];
   gated_t system_deps [8];
   issue_t issues [7];
@@ -487,6 +489,12 @@ static const test_t tests [] = {
     .build_source = { { "b.c", .tree = SPN_TREE_MANIFEST }, { "c.c", .when = "os = \"linux\"" } },
     .build_include = { { "inc", .tree = SPN_TREE_MANIFEST } },
   },
+  {
+    .name = "script_limits",
+    .manifest = "script_limits",
+    .build_wasm = { .stack = 65536, .heap = 1048576 },
+    .configure_wasm = { .heap = 4194304 },
+  },
   {
     .name = "validate_metaprogram_when_option",
     .manifest = "validate_metaprogram_when_option",
@@ -1059,6 +1067,10 @@ sp_test_each(lower, cases, test_t, tests) {
   check_gated_paths(t, pkg.gated.include, it->include);
   check_gated_paths(t, pkg.build.gated.source, it->build_source);
   check_gated_paths(t, pkg.build.gated.include, it->build_include);
+  sp_expect_eq(t, pkg.build.wasm.stack, it->build_wasm.stack);
+  sp_expect_eq(t, pkg.build.wasm.heap, it->build_wasm.heap);
+  sp_expect_eq(t, pkg.configure.wasm.stack, it->configure_wasm.stack);
+  sp_expect_eq(t, pkg.configure.wasm.heap, it->configure_wasm.heap);
 
   // Targets
   sp_try(check_targets(t, pkg.libs,     it->libs,     SP_CARR_LEN(it->libs),     SPN_TARGET_KIND_LIB));
@@ -12,6 +12,7 @@
 #include "index/index.h"
 #include "index/types.h"
 #include "intern/intern.h"
+#include "lock/lock.h"
 #include "pkg/id.h"
 #include "resolve/dump.h"
 #include "resolve/resolve.h"
@@ -70,6 +71,15 @@ static resolve_result_t execute_fixture(const fx_config_t* config, const spn_pkg
     .abi = SPN_ABI_GNU,
   }, root->config, config->budget);
 
+  // A fixture with a lock resolves through it; a lock the walk rejects falls
+  // back to a full solve, same as the resolve step
+  spn_lock_file_t lock = sp_zero;
+  sp_str_t lock_path = sp_fs_join_path(mem, dir, sp_str_lit("spn.lock"));
+  if (sp_fs_is_target_file(lock_path)) {
+    lock = spn_lock_file_load(mem, lock_path, SP_NULLPTR);
+    resolver.lock = &lock;
+  }
+
   resolve_result_t result = sp_zero_s(resolve_result_t);
   result.intern = intern;
   spn_resolve_query_init(mem, &result.query);
@@ -78,7 +88,15 @@ static resolve_result_t execute_fixture(const fx_config_t* config, const spn_pkg
     .source = SPN_PKG_SOURCE_ROOT,
   });
 
-  spn_resolve_from_solver(&resolver, &result.query);
+  if (spn_resolve_from_solver(&resolver, &result.query) && resolver.lock) {
+    resolver.lock = SP_NULLPTR;
+    spn_resolve_query_init(mem, &result.query);
+    spn_resolve_query_add(&result.query, (spn_requested_dep_t) {
+      .qualified = sp_str_view(root_qualified),
+      .source = SPN_PKG_SOURCE_ROOT,
+    });
+    spn_resolve_from_solver(&resolver, &result.query);
+  }
   return result;
 }
 
@@ -56,6 +56,11 @@ static const builtins_test_t tests [] = {
 };
 
 static sp_err_t builtins_catalog(sp_test_t* t, spn_toolchain_catalog_t* catalog) {
+  spn_toolchain_catalog_init_builtins(catalog, sp_test_arena(t));
+  return SP_OK;
+}
+
+static sp_err_t builtins_json_catalog(sp_test_t* t, spn_toolchain_catalog_t* catalog) {
   sp_mem_t mem = sp_test_arena(t);
   sp_str_t path = test_repo_path(mem, sp_str_lit("source/core/toolchain/toolchains.json"));
 
@@ -65,6 +70,14 @@ static sp_err_t builtins_catalog(sp_test_t* t, spn_toolchain_catalog_t* catalog)
   return SP_OK;
 }
 
+static void builtins_expect_launcher(sp_test_t* t, spn_toolchain_launcher_t a, spn_toolchain_launcher_t b) {
+  sp_expect(t, sp_str_equal(a.program.prefix, b.program.prefix));
+  sp_expect_eq(t, sp_da_size(a.args), sp_da_size(b.args));
+  sp_for(it, sp_min(sp_da_size(a.args), sp_da_size(b.args))) {
+    sp_expect(t, sp_str_equal(a.args[it], b.args[it]));
+  }
+}
+
 static bool builtins_is_sha256(sp_str_t str) {
   return str.len == 64 && test_str_is_hex(str);
 }
@@ -142,3 +155,40 @@ sp_test(builtins, well_formed) {
 
   return SP_OK;
 }
+
+// The generated tables must say exactly what toolchains.json says
+sp_test(builtins, match_json) {
+  spn_toolchain_catalog_t generated = sp_zero;
+  spn_toolchain_catalog_t parsed = sp_zero;
+  if (builtins_catalog(t, &generated)) return SP_ERR;
+  if (builtins_json_catalog(t, &parsed)) return SP_ERR;
+  sp_must_eq(t, fixture_catalog_size(&generated), fixture_catalog_size(&parsed));
+
+  sp_for(index, fixture_catalog_size(&parsed)) {
+    spn_toolchain_info_t* a = fixture_catalog_at(&generated, index);
+    spn_toolchain_info_t* b = fixture_catalog_at(&parsed, index);
+    sp_expect(t, sp_str_equal(a->name, b->name));
+    sp_expect(t, sp_str_equal(a->version, b->version));
+    sp_expect_eq(t, (u32)a->driver, (u32)b->driver);
+    sp_expect_eq(t, (u32)a->source, (u32)b->source);
+    builtins_expect_launcher(t, a->compiler, b->compiler);
+    builtins_expect_launcher(t, a->cxx, b->cxx);
+    builtins_expect_launcher(t, a->linker, b->linker);
+    builtins_expect_launcher(t, a->archiver, b->archiver);
+
+    sp_must_eq(t, sp_da_size(a->hosts), sp_da_size(b->hosts));
+    sp_da_for(b->hosts, it) {
+      sp_expect(t, fixture_triple_equal(a->hosts[it].triple, b->hosts[it].triple));
+      sp_expect(t, sp_str_equal(a->hosts[it].artifact.url, b->hosts[it].artifact.url));
+      sp_expect(t, sp_str_equal(a->hosts[it].artifact.sha256, b->hosts[it].artifact.sha256));
+      sp_expect(t, sp_str_equal(a->hosts[it].artifact.mirror_list, b->hosts[it].artifact.mirror_list));
+    }
+
+    sp_must_eq(t, sp_da_size(a->targets), sp_da_size(b->targets));
+    sp_da_for(b->targets, it) {
+      sp_expect(t, fixture_triple_equal(a->targets[it], b->targets[it]));
+    }
+  }
+
+  return SP_OK;
+}
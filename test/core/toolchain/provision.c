@@ -28,6 +28,7 @@ typedef struct {
   bool no_sha;
   const c8* mirror;
   bool fetch_fail;
+  bool trickle;
   const c8* fail_url_containing;
   const c8* store_dir;
   bool dest_file;
@@ -48,6 +49,7 @@ typedef struct {
   sp_str_t last_url;
   sp_str_t fail_url_containing;
   bool fail;
+  bool trickle;
 } fetch_stub_t;
 
 static const provision_test_t tests [] = {
@@ -69,6 +71,15 @@ static const provision_test_t tests [] = {
     .toolchains = { "A", "B" },
     .expect = { .calls = 1 },
   },
+  {
+    .name = "slow_download_is_hashed_in_flight",
+    .trickle = true,
+    .expect = {
+      .calls = 1,
+      .root_in_store = true,
+      .extracted = true,
+    },
+  },
   {
     .name = "sha_mismatch_fails_and_leaves_no_store_entry",
     .sha = "beefbeefbeefbeefbeefbeefbeefbeefbeefbeefbeefbeefbeefbeefbeefbeef",
@@ -189,7 +200,24 @@ static spn_err_t fetch_stub(sp_str_t url, sp_str_t dest, void* user_data) {
   stub->last_url = sp_str_copy(stub->mem, url);
   if (stub->fail) return SPN_ERROR;
   if (!sp_str_empty(stub->fail_url_containing) && sp_str_contains(url, stub->fail_url_containing)) return SPN_ERROR;
-  if (sp_fs_copy(stub->tarball, dest)) return SPN_ERROR;
+
+  // Written into dest the way curl -o does, which may be a fifo. A trickle
+  // arrives in pieces, each through its own open
+  sp_str_t bytes = sp_zero;
+  if (sp_io_read_file(stub->mem, stub->tarball, &bytes)) return SPN_ERROR;
+  u32 piece = stub->trickle ? bytes.len / 4 + 1 : bytes.len;
+  for (u32 offset = 0; offset < bytes.len; offset += piece) {
+    sp_sys_fd_t fd = SP_SYS_INVALID_FD;
+    if (sp_sys_open_s(sp_sys_get_root(0), dest, SP_SYS_OPEN_MODE_WO, SP_SYS_OPEN_CREATE | SP_SYS_OPEN_APPEND, &fd)) return SPN_ERROR;
+    sp_io_file_writer_t io;
+    sp_io_file_writer_from_fd(&io, fd, SP_IO_CLOSE_MODE_AUTO);
+    io.pos = io.size;
+    sp_io_write_str(&io.base, sp_str_sub(bytes, offset, sp_min(piece, bytes.len - offset)), SP_NULLPTR);
+    sp_io_file_writer_close(&io);
+    if (stub->trickle) {
+      sp_os_sleep_ms(5);
+    }
+  }
   return SPN_OK;
 }
 
@@ -206,6 +234,7 @@ sp_test_each(provision, store, provision_test_t, tests, .setup = spn_test_ctx_se
   fetch_stub_t stub = sp_zero;
   stub.mem = mem;
   stub.fail = it->fetch_fail;
+  stub.trickle = it->trickle;
   if (it->fail_url_containing) {
     stub.fail_url_containing = sp_str_view(it->fail_url_containing);
   }
@@ -360,3 +389,64 @@ sp_test(provision, store_path_is_content_addressed) {
   sp_expect_str_eq(t, spn_toolchain_store_path(&store, artifact), sp_fs_join_path(mem, store.dir, sp_str_lit("cafe")));
   return SP_OK;
 }
+
+static sp_str_t provision_tarball(sp_test_t* t, sp_str_t dir, const c8* version, const c8* c) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_str_t tree = sp_fs_join_path(mem, dir, sp_str_view(version));
+  provision_create(mem, tree, "A/B", "B");
+  provision_create(mem, tree, "A/lib/C", c);
+
+  sp_str_t tarball = sp_fs_join_path(mem, dir, sp_fmt(mem, "{}.tar.gz", sp_fmt_cstr(version)).value);
+  sp_ps_output_t tar = sp_ps_run(mem, (sp_ps_config_t) {
+    .command = sp_str_lit("tar"),
+    .args = { sp_str_lit("czf"), tarball, sp_str_lit("-C"), tree, sp_str_lit("A") },
+  });
+  sp_must_eq(t, 0, tar.status.exit_code);
+  return tarball;
+}
+
+static sp_sys_file_meta_t provision_meta(sp_mem_t mem, sp_str_t root, const c8* file) {
+  sp_sys_file_meta_t meta = sp_zero;
+  sp_sys_get_path_metadata_s(sp_sys_get_root(0), sp_fs_join_path(mem, root, sp_str_view(file)), &meta);
+  return meta;
+}
+
+sp_test(provision, versions_share_identical_files, .setup = spn_test_ctx_setup) {
+  sp_mem_t mem = sp_test_arena(t);
+  sp_str_t dir = sp_test_dir(t);
+
+  fetch_stub_t stub = { .mem = mem };
+  spn_toolchain_store_t store = {
+    .mem = mem,
+    .dir = sp_fs_join_path(mem, dir, sp_str_lit("store")),
+    .fetch = fetch_stub,
+    .fetch_user_data = &stub,
+  };
+  sp_fs_create_dir(store.dir);
+
+  const c8* versions [] = { "v1", "v2" };
+  const c8* contents [] = { "C1", "C2" };
+  sp_str_t roots [2] = sp_zero;
+  sp_for(v, 2) {
+    stub.tarball = provision_tarball(t, dir, versions[v], contents[v]);
+    sp_str_t sha = sp_zero;
+    sp_must_eq(t, (u32)SPN_OK, (u32)spn_sha256_file(mem, stub.tarball, &sha));
+
+    spn_toolchain_info_t toolchain = fixture_local_toolchain("A", "A");
+    toolchain.source = SPN_TOOLCHAIN_SOURCE_DISTRIBUTION;
+    spn_opt_artifact_t artifact = sp_zero;
+    sp_opt_set(artifact, ((spn_artifact_t) {
+      .url = sp_fmt(mem, "https://tc.example.com/{}", sp_fmt_str(sp_fs_get_name(stub.tarball))).value,
+      .sha256 = sha,
+    }));
+    sp_must_eq(t, (u32)SPN_OK, (u32)spn_toolchain_provision(&store, &toolchain, artifact, &roots[v]));
+  }
+
+  sp_expect(t, !sp_str_equal(roots[0], roots[1]));
+  sp_expect_str_eq_c(t, test_read_file(mem, sp_fs_join_path(mem, roots[1], sp_str_lit("lib/C"))), "C2");
+
+  // B is one inode across both versions; C differs, so it can't be
+  sp_expect_eq(t, provision_meta(mem, roots[0], "B").id, provision_meta(mem, roots[1], "B").id);
+  sp_expect_ne(t, provision_meta(mem, roots[0], "lib/C").id, provision_meta(mem, roots[1], "lib/C").id);
+  return SP_OK;
+}
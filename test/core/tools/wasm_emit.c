@@ -1,5 +1,10 @@
 #include "wasm_emit.h"
 
+#include "sp/sp_test.h"
+#include "spn/core.h"
+#include "dag/wasi.h"
+#include "wasm_export.h"
+
 #define WASM_OP_I32_CONST 0x41
 #define WASM_OP_I64_CONST 0x42
 #define WASM_OP_I32_LOAD 0x28
@@ -332,3 +337,20 @@ sp_str_t wasm_emit_module(sp_mem_t mem, const wasm_emit_fn_t* fns, u32 count) {
 
   return sp_io_dyn_mem_writer_as_str(&out);
 }
+
+static sp_test_once_t runtime_once;
+
+static sp_err_t runtime_bring_up(void* user) {
+  SP_UNUSED(user);
+  if (!wasm_runtime_init()) {
+    return SP_ERR;
+  }
+  if (spn_dag_wasi_install() != SPN_OK) {
+    return SP_ERR;
+  }
+  return SP_OK;
+}
+
+sp_err_t wasm_emit_runtime_init() {
+  return sp_test_once(&runtime_once, runtime_bring_up, SP_NULLPTR);
+}
@@ -26,3 +26,6 @@ typedef struct {
 } wasm_emit_fn_t;
 
 sp_str_t wasm_emit_module(sp_mem_t mem, const wasm_emit_fn_t* fns, u32 count);
+
+// Brings WAMR up once per process, with the DAG's WASI shims installed
+sp_err_t wasm_emit_runtime_init();
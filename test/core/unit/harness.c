@@ -2,8 +2,8 @@
 
 #include "paths/paths.h"
 
-void spn_wasm_script_init(spn_wasm_script_t* script, sp_str_t module) {
-  *script = (spn_wasm_script_t) { .path = module };
+void spn_wasm_script_init(spn_wasm_script_t* script, sp_str_t module, spn_wasm_limits_t limits) {
+  *script = (spn_wasm_script_t) { .path = module, .limits = limits };
 }
 
 sp_da(sp_str_t) test_str_list(sp_mem_t mem, const c8* const* items, u32 max) {
@@ -0,0 +1,235 @@
+#include "spn_test.h"
+
+#include "external/wasm/module.h"
+#include "wasm_emit.h"
+#include "wasm_export.h"
+
+#define WASM_MODULE_STACK_SIZE (64 * 1024)
+#define WASM_MODULE_HEAP_SIZE (64 * 1024)
+
+typedef enum {
+  WASM_MODULE_NONE,
+  WASM_MODULE_RUN,
+  WASM_MODULE_OTHER,
+  WASM_MODULE_GARBAGE,
+  WASM_MODULE_MISSING,
+} wasm_module_kind_t;
+
+typedef struct {
+  const c8* name;
+  wasm_module_kind_t first;
+  wasm_module_kind_t second;
+
+  struct {
+    spn_err_t err;
+    bool shared;
+    u32 size;
+  } expect;
+} wasm_module_test_t;
+
+sp_test_suite(wasm_module, .serial = true);
+
+static const wasm_module_test_t tests [] = {
+  { .name = "same_bytes",      .first = WASM_MODULE_RUN, .second = WASM_MODULE_RUN,     .expect = { .shared = true, .size = 1 } },
+  { .name = "different_bytes", .first = WASM_MODULE_RUN, .second = WASM_MODULE_OTHER,   .expect = { .size = 2 } },
+  { .name = "garbage",         .first = WASM_MODULE_RUN, .second = WASM_MODULE_GARBAGE, .expect = { .err = SPN_ERR_WASM_MODULE_LOAD_FAILED, .size = 1 } },
+  { .name = "missing",         .first = WASM_MODULE_RUN, .second = WASM_MODULE_MISSING, .expect = { .err = SPN_ERR_WASM_READ_FAILED, .size = 1 } },
+};
+
+static sp_str_t write_module(sp_mem_t mem, sp_str_t dir, const c8* name, wasm_module_kind_t kind) {
+  sp_str_t path = sp_fs_join_path(mem, dir, sp_cstr_as_str(name));
+  // Nothing is preopened, so the stat only fails with an errno
+  static const wasm_emit_op_t ops [] = { { WASM_EMIT_STAT, "H" } };
+  wasm_emit_fn_t fns [] = {
+    { .name = "run",   .ops = ops, .count = sp_carr_len(ops) },
+    { .name = "other", .ops = ops, .count = sp_carr_len(ops) },
+  };
+
+  switch (kind) {
+    case WASM_MODULE_RUN: {
+      sp_fs_create_file_str(path, wasm_emit_module(mem, fns, 1));
+      break;
+    }
+    case WASM_MODULE_OTHER: {
+      sp_fs_create_file_str(path, wasm_emit_module(mem, fns, 2));
+      break;
+    }
+    case WASM_MODULE_GARBAGE: {
+      sp_fs_create_file_str(path, sp_str_lit("not a wasm module"));
+      break;
+    }
+    case WASM_MODULE_MISSING:
+    case WASM_MODULE_NONE: {
+      break;
+    }
+  }
+  return path;
+}
+
+static spn_wasm_instance_t* instantiate(spn_wasm_modules_t* modules, spn_wasm_module_t* module) {
+  c8 error [128] = sp_zero;
+  spn_wasm_limits_t limits = { .stack = WASM_MODULE_STACK_SIZE, .heap = WASM_MODULE_HEAP_SIZE };
+  return spn_wasm_modules_instantiate(modules, module, SP_NULLPTR, 0, limits, error, sizeof(error));
+}
+
+static bool call_run(spn_wasm_instance_t* instance) {
+  wasm_exec_env_t env = wasm_runtime_create_exec_env(instance, WASM_MODULE_STACK_SIZE);
+  if (!env) {
+    return false;
+  }
+  wasm_function_inst_t fn = wasm_runtime_lookup_function(instance, "run");
+  wasm_val_t results [1] = sp_zero;
+  bool ok = fn && wasm_runtime_call_wasm_a(env, fn, 1, results, 0, SP_NULLPTR);
+  wasm_runtime_destroy_exec_env(env);
+  return ok;
+}
+
+sp_test_each(wasm_module, load, wasm_module_test_t, tests) {
+  if (!sp_str_empty(sp_os_env_get(sp_str_lit("SPN_TEST_SIM")))) {
+    return sp_test_skip(t, "wamr reads modules outside the sim filesystem");
+  }
+
+  sp_must_ok(t, wasm_emit_runtime_init());
+
+  sp_mem_t mem = sp_test_arena(t);
+  sp_str_t dir = sp_test_dir(t);
+  sp_fs_create_dir(dir);
+
+  spn_wasm_modules_t modules;
+  spn_wasm_modules_init(&modules, mem);
+
+  c8 error [128] = sp_zero;
+  spn_wasm_module_t* first = SP_NULLPTR;
+  spn_wasm_module_t* second = SP_NULLPTR;
+  sp_must_eq(t, spn_wasm_modules_load(&modules, write_module(mem, dir, "a.wasm", it->first), &first, error, sizeof(error)), SPN_OK);
+  sp_must(t, first != SP_NULLPTR);
+  sp_expect_eq(t, spn_wasm_modules_load(&modules, write_module(mem, dir, "b.wasm", it->second), &second, error, sizeof(error)), it->expect.err);
+  sp_expect_eq(t, spn_wasm_modules_size(&modules), it->expect.size);
+
+  if (it->expect.err) {
+    sp_expect(t, second == SP_NULLPTR);
+  }
+  else {
+    sp_expect_eq(t, first == second, it->expect.shared);
+
+    // Every load gets its own instance, however the module was found
+    spn_wasm_instance_t* a = instantiate(&modules, first);
+    spn_wasm_instance_t* b = instantiate(&modules, second);
+    sp_must(t, a != SP_NULLPTR);
+    sp_must(t, b != SP_NULLPTR);
+    sp_expect(t, a != b);
+    sp_expect(t, call_run(a));
+    sp_expect(t, call_run(b));
+    wasm_runtime_deinstantiate(a);
+    wasm_runtime_deinstantiate(b);
+  }
+
+  spn_wasm_modules_deinit(&modules);
+  sp_expect_eq(t, spn_wasm_modules_size(&modules), 0);
+  return SP_OK;
+}
+
+typedef struct {
+  sp_mem_t mem;
+  spn_wasm_modules_t modules;
+  spn_wasm_module_t* module;
+} wasm_pool_env_t;
+
+static spn_err_t wasm_pool_env_init(wasm_pool_env_t* env, sp_test_t* t) {
+  env->mem = sp_test_arena(t);
+  sp_fs_create_dir(sp_test_dir(t));
+  spn_wasm_modules_init(&env->modules, env->mem);
+
+  c8 error [128] = sp_zero;
+  sp_str_t path = write_module(env->mem, sp_test_dir(t), "a.wasm", WASM_MODULE_RUN);
+  return spn_wasm_modules_load(&env->modules, path, &env->module, error, sizeof(error));
+}
+
+static spn_wasm_script_t wasm_pool_script(wasm_pool_env_t* env) {
+  return (spn_wasm_script_t) { .state = SPN_WASM_SCRIPT_OPEN, .module = env->module };
+}
+
+// What a call does: take an idle instance or make one, run, put it back
+static bool wasm_pool_call(wasm_pool_env_t* env, spn_wasm_script_t* script) {
+  spn_wasm_runner_t* runner = spn_wasm_script_take(script);
+  if (!runner) {
+    spn_wasm_instance_t* instance = instantiate(&env->modules, script->module);
+    if (!instance) {
+      return false;
+    }
+    sp_mem_arena_t* arena = sp_mem_arena_new(sp_mem_os_new());
+    runner = sp_alloc_type(sp_mem_arena_as_allocator(arena), spn_wasm_runner_t);
+    runner->arena = arena;
+    runner->instance = instance;
+    runner->env = wasm_runtime_create_exec_env(instance, WASM_MODULE_STACK_SIZE);
+    spn_wasm_script_adopt(script, runner);
+  }
+  bool ok = call_run(runner->instance);
+  spn_wasm_script_put(script, runner);
+  return ok;
+}
+
+sp_test(wasm_module, trim_then_instantiate) {
+  if (!sp_str_empty(sp_os_env_get(sp_str_lit("SPN_TEST_SIM")))) {
+    return sp_test_skip(t, "wamr reads modules outside the sim filesystem");
+  }
+  sp_must_ok(t, wasm_emit_runtime_init());
+
+  wasm_pool_env_t env = sp_zero;
+  sp_must_eq(t, wasm_pool_env_init(&env, t), SPN_OK);
+  spn_wasm_script_t script = wasm_pool_script(&env);
+
+  sp_expect(t, wasm_pool_call(&env, &script));
+  sp_expect(t, wasm_pool_call(&env, &script));
+  sp_expect_eq(t, script.num_runners, 1);
+
+  spn_wasm_script_trim(&script);
+  sp_expect_eq(t, script.num_runners, 0);
+  sp_expect(t, script.idle == SP_NULLPTR);
+
+  // The module outlives its instances, so the next call instantiates again
+  sp_expect(t, wasm_pool_call(&env, &script));
+  sp_expect_eq(t, script.num_runners, 1);
+  sp_expect_eq(t, spn_wasm_modules_size(&env.modules), 1);
+
+  spn_wasm_script_trim(&script);
+  spn_wasm_modules_deinit(&env.modules);
+  return SP_OK;
+}
+
+sp_test(wasm_module, last_release_trims) {
+  if (!sp_str_empty(sp_os_env_get(sp_str_lit("SPN_TEST_SIM")))) {
+    return sp_test_skip(t, "wamr reads modules outside the sim filesystem");
+  }
+  sp_must_ok(t, wasm_emit_runtime_init());
+
+  wasm_pool_env_t env = sp_zero;
+  sp_must_eq(t, wasm_pool_env_init(&env, t), SPN_OK);
+  spn_wasm_scripts_t scripts = {
+    .configure = wasm_pool_script(&env),
+    .build = wasm_pool_script(&env),
+  };
+
+  spn_wasm_scripts_retain(&scripts);
+  spn_wasm_scripts_retain(&scripts);
+  sp_expect(t, wasm_pool_call(&env, &scripts.configure));
+  sp_expect(t, wasm_pool_call(&env, &scripts.build));
+
+  spn_wasm_scripts_release(&scripts);
+  sp_expect_eq(t, scripts.configure.num_runners, 1);
+  sp_expect_eq(t, scripts.build.num_runners, 1);
+
+  // An instance in the middle of a call isn't idle, so it survives the trim
+  spn_wasm_runner_t* busy = spn_wasm_script_take(&scripts.build);
+  sp_must(t, busy != SP_NULLPTR);
+  spn_wasm_scripts_release(&scripts);
+  sp_expect_eq(t, scripts.configure.num_runners, 0);
+  sp_expect_eq(t, scripts.build.num_runners, 1);
+
+  spn_wasm_script_put(&scripts.build, busy);
+  spn_wasm_scripts_trim(&scripts);
+  sp_expect_eq(t, scripts.build.num_runners, 0);
+
+  spn_wasm_modules_deinit(&env.modules);
+  return SP_OK;
+}
@@ -0,0 +1,114 @@
+#include "spn_test.h"
+
+#include "dag/dag.h"
+#include "paths/paths.h"
+#include "watch/watch.h"
+
+#if defined(SP_LINUX)
+
+typedef struct {
+  const c8* name;
+  const c8* path;
+
+  struct {
+    bool rebuild;
+    bool manifest;
+  } expect;
+} watch_test_t;
+
+static const watch_test_t tests [] = {
+  { .name = "source_edited",   .path = "src/main.c",            .expect = { .rebuild = true } },
+  { .name = "manifest_edited", .path = "spn.toml",              .expect = { .rebuild = true, .manifest = true } },
+  { .name = "quiet_rewritten", .path = "compile_commands.json" },
+  { .name = "hidden_file",     .path = "src/.main.c.swp" },
+  { .name = "hidden_dir",      .path = ".spn/build.jsonl" },
+  { .name = "skipped_dir",     .path = "build/main.o" },
+};
+
+typedef struct {
+  sp_mem_t mem;
+  sp_str_t root;
+  spn_path_roots_t roots;
+  spn_dag_file_cache_t files;
+  spn_watch_t watch;
+} watch_env_t;
+
+static sp_str_t watch_env_path(watch_env_t* env, const c8* path) {
+  return sp_fs_join_path(env->mem, env->root, sp_cstr_as_str(path));
+}
+
+static spn_err_t watch_env_init(watch_env_t* env, sp_test_t* t) {
+  sp_mem_zero(env, sizeof(*env));
+  env->mem = sp_test_arena(t);
+  sp_fs_create_dir(sp_test_dir(t));
+  env->root = sp_fs_canonicalize_path(env->mem, sp_test_dir(t));
+  env->roots.dirs[SPN_PATH_ROOT_PROJECT] = env->root;
+
+  const c8* dirs [] = { "src", ".spn", "build" };
+  sp_carr_for(dirs, it) {
+    sp_fs_create_dir(watch_env_path(env, dirs[it]));
+  }
+  sp_carr_for(tests, it) {
+    sp_fs_create_file_str(watch_env_path(env, tests[it].path), sp_str_lit("A"));
+  }
+
+  spn_dag_file_cache_init(&env->files, env->mem, &env->roots);
+
+  sp_da(sp_str_t) skip = sp_da_new(env->mem, sp_str_t);
+  sp_da_push(skip, watch_env_path(env, "build"));
+  sp_da(sp_str_t) quiet = sp_da_new(env->mem, sp_str_t);
+  sp_da_push(quiet, watch_env_path(env, "compile_commands.json"));
+
+  spn_try(spn_watch_init(&env->watch, (spn_watch_config_t) {
+    .mem = env->mem,
+    .roots = &env->roots,
+    .root = env->root,
+    .manifest = watch_env_path(env, "spn.toml"),
+    .skip = skip,
+    .quiet = quiet,
+  }));
+  env->watch.files = &env->files;
+  return SPN_OK;
+}
+
+sp_test_each(watch, drain, watch_test_t, tests) {
+  watch_env_t env;
+  sp_must_eq(t, watch_env_init(&env, t), SPN_OK);
+
+  spn_path_t path = spn_path_make(&env.roots, watch_env_path(&env, it->path));
+  sp_sys_file_meta_t meta = sp_zero;
+  sp_must_eq(t, spn_dag_file_cache_stat(&env.files, path, &meta), SPN_OK);
+  sp_expect_eq(t, meta.size, 1);
+
+  sp_must_eq(t, sp_fs_create_file_str(watch_env_path(&env, it->path), sp_str_lit("BB")), SP_OK);
+  spn_watch_changes_t changes = spn_watch_drain(&env.watch);
+  sp_expect_eq(t, changes.rebuild, it->expect.rebuild);
+  sp_expect_eq(t, changes.manifest, it->expect.manifest);
+
+  // Whatever the watch didn't see, settling forgets
+  spn_watch_settle(&env.watch);
+  sp_must_eq(t, spn_dag_file_cache_stat(&env.files, path, &meta), SPN_OK);
+  sp_expect_eq(t, meta.size, 2);
+
+  spn_watch_deinit(&env.watch);
+  return SP_OK;
+}
+
+sp_test(watch, new_dir_is_watched) {
+  watch_env_t env;
+  sp_must_eq(t, watch_env_init(&env, t), SPN_OK);
+  sp_expect(t, !spn_watch_drain(&env.watch).rebuild);
+
+  sp_fs_create_dir(watch_env_path(&env, "src/new"));
+  sp_expect(t, spn_watch_drain(&env.watch).rebuild);
+
+  sp_fs_create_file_str(watch_env_path(&env, "src/new/a.c"), sp_str_lit("A"));
+  spn_watch_changes_t changes = spn_watch_drain(&env.watch);
+  sp_expect(t, changes.rebuild);
+  sp_expect(t, changes.paths > 0);
+
+  spn_watch_deinit(&env.watch);
+  return SP_OK;
+}
+
+#endif
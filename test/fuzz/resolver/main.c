@@ -9,6 +9,7 @@
 #include "intern/intern.h"
 #include "pkg/id.h"
 #include "resolve/resolve.h"
+#include "semver/compare.h"
 #include "semver/parser.h"
 #include "spn/core.h"
 
@@ -71,10 +72,17 @@ spn_err_t spn_index_cache_get_package(spn_index_cache_t* cache, spn_pkg_name_t i
   return SPN_OK;
 }
 
+void spn_index_cache_prefetch(spn_index_cache_t* cache, spn_pkg_name_t* ids, u32 count) {
+
+}
+
 typedef struct {
   spn_resolve_query_t query;
   sp_intern_t* intern;
   spn_err_t err;
+  u64 candidates;
+  u64 pruned;
+  u64 time;
 } fz_result_t;
 
 static spn_dep_kind_t fz_root_dep_kind(spn_index_dep_kind_t kind) {
@@ -107,7 +115,7 @@ static bool fz_pkg_linked(fz_pkg_t* pkg) {
   return pkg->linkages.source || pkg->linkages.static_lib || pkg->linkages.shared;
 }
 
-static fz_result_t fz_execute(sp_mem_t mem, fz_universe_t* u, sp_intern_t* intern) {
+static fz_result_t fz_execute_ex(sp_mem_t mem, fz_universe_t* u, sp_intern_t* intern, bool learn) {
   fz_state = sp_zero_s(fz_state_t);
   sp_str_ht_init(mem, fz_state.cache);
 
@@ -232,6 +240,7 @@ static fz_result_t fz_execute(sp_mem_t mem, fz_universe_t* u, sp_intern_t* inter
 
   spn_resolver_t resolver = sp_zero;
   spn_resolver_init(&resolver, mem, intern, &cache, &registry, (spn_profile_info_t) { .linkage = u->profile.linkage }, config, u->profile.budget);
+  resolver.learn = learn;
 
   fz_result_t result = sp_zero_s(fz_result_t);
   result.intern = intern;
@@ -242,9 +251,16 @@ static fz_result_t fz_execute(sp_mem_t mem, fz_universe_t* u, sp_intern_t* inter
   });
 
   result.err = spn_resolve_from_solver(&resolver, &result.query);
+  result.candidates = resolver.stats.candidates;
+  result.pruned = resolver.stats.pruned;
+  result.time = result.query.time;
   return result;
 }
 
+static fz_result_t fz_execute(sp_mem_t mem, fz_universe_t* u, sp_intern_t* intern) {
+  return fz_execute_ex(mem, u, intern, true);
+}
+
 static bool fz_failed_with(fz_result_t* result, spn_err_t kind) {
   sp_da_for(result->query.errors, it) {
     if (result->query.errors[it].kind == kind) {
@@ -404,11 +420,138 @@ static fz_err_t fz_run_iteration(sp_fuzz_prng_t base, u64 iter) {
   return err;
 }
 
+///////////
+// BENCH //
+///////////
+// Solves the same big universes with and without learned incompatibilities.
+// Wherever neither side blew the budget, both must reach the same solution
+// (every pick, with the same edges) or fail with the same error; what differs
+// is how many candidates each side explored and how long it took.
+typedef struct {
+  u64 candidates;
+  u64 pruned;
+  u64 time;
+  u64 blown;
+} fz_bench_side_t;
+
+static bool fz_bench_same_pkg(spn_resolved_pkg_t* a, spn_resolved_pkg_t* b) {
+  if (sp_da_size(a->edges) != sp_da_size(b->edges)) {
+    return false;
+  }
+  sp_da_for(a->edges, it) {
+    spn_resolved_dep_t* x = &a->edges[it];
+    spn_resolved_dep_t* y = &b->edges[it];
+    if (!spn_pkg_id_eq(x->id, y->id) || x->kind != y->kind || x->edge != y->edge || x->private != y->private) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool fz_bench_same_err(spn_err_union_t a, spn_err_union_t b) {
+  if (a.kind != b.kind) {
+    return false;
+  }
+  switch (a.kind) {
+    case SPN_ERR_PKG_NO_MATCH:
+    case SPN_ERR_PKG_CONFLICT:
+    case SPN_ERR_PKG_CONFLICT_EXACT: {
+      return sp_str_equal(a.unsatisfiable.qualified, b.unsatisfiable.qualified)
+        && sp_str_equal(a.unsatisfiable.range, b.unsatisfiable.range)
+        && sp_str_equal(a.unsatisfiable.requester, b.unsatisfiable.requester)
+        && spn_semver_eq(a.unsatisfiable.requester_version, b.unsatisfiable.requester_version)
+        && spn_semver_eq(a.unsatisfiable.selected, b.unsatisfiable.selected);
+    }
+    default: {
+      return true;
+    }
+  }
+}
+
+// Both sides share an intern, so their ids compare directly
+static bool fz_bench_same(fz_result_t* a, fz_result_t* b) {
+  if (!a->err != !b->err) {
+    return false;
+  }
+  if (a->err) {
+    if (sp_da_size(a->query.errors) != sp_da_size(b->query.errors)) {
+      return false;
+    }
+    sp_da_for(a->query.errors, it) {
+      if (!fz_bench_same_err(a->query.errors[it], b->query.errors[it])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  if (sp_ht_size(a->query.result) != sp_ht_size(b->query.result)) {
+    return false;
+  }
+  sp_ht_for_kv(a->query.result, it) {
+    spn_resolved_pkg_t* other = sp_ht_getp(b->query.result, *it.key);
+    if (!other || !fz_bench_same_pkg(it.val, other)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static s32 fz_bench(sp_fuzz_prng_t base, u64 iters, sp_io_writer_t* out) {
+  fz_bench_side_t sides [2] = sp_zero;
+  u64 mismatched = 0;
+
+  for (u64 iter = 0; iter < iters; iter++) {
+    sp_mem_arena_t* arena = sp_mem_arena_new(sp_mem_os_new());
+    sp_mem_t mem = sp_mem_arena_as_allocator(arena);
+    sp_fuzz_prng_t prng = sp_fuzz_iter(base, iter);
+
+    fz_profile_t profile = fz_gen_profile(&prng);
+    profile.big = true;
+    profile.pkg_count = FZ_MAX_PKGS;
+    profile.out_degree = sp_fuzz_range(&prng, 2, 4);
+    profile.release_count = FZ_MAX_RELEASES;
+    profile.budget = 0;
+    fz_universe_t universe = fz_gen_universe(mem, &prng, profile);
+
+    sp_intern_t* intern = sp_intern_new(mem);
+    fz_result_t results [2] = sp_zero;
+    sp_carr_for(results, side) {
+      results[side] = fz_execute_ex(mem, &universe, intern, side == 0);
+      sides[side].candidates += results[side].candidates;
+      sides[side].pruned += results[side].pruned;
+      sides[side].time += results[side].time;
+      sides[side].blown += fz_failed_with(&results[side], SPN_ERR_RESOLVE_TOO_COMPLEX);
+    }
+
+    bool blown = fz_failed_with(&results[0], SPN_ERR_RESOLVE_TOO_COMPLEX) || fz_failed_with(&results[1], SPN_ERR_RESOLVE_TOO_COMPLEX);
+    if (!blown && !fz_bench_same(&results[0], &results[1])) {
+      sp_fmt_io(out, "bench: solutions differ (iter {})\n", sp_fmt_uint(iter));
+      mismatched++;
+    }
+
+    sp_mem_arena_destroy(arena);
+  }
+
+  const c8* names [2] = { "learning", "no learning" };
+  sp_carr_for(sides, side) {
+    sp_fmt_io(out, "bench: {}: {} candidates, {} pruned, {} budget blowups, {} ms\n",
+      sp_fmt_cstr(names[side]),
+      sp_fmt_uint(sides[side].candidates),
+      sp_fmt_uint(sides[side].pruned),
+      sp_fmt_uint(sides[side].blown),
+      sp_fmt_uint(sides[side].time / 1000000)
+    );
+  }
+  return mismatched ? 1 : 0;
+}
+
 typedef struct {
   s64 iters;
   s64 iter;
   const c8* seed;
   bool keep_going;
+  bool bench;
   s32 status;
 } fz_cli_t;
 
@@ -438,6 +581,11 @@ static sp_cli_result_t fz_cli_run(sp_cli_t* cli) {
   sp_fuzz_prng_t base = sp_fuzz_stream(names);
 
   sp_io_writer_t* out = sp_io_get_std_out();
+  if (config->bench) {
+    config->status = fz_bench(base, config->iters >= 0 ? (u64)config->iters : 64, out);
+    return SP_CLI_OK;
+  }
+
   u64 failures[FZ_ERR_COUNT] = sp_zero;
   u64 failed = 0;
 
@@ -513,6 +661,12 @@ s32 main(s32 num_args, c8** args) {
         .summary = "Run every iteration instead of stopping at the first failure",
         .ptr = &config.keep_going,
       },
+      {
+        .brief = 'b',
+        .name = "bench",
+        .summary = "Time the solver with and without learning on big universes instead of fuzzing",
+        .ptr = &config.bench,
+      },
     },
     .env = {
       { .name = "SPN_FUZZ_ENABLE",     .kind = SP_CLI_OPT_CSTR, .summary = "Must be set for the fuzzer to run at all" },
@@ -187,3 +187,28 @@ sp_test(freshness, output_deleted) {
     },
   });
 }
+
+sp_test(freshness, thin_archive_noop) {
+  return run_rebuild_test(t, (rebuild_test_t) {
+    .project = "test/integration/fixtures/freshness/dep",
+    .copy = { "packages/*" },
+    .first = {
+      .args = { "build", "-p", "debug", "--thin-archives" },
+      .expect.exists = { static_lib("spum"), store_file("bin/main") },
+    },
+    .rebuilds = {
+      {
+        .command = {
+          .args = { "build", "-p", "debug", "--thin-archives" },
+          .expect.events = {
+            { .event = SPN_EVENT_TARGET_BUILD_PASSED, .absent = true },
+            { .event = SPN_EVENT_LINK_PASSED, .absent = true },
+          },
+        },
+      },
+    },
+    .watches = {
+      { .file = static_lib("spum"), .mtime = REBUILD_MTIME_UNCHANGED },
+    },
+  });
+}
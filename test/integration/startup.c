@@ -0,0 +1,20 @@
+#include "harness.h"
+
+// Ceilings, not targets. The syscall count catches a subsystem creeping back
+// into the path every command takes; wall time is only reported, and checked
+// against its ceiling when SPN_TEST_STARTUP_TIMING is set
+sp_test(startup, help) {
+  return run_startup_test(t, (startup_test_t) {
+    .project = "test/integration/fixtures/startup/null",
+    .args = { "--help" },
+    .budget = { .ms = 50, .syscalls = 250 },
+  });
+}
+
+sp_test(startup, null_build) {
+  return run_startup_test(t, (startup_test_t) {
+    .project = "test/integration/fixtures/startup/null",
+    .args = { "build" },
+    .budget = { .ms = 500, .syscalls = 4000 },
+  });
+}
@@ -738,7 +738,7 @@ static sp_err_t expect_command_cc(sp_test_t* t, fixture_t* fixture, command_cc_t
   return SP_ERR;
 }
 
-static sp_ps_output_t run_spn_command(sp_test_t* t, fixture_t* fixture, const c8* output_mode, const c8* const* args, const c8* const* env) {
+static sp_ps_config_t spn_command_config(fixture_t* fixture, const c8* output_mode, const c8* const* args, const c8* const* env) {
   sp_mem_t mem = fixture->mem;
   sp_ps_config_t config = {
     .command = fixture->paths.spn,
@@ -783,7 +783,12 @@ static sp_ps_output_t run_spn_command(sp_test_t* t, fixture_t* fixture, const c8
       sp_ps_config_add_arg(mem, &config, sp_str_view(args[it]));
     }
   }
+  return config;
+}
 
+static sp_ps_output_t run_spn_command(sp_test_t* t, fixture_t* fixture, const c8* output_mode, const c8* const* args, const c8* const* env) {
+  sp_mem_t mem = fixture->mem;
+  sp_ps_config_t config = spn_command_config(fixture, output_mode, args, env);
   sp_ps_output_t output = sp_ps_run(mem, config);
   fixture->events = output.out;
   sp_test_kv(t, "command", ps_command_line(mem, &config));
@@ -984,6 +989,117 @@ sp_err_t run_command_test(sp_test_t* t, command_test_t test) {
   return run_command(t, &fixture, test);
 }
 
+// % time, seconds, usecs/call, calls, then errors only when there were any
+static u32 strace_total_calls(sp_str_t summary) {
+  u32 calls = 0;
+  sp_str_for_line(summary, it) {
+    sp_str_t line = sp_str_trim(it.line);
+    if (!sp_str_ends_with(line, sp_str_lit(" total"))) {
+      continue;
+    }
+    sp_for(column, 4) {
+      sp_str_pair_t pair = sp_str_cleave_c8(sp_str_trim(line), ' ');
+      if (column == 3) {
+        calls = sp_parse_u32(pair.first);
+      }
+      line = pair.second;
+    }
+  }
+  return calls;
+}
+
+// Pinned to one CPU, since spn sizes its pools to the machine and the budget
+// shouldn't depend on how many cores the runner has. Without strace and
+// taskset there's nothing to count with
+static bool can_count_syscalls(fixture_t* fixture) {
+  sp_ps_output_t probe = sp_ps_run(fixture->mem, (sp_ps_config_t) {
+    .command = sp_str_lit("taskset"),
+    .args = { sp_str_lit("-c"), sp_str_lit("0"), sp_str_lit("strace"), sp_str_lit("-V") },
+    .io = {
+      .in.mode = SP_PS_IO_MODE_NULL,
+      .err.mode = SP_PS_IO_MODE_NULL,
+    },
+  });
+  return !probe.status.exit_code;
+}
+
+// strace exits with the traced command's status, so the run is checked like
+// any other
+static sp_ps_output_t count_spn_syscalls(fixture_t* fixture, const c8* const* args, u32* calls) {
+  sp_mem_t mem = fixture->mem;
+  sp_ps_config_t spn = spn_command_config(fixture, "json", args, SP_NULLPTR);
+  sp_str_t summary = fixture_path(fixture, sp_str_lit("strace.txt"));
+  sp_ps_config_t config = {
+    .command = sp_str_lit("taskset"),
+    .args = {
+      sp_str_lit("-c"), sp_str_lit("0"),
+      sp_str_lit("strace"), sp_str_lit("-f"), sp_str_lit("-c"), sp_str_lit("-o"), summary,
+      spn.command,
+    },
+    .cwd = spn.cwd,
+    .io = spn.io,
+    .env = spn.env,
+  };
+  sp_carr_for(spn.args, it) {
+    if (sp_str_empty(spn.args[it])) break;
+    sp_ps_config_add_arg(mem, &config, spn.args[it]);
+  }
+  sp_da_for(spn.dyn_args, it) {
+    sp_ps_config_add_arg(mem, &config, spn.dyn_args[it]);
+  }
+
+  sp_ps_output_t output = sp_ps_run(mem, config);
+  *calls = strace_total_calls(test_read_file(mem, summary));
+  return output;
+}
+
+sp_err_t run_startup_test(sp_test_t* t, startup_test_t test) {
+  fixture_t fixture = sp_zero;
+  sp_try(fixture_init(t, &fixture));
+
+  // Wall time depends on the machine, so it only gates when a run opts in;
+  // the syscall count gates wherever strace is around to take it
+  bool timed = !sp_str_empty(sp_os_env_get(sp_str_lit("SPN_TEST_STARTUP_TIMING")));
+  bool counted = test.budget.syscalls && can_count_syscalls(&fixture);
+  if (!timed && !counted) {
+    return sp_test_skip(t, "no strace or taskset to count syscalls with, and SPN_TEST_STARTUP_TIMING is unset");
+  }
+
+  sp_try(prepare_test(t, &fixture, test.project, SP_NULLPTR));
+
+  // The first run pays for whatever spn sets up once and keeps; the budget is
+  // for every run after it
+  sp_ps_output_t output = run_spn_command(t, &fixture, "json", test.args, SP_NULLPTR);
+  sp_must_eq(t, test.rc, output.status.exit_code);
+
+  // Best of several, since a loaded machine only ever makes a run slower
+  u64 best = 0;
+  sp_for(it, SPN_TEST_STARTUP_RUNS) {
+    sp_tm_timer_t timer = sp_tm_start_timer();
+    output = run_spn_command(t, &fixture, "json", test.args, SP_NULLPTR);
+    u64 elapsed = sp_tm_read_timer(&timer);
+    sp_must_eq(t, test.rc, output.status.exit_code);
+    best = it ? sp_min(best, elapsed) : elapsed;
+  }
+  u64 ms = best / 1000000;
+  sp_test_kv(t, "ms", sp_fmt(fixture.mem, "{}", sp_fmt_uint(ms)).value);
+  sp_test_kv(t, "ms_budget", sp_fmt(fixture.mem, "{}", sp_fmt_uint(test.budget.ms)).value);
+  if (timed) {
+    sp_expect_le(t, ms, (u64)test.budget.ms);
+  }
+
+  if (counted) {
+    u32 calls = 0;
+    output = count_spn_syscalls(&fixture, test.args, &calls);
+    sp_must_eq(t, test.rc, output.status.exit_code);
+    sp_test_kv(t, "syscalls", sp_fmt(fixture.mem, "{}", sp_fmt_uint(calls)).value);
+    sp_test_kv(t, "syscalls_budget", sp_fmt(fixture.mem, "{}", sp_fmt_uint(test.budget.syscalls)).value);
+    sp_must(t, calls > 0);
+    sp_expect_le(t, calls, test.budget.syscalls);
+  }
+  return SP_OK;
+}
+
 static sp_err_t apply_rebuild_change(sp_test_t* t, fixture_t* fixture, rebuild_change_t change) {
   sp_carr_for(change.remove_files, it) {
     if (sp_str_empty(change.remove_files[it])) {
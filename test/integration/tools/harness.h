@@ -137,6 +137,20 @@ typedef struct {
   command_expect_t expect;
 } command_test_t;
 
+#define SPN_TEST_STARTUP_RUNS 5
+
+typedef struct {
+  u32 ms;
+  u32 syscalls;
+} startup_budget_t;
+
+typedef struct {
+  const c8* project;
+  const c8* args [SPN_TEST_COMMAND_MAX_ARGS];
+  s32 rc;
+  startup_budget_t budget;
+} startup_test_t;
+
 #define SPN_TEST_REBUILD_MAX_CHANGES 4
 #define SPN_TEST_REBUILD_MAX_STEPS 3
 #define SPN_TEST_REBUILD_MAX_WATCHES 4
@@ -241,6 +255,7 @@ sp_err_t test_when(sp_test_t* t, test_when_t when);
 sp_err_t run_command(sp_test_t* t, fixture_t* fixture, command_test_t test);
 sp_err_t run_command_test(sp_test_t* t, command_test_t test);
 sp_err_t run_rebuild_test(sp_test_t* t, rebuild_test_t test);
+sp_err_t run_startup_test(sp_test_t* t, startup_test_t test);
 sp_err_t run_actions(sp_test_t* t, fixture_t* fixture, const action_t* actions);
 sp_err_t run_test(sp_test_t* t, test_t test);
 sp_err_t run_opt_test(sp_test_t* t, opt_test_t test);
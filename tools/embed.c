@@ -4,6 +4,7 @@
 #include "sp/sp_elf.h"
 #include "sp/coff.h"
 #include "sp/macho.h"
+#include "sha256/sha256.h"
 
 typedef enum {
   EMBED_FORMAT_ELF,
@@ -128,6 +129,7 @@ typedef struct {
   sp_str_t path;
   sp_str_t symbol;
   u64 size;
+  u8 digest [32];
 } embed_entry_t;
 
 static sp_str_t embed_symbol_from_path(sp_mem_t mem, sp_str_t path) {
@@ -165,15 +167,34 @@ static sp_cli_result_t embed_one(
   embed_obj_add(obj, symbol, content.data, size);
   embed_obj_add(obj, sp_fmt(mem, "{}_size", sp_fmt_str(symbol)).value, &size, sizeof(u64));
 
-  sp_da_push(*entries, ((embed_entry_t){
+  embed_entry_t entry = {
     .path = embed_path,
     .symbol = symbol,
     .size = size,
-  }));
+  };
+  spn_sha256(content.data, size, entry.digest);
+  sp_da_push(*entries, entry);
 
   return SP_CLI_OK;
 }
 
+// Same digest as spn_cc_embed_ctx_digest(): every path and its contents, in
+// manifest order
+static sp_str_t embed_digest(sp_mem_t mem, sp_da(embed_entry_t) entries) {
+  spn_sha256_ctx_t sha = sp_zero;
+  spn_sha256_init(&sha);
+  sp_da_for(entries, it) {
+    u8 separator = 0;
+    spn_sha256_update(&sha, (const u8*)entries[it].path.data, entries[it].path.len);
+    spn_sha256_update(&sha, &separator, 1);
+    spn_sha256_update(&sha, entries[it].digest, sizeof(entries[it].digest));
+  }
+
+  u8 digest [32];
+  spn_sha256_final(&sha, digest);
+  return spn_sha256_digest_hex(mem, digest);
+}
+
 sp_cli_result_t embed_run(sp_cli_t* cli) {
   embed_t* embed = sp_cast(embed_t*, cli->user_data);
 
@@ -249,6 +270,7 @@ sp_cli_result_t embed_run(sp_cli_t* cli) {
   }
   sp_fmt_io(&header.base, "\ntypedef struct {{\n  const char* path;\n  const void* data;\n  unsigned long long size;\n}} spn_embed_entry_t;\n");
   sp_fmt_io(&header.base, "static const unsigned int spn_embed_count = {};\n", sp_fmt_uint(sp_da_size(entries)));
+  sp_fmt_io(&header.base, "static const char spn_embed_digest[] = \"{}\";\n", sp_fmt_str(embed_digest(mem, entries)));
   sp_fmt_io(&header.base, "static const spn_embed_entry_t spn_embed_manifest[] = {{\n");
   sp_da_for(entries, it) {
     embed_entry_t entry = entries[it];
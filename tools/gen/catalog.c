@@ -0,0 +1,291 @@
+#include "gen.h"
+
+static bool catalog_fail(catalog_t* catalog, sp_str_t where, const c8* what) {
+  catalog->err = sp_fmt(catalog->mem, "toolchains: {.cyan}: {}", sp_fmt_str(where), sp_fmt_cstr(what)).value;
+  return false;
+}
+
+static sp_str_t catalog_str(catalog_t* catalog, yyjson_val* val) {
+  return sp_str_from_cstr_n(catalog->mem, yyjson_get_str(val), (u32)yyjson_get_len(val));
+}
+
+// An sp_str_t initializer with the length computed here instead of at startup
+static sp_str_t catalog_c_str(catalog_t* catalog, sp_str_t str) {
+  sp_io_dyn_mem_writer_t w = sp_zero;
+  sp_io_dyn_mem_writer_init(catalog->mem, &w);
+
+  sp_fmt_io(&w.base, "{{ .data = \"");
+  sp_for(it, str.len) {
+    c8 c = str.data[it];
+    if (c == '"' || c == '\\') {
+      sp_io_write_c8(&w.base, '\\');
+      sp_io_write_c8(&w.base, c);
+    }
+    else if ((u8)c < 0x20 || (u8)c >= 0x7f) {
+      sp_fmt_io(&w.base, "\\{}{}{}", sp_fmt_uint(((u8)c >> 6) & 7), sp_fmt_uint(((u8)c >> 3) & 7), sp_fmt_uint((u8)c & 7));
+    }
+    else {
+      sp_io_write_c8(&w.base, c);
+    }
+  }
+  sp_fmt_io(&w.base, "\", .len = {} }}", sp_fmt_uint(str.len));
+  return sp_io_dyn_mem_writer_take_str(&w);
+}
+
+static bool catalog_read_str(catalog_t* catalog, sp_str_t where, yyjson_val* obj, const c8* key, bool required, sp_str_t* out) {
+  yyjson_val* val = yyjson_obj_get(obj, key);
+  if (!val) {
+    if (required) {
+      catalog->err = sp_fmt(catalog->mem, "toolchains: {.cyan}: missing {.red}", sp_fmt_str(where), sp_fmt_cstr(key)).value;
+      return false;
+    }
+    *out = sp_str_lit("{ 0 }");
+    return true;
+  }
+  if (!yyjson_is_str(val)) {
+    catalog->err = sp_fmt(catalog->mem, "toolchains: {.cyan}: {.red} must be a string", sp_fmt_str(where), sp_fmt_cstr(key)).value;
+    return false;
+  }
+  *out = catalog_c_str(catalog, catalog_str(catalog, val));
+  return true;
+}
+
+static sp_str_t catalog_add_array(catalog_t* catalog, sp_str_t name, const c8* type, sp_da(sp_str_t) items) {
+  sp_da_push(catalog->arrays, ((catalog_array_t) {
+    .name = name,
+    .type = sp_cstr_as_str(type),
+    .items = items,
+  }));
+  return name;
+}
+
+static bool catalog_read_launcher(catalog_t* catalog, sp_str_t where, sp_str_t id, yyjson_val* obj, const c8* key, bool required, sp_str_t* out) {
+  yyjson_val* val = yyjson_obj_get(obj, key);
+  if (!val) {
+    if (required) {
+      catalog->err = sp_fmt(catalog->mem, "toolchains: {.cyan}: missing {.red}", sp_fmt_str(where), sp_fmt_cstr(key)).value;
+      return false;
+    }
+    *out = sp_str_lit("{ 0 }");
+    return true;
+  }
+  if (!yyjson_is_obj(val)) {
+    return catalog_fail(catalog, where, "launchers must be objects");
+  }
+
+  sp_str_t program = sp_zero;
+  if (!catalog_read_str(catalog, where, val, "program", true, &program)) {
+    return false;
+  }
+
+  sp_da(sp_str_t) args = sp_da_new(catalog->mem, sp_str_t);
+  yyjson_val* list = yyjson_obj_get(val, "args");
+  if (list && !yyjson_is_arr(list)) {
+    return catalog_fail(catalog, where, "launcher args must be an array");
+  }
+  size_t idx, max;
+  yyjson_val* arg;
+  yyjson_arr_foreach(list, idx, max, arg) {
+    if (!yyjson_is_str(arg)) {
+      return catalog_fail(catalog, where, "launcher args must be strings");
+    }
+    sp_da_push(args, catalog_c_str(catalog, catalog_str(catalog, arg)));
+  }
+
+  sp_str_t array = sp_str_lit("SP_NULLPTR");
+  if (!sp_da_empty(args)) {
+    sp_str_t name = sp_fmt(catalog->mem, "{}_{}_args", sp_fmt_str(id), sp_fmt_cstr(key)).value;
+    array = catalog_add_array(catalog, name, "sp_str_t", args);
+  }
+
+  *out = sp_fmt(catalog->mem, "{{ .program = {}, .args = {}, .num_args = {} }}",
+    sp_fmt_str(program),
+    sp_fmt_str(array),
+    sp_fmt_uint(sp_da_size(args))).value;
+  return true;
+}
+
+static bool catalog_read_hosts(catalog_t* catalog, sp_str_t where, sp_str_t id, yyjson_val* obj, catalog_toolchain_t* toolchain) {
+  toolchain->hosts = sp_str_lit("SP_NULLPTR");
+
+  yyjson_val* hosts = yyjson_obj_get(obj, "host");
+  if (!hosts) {
+    return true;
+  }
+  if (!yyjson_is_obj(hosts)) {
+    return catalog_fail(catalog, where, "host must be an object");
+  }
+
+  sp_da(sp_str_t) items = sp_da_new(catalog->mem, sp_str_t);
+  size_t idx, max;
+  yyjson_val *key, *val;
+  yyjson_obj_foreach(hosts, idx, max, key, val) {
+    sp_str_t triple = catalog_str(catalog, key);
+    sp_str_t host = sp_fmt(catalog->mem, "{}.host.{}", sp_fmt_str(where), sp_fmt_str(triple)).value;
+    if (!yyjson_is_obj(val)) {
+      return catalog_fail(catalog, host, "artifacts must be objects");
+    }
+
+    sp_str_t url = sp_zero;
+    sp_str_t sha256 = sp_zero;
+    if (!catalog_read_str(catalog, host, val, "url", true, &url)) {
+      return false;
+    }
+    if (!catalog_read_str(catalog, host, val, "sha256", false, &sha256)) {
+      return false;
+    }
+    sp_da_push(items, sp_fmt(catalog->mem, "{{ .triple = {}, .url = {}, .sha256 = {} }}",
+      sp_fmt_str(catalog_c_str(catalog, triple)),
+      sp_fmt_str(url),
+      sp_fmt_str(sha256)).value);
+  }
+
+  toolchain->num_hosts = sp_da_size(items);
+  if (toolchain->num_hosts) {
+    toolchain->hosts = catalog_add_array(catalog, sp_fmt(catalog->mem, "{}_hosts", sp_fmt_str(id)).value, "spn_toolchain_builtin_host_t", items);
+  }
+  return true;
+}
+
+static bool catalog_read_targets(catalog_t* catalog, sp_str_t where, sp_str_t id, yyjson_val* obj, catalog_toolchain_t* toolchain) {
+  toolchain->targets = sp_str_lit("SP_NULLPTR");
+
+  yyjson_val* targets = yyjson_obj_get(obj, "target");
+  if (!targets) {
+    return true;
+  }
+  if (!yyjson_is_arr(targets)) {
+    return catalog_fail(catalog, where, "target must be an array");
+  }
+
+  sp_da(sp_str_t) items = sp_da_new(catalog->mem, sp_str_t);
+  size_t idx, max;
+  yyjson_val* val;
+  yyjson_arr_foreach(targets, idx, max, val) {
+    if (!yyjson_is_obj(val)) {
+      return catalog_fail(catalog, where, "targets must be objects");
+    }
+
+    sp_str_t arch = sp_zero;
+    sp_str_t os = sp_zero;
+    sp_str_t abi = sp_zero;
+    if (!catalog_read_str(catalog, where, val, "arch", false, &arch)) return false;
+    if (!catalog_read_str(catalog, where, val, "os", false, &os)) return false;
+    if (!catalog_read_str(catalog, where, val, "abi", false, &abi)) return false;
+    sp_da_push(items, sp_fmt(catalog->mem, "{{ .arch = {}, .os = {}, .abi = {} }}",
+      sp_fmt_str(arch),
+      sp_fmt_str(os),
+      sp_fmt_str(abi)).value);
+  }
+
+  toolchain->num_targets = sp_da_size(items);
+  if (toolchain->num_targets) {
+    toolchain->targets = catalog_add_array(catalog, sp_fmt(catalog->mem, "{}_targets", sp_fmt_str(id)).value, "spn_toolchain_builtin_target_t", items);
+  }
+  return true;
+}
+
+static bool catalog_read_toolchain(catalog_t* catalog, u32 index, yyjson_val* obj) {
+  sp_str_t where = sp_fmt(catalog->mem, "toolchain[{}]", sp_fmt_uint(index)).value;
+  if (!yyjson_is_obj(obj)) {
+    return catalog_fail(catalog, where, "toolchains must be objects");
+  }
+
+  yyjson_val* name = yyjson_obj_get(obj, "name");
+  if (yyjson_is_str(name)) {
+    where = catalog_str(catalog, name);
+  }
+
+  sp_str_t id = sp_fmt(catalog->mem, "spn_toolchain_builtin_{}", sp_fmt_uint(index)).value;
+  catalog_toolchain_t toolchain = sp_zero;
+  if (!catalog_read_str(catalog, where, obj, "name", true, &toolchain.name)) return false;
+  if (!catalog_read_str(catalog, where, obj, "version", false, &toolchain.version)) return false;
+  if (!catalog_read_str(catalog, where, obj, "driver", true, &toolchain.driver)) return false;
+  if (!catalog_read_str(catalog, where, obj, "mirrors", false, &toolchain.mirrors)) return false;
+  if (!catalog_read_launcher(catalog, where, id, obj, "compiler", true, &toolchain.compiler)) return false;
+  if (!catalog_read_launcher(catalog, where, id, obj, "cxx", false, &toolchain.cxx)) return false;
+  if (!catalog_read_launcher(catalog, where, id, obj, "linker", true, &toolchain.linker)) return false;
+  if (!catalog_read_launcher(catalog, where, id, obj, "archiver", true, &toolchain.archiver)) return false;
+  if (!catalog_read_hosts(catalog, where, id, obj, &toolchain)) return false;
+  if (!catalog_read_targets(catalog, where, id, obj, &toolchain)) return false;
+
+  sp_da_push(catalog->toolchains, toolchain);
+  return true;
+}
+
+catalog_t* catalog_parse(sp_mem_t mem, sp_str_t path) {
+  catalog_t* catalog = sp_alloc_type(mem, catalog_t);
+  catalog->mem = mem;
+  sp_da_init(mem, catalog->arrays);
+  sp_da_init(mem, catalog->toolchains);
+
+  sp_str_t json = sp_zero;
+  if (sp_io_read_file(mem, path, &json)) {
+    catalog->err = sp_fmt(mem, "failed to read {}", sp_fmt_str(path)).value;
+    return catalog;
+  }
+
+  yyjson_alc alc = gen_yyjson_alc(&catalog->mem);
+  yyjson_doc* doc = yyjson_read_opts((c8*)json.data, json.len, 0, &alc, SP_NULLPTR);
+  if (!doc) {
+    catalog->err = sp_fmt(mem, "{} is not valid json", sp_fmt_str(path)).value;
+    return catalog;
+  }
+
+  yyjson_val* toolchains = yyjson_obj_get(yyjson_doc_get_root(doc), "toolchain");
+  if (!yyjson_is_arr(toolchains) || !yyjson_arr_size(toolchains)) {
+    catalog_fail(catalog, path, "expected a non-empty toolchain array");
+    return catalog;
+  }
+
+  size_t idx, max;
+  yyjson_val* val;
+  yyjson_arr_foreach(toolchains, idx, max, val) {
+    if (!catalog_read_toolchain(catalog, (u32)idx, val)) {
+      return catalog;
+    }
+  }
+
+  return catalog;
+}
+
+static sp_template_scope_t* catalog_scope(catalog_t* catalog) {
+  sp_template_scope_t* root = sp_template_scope_create(catalog->mem);
+
+  sp_template_list(root, sp_str_lit("arrays"));
+  sp_da_for(catalog->arrays, it) {
+    catalog_array_t* array = &catalog->arrays[it];
+    sp_template_scope_t* scope = sp_template_push(root, sp_str_lit("arrays"));
+    sp_template_set(scope, sp_str_lit("name"), array->name);
+    sp_template_set(scope, sp_str_lit("type"), array->type);
+    sp_template_list(scope, sp_str_lit("items"));
+    sp_da_for(array->items, item) {
+      sp_template_set(sp_template_push(scope, sp_str_lit("items")), sp_str_lit("value"), array->items[item]);
+    }
+  }
+
+  sp_template_list(root, sp_str_lit("toolchains"));
+  sp_da_for(catalog->toolchains, it) {
+    catalog_toolchain_t* toolchain = &catalog->toolchains[it];
+    sp_template_scope_t* scope = sp_template_push(root, sp_str_lit("toolchains"));
+    sp_template_set(scope, sp_str_lit("name"), toolchain->name);
+    sp_template_set(scope, sp_str_lit("version"), toolchain->version);
+    sp_template_set(scope, sp_str_lit("driver"), toolchain->driver);
+    sp_template_set(scope, sp_str_lit("mirrors"), toolchain->mirrors);
+    sp_template_set(scope, sp_str_lit("compiler"), toolchain->compiler);
+    sp_template_set(scope, sp_str_lit("cxx"), toolchain->cxx);
+    sp_template_set(scope, sp_str_lit("linker"), toolchain->linker);
+    sp_template_set(scope, sp_str_lit("archiver"), toolchain->archiver);
+    sp_template_set(scope, sp_str_lit("hosts"), toolchain->hosts);
+    sp_template_set(scope, sp_str_lit("num_hosts"), sp_fmt(catalog->mem, "{}", sp_fmt_uint(toolchain->num_hosts)).value);
+    sp_template_set(scope, sp_str_lit("targets"), toolchain->targets);
+    sp_template_set(scope, sp_str_lit("num_targets"), sp_fmt(catalog->mem, "{}", sp_fmt_uint(toolchain->num_targets)).value);
+  }
+
+  sp_template_set(root, sp_str_lit("count"), sp_fmt(catalog->mem, "{}", sp_fmt_uint(sp_da_size(catalog->toolchains))).value);
+  return root;
+}
+
+gen_render_t catalog_render_impl(catalog_t* catalog) {
+  return (gen_render_t) { .template = sp_str_lit("catalog/impl.c"), .scope = catalog_scope(catalog) };
+}
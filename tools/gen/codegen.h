@@ -8,6 +8,7 @@ typedef struct {
   sp_str_t out;
   sp_str_t include;
   sp_str_t templates;
+  sp_str_t toolchains;
 } codegen_paths_t;
 
 typedef void (*codegen_log_fn_t)(void* user, sp_str_t message);
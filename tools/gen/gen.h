@@ -157,6 +157,35 @@ typedef struct {
   sp_str_t err;
 } abi_t;
 
+// Every field is already rendered as a C initializer
+typedef struct {
+  sp_str_t name;
+  sp_str_t version;
+  sp_str_t driver;
+  sp_str_t mirrors;
+  sp_str_t compiler;
+  sp_str_t cxx;
+  sp_str_t linker;
+  sp_str_t archiver;
+  sp_str_t hosts;
+  u32 num_hosts;
+  sp_str_t targets;
+  u32 num_targets;
+} catalog_toolchain_t;
+
+typedef struct {
+  sp_str_t name;
+  sp_str_t type;
+  sp_da(sp_str_t) items;
+} catalog_array_t;
+
+typedef struct {
+  sp_mem_t mem;
+  sp_da(catalog_array_t) arrays;
+  sp_da(catalog_toolchain_t) toolchains;
+  sp_str_t err;
+} catalog_t;
+
 typedef struct {
   sp_str_t template;
   sp_template_scope_t* scope;
@@ -185,5 +214,7 @@ yyjson_alc gen_yyjson_alc(sp_mem_t* mem);
 abi_t* abi_parse(sp_mem_t mem, sp_str_t path);
 gen_render_t abi_render_decls(abi_t* abi);
 gen_render_t abi_render_impl(abi_t* abi);
+catalog_t* catalog_parse(sp_mem_t mem, sp_str_t path);
+gen_render_t catalog_render_impl(catalog_t* catalog);
 
 #endif
@@ -9,6 +9,7 @@ typedef struct {
   const c8* out;
   const c8* include;
   const c8* templates;
+  const c8* toolchains;
 } args_t;
 
 static void log_line(void* user, sp_str_t message) {
@@ -24,6 +25,7 @@ static sp_cli_result_t run_cli(sp_cli_t* cli) {
     .out = sp_cstr_as_str(args->out),
     .include = sp_cstr_as_str(args->include),
     .templates = sp_cstr_as_str(args->templates),
+    .toolchains = sp_cstr_as_str(args->toolchains),
   }, log_line, SP_NULLPTR);
 
   if (!sp_str_empty(err)) {
@@ -37,7 +39,7 @@ s32 main(s32 num_args, const c8** args) {
 
   sp_cli_cmd_t root = {
     .name = "jtd_gen",
-    .summary = "Generate C structs and load/write code from JTD schemas",
+    .summary = "Generate C structs and load/write code from JTD schemas, and the builtin toolchain tables",
     .args = {
       {
         .name = "schema",
@@ -59,6 +61,11 @@ s32 main(s32 num_args, const c8** args) {
         .summary = "Path to the template root directory",
         .ptr = &parsed.templates,
       },
+      {
+        .name = "toolchains",
+        .summary = "Path to the builtin toolchain catalog",
+        .ptr = &parsed.toolchains,
+      },
     },
     .handler = run_cli,
   };
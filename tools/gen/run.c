@@ -262,6 +262,17 @@ static bool render_abi(codegen_t* c) {
   return true;
 }
 
+static bool render_catalog(codegen_t* c) {
+  catalog_t* catalog = catalog_parse(c->mem, c->paths.toolchains);
+  if (!sp_str_empty(catalog->err)) {
+    return fail(c, catalog->err);
+  }
+
+  try(render_one(c, out_path(c, c->paths.out, sp_str_lit("builtins"), ".gen.c"), catalog_render_impl(catalog)));
+  emit(c, sp_fmt(c->mem, "wrote builtins ({} toolchains)", sp_fmt_uint(sp_da_size(catalog->toolchains))).value);
+  return true;
+}
+
 static s32 sort_entries(const void* a, const void* b) {
   const sp_fs_entry_t* ea = (const sp_fs_entry_t*)a;
   const sp_fs_entry_t* eb = (const sp_fs_entry_t*)b;
@@ -290,7 +301,8 @@ static bool run(codegen_t* c) {
     try(render_kind(c, entry));
   }
 
-  return render_abi(c);
+  try(render_abi(c));
+  return render_catalog(c);
 }
 
 sp_str_t codegen_run(sp_mem_t mem, codegen_paths_t paths, codegen_log_fn_t log, void* user) {
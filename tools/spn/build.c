@@ -24,6 +24,7 @@ spn_err_t codegen(spn_t* spn) {
     .out = sp_str_lit("/source/source/core/codegen/gen"),
     .include = sp_str_lit("/source/include/spn"),
     .templates = sp_str_lit("/source/tools/gen/templates"),
+    .toolchains = sp_str_lit("/source/source/core/toolchain/toolchains.json"),
   }, codegen_log, &io);
 
   if (!sp_str_empty(err)) {
@@ -44,10 +44,12 @@ static void add_codegen(spn_t* spn, spn_config_t* config) {
 
   add_inputs(spn, mem, node, sp_str_lit("/source/source/core/codegen/schema"));
   add_inputs(spn, mem, node, sp_str_lit("/source/tools/gen/templates"));
+  spn_node_add_input(node, host_path(spn, mem, sp_str_lit("/source/source/core/toolchain/toolchains.json")));
 
   add_output(spn, mem, node, "source/core/codegen/gen", sp_str_lit("common"), ".gen.h");
   add_output(spn, mem, node, "source/core/codegen/gen", sp_str_lit("abi"), ".gen.h");
   add_output(spn, mem, node, "source/core/codegen/gen", sp_str_lit("abi"), ".gen.c");
+  add_output(spn, mem, node, "source/core/codegen/gen", sp_str_lit("builtins"), ".gen.c");
   add_output(spn, mem, node, "include/spn", sp_str_lit("err"), ".h");
 
   sp_da(sp_fs_entry_t) schemas = sp_zero;
@@ -78,7 +80,6 @@ spn_err_t configure(spn_t* spn, spn_config_t* config) {
   spn_target_embed_file_ex(target, "include/spn.h", "include_spn_h", "u8", "u64");
   spn_target_embed_file_ex(target, "include/spn/core.h", "include_spn_core_h", "u8", "u64");
   spn_target_embed_file_ex(target, "include/spn/err.h", "include_spn_err_h", "u8", "u64");
-  spn_target_embed_file_ex(target, "source/core/toolchain/toolchains.json", "toolchains_json", "u8", "u64");
   spn_target_embed_dir_ex(target, "assets/init", "init", "u8", "u64");
 
   add_codegen(spn, config);